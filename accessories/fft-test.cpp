@@ -25,6 +25,333 @@ Free Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1
 #include "includes.h"
 #include <time.h>
 
+/* The MMX rank() of the original radix-2 FFT, one butterfly at a time */
+static void ref_fft(CPX *_x, int32 _N, int32 *_R, bool _inverse)
+{
+
+	int32 lcv, lcv2, lcv3, M, bsize, index;
+	int32 ai, aq, bi, bq, wi, wq, ti, tq;
+	CPX *t;
+	const double pi = 3.14159265358979323846264338327;
+
+	M = 0;
+	while((1 << M) < _N)
+		M++;
+
+	/* Bit reverse */
+	t = new CPX[_N];
+	memcpy(t, _x, _N*sizeof(CPX));
+	for(lcv = 0; lcv < _N; lcv++)
+	{
+		index = 0;
+		for(lcv2 = 0; lcv2 < M; lcv2++)
+			index |= ((lcv >> lcv2) & 0x1) << (M - 1 - lcv2);
+		_x[lcv] = t[index];
+	}
+	delete [] t;
+
+	for(lcv = 0, bsize = 1; lcv < M; lcv++, bsize <<= 1)
+		for(lcv2 = 0; lcv2 < _N; lcv2 += 2*bsize)
+			for(lcv3 = 0; lcv3 < bsize; lcv3++)
+			{
+				index = lcv3*(_N/(2*bsize));
+				wi = (int32)floor(16384*cos((-2*pi*index)/_N));
+				wq = (int32)floor(16384*sin((-2*pi*index)/_N));
+				if(_inverse)
+					wq = -wq;
+
+				ai = _x[lcv2+lcv3].i;			aq = _x[lcv2+lcv3].q;
+				bi = _x[lcv2+lcv3+bsize].i;		bq = _x[lcv2+lcv3+bsize].q;
+				if(_R[lcv])
+				{
+					ai >>= 1; aq >>= 1;
+					bi >>= 1; bq >>= 1;
+				}
+
+				/* pmaddwd, round, psrad and packssdw */
+				ti = (bi*wi - bq*wq + 8192) >> 14;
+				tq = (bi*wq + bq*wi + 8192) >> 14;
+				ti = ti > 32767 ? 32767 : (ti < -32768 ? -32768 : ti);
+				tq = tq > 32767 ? 32767 : (tq < -32768 ? -32768 : tq);
+
+				/* paddw and psubw wrap */
+				_x[lcv2+lcv3].i = (int16)(ai + ti);			_x[lcv2+lcv3].q = (int16)(aq + tq);
+				_x[lcv2+lcv3+bsize].i = (int16)(ai - ti);	_x[lcv2+lcv3+bsize].q = (int16)(aq - tq);
+			}
+
+}
+
+/* The radix-4 passes have to give exactly what the radix-2 ranks did, for every size and scaling */
+static int32 check_fft()
+{
+
+	int32 lcv, lcv2, N, R[MAX_RANKS], err, errs;
+	CPX *x, *y;
+	FFT *pFFT;
+
+	errs = 0;
+
+	for(N = 4; N <= 8192; N <<= 1)
+	{
+		err = 0;
+
+		x = new CPX[N];
+		y = new CPX[N];
+
+		for(lcv = 0; lcv < 20; lcv++)
+		{
+			for(lcv2 = 0; lcv2 < MAX_RANKS; lcv2++)
+				R[lcv2] = rand() & 0x1;
+
+			/* Full scale, so the saturation and the wrap have to match too */
+			for(lcv2 = 0; lcv2 < N; lcv2++)
+			{
+				x[lcv2].i = (int16)rand();
+				x[lcv2].q = (int16)rand();
+			}
+
+			pFFT = new FFT(N, R);
+
+			memcpy(y, x, N*sizeof(CPX));
+			if(lcv & 0x1)
+			{
+				pFFT->doiFFT(x, true);
+				ref_fft(y, N, R, true);
+			}
+			else
+			{
+				pFFT->doFFT(x, true);
+				ref_fft(y, N, R, false);
+			}
+
+			for(lcv2 = 0; lcv2 < N; lcv2++)
+				if((x[lcv2].i != y[lcv2].i) || (x[lcv2].q != y[lcv2].q))
+					err++;
+
+			delete pFFT;
+		}
+
+		if(err)
+			printf("FFT %d \t\tFAILED: %d\n",N,err);
+		else
+			printf("FFT %d \t\tPASSED\n",N);
+
+		errs += err;
+
+		delete [] x;
+		delete [] y;
+	}
+
+	return(errs);
+
+}
+
+/* A batched call has to give what the same vectors one at a time do, whatever the stride */
+static int32 check_batch()
+{
+
+	int32 lcv, lcv2, N, count, stride, err, errs;
+	CPX *x, *y;
+	FFT *pFFT;
+
+	errs = 0;
+	count = 13;
+
+	for(N = 4; N <= 8192; N <<= 1)
+	{
+		err = 0;
+		stride = N + 3;
+
+		x = new CPX[count*stride];
+		y = new CPX[count*stride];
+
+		for(lcv = 0; lcv < count*stride; lcv++)
+		{
+			x[lcv].i = (int16)rand();
+			x[lcv].q = (int16)rand();
+		}
+
+		pFFT = new FFT(N);
+
+		for(lcv = 0; lcv < 2; lcv++)
+		{
+			memcpy(y, x, count*stride*sizeof(CPX));
+
+			if(lcv)
+			{
+				pFFT->doiFFTBatch(x, count, stride, true);
+				for(lcv2 = 0; lcv2 < count; lcv2++)
+					pFFT->doiFFT(&y[lcv2*stride], true);
+			}
+			else
+			{
+				pFFT->doFFTBatch(x, count, stride, true);
+				for(lcv2 = 0; lcv2 < count; lcv2++)
+					pFFT->doFFT(&y[lcv2*stride], true);
+			}
+
+			for(lcv2 = 0; lcv2 < count*stride; lcv2++)
+				if((x[lcv2].i != y[lcv2].i) || (x[lcv2].q != y[lcv2].q))
+					err++;
+		}
+
+		if(err)
+			printf("FFT batch %d \t\tFAILED: %d\n",N,err);
+		else
+			printf("FFT batch %d \t\tPASSED\n",N);
+
+		errs += err;
+
+		delete pFFT;
+		delete [] x;
+		delete [] y;
+	}
+
+	return(errs);
+
+}
+
+/* Sizes that are not a power of 2 against a direct DFT, to within the rounding of the twiddles.
+ * 90 and 375 leave the SIMD stages groups that are not a multiple of their width */
+static int32 check_mixed()
+{
+
+	int32 sizes[] = {12, 60, 90, 375, 1000, 2000, 3000, 4000, 5000, 8000};
+	int32 lcv, lcv2, lcv3, N, R[MAX_RANKS], ranks, shift, err, errs;
+	double re, im, ph, scale, worst;
+	CPX *x, *y;
+	FFT *pFFT;
+
+	errs = 0;
+
+	for(lcv = 0; lcv < (int32)(sizeof(sizes)/sizeof(int32)); lcv++)
+	{
+		N = sizes[lcv];
+		x = new CPX[N];
+		y = new CPX[N];
+
+		ranks = 0;
+		while((1 << ranks) < N)
+			ranks++;
+
+		/* Scale all but the last 2 ranks */
+		for(lcv2 = 0; lcv2 < MAX_RANKS; lcv2++)
+			R[lcv2] = lcv2 < ranks - 2;
+		shift = ranks - 2;
+		scale = 1.0/(double)(1 << shift);
+
+		for(lcv2 = 0; lcv2 < N; lcv2++)
+		{
+			y[lcv2].i = (int16)(rand() % 8192 - 4096);
+			y[lcv2].q = (int16)(rand() % 8192 - 4096);
+		}
+
+		pFFT = new FFT(N, R);
+		err = 0;
+		worst = 0;
+
+		for(lcv3 = 0; lcv3 < 2; lcv3++)
+		{
+			memcpy(x, y, N*sizeof(CPX));
+
+			if(lcv3)
+				pFFT->doiFFT(x, true);
+			else
+				pFFT->doFFT(x, true);
+
+			for(lcv2 = 0; lcv2 < N; lcv2++)
+			{
+				re = im = 0;
+				for(int32 k = 0; k < N; k++)
+				{
+					ph = (lcv3 ? 2.0 : -2.0)*3.14159265358979323846*(double)(((int64)lcv2*k) % N)/(double)N;
+					re += y[k].i*cos(ph) - y[k].q*sin(ph);
+					im += y[k].i*sin(ph) + y[k].q*cos(ph);
+				}
+
+				re = fabs(re*scale - x[lcv2].i);
+				im = fabs(im*scale - x[lcv2].q);
+				worst = re > worst ? re : worst;
+				worst = im > worst ? im : worst;
+				if((re > 2.0) || (im > 2.0))
+					err++;
+			}
+		}
+
+		if(err)
+			printf("FFT mixed %d \t\tFAILED: %d, worst %.2f\n",N,err,worst);
+		else
+			printf("FFT mixed %d \t\tPASSED, worst %.2f\n",N,worst);
+
+		errs += err;
+
+		delete pFFT;
+		delete [] x;
+		delete [] y;
+	}
+
+	return(errs);
+
+}
+
+/* Sizes with a factor other than 2, 3 and 5 must be refused, and the transforms leave the data alone */
+static int32 check_reject()
+{
+
+	int32 sizes[] = {7, 14, 896, 2046};
+	int32 lcv, lcv2, N, R[MAX_RANKS], err, errs;
+	CPX *x, *y;
+	FFT *pFFT;
+
+	errs = 0;
+	memset(R, 0x0, sizeof(R));
+
+	for(lcv = 0; lcv < (int32)(sizeof(sizes)/sizeof(int32)); lcv++)
+	{
+		N = sizes[lcv];
+		x = new CPX[N];
+		y = new CPX[N];
+
+		for(lcv2 = 0; lcv2 < N; lcv2++)
+		{
+			y[lcv2].i = (int16)(rand() % 8192 - 4096);
+			y[lcv2].q = (int16)(rand() % 8192 - 4096);
+		}
+		memcpy(x, y, N*sizeof(CPX));
+
+		pFFT = new FFT(N, R);
+		err = pFFT->getValid() != 0;
+
+		pFFT->doFFT(x, true);
+		pFFT->doiFFT(x, true);
+		pFFT->doFFTBatch(x, 1, N, true);
+		if(memcmp(x, y, N*sizeof(CPX)))
+			err++;
+
+		if(err)
+			printf("FFT reject %d \t\tFAILED: %d\n",N,err);
+		else
+			printf("FFT reject %d \t\tPASSED\n",N);
+
+		errs += err;
+
+		delete pFFT;
+		delete [] x;
+		delete [] y;
+	}
+
+	/* And the sizes that can be done must say so */
+	pFFT = new FFT(2048, R);
+	errs += pFFT->getValid() != 1;
+	delete pFFT;
+	pFFT = new FFT(3000, R);
+	errs += pFFT->getValid() != 1;
+	delete pFFT;
+
+	return(errs);
+
+}
+
 int main(int32 argc, char** argv)
 {
 
@@ -49,6 +376,9 @@ int main(int32 argc, char** argv)
 	for(lcv = 0; lcv < argc; lcv++)
 		printf("%s\n",argv[lcv]);
 
+	if(check_fft() || check_batch() || check_mixed() || check_reject())
+		return(-1);
+
 	/* Read in the data */
 	fp = fopen("input.dat","rb");
 	if(fp == NULL)
@@ -19,6 +19,8 @@ Free Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1
 
 #include "includes.h"
 
+#include <immintrin.h>
+
 //#define NO_SIMD
 
 #ifdef NO_SIMD
@@ -41,6 +43,7 @@ FFT::FFT()
 {
 
 	N = 0;
+	valid = 0;
 
 }
 
@@ -62,6 +65,18 @@ FFT::FFT(int32 _N)
 		_N >>= 1;
 	}
 
+	/* Anything other than 2^N goes through the mixed radix stages */
+	if(N & (N - 1))
+	{
+		initMixed();
+		return;
+	}
+
+	mixed = 0;
+	valid = 1;
+	TW = TWr = TWi = NULL;
+	MX = NULL;
+
 	W = (MIX *)malloc(N/2*sizeof(MIX));  	// Forward twiddle lookup
 	iW = (MIX *)malloc(N/2*sizeof(MIX)); 	// Inverse twiddle lookup
 	BR  = (int32 *)malloc(N*sizeof(int32)); 	// Bit reverse lookup
@@ -69,6 +84,7 @@ FFT::FFT(int32 _N)
 
 	initW();
 	initBR();
+	initRanks();
 
 }
 
@@ -91,6 +107,18 @@ FFT::FFT(int32 _N, int32 _R[MAX_RANKS])
 		_N >>= 1;
 	}
 
+	/* Anything other than 2^N goes through the mixed radix stages */
+	if(N & (N - 1))
+	{
+		initMixed();
+		return;
+	}
+
+	mixed = 0;
+	valid = 1;
+	TW = TWr = TWi = NULL;
+	MX = NULL;
+
 	W = (MIX *)malloc(N/2*sizeof(MIX));  	// Forward twiddle lookup
 	iW = (MIX *)malloc(N/2*sizeof(MIX)); 	// Inverse twiddle lookup
 	BR  = (int32 *)malloc(N*sizeof(int32)); 	// Bit reverse lookup
@@ -98,6 +126,7 @@ FFT::FFT(int32 _N, int32 _R[MAX_RANKS])
 
 	initW();
 	initBR();
+	initRanks();
 
 }
 
@@ -108,6 +137,14 @@ FFT::~FFT()
 	free(BR);
 	free(W);
 	free(iW);
+	free(Wr);
+	free(Wi);
+	free(iWr);
+	free(iWi);
+	free(TW);
+	free(TWr);
+	free(TWi);
+	free(MX);
 }
 
 void FFT::initW()
@@ -169,6 +206,18 @@ void FFT::doFFT(CPX *_x, bool _shuf)
 	CPX *a, *b;
 	MIX *w;
 
+	if(mixed)
+	{
+		doMixed(_x, false);
+		return;
+	}
+
+	if(M >= 2)
+	{
+		doRanks(_x, 1, N, Wr, Wi, _shuf);
+		return;
+	}
+
 	if(_shuf)
 		doShuffle(_x);	//bit reverse the array
 
@@ -199,6 +248,18 @@ void FFT::doiFFT(CPX *_x, bool _shuf)
 	CPX *a, *b;
 	MIX *w;
 
+	if(mixed)
+	{
+		doMixed(_x, true);
+		return;
+	}
+
+	if(M >= 2)
+	{
+		doRanks(_x, 1, N, iWr, iWi, _shuf);
+		return;
+	}
+
 	if(_shuf)
 		doShuffle(_x);	//bit reverse the array
 
@@ -224,6 +285,40 @@ void FFT::doiFFT(CPX *_x, bool _shuf)
 }
 
 
+void FFT::doFFTBatch(CPX *_x, int32 _count, int32 _stride, bool _shuf)
+{
+
+	int32 lcv;
+
+	if((M >= 2) && !mixed)
+	{
+		doRanks(_x, _count, _stride, Wr, Wi, _shuf);
+		return;
+	}
+
+	for(lcv = 0; lcv < _count; lcv++)
+		doFFT(_x + lcv*_stride, _shuf);
+
+}
+
+
+void FFT::doiFFTBatch(CPX *_x, int32 _count, int32 _stride, bool _shuf)
+{
+
+	int32 lcv;
+
+	if((M >= 2) && !mixed)
+	{
+		doRanks(_x, _count, _stride, iWr, iWi, _shuf);
+		return;
+	}
+
+	for(lcv = 0; lcv < _count; lcv++)
+		doiFFT(_x + lcv*_stride, _shuf);
+
+}
+
+
 void FFT::doFFTdf(CPX *_x, bool _shuf)
 {
 
@@ -232,6 +327,12 @@ void FFT::doFFTdf(CPX *_x, bool _shuf)
 	CPX *a, *b;
 	MIX *w;
 
+	if(mixed)
+	{
+		doMixed(_x, false);
+		return;
+	}
+
 	bsize = N >> 1;
 	nblocks = 1;
 
@@ -264,6 +365,12 @@ void FFT::doiFFTdf(CPX *_x, bool _shuf)
 	CPX *a, *b;
 	MIX *w;
 
+	if(mixed)
+	{
+		doMixed(_x, true);
+		return;
+	}
+
 	bsize = N >> 1;
 	nblocks = 1;
 
@@ -301,6 +408,1708 @@ void FFT::doShuffle(CPX *_x)
 }
 
 
+/* doFFT and doiFFT take their ranks two at a time, as radix-4 passes over the data, and the
+ * first pass reads straight out of bit reversed order, so there is no separate shuffle. Each of
+ * the two ranks in a pass is still its own radix-2 butterfly with its own R[] scaling, rounded
+ * and saturated the way rank() does it, so the results are bit for bit the same. doFFTBatch and
+ * doiFFTBatch run each pass over a chunk of vectors before the next, reusing the twiddle loads. */
+
+static inline int32 sat16(int32 _x)
+{
+
+	if(_x > 32767)
+		return(32767);
+	if(_x < -32768)
+		return(-32768);
+	return(_x);
+
+}
+
+/* One butterfly of rank(), _wr holds the [Re -Im] words of W and _wi the [Im Re] words */
+static inline void bfly_x86(CPX *_A, CPX *_B, int32 _wr, int32 _wi, int32 _scale)
+{
+
+	int32 ai, aq, bi, bq, ti, tq;
+
+	ai = _A->i; aq = _A->q;
+	bi = _B->i; bq = _B->q;
+
+	if(_scale)
+	{
+		ai >>= 1; aq >>= 1;
+		bi >>= 1; bq >>= 1;
+	}
+
+	ti = sat16((bi*(int16)_wr + bq*(int16)(_wr >> 16) + 8192) >> 14);
+	tq = sat16((bi*(int16)_wi + bq*(int16)(_wi >> 16) + 8192) >> 14);
+
+	_A->i = (int16)(ai + ti);
+	_A->q = (int16)(aq + tq);
+	_B->i = (int16)(ai - ti);
+	_B->q = (int16)(aq - tq);
+
+}
+
+/* One rank of _h point blocks, on each of the _count vectors _stride points apart */
+static void pass_r2_x86(CPX *_x, int32 _count, int32 _stride, int32 *_wr, int32 *_wi, int32 _h, int32 _n, int32 _scale)
+{
+
+	int32 lcv, lcv2, lcv3;
+	CPX *a;
+
+	for(lcv = 0; lcv < _n; lcv += 2*_h)
+		for(lcv2 = 0; lcv2 < _h; lcv2++)
+			for(lcv3 = 0; lcv3 < _count; lcv3++)
+			{
+				a = &_x[lcv3*_stride + lcv + lcv2];
+				bfly_x86(a, a + _h, _wr[lcv2], _wi[lcv2], _scale);
+			}
+
+}
+
+/* Two ranks, _h point blocks into 4*_h point blocks, _wr0/_wi0 hold the twiddles of the first */
+static void pass_r4_x86(CPX *_x, int32 _count, int32 _stride, int32 *_wr0, int32 *_wi0, int32 *_wr1, int32 *_wi1, int32 _h, int32 _n, int32 _s0, int32 _s1)
+{
+
+	int32 lcv, lcv2, lcv3;
+	CPX *a;
+
+	for(lcv = 0; lcv < _n; lcv += 4*_h)
+		for(lcv2 = 0; lcv2 < _h; lcv2++)
+			for(lcv3 = 0; lcv3 < _count; lcv3++)
+			{
+				a = &_x[lcv3*_stride + lcv + lcv2];
+				bfly_x86(a,			a + _h,		_wr0[lcv2],			_wi0[lcv2],			_s0);
+				bfly_x86(a + 2*_h,	a + 3*_h,	_wr0[lcv2],			_wi0[lcv2],			_s0);
+				bfly_x86(a,			a + 2*_h,	_wr1[lcv2],			_wi1[lcv2],			_s1);
+				bfly_x86(a + _h,	a + 3*_h,	_wr1[lcv2 + _h],	_wi1[lcv2 + _h],	_s1);
+			}
+
+}
+
+/* Ranks 0 and 1, taking the input in bit reversed order from _src */
+static void pass_first_x86(CPX *_x, CPX *_src, int32 *_br, int32 *_wr, int32 *_wi, int32 _n, int32 _s0, int32 _s1)
+{
+
+	int32 lcv;
+
+	for(lcv = 0; lcv < _n; lcv++)
+		_x[lcv] = _src[_br[lcv]];
+
+	pass_r4_x86(_x, 1, _n, &_wr[0], &_wi[0], &_wr[1], &_wi[1], 1, _n, _s0, _s1);
+
+}
+
+
+/* The same butterfly 4 at a time, the real and imaginary parts interleaved back before the pack */
+__attribute__ ((target("sse2")))
+static inline void bfly_sse(__m128i *_A, __m128i *_B, __m128i _wr, __m128i _wi, int32 _scale)
+{
+
+	__m128i a, b, re, im, t, rnd;
+
+	rnd = _mm_set1_epi32(8192);
+	a = *_A;
+	b = *_B;
+
+	if(_scale)
+	{
+		a = _mm_srai_epi16(a, 1);
+		b = _mm_srai_epi16(b, 1);
+	}
+
+	re = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(b, _wr), rnd), 14);
+	im = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(b, _wi), rnd), 14);
+	t = _mm_packs_epi32(_mm_unpacklo_epi32(re, im), _mm_unpackhi_epi32(re, im));
+
+	*_A = _mm_add_epi16(a, t);
+	*_B = _mm_sub_epi16(a, t);
+
+}
+
+__attribute__ ((target("sse2")))
+static void pass_r2_sse(CPX *_x, int32 _count, int32 _stride, int32 *_wr, int32 *_wi, int32 _h, int32 _n, int32 _scale)
+{
+
+	int32 lcv, lcv2, lcv3;
+	__m128i a, b, wr, wi;
+	CPX *p;
+
+	for(lcv = 0; lcv < _n; lcv += 2*_h)
+		for(lcv2 = 0; lcv2 < _h; lcv2 += 4)
+		{
+			wr = _mm_loadu_si128((__m128i *)&_wr[lcv2]);
+			wi = _mm_loadu_si128((__m128i *)&_wi[lcv2]);
+
+			for(lcv3 = 0; lcv3 < _count; lcv3++)
+			{
+				p = &_x[lcv3*_stride + lcv + lcv2];
+				a = _mm_loadu_si128((__m128i *)p);
+				b = _mm_loadu_si128((__m128i *)(p + _h));
+
+				bfly_sse(&a, &b, wr, wi, _scale);
+
+				_mm_storeu_si128((__m128i *)p, a);
+				_mm_storeu_si128((__m128i *)(p + _h), b);
+			}
+		}
+
+}
+
+__attribute__ ((target("sse2")))
+static void pass_r4_sse(CPX *_x, int32 _count, int32 _stride, int32 *_wr0, int32 *_wi0, int32 *_wr1, int32 *_wi1, int32 _h, int32 _n, int32 _s0, int32 _s1)
+{
+
+	int32 lcv, lcv2, lcv3;
+	__m128i x0, x1, x2, x3, wr0, wi0, wr1, wi1, wr2, wi2;
+	CPX *p;
+
+	for(lcv = 0; lcv < _n; lcv += 4*_h)
+		for(lcv2 = 0; lcv2 < _h; lcv2 += 4)
+		{
+			wr0 = _mm_loadu_si128((__m128i *)&_wr0[lcv2]);
+			wi0 = _mm_loadu_si128((__m128i *)&_wi0[lcv2]);
+			wr1 = _mm_loadu_si128((__m128i *)&_wr1[lcv2]);
+			wi1 = _mm_loadu_si128((__m128i *)&_wi1[lcv2]);
+			wr2 = _mm_loadu_si128((__m128i *)&_wr1[lcv2 + _h]);
+			wi2 = _mm_loadu_si128((__m128i *)&_wi1[lcv2 + _h]);
+
+			for(lcv3 = 0; lcv3 < _count; lcv3++)
+			{
+				p = &_x[lcv3*_stride + lcv + lcv2];
+				x0 = _mm_loadu_si128((__m128i *)p);
+				x1 = _mm_loadu_si128((__m128i *)(p + _h));
+				x2 = _mm_loadu_si128((__m128i *)(p + 2*_h));
+				x3 = _mm_loadu_si128((__m128i *)(p + 3*_h));
+
+				bfly_sse(&x0, &x1, wr0, wi0, _s0);
+				bfly_sse(&x2, &x3, wr0, wi0, _s0);
+				bfly_sse(&x0, &x2, wr1, wi1, _s1);
+				bfly_sse(&x1, &x3, wr2, wi2, _s1);
+
+				_mm_storeu_si128((__m128i *)p, x0);
+				_mm_storeu_si128((__m128i *)(p + _h), x1);
+				_mm_storeu_si128((__m128i *)(p + 2*_h), x2);
+				_mm_storeu_si128((__m128i *)(p + 3*_h), x3);
+			}
+		}
+
+}
+
+/* Ranks 0 and 1 on 4 blocks at a time, one block per lane, then a 4x4 transpose puts each
+ * block's 4 points back next to each other. _n has to be at least 16. */
+__attribute__ ((target("sse2")))
+static void pass_first_sse(CPX *_x, CPX *_src, int32 *_br, int32 *_wr, int32 *_wi, int32 _n, int32 _s0, int32 _s1)
+{
+
+	int32 lcv;
+	int *s = (int *)_src;
+	int32 *br;
+	__m128i x0, x1, x2, x3, t0, t1, t2, t3;
+	__m128i wr0, wi0, wr1, wi1, wr2, wi2;
+
+	wr0 = _mm_set1_epi32(_wr[0]);	wi0 = _mm_set1_epi32(_wi[0]);
+	wr1 = _mm_set1_epi32(_wr[1]);	wi1 = _mm_set1_epi32(_wi[1]);
+	wr2 = _mm_set1_epi32(_wr[2]);	wi2 = _mm_set1_epi32(_wi[2]);
+
+	for(lcv = 0; lcv < _n; lcv += 16)
+	{
+		br = &_br[lcv];
+		x0 = _mm_setr_epi32(s[br[0]], s[br[4]], s[br[8]],  s[br[12]]);
+		x1 = _mm_setr_epi32(s[br[1]], s[br[5]], s[br[9]],  s[br[13]]);
+		x2 = _mm_setr_epi32(s[br[2]], s[br[6]], s[br[10]], s[br[14]]);
+		x3 = _mm_setr_epi32(s[br[3]], s[br[7]], s[br[11]], s[br[15]]);
+
+		bfly_sse(&x0, &x1, wr0, wi0, _s0);
+		bfly_sse(&x2, &x3, wr0, wi0, _s0);
+		bfly_sse(&x0, &x2, wr1, wi1, _s1);
+		bfly_sse(&x1, &x3, wr2, wi2, _s1);
+
+		t0 = _mm_unpacklo_epi32(x0, x1);
+		t1 = _mm_unpacklo_epi32(x2, x3);
+		t2 = _mm_unpackhi_epi32(x0, x1);
+		t3 = _mm_unpackhi_epi32(x2, x3);
+
+		_mm_storeu_si128((__m128i *)&_x[lcv],		_mm_unpacklo_epi64(t0, t1));
+		_mm_storeu_si128((__m128i *)&_x[lcv + 4],	_mm_unpackhi_epi64(t0, t1));
+		_mm_storeu_si128((__m128i *)&_x[lcv + 8],	_mm_unpacklo_epi64(t2, t3));
+		_mm_storeu_si128((__m128i *)&_x[lcv + 12],	_mm_unpackhi_epi64(t2, t3));
+	}
+
+}
+
+
+/* 8 at a time, packs and unpacks work within each 128 bit lane so the order still comes out right */
+__attribute__ ((target("avx2")))
+static inline void bfly_avx2(__m256i *_A, __m256i *_B, __m256i _wr, __m256i _wi, int32 _scale)
+{
+
+	__m256i a, b, re, im, t, rnd;
+
+	rnd = _mm256_set1_epi32(8192);
+	a = *_A;
+	b = *_B;
+
+	if(_scale)
+	{
+		a = _mm256_srai_epi16(a, 1);
+		b = _mm256_srai_epi16(b, 1);
+	}
+
+	re = _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(b, _wr), rnd), 14);
+	im = _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(b, _wi), rnd), 14);
+	t = _mm256_packs_epi32(_mm256_unpacklo_epi32(re, im), _mm256_unpackhi_epi32(re, im));
+
+	*_A = _mm256_add_epi16(a, t);
+	*_B = _mm256_sub_epi16(a, t);
+
+}
+
+__attribute__ ((target("avx2")))
+static void pass_r2_avx2(CPX *_x, int32 _count, int32 _stride, int32 *_wr, int32 *_wi, int32 _h, int32 _n, int32 _scale)
+{
+
+	int32 lcv, lcv2, lcv3;
+	__m256i a, b, wr, wi;
+	CPX *p;
+
+	for(lcv = 0; lcv < _n; lcv += 2*_h)
+		for(lcv2 = 0; lcv2 < _h; lcv2 += 8)
+		{
+			wr = _mm256_loadu_si256((__m256i *)&_wr[lcv2]);
+			wi = _mm256_loadu_si256((__m256i *)&_wi[lcv2]);
+
+			for(lcv3 = 0; lcv3 < _count; lcv3++)
+			{
+				p = &_x[lcv3*_stride + lcv + lcv2];
+				a = _mm256_loadu_si256((__m256i *)p);
+				b = _mm256_loadu_si256((__m256i *)(p + _h));
+
+				bfly_avx2(&a, &b, wr, wi, _scale);
+
+				_mm256_storeu_si256((__m256i *)p, a);
+				_mm256_storeu_si256((__m256i *)(p + _h), b);
+			}
+		}
+
+}
+
+__attribute__ ((target("avx2")))
+static void pass_r4_avx2(CPX *_x, int32 _count, int32 _stride, int32 *_wr0, int32 *_wi0, int32 *_wr1, int32 *_wi1, int32 _h, int32 _n, int32 _s0, int32 _s1)
+{
+
+	int32 lcv, lcv2, lcv3;
+	__m256i x0, x1, x2, x3, wr0, wi0, wr1, wi1, wr2, wi2;
+	CPX *p;
+
+	for(lcv = 0; lcv < _n; lcv += 4*_h)
+		for(lcv2 = 0; lcv2 < _h; lcv2 += 8)
+		{
+			wr0 = _mm256_loadu_si256((__m256i *)&_wr0[lcv2]);
+			wi0 = _mm256_loadu_si256((__m256i *)&_wi0[lcv2]);
+			wr1 = _mm256_loadu_si256((__m256i *)&_wr1[lcv2]);
+			wi1 = _mm256_loadu_si256((__m256i *)&_wi1[lcv2]);
+			wr2 = _mm256_loadu_si256((__m256i *)&_wr1[lcv2 + _h]);
+			wi2 = _mm256_loadu_si256((__m256i *)&_wi1[lcv2 + _h]);
+
+			for(lcv3 = 0; lcv3 < _count; lcv3++)
+			{
+				p = &_x[lcv3*_stride + lcv + lcv2];
+				x0 = _mm256_loadu_si256((__m256i *)p);
+				x1 = _mm256_loadu_si256((__m256i *)(p + _h));
+				x2 = _mm256_loadu_si256((__m256i *)(p + 2*_h));
+				x3 = _mm256_loadu_si256((__m256i *)(p + 3*_h));
+
+				bfly_avx2(&x0, &x1, wr0, wi0, _s0);
+				bfly_avx2(&x2, &x3, wr0, wi0, _s0);
+				bfly_avx2(&x0, &x2, wr1, wi1, _s1);
+				bfly_avx2(&x1, &x3, wr2, wi2, _s1);
+
+				_mm256_storeu_si256((__m256i *)p, x0);
+				_mm256_storeu_si256((__m256i *)(p + _h), x1);
+				_mm256_storeu_si256((__m256i *)(p + 2*_h), x2);
+				_mm256_storeu_si256((__m256i *)(p + 3*_h), x3);
+			}
+		}
+
+}
+
+
+/* Ranks 0 and 1 on 8 blocks at a time, gathered straight out of bit reversed order, then
+ * transposed back as in pass_first_sse. _n has to be at least 32. */
+__attribute__ ((target("avx2")))
+static void pass_first_avx2(CPX *_x, CPX *_src, int32 *_br, int32 *_wr, int32 *_wi, int32 _n, int32 _s0, int32 _s1)
+{
+
+	int32 lcv;
+	__m256i x0, x1, x2, x3, t0, t1, t2, t3;
+	__m256i i0, i1, i2, i3;
+	__m256i wr0, wi0, wr1, wi1, wr2, wi2;
+
+	wr0 = _mm256_set1_epi32(_wr[0]);	wi0 = _mm256_set1_epi32(_wi[0]);
+	wr1 = _mm256_set1_epi32(_wr[1]);	wi1 = _mm256_set1_epi32(_wi[1]);
+	wr2 = _mm256_set1_epi32(_wr[2]);	wi2 = _mm256_set1_epi32(_wi[2]);
+
+	/* Lane e takes point k of block e */
+	i0 = _mm256_setr_epi32(0, 4, 8, 12, 16, 20, 24, 28);
+	i1 = _mm256_add_epi32(i0, _mm256_set1_epi32(1));
+	i2 = _mm256_add_epi32(i0, _mm256_set1_epi32(2));
+	i3 = _mm256_add_epi32(i0, _mm256_set1_epi32(3));
+
+	for(lcv = 0; lcv < _n; lcv += 32)
+	{
+		x0 = _mm256_i32gather_epi32((int *)_src, _mm256_i32gather_epi32((int *)&_br[lcv], i0, 4), 4);
+		x1 = _mm256_i32gather_epi32((int *)_src, _mm256_i32gather_epi32((int *)&_br[lcv], i1, 4), 4);
+		x2 = _mm256_i32gather_epi32((int *)_src, _mm256_i32gather_epi32((int *)&_br[lcv], i2, 4), 4);
+		x3 = _mm256_i32gather_epi32((int *)_src, _mm256_i32gather_epi32((int *)&_br[lcv], i3, 4), 4);
+
+		bfly_avx2(&x0, &x1, wr0, wi0, _s0);
+		bfly_avx2(&x2, &x3, wr0, wi0, _s0);
+		bfly_avx2(&x0, &x2, wr1, wi1, _s1);
+		bfly_avx2(&x1, &x3, wr2, wi2, _s1);
+
+		/* 4x4 within each 128 bit lane leaves blocks 4L..4L+3 in lane L of t0..t3 */
+		t0 = _mm256_unpacklo_epi32(x0, x1);
+		t1 = _mm256_unpacklo_epi32(x2, x3);
+		t2 = _mm256_unpackhi_epi32(x0, x1);
+		t3 = _mm256_unpackhi_epi32(x2, x3);
+
+		x0 = _mm256_unpacklo_epi64(t0, t1);
+		x1 = _mm256_unpackhi_epi64(t0, t1);
+		x2 = _mm256_unpacklo_epi64(t2, t3);
+		x3 = _mm256_unpackhi_epi64(t2, t3);
+
+		_mm256_storeu_si256((__m256i *)&_x[lcv],		_mm256_permute2x128_si256(x0, x1, 0x20));
+		_mm256_storeu_si256((__m256i *)&_x[lcv + 8],	_mm256_permute2x128_si256(x2, x3, 0x20));
+		_mm256_storeu_si256((__m256i *)&_x[lcv + 16],	_mm256_permute2x128_si256(x0, x1, 0x31));
+		_mm256_storeu_si256((__m256i *)&_x[lcv + 24],	_mm256_permute2x128_si256(x2, x3, 0x31));
+	}
+
+}
+
+/* Ranks 2 and 3, where the 4 point blocks would only fill half a register, so two 16 point
+ * blocks share each one, a block per lane. _n has to be at least 32. */
+__attribute__ ((target("avx2")))
+static void pass_r4_h4_avx2(CPX *_x, int32 _count, int32 _stride, int32 *_wr0, int32 *_wi0, int32 *_wr1, int32 *_wi1, int32 _n, int32 _s0, int32 _s1)
+{
+
+	int32 lcv, lcv3;
+	__m256i a0, a1, a2, a3, x0, x1, x2, x3;
+	__m256i wr0, wi0, wr1, wi1, wr2, wi2;
+	CPX *p;
+
+	wr0 = _mm256_broadcastsi128_si256(_mm_loadu_si128((__m128i *)&_wr0[0]));
+	wi0 = _mm256_broadcastsi128_si256(_mm_loadu_si128((__m128i *)&_wi0[0]));
+	wr1 = _mm256_broadcastsi128_si256(_mm_loadu_si128((__m128i *)&_wr1[0]));
+	wi1 = _mm256_broadcastsi128_si256(_mm_loadu_si128((__m128i *)&_wi1[0]));
+	wr2 = _mm256_broadcastsi128_si256(_mm_loadu_si128((__m128i *)&_wr1[4]));
+	wi2 = _mm256_broadcastsi128_si256(_mm_loadu_si128((__m128i *)&_wi1[4]));
+
+	for(lcv3 = 0; lcv3 < _count; lcv3++)
+		for(lcv = 0; lcv < _n; lcv += 32)
+		{
+			p = &_x[lcv3*_stride + lcv];
+			a0 = _mm256_loadu_si256((__m256i *)p);
+			a1 = _mm256_loadu_si256((__m256i *)(p + 8));
+			a2 = _mm256_loadu_si256((__m256i *)(p + 16));
+			a3 = _mm256_loadu_si256((__m256i *)(p + 24));
+
+			x0 = _mm256_permute2x128_si256(a0, a2, 0x20);
+			x1 = _mm256_permute2x128_si256(a0, a2, 0x31);
+			x2 = _mm256_permute2x128_si256(a1, a3, 0x20);
+			x3 = _mm256_permute2x128_si256(a1, a3, 0x31);
+
+			bfly_avx2(&x0, &x1, wr0, wi0, _s0);
+			bfly_avx2(&x2, &x3, wr0, wi0, _s0);
+			bfly_avx2(&x0, &x2, wr1, wi1, _s1);
+			bfly_avx2(&x1, &x3, wr2, wi2, _s1);
+
+			_mm256_storeu_si256((__m256i *)p,			_mm256_permute2x128_si256(x0, x1, 0x20));
+			_mm256_storeu_si256((__m256i *)(p + 8),		_mm256_permute2x128_si256(x2, x3, 0x20));
+			_mm256_storeu_si256((__m256i *)(p + 16),	_mm256_permute2x128_si256(x0, x1, 0x31));
+			_mm256_storeu_si256((__m256i *)(p + 24),	_mm256_permute2x128_si256(x2, x3, 0x31));
+		}
+
+}
+
+
+/* 16 at a time */
+__attribute__ ((target("avx512f,avx512bw")))
+static inline void bfly_avx512(__m512i *_A, __m512i *_B, __m512i _wr, __m512i _wi, int32 _scale)
+{
+
+	__m512i a, b, re, im, t, rnd;
+
+	rnd = _mm512_set1_epi32(8192);
+	a = *_A;
+	b = *_B;
+
+	if(_scale)
+	{
+		a = _mm512_srai_epi16(a, 1);
+		b = _mm512_srai_epi16(b, 1);
+	}
+
+	re = _mm512_srai_epi32(_mm512_add_epi32(_mm512_madd_epi16(b, _wr), rnd), 14);
+	im = _mm512_srai_epi32(_mm512_add_epi32(_mm512_madd_epi16(b, _wi), rnd), 14);
+	t = _mm512_packs_epi32(_mm512_unpacklo_epi32(re, im), _mm512_unpackhi_epi32(re, im));
+
+	*_A = _mm512_add_epi16(a, t);
+	*_B = _mm512_sub_epi16(a, t);
+
+}
+
+__attribute__ ((target("avx512f,avx512bw")))
+static void pass_r2_avx512(CPX *_x, int32 _count, int32 _stride, int32 *_wr, int32 *_wi, int32 _h, int32 _n, int32 _scale)
+{
+
+	int32 lcv, lcv2, lcv3;
+	__m512i a, b, wr, wi;
+	CPX *p;
+
+	for(lcv = 0; lcv < _n; lcv += 2*_h)
+		for(lcv2 = 0; lcv2 < _h; lcv2 += 16)
+		{
+			wr = _mm512_loadu_si512((void *)&_wr[lcv2]);
+			wi = _mm512_loadu_si512((void *)&_wi[lcv2]);
+
+			for(lcv3 = 0; lcv3 < _count; lcv3++)
+			{
+				p = &_x[lcv3*_stride + lcv + lcv2];
+				a = _mm512_loadu_si512((void *)p);
+				b = _mm512_loadu_si512((void *)(p + _h));
+
+				bfly_avx512(&a, &b, wr, wi, _scale);
+
+				_mm512_storeu_si512((void *)p, a);
+				_mm512_storeu_si512((void *)(p + _h), b);
+			}
+		}
+
+}
+
+__attribute__ ((target("avx512f,avx512bw")))
+static void pass_r4_avx512(CPX *_x, int32 _count, int32 _stride, int32 *_wr0, int32 *_wi0, int32 *_wr1, int32 *_wi1, int32 _h, int32 _n, int32 _s0, int32 _s1)
+{
+
+	int32 lcv, lcv2, lcv3;
+	__m512i x0, x1, x2, x3, wr0, wi0, wr1, wi1, wr2, wi2;
+	CPX *p;
+
+	for(lcv = 0; lcv < _n; lcv += 4*_h)
+		for(lcv2 = 0; lcv2 < _h; lcv2 += 16)
+		{
+			wr0 = _mm512_loadu_si512((void *)&_wr0[lcv2]);
+			wi0 = _mm512_loadu_si512((void *)&_wi0[lcv2]);
+			wr1 = _mm512_loadu_si512((void *)&_wr1[lcv2]);
+			wi1 = _mm512_loadu_si512((void *)&_wi1[lcv2]);
+			wr2 = _mm512_loadu_si512((void *)&_wr1[lcv2 + _h]);
+			wi2 = _mm512_loadu_si512((void *)&_wi1[lcv2 + _h]);
+
+			for(lcv3 = 0; lcv3 < _count; lcv3++)
+			{
+				p = &_x[lcv3*_stride + lcv + lcv2];
+				x0 = _mm512_loadu_si512((void *)p);
+				x1 = _mm512_loadu_si512((void *)(p + _h));
+				x2 = _mm512_loadu_si512((void *)(p + 2*_h));
+				x3 = _mm512_loadu_si512((void *)(p + 3*_h));
+
+				bfly_avx512(&x0, &x1, wr0, wi0, _s0);
+				bfly_avx512(&x2, &x3, wr0, wi0, _s0);
+				bfly_avx512(&x0, &x2, wr1, wi1, _s1);
+				bfly_avx512(&x1, &x3, wr2, wi2, _s1);
+
+				_mm512_storeu_si512((void *)p, x0);
+				_mm512_storeu_si512((void *)(p + _h), x1);
+				_mm512_storeu_si512((void *)(p + 2*_h), x2);
+				_mm512_storeu_si512((void *)(p + 3*_h), x3);
+			}
+		}
+
+}
+
+
+/* Swap the 128 bit lanes of 4 registers as a 4x4 matrix, lane j of _x[i] ends up in lane i of _x[j] */
+__attribute__ ((target("avx512f,avx512bw")))
+static inline void lanes_avx512(__m512i *_x0, __m512i *_x1, __m512i *_x2, __m512i *_x3)
+{
+
+	__m512i u0, u1, u2, u3;
+
+	u0 = _mm512_shuffle_i32x4(*_x0, *_x1, 0x44);
+	u1 = _mm512_shuffle_i32x4(*_x2, *_x3, 0x44);
+	u2 = _mm512_shuffle_i32x4(*_x0, *_x1, 0xee);
+	u3 = _mm512_shuffle_i32x4(*_x2, *_x3, 0xee);
+
+	*_x0 = _mm512_shuffle_i32x4(u0, u1, 0x88);
+	*_x1 = _mm512_shuffle_i32x4(u0, u1, 0xdd);
+	*_x2 = _mm512_shuffle_i32x4(u2, u3, 0x88);
+	*_x3 = _mm512_shuffle_i32x4(u2, u3, 0xdd);
+
+}
+
+/* Ranks 0 and 1 on 16 blocks at a time, as pass_first_avx2. _n has to be at least 64. */
+__attribute__ ((target("avx512f,avx512bw")))
+static void pass_first_avx512(CPX *_x, CPX *_src, int32 *_br, int32 *_wr, int32 *_wi, int32 _n, int32 _s0, int32 _s1)
+{
+
+	int32 lcv;
+	__m512i x0, x1, x2, x3, t0, t1, t2, t3;
+	__m512i i0, i1, i2, i3;
+	__m512i wr0, wi0, wr1, wi1, wr2, wi2;
+
+	wr0 = _mm512_set1_epi32(_wr[0]);	wi0 = _mm512_set1_epi32(_wi[0]);
+	wr1 = _mm512_set1_epi32(_wr[1]);	wi1 = _mm512_set1_epi32(_wi[1]);
+	wr2 = _mm512_set1_epi32(_wr[2]);	wi2 = _mm512_set1_epi32(_wi[2]);
+
+	/* Lane e takes point k of block e */
+	i0 = _mm512_setr_epi32(0, 4, 8, 12, 16, 20, 24, 28, 32, 36, 40, 44, 48, 52, 56, 60);
+	i1 = _mm512_add_epi32(i0, _mm512_set1_epi32(1));
+	i2 = _mm512_add_epi32(i0, _mm512_set1_epi32(2));
+	i3 = _mm512_add_epi32(i0, _mm512_set1_epi32(3));
+
+	for(lcv = 0; lcv < _n; lcv += 64)
+	{
+		x0 = _mm512_i32gather_epi32(_mm512_i32gather_epi32(i0, (void *)&_br[lcv], 4), (void *)_src, 4);
+		x1 = _mm512_i32gather_epi32(_mm512_i32gather_epi32(i1, (void *)&_br[lcv], 4), (void *)_src, 4);
+		x2 = _mm512_i32gather_epi32(_mm512_i32gather_epi32(i2, (void *)&_br[lcv], 4), (void *)_src, 4);
+		x3 = _mm512_i32gather_epi32(_mm512_i32gather_epi32(i3, (void *)&_br[lcv], 4), (void *)_src, 4);
+
+		bfly_avx512(&x0, &x1, wr0, wi0, _s0);
+		bfly_avx512(&x2, &x3, wr0, wi0, _s0);
+		bfly_avx512(&x0, &x2, wr1, wi1, _s1);
+		bfly_avx512(&x1, &x3, wr2, wi2, _s1);
+
+		t0 = _mm512_unpacklo_epi32(x0, x1);
+		t1 = _mm512_unpacklo_epi32(x2, x3);
+		t2 = _mm512_unpackhi_epi32(x0, x1);
+		t3 = _mm512_unpackhi_epi32(x2, x3);
+
+		x0 = _mm512_unpacklo_epi64(t0, t1);
+		x1 = _mm512_unpackhi_epi64(t0, t1);
+		x2 = _mm512_unpacklo_epi64(t2, t3);
+		x3 = _mm512_unpackhi_epi64(t2, t3);
+
+		lanes_avx512(&x0, &x1, &x2, &x3);
+
+		_mm512_storeu_si512((void *)&_x[lcv],		x0);
+		_mm512_storeu_si512((void *)&_x[lcv + 16],	x1);
+		_mm512_storeu_si512((void *)&_x[lcv + 32],	x2);
+		_mm512_storeu_si512((void *)&_x[lcv + 48],	x3);
+	}
+
+}
+
+/* Ranks 2 and 3 with four 16 point blocks sharing each register, as pass_r4_h4_avx2. _n has to
+ * be at least 64. */
+__attribute__ ((target("avx512f,avx512bw")))
+static void pass_r4_h4_avx512(CPX *_x, int32 _count, int32 _stride, int32 *_wr0, int32 *_wi0, int32 *_wr1, int32 *_wi1, int32 _n, int32 _s0, int32 _s1)
+{
+
+	int32 lcv, lcv3;
+	__m512i x0, x1, x2, x3;
+	__m512i wr0, wi0, wr1, wi1, wr2, wi2;
+	CPX *p;
+
+	wr0 = _mm512_broadcast_i32x4(_mm_loadu_si128((__m128i *)&_wr0[0]));
+	wi0 = _mm512_broadcast_i32x4(_mm_loadu_si128((__m128i *)&_wi0[0]));
+	wr1 = _mm512_broadcast_i32x4(_mm_loadu_si128((__m128i *)&_wr1[0]));
+	wi1 = _mm512_broadcast_i32x4(_mm_loadu_si128((__m128i *)&_wi1[0]));
+	wr2 = _mm512_broadcast_i32x4(_mm_loadu_si128((__m128i *)&_wr1[4]));
+	wi2 = _mm512_broadcast_i32x4(_mm_loadu_si128((__m128i *)&_wi1[4]));
+
+	for(lcv3 = 0; lcv3 < _count; lcv3++)
+		for(lcv = 0; lcv < _n; lcv += 64)
+		{
+			p = &_x[lcv3*_stride + lcv];
+			x0 = _mm512_loadu_si512((void *)p);
+			x1 = _mm512_loadu_si512((void *)(p + 16));
+			x2 = _mm512_loadu_si512((void *)(p + 32));
+			x3 = _mm512_loadu_si512((void *)(p + 48));
+
+			lanes_avx512(&x0, &x1, &x2, &x3);
+
+			bfly_avx512(&x0, &x1, wr0, wi0, _s0);
+			bfly_avx512(&x2, &x3, wr0, wi0, _s0);
+			bfly_avx512(&x0, &x2, wr1, wi1, _s1);
+			bfly_avx512(&x1, &x3, wr2, wi2, _s1);
+
+			lanes_avx512(&x0, &x1, &x2, &x3);
+
+			_mm512_storeu_si512((void *)p,			x0);
+			_mm512_storeu_si512((void *)(p + 16),	x1);
+			_mm512_storeu_si512((void *)(p + 32),	x2);
+			_mm512_storeu_si512((void *)(p + 48),	x3);
+		}
+
+}
+
+
+void FFT::initRanks()
+{
+
+	int32 lcv, lcv2, h;
+	MIX *w;
+
+	/* Rank s uses W[k*N/2^(s+1)] for k < 2^s, laid out from 2^s - 1 on */
+	Wr = (int32 *)malloc(N*sizeof(int32));
+	Wi = (int32 *)malloc(N*sizeof(int32));
+	iWr = (int32 *)malloc(N*sizeof(int32));
+	iWi = (int32 *)malloc(N*sizeof(int32));
+
+	for(lcv = 0; lcv < M; lcv++)
+	{
+		h = 1 << lcv;
+		for(lcv2 = 0; lcv2 < h; lcv2++)
+		{
+			w = &W[lcv2*(N/(2*h))];
+			Wr[h-1+lcv2] = (int32)(((uint32)(uint16)w->nq << 16) | (uint16)w->i);
+			Wi[h-1+lcv2] = (int32)(((uint32)(uint16)w->ni << 16) | (uint16)w->q);
+
+			w = &iW[lcv2*(N/(2*h))];
+			iWr[h-1+lcv2] = (int32)(((uint32)(uint16)w->nq << 16) | (uint16)w->i);
+			iWi[h-1+lcv2] = (int32)(((uint32)(uint16)w->ni << 16) | (uint16)w->q);
+		}
+	}
+
+#ifdef NO_SIMD
+	width = 1;
+#else
+	if(CPU_AVX512())
+		width = 16;
+	else if(CPU_AVX2())
+		width = 8;
+	else
+		width = 4;
+#endif
+
+	batch = FFT_BATCH_BYTES/(N*sizeof(CPX));
+	if(batch < 1)
+		batch = 1;
+
+}
+
+
+void FFT::doRanks(CPX *_x, int32 _count, int32 _stride, int32 *_wr, int32 *_wi, bool _shuf)
+{
+
+	int32 lcv, lcv2, h, rows;
+	CPX *x, *p;
+
+	/* Run every pass over a chunk of vectors before moving on, so each twiddle load is shared
+	 * by the whole chunk while the chunk itself stays in cache */
+	for(lcv2 = 0; lcv2 < _count; lcv2 += batch)
+	{
+		x = _x + lcv2*_stride;
+		rows = _count - lcv2 < batch ? _count - lcv2 : batch;
+
+		/* Ranks 0 and 1 */
+		if(_shuf)
+		{
+			for(lcv = 0; lcv < rows; lcv++)
+			{
+				p = x + lcv*_stride;
+				memcpy(BRX, p, N*sizeof(CPX));
+
+				if((width >= 16) && (N >= 64))
+					pass_first_avx512(p, (CPX *)BRX, BR, _wr, _wi, N, R[0], R[1]);
+				else if((width >= 8) && (N >= 32))
+					pass_first_avx2(p, (CPX *)BRX, BR, _wr, _wi, N, R[0], R[1]);
+				else if((width >= 4) && (N >= 16))
+					pass_first_sse(p, (CPX *)BRX, BR, _wr, _wi, N, R[0], R[1]);
+				else
+					pass_first_x86(p, (CPX *)BRX, BR, _wr, _wi, N, R[0], R[1]);
+			}
+		}
+		else
+			pass_r4_x86(x, rows, _stride, &_wr[0], &_wi[0], &_wr[1], &_wi[1], 1, N, R[0], R[1]);
+
+		/* The rest in pairs, on the widest unit that fits the blocks */
+		for(lcv = 2; lcv + 1 < M; lcv += 2)
+		{
+			h = 1 << lcv;
+
+			if((width >= 16) && (h >= 16))
+				pass_r4_avx512(x, rows, _stride, &_wr[h-1], &_wi[h-1], &_wr[2*h-1], &_wi[2*h-1], h, N, R[lcv], R[lcv+1]);
+			else if((width >= 16) && (h == 4) && (N >= 64))
+				pass_r4_h4_avx512(x, rows, _stride, &_wr[h-1], &_wi[h-1], &_wr[2*h-1], &_wi[2*h-1], N, R[lcv], R[lcv+1]);
+			else if((width >= 8) && (h == 4) && (N >= 32))
+				pass_r4_h4_avx2(x, rows, _stride, &_wr[h-1], &_wi[h-1], &_wr[2*h-1], &_wi[2*h-1], N, R[lcv], R[lcv+1]);
+			else if((width >= 8) && (h >= 8))
+				pass_r4_avx2(x, rows, _stride, &_wr[h-1], &_wi[h-1], &_wr[2*h-1], &_wi[2*h-1], h, N, R[lcv], R[lcv+1]);
+			else if(width >= 4)
+				pass_r4_sse(x, rows, _stride, &_wr[h-1], &_wi[h-1], &_wr[2*h-1], &_wi[2*h-1], h, N, R[lcv], R[lcv+1]);
+			else
+				pass_r4_x86(x, rows, _stride, &_wr[h-1], &_wi[h-1], &_wr[2*h-1], &_wi[2*h-1], h, N, R[lcv], R[lcv+1]);
+		}
+
+		/* An odd rank left over */
+		if(lcv < M)
+		{
+			h = 1 << lcv;
+
+			if((width >= 16) && (h >= 16))
+				pass_r2_avx512(x, rows, _stride, &_wr[h-1], &_wi[h-1], h, N, R[lcv]);
+			else if((width >= 8) && (h >= 8))
+				pass_r2_avx2(x, rows, _stride, &_wr[h-1], &_wi[h-1], h, N, R[lcv]);
+			else if(width >= 4)
+				pass_r2_sse(x, rows, _stride, &_wr[h-1], &_wi[h-1], h, N, R[lcv]);
+			else
+				pass_r2_x86(x, rows, _stride, &_wr[h-1], &_wi[h-1], h, N, R[lcv]);
+		}
+	}
+
+}
+
+
+/* Sizes that are not a power of 2, 2000, 4000, 5000 or 8000 samples/ms say, are factored into
+ * radix 4, 2, 3 and 5 stages run self sorting (Stockham), so there is no reordering and the
+ * input and output are both in natural order. The data is carried as 32 bit [Re Im] pairs so
+ * nothing saturates along the way, and the R[] of the ranks 2^M would need are added up into a
+ * single shift taken at the end. The inverse is the forward transform of the conjugate. */
+
+#define MIX_Q14(_x, _k) ((int32)(((int64)(_x)*(_k) + 8192) >> 14))
+
+static const int32 C3  = 14189;		//!< sin(2pi/3) in Q14
+static const int32 C51 = 5063;		//!< cos(2pi/5) in Q14
+static const int32 C52 = -13255;	//!< cos(4pi/5) in Q14
+static const int32 S51 = 15582;		//!< sin(2pi/5) in Q14
+static const int32 S52 = 9630;		//!< sin(4pi/5) in Q14
+
+/* Multiply _y[l] by the stage twiddle _w[l-1] on the way out */
+static inline void twiddle_out(int32 *_y, int32 _re, int32 _im, int32 *_w)
+{
+
+	_y[0] = (int32)(((int64)_re*_w[0] - (int64)_im*_w[1] + 8192) >> 14);
+	_y[1] = (int32)(((int64)_re*_w[1] + (int64)_im*_w[0] + 8192) >> 14);
+
+}
+
+/* One butterfly, reading _a[j*_sm] and writing _y[l*_ys] */
+static inline void bfly_r2(int32 *_a, int32 *_y, int32 *_w, int32 _sm, int32 _ys)
+{
+
+	_y[0] = _a[0] + _a[_sm];
+	_y[1] = _a[1] + _a[_sm+1];
+	twiddle_out(_y + _ys, _a[0] - _a[_sm], _a[1] - _a[_sm+1], _w);
+
+}
+
+static inline void bfly_r4(int32 *_a, int32 *_y, int32 *_w, int32 _sm, int32 _ys)
+{
+
+	int32 t0r, t0i, t1r, t1i, t2r, t2i, t3r, t3i;
+
+	t0r = _a[0] + _a[2*_sm];		t0i = _a[1] + _a[2*_sm+1];
+	t1r = _a[0] - _a[2*_sm];		t1i = _a[1] - _a[2*_sm+1];
+	t2r = _a[_sm] + _a[3*_sm];		t2i = _a[_sm+1] + _a[3*_sm+1];
+	t3r = _a[_sm] - _a[3*_sm];		t3i = _a[_sm+1] - _a[3*_sm+1];
+
+	_y[0] = t0r + t2r;
+	_y[1] = t0i + t2i;
+	twiddle_out(_y + _ys, t1r + t3i, t1i - t3r, &_w[0]);
+	twiddle_out(_y + 2*_ys, t0r - t2r, t0i - t2i, &_w[2]);
+	twiddle_out(_y + 3*_ys, t1r - t3i, t1i + t3r, &_w[4]);
+
+}
+
+static inline void bfly_r3(int32 *_a, int32 *_y, int32 *_w, int32 _sm, int32 _ys)
+{
+
+	int32 sr, si, dr, di, mr, mi;
+
+	sr = _a[_sm] + _a[2*_sm];		si = _a[_sm+1] + _a[2*_sm+1];
+	dr = MIX_Q14(_a[_sm] - _a[2*_sm], C3);
+	di = MIX_Q14(_a[_sm+1] - _a[2*_sm+1], C3);
+	mr = _a[0] - MIX_Q14(sr, 8192);
+	mi = _a[1] - MIX_Q14(si, 8192);
+
+	_y[0] = _a[0] + sr;
+	_y[1] = _a[1] + si;
+	twiddle_out(_y + _ys, mr + di, mi - dr, &_w[0]);
+	twiddle_out(_y + 2*_ys, mr - di, mi + dr, &_w[2]);
+
+}
+
+static inline void bfly_r5(int32 *_a, int32 *_y, int32 *_w, int32 _sm, int32 _ys)
+{
+
+	int32 s1r, s1i, s2r, s2i, d1r, d1i, d2r, d2i;
+	int32 m1r, m1i, m2r, m2i, n1r, n1i, n2r, n2i;
+
+	s1r = _a[_sm] + _a[4*_sm];		s1i = _a[_sm+1] + _a[4*_sm+1];
+	d1r = _a[_sm] - _a[4*_sm];		d1i = _a[_sm+1] - _a[4*_sm+1];
+	s2r = _a[2*_sm] + _a[3*_sm];	s2i = _a[2*_sm+1] + _a[3*_sm+1];
+	d2r = _a[2*_sm] - _a[3*_sm];	d2i = _a[2*_sm+1] - _a[3*_sm+1];
+
+	m1r = _a[0] + MIX_Q14(s1r, C51) + MIX_Q14(s2r, C52);
+	m1i = _a[1] + MIX_Q14(s1i, C51) + MIX_Q14(s2i, C52);
+	m2r = _a[0] + MIX_Q14(s1r, C52) + MIX_Q14(s2r, C51);
+	m2i = _a[1] + MIX_Q14(s1i, C52) + MIX_Q14(s2i, C51);
+	n1r = MIX_Q14(d1r, S51) + MIX_Q14(d2r, S52);
+	n1i = MIX_Q14(d1i, S51) + MIX_Q14(d2i, S52);
+	n2r = MIX_Q14(d1r, S52) - MIX_Q14(d2r, S51);
+	n2i = MIX_Q14(d1i, S52) - MIX_Q14(d2i, S51);
+
+	_y[0] = _a[0] + s1r + s2r;
+	_y[1] = _a[1] + s1i + s2i;
+	twiddle_out(_y + _ys, m1r + n1i, m1i - n1r, &_w[0]);
+	twiddle_out(_y + 2*_ys, m2r + n2i, m2i - n2r, &_w[2]);
+	twiddle_out(_y + 3*_ys, m2r - n2i, m2i + n2r, &_w[4]);
+	twiddle_out(_y + 4*_ys, m1r - n1i, m1i + n1r, &_w[6]);
+
+}
+
+static inline void bfly_mixed(int32 _p, int32 *_a, int32 *_y, int32 *_w, int32 _sm, int32 _ys)
+{
+
+	switch(_p)
+	{
+		case 4: bfly_r4(_a, _y, _w, _sm, _ys); break;
+		case 2: bfly_r2(_a, _y, _w, _sm, _ys); break;
+		case 3: bfly_r3(_a, _y, _w, _sm, _ys); break;
+		case 5: bfly_r5(_a, _y, _w, _sm, _ys); break;
+	}
+
+}
+
+/* One stage, _m groups of _s butterflies, reading _x[k + s*(q + m*j)] and writing _y[k + s*(p*q + l)] */
+static void stage_x86(int32 *_x, int32 *_y, int32 *_w, int32 _p, int32 _m, int32 _s)
+{
+
+	int32 q, k, sm;
+
+	sm = 2*_s*_m;
+
+	for(q = 0; q < _m; q++, _w += 2*(_p-1))
+		for(k = 0; k < _s; k++)
+			bfly_mixed(_p, &_x[2*(k + _s*q)], &_y[2*(k + _s*_p*q)], _w, sm, 2*_s);
+
+}
+
+
+/* The SIMD stages keep the real and imaginary parts in separate registers and give the same
+ * results bit for bit. A Q14 product is split as x = H*2^15 + L, with L the low 15 bits, so both
+ * halves fit the 16 bit words of pmaddwd and (x*k + 8192) >> 14 is exactly 2*(H*k) + ((L*k +
+ * 8192) >> 14). H only fits while |x| < 2^30, which a transform of int16 data holds up to 16384
+ * points, longer ones run stage_x86(). The twiddles are packed into TWr and TWi as [Re -Im] and
+ * [Im Re] words the way Wr and Wi are for the ranks. */
+
+__attribute__ ((target("sse2")))
+static inline void load_mixed_sse(int32 *_p, __m128i *_re, __m128i *_im)
+{
+
+	__m128i a, b;
+
+	a = _mm_shuffle_epi32(_mm_loadu_si128((__m128i *)_p), 0xD8);
+	b = _mm_shuffle_epi32(_mm_loadu_si128((__m128i *)(_p + 4)), 0xD8);
+	*_re = _mm_unpacklo_epi64(a, b);
+	*_im = _mm_unpackhi_epi64(a, b);
+
+}
+
+__attribute__ ((target("sse2")))
+static inline void store_mixed_sse(int32 *_p, __m128i _re, __m128i _im)
+{
+
+	_mm_storeu_si128((__m128i *)_p, _mm_unpacklo_epi32(_re, _im));
+	_mm_storeu_si128((__m128i *)(_p + 4), _mm_unpackhi_epi32(_re, _im));
+
+}
+
+/* MIX_Q14(_x, _k) */
+__attribute__ ((target("sse2")))
+static inline __m128i mulq14_sse(__m128i _x, int32 _k)
+{
+
+	__m128i x, hi, lo;
+
+	x = _mm_or_si128(_mm_and_si128(_x, _mm_set1_epi32(0x7fff)), _mm_slli_epi32(_mm_srai_epi32(_x, 15), 16));
+	hi = _mm_madd_epi16(x, _mm_set1_epi32(_k << 16));
+	lo = _mm_madd_epi16(x, _mm_set1_epi32(_k & 0xffff));
+
+	return(_mm_add_epi32(_mm_slli_epi32(hi, 1), _mm_srai_epi32(_mm_add_epi32(lo, _mm_set1_epi32(8192)), 14)));
+
+}
+
+/* twiddle_out() */
+__attribute__ ((target("sse2")))
+static inline void twiddle_sse(__m128i *_re, __m128i *_im, __m128i _wr, __m128i _wi)
+{
+
+	__m128i l, h, rnd;
+
+	rnd = _mm_set1_epi32(8192);
+	l = _mm_and_si128(_mm_set1_epi32(0x7fff), *_re);
+	l = _mm_or_si128(l, _mm_slli_epi32(_mm_and_si128(_mm_set1_epi32(0x7fff), *_im), 16));
+	h = _mm_and_si128(_mm_set1_epi32(0xffff), _mm_srai_epi32(*_re, 15));
+	h = _mm_or_si128(h, _mm_slli_epi32(_mm_srai_epi32(*_im, 15), 16));
+
+	*_re = _mm_add_epi32(_mm_slli_epi32(_mm_madd_epi16(h, _wr), 1), _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(l, _wr), rnd), 14));
+	*_im = _mm_add_epi32(_mm_slli_epi32(_mm_madd_epi16(h, _wi), 1), _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(l, _wi), rnd), 14));
+
+}
+
+/* bfly_r2() to bfly_r5() on the _p inputs in _re and _im, the outputs are left in their place */
+__attribute__ ((target("sse2")))
+static inline void bfly_mixed_sse(__m128i *_re, __m128i *_im, __m128i *_wr, __m128i *_wi, const int32 _p)
+{
+
+	__m128i t0r, t0i, t1r, t1i, t2r, t2i, t3r, t3i;
+	__m128i m1r, m1i, m2r, m2i, n1r, n1i, n2r, n2i;
+	int32 l;
+
+	switch(_p)
+	{
+		case 2:
+			t0r = _mm_sub_epi32(_re[0], _re[1]);
+			t0i = _mm_sub_epi32(_im[0], _im[1]);
+			_re[0] = _mm_add_epi32(_re[0], _re[1]);
+			_im[0] = _mm_add_epi32(_im[0], _im[1]);
+			_re[1] = t0r; _im[1] = t0i;
+			break;
+
+		case 4:
+			t0r = _mm_add_epi32(_re[0], _re[2]);		t0i = _mm_add_epi32(_im[0], _im[2]);
+			t1r = _mm_sub_epi32(_re[0], _re[2]);		t1i = _mm_sub_epi32(_im[0], _im[2]);
+			t2r = _mm_add_epi32(_re[1], _re[3]);		t2i = _mm_add_epi32(_im[1], _im[3]);
+			t3r = _mm_sub_epi32(_re[1], _re[3]);		t3i = _mm_sub_epi32(_im[1], _im[3]);
+
+			_re[0] = _mm_add_epi32(t0r, t2r);			_im[0] = _mm_add_epi32(t0i, t2i);
+			_re[1] = _mm_add_epi32(t1r, t3i);			_im[1] = _mm_sub_epi32(t1i, t3r);
+			_re[2] = _mm_sub_epi32(t0r, t2r);			_im[2] = _mm_sub_epi32(t0i, t2i);
+			_re[3] = _mm_sub_epi32(t1r, t3i);			_im[3] = _mm_add_epi32(t1i, t3r);
+			break;
+
+		case 3:
+			t0r = _mm_add_epi32(_re[1], _re[2]);		t0i = _mm_add_epi32(_im[1], _im[2]);
+			t1r = mulq14_sse(_mm_sub_epi32(_re[1], _re[2]), C3);
+			t1i = mulq14_sse(_mm_sub_epi32(_im[1], _im[2]), C3);
+			m1r = _mm_sub_epi32(_re[0], _mm_srai_epi32(_mm_add_epi32(t0r, _mm_set1_epi32(1)), 1));
+			m1i = _mm_sub_epi32(_im[0], _mm_srai_epi32(_mm_add_epi32(t0i, _mm_set1_epi32(1)), 1));
+
+			_re[0] = _mm_add_epi32(_re[0], t0r);		_im[0] = _mm_add_epi32(_im[0], t0i);
+			_re[1] = _mm_add_epi32(m1r, t1i);			_im[1] = _mm_sub_epi32(m1i, t1r);
+			_re[2] = _mm_sub_epi32(m1r, t1i);			_im[2] = _mm_add_epi32(m1i, t1r);
+			break;
+
+		case 5:
+			t0r = _mm_add_epi32(_re[1], _re[4]);		t0i = _mm_add_epi32(_im[1], _im[4]);
+			t1r = _mm_sub_epi32(_re[1], _re[4]);		t1i = _mm_sub_epi32(_im[1], _im[4]);
+			t2r = _mm_add_epi32(_re[2], _re[3]);		t2i = _mm_add_epi32(_im[2], _im[3]);
+			t3r = _mm_sub_epi32(_re[2], _re[3]);		t3i = _mm_sub_epi32(_im[2], _im[3]);
+
+			m1r = _mm_add_epi32(_re[0], _mm_add_epi32(mulq14_sse(t0r, C51), mulq14_sse(t2r, C52)));
+			m1i = _mm_add_epi32(_im[0], _mm_add_epi32(mulq14_sse(t0i, C51), mulq14_sse(t2i, C52)));
+			m2r = _mm_add_epi32(_re[0], _mm_add_epi32(mulq14_sse(t0r, C52), mulq14_sse(t2r, C51)));
+			m2i = _mm_add_epi32(_im[0], _mm_add_epi32(mulq14_sse(t0i, C52), mulq14_sse(t2i, C51)));
+			n1r = _mm_add_epi32(mulq14_sse(t1r, S51), mulq14_sse(t3r, S52));
+			n1i = _mm_add_epi32(mulq14_sse(t1i, S51), mulq14_sse(t3i, S52));
+			n2r = _mm_sub_epi32(mulq14_sse(t1r, S52), mulq14_sse(t3r, S51));
+			n2i = _mm_sub_epi32(mulq14_sse(t1i, S52), mulq14_sse(t3i, S51));
+
+			_re[0] = _mm_add_epi32(_re[0], _mm_add_epi32(t0r, t2r));
+			_im[0] = _mm_add_epi32(_im[0], _mm_add_epi32(t0i, t2i));
+			_re[1] = _mm_add_epi32(m1r, n1i);			_im[1] = _mm_sub_epi32(m1i, n1r);
+			_re[2] = _mm_add_epi32(m2r, n2i);			_im[2] = _mm_sub_epi32(m2i, n2r);
+			_re[3] = _mm_sub_epi32(m2r, n2i);			_im[3] = _mm_add_epi32(m2i, n2r);
+			_re[4] = _mm_sub_epi32(m1r, n1i);			_im[4] = _mm_add_epi32(m1i, n1r);
+			break;
+	}
+
+	for(l = 1; l < _p; l++)
+		twiddle_sse(&_re[l], &_im[l], _wr[l-1], _wi[l-1]);
+
+}
+
+/* stage_x86() 4 butterflies of a group at a time, which needs _s of at least 4 */
+__attribute__ ((target("sse2"), always_inline))
+static inline void stage_k_sse(int32 *_x, int32 *_y, int32 *_w, int32 *_wr, int32 *_wi, const int32 _p, int32 _m, int32 _s)
+{
+
+	int32 q, k, j, sm;
+	__m128i re[5], im[5], wr[4], wi[4];
+	int32 *a, *y;
+
+	sm = 2*_s*_m;
+
+	for(q = 0; q < _m; q++, _w += 2*(_p-1))
+	{
+		for(j = 1; j < _p; j++)
+		{
+			wr[j-1] = _mm_set1_epi32(_wr[(j-1)*_m + q]);
+			wi[j-1] = _mm_set1_epi32(_wi[(j-1)*_m + q]);
+		}
+
+		for(k = 0; k + 4 <= _s; k += 4)
+		{
+			a = &_x[2*(k + _s*q)];
+			y = &_y[2*(k + _s*_p*q)];
+
+			for(j = 0; j < _p; j++)
+				load_mixed_sse(a + j*sm, &re[j], &im[j]);
+
+			bfly_mixed_sse(re, im, wr, wi, _p);
+
+			for(j = 0; j < _p; j++)
+				store_mixed_sse(y + 2*_s*j, re[j], im[j]);
+		}
+
+		for(; k < _s; k++)
+			bfly_mixed(_p, &_x[2*(k + _s*q)], &_y[2*(k + _s*_p*q)], _w, sm, 2*_s);
+	}
+
+}
+
+/* The first stage, where _s is 1, 4 groups at a time. Each lane has its own twiddles and its
+ * outputs are _p points apart, so they go out 64 bits at a time */
+__attribute__ ((target("sse2"), always_inline))
+static inline void stage_q_sse(int32 *_x, int32 *_y, int32 *_w, int32 *_wr, int32 *_wi, const int32 _p, int32 _m)
+{
+
+	int32 q, j, sm;
+	__m128i re[5], im[5], wr[4], wi[4], lo, hi;
+	int32 *y;
+
+	sm = 2*_m;
+
+	for(q = 0; q + 4 <= _m; q += 4)
+	{
+		for(j = 0; j < _p; j++)
+			load_mixed_sse(&_x[2*q] + j*sm, &re[j], &im[j]);
+
+		for(j = 1; j < _p; j++)
+		{
+			wr[j-1] = _mm_loadu_si128((__m128i *)&_wr[(j-1)*_m + q]);
+			wi[j-1] = _mm_loadu_si128((__m128i *)&_wi[(j-1)*_m + q]);
+		}
+
+		bfly_mixed_sse(re, im, wr, wi, _p);
+
+		y = &_y[2*_p*q];
+		for(j = 0; j < _p; j++)
+		{
+			lo = _mm_unpacklo_epi32(re[j], im[j]);
+			hi = _mm_unpackhi_epi32(re[j], im[j]);
+			_mm_storel_epi64((__m128i *)(y + 2*j), lo);
+			_mm_storel_epi64((__m128i *)(y + 2*(_p + j)), _mm_unpackhi_epi64(lo, lo));
+			_mm_storel_epi64((__m128i *)(y + 2*(2*_p + j)), hi);
+			_mm_storel_epi64((__m128i *)(y + 2*(3*_p + j)), _mm_unpackhi_epi64(hi, hi));
+		}
+	}
+
+	for(; q < _m; q++)
+		bfly_mixed(_p, &_x[2*q], &_y[2*_p*q], &_w[2*(_p-1)*q], sm, 2);
+
+}
+
+__attribute__ ((target("sse2")))
+static void stage_sse(int32 *_x, int32 *_y, int32 *_w, int32 *_wr, int32 *_wi, int32 _p, int32 _m, int32 _s)
+{
+
+	if(_s == 1)
+	{
+		switch(_p)
+		{
+			case 4: stage_q_sse(_x, _y, _w, _wr, _wi, 4, _m); break;
+			case 2: stage_q_sse(_x, _y, _w, _wr, _wi, 2, _m); break;
+			case 3: stage_q_sse(_x, _y, _w, _wr, _wi, 3, _m); break;
+			case 5: stage_q_sse(_x, _y, _w, _wr, _wi, 5, _m); break;
+		}
+		return;
+	}
+
+	switch(_p)
+	{
+		case 4: stage_k_sse(_x, _y, _w, _wr, _wi, 4, _m, _s); break;
+		case 2: stage_k_sse(_x, _y, _w, _wr, _wi, 2, _m, _s); break;
+		case 3: stage_k_sse(_x, _y, _w, _wr, _wi, 3, _m, _s); break;
+		case 5: stage_k_sse(_x, _y, _w, _wr, _wi, 5, _m, _s); break;
+	}
+}
+
+/* The same 8 at a time. The 128 bit halves are split on their own, so the lanes come out of
+ * load_mixed_avx2() in 0 1 4 5 2 3 6 7 order and go back the same way, the twiddles are the
+ * same for every lane */
+__attribute__ ((target("avx2")))
+static inline void load_mixed_avx2(int32 *_p, __m256i *_re, __m256i *_im)
+{
+
+	__m256i a, b;
+
+	a = _mm256_shuffle_epi32(_mm256_loadu_si256((__m256i *)_p), 0xD8);
+	b = _mm256_shuffle_epi32(_mm256_loadu_si256((__m256i *)(_p + 8)), 0xD8);
+	*_re = _mm256_unpacklo_epi64(a, b);
+	*_im = _mm256_unpackhi_epi64(a, b);
+
+}
+
+__attribute__ ((target("avx2")))
+static inline void store_mixed_avx2(int32 *_p, __m256i _re, __m256i _im)
+{
+
+	_mm256_storeu_si256((__m256i *)_p, _mm256_unpacklo_epi32(_re, _im));
+	_mm256_storeu_si256((__m256i *)(_p + 8), _mm256_unpackhi_epi32(_re, _im));
+
+}
+
+__attribute__ ((target("avx2")))
+static inline __m256i mulq14_avx2(__m256i _x, int32 _k)
+{
+
+	__m256i x, hi, lo;
+
+	x = _mm256_or_si256(_mm256_and_si256(_x, _mm256_set1_epi32(0x7fff)), _mm256_slli_epi32(_mm256_srai_epi32(_x, 15), 16));
+	hi = _mm256_madd_epi16(x, _mm256_set1_epi32(_k << 16));
+	lo = _mm256_madd_epi16(x, _mm256_set1_epi32(_k & 0xffff));
+
+	return(_mm256_add_epi32(_mm256_slli_epi32(hi, 1), _mm256_srai_epi32(_mm256_add_epi32(lo, _mm256_set1_epi32(8192)), 14)));
+
+}
+
+__attribute__ ((target("avx2")))
+static inline void twiddle_avx2(__m256i *_re, __m256i *_im, __m256i _wr, __m256i _wi)
+{
+
+	__m256i l, h, rnd;
+
+	rnd = _mm256_set1_epi32(8192);
+	l = _mm256_and_si256(_mm256_set1_epi32(0x7fff), *_re);
+	l = _mm256_or_si256(l, _mm256_slli_epi32(_mm256_and_si256(_mm256_set1_epi32(0x7fff), *_im), 16));
+	h = _mm256_and_si256(_mm256_set1_epi32(0xffff), _mm256_srai_epi32(*_re, 15));
+	h = _mm256_or_si256(h, _mm256_slli_epi32(_mm256_srai_epi32(*_im, 15), 16));
+
+	*_re = _mm256_add_epi32(_mm256_slli_epi32(_mm256_madd_epi16(h, _wr), 1), _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(l, _wr), rnd), 14));
+	*_im = _mm256_add_epi32(_mm256_slli_epi32(_mm256_madd_epi16(h, _wi), 1), _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(l, _wi), rnd), 14));
+
+}
+
+__attribute__ ((target("avx2")))
+static inline void bfly_mixed_avx2(__m256i *_re, __m256i *_im, __m256i *_wr, __m256i *_wi, const int32 _p)
+{
+
+	__m256i t0r, t0i, t1r, t1i, t2r, t2i, t3r, t3i;
+	__m256i m1r, m1i, m2r, m2i, n1r, n1i, n2r, n2i;
+	int32 l;
+
+	switch(_p)
+	{
+		case 2:
+			t0r = _mm256_sub_epi32(_re[0], _re[1]);
+			t0i = _mm256_sub_epi32(_im[0], _im[1]);
+			_re[0] = _mm256_add_epi32(_re[0], _re[1]);
+			_im[0] = _mm256_add_epi32(_im[0], _im[1]);
+			_re[1] = t0r; _im[1] = t0i;
+			break;
+
+		case 4:
+			t0r = _mm256_add_epi32(_re[0], _re[2]);		t0i = _mm256_add_epi32(_im[0], _im[2]);
+			t1r = _mm256_sub_epi32(_re[0], _re[2]);		t1i = _mm256_sub_epi32(_im[0], _im[2]);
+			t2r = _mm256_add_epi32(_re[1], _re[3]);		t2i = _mm256_add_epi32(_im[1], _im[3]);
+			t3r = _mm256_sub_epi32(_re[1], _re[3]);		t3i = _mm256_sub_epi32(_im[1], _im[3]);
+
+			_re[0] = _mm256_add_epi32(t0r, t2r);		_im[0] = _mm256_add_epi32(t0i, t2i);
+			_re[1] = _mm256_add_epi32(t1r, t3i);		_im[1] = _mm256_sub_epi32(t1i, t3r);
+			_re[2] = _mm256_sub_epi32(t0r, t2r);		_im[2] = _mm256_sub_epi32(t0i, t2i);
+			_re[3] = _mm256_sub_epi32(t1r, t3i);		_im[3] = _mm256_add_epi32(t1i, t3r);
+			break;
+
+		case 3:
+			t0r = _mm256_add_epi32(_re[1], _re[2]);		t0i = _mm256_add_epi32(_im[1], _im[2]);
+			t1r = mulq14_avx2(_mm256_sub_epi32(_re[1], _re[2]), C3);
+			t1i = mulq14_avx2(_mm256_sub_epi32(_im[1], _im[2]), C3);
+			m1r = _mm256_sub_epi32(_re[0], _mm256_srai_epi32(_mm256_add_epi32(t0r, _mm256_set1_epi32(1)), 1));
+			m1i = _mm256_sub_epi32(_im[0], _mm256_srai_epi32(_mm256_add_epi32(t0i, _mm256_set1_epi32(1)), 1));
+
+			_re[0] = _mm256_add_epi32(_re[0], t0r);		_im[0] = _mm256_add_epi32(_im[0], t0i);
+			_re[1] = _mm256_add_epi32(m1r, t1i);		_im[1] = _mm256_sub_epi32(m1i, t1r);
+			_re[2] = _mm256_sub_epi32(m1r, t1i);		_im[2] = _mm256_add_epi32(m1i, t1r);
+			break;
+
+		case 5:
+			t0r = _mm256_add_epi32(_re[1], _re[4]);		t0i = _mm256_add_epi32(_im[1], _im[4]);
+			t1r = _mm256_sub_epi32(_re[1], _re[4]);		t1i = _mm256_sub_epi32(_im[1], _im[4]);
+			t2r = _mm256_add_epi32(_re[2], _re[3]);		t2i = _mm256_add_epi32(_im[2], _im[3]);
+			t3r = _mm256_sub_epi32(_re[2], _re[3]);		t3i = _mm256_sub_epi32(_im[2], _im[3]);
+
+			m1r = _mm256_add_epi32(_re[0], _mm256_add_epi32(mulq14_avx2(t0r, C51), mulq14_avx2(t2r, C52)));
+			m1i = _mm256_add_epi32(_im[0], _mm256_add_epi32(mulq14_avx2(t0i, C51), mulq14_avx2(t2i, C52)));
+			m2r = _mm256_add_epi32(_re[0], _mm256_add_epi32(mulq14_avx2(t0r, C52), mulq14_avx2(t2r, C51)));
+			m2i = _mm256_add_epi32(_im[0], _mm256_add_epi32(mulq14_avx2(t0i, C52), mulq14_avx2(t2i, C51)));
+			n1r = _mm256_add_epi32(mulq14_avx2(t1r, S51), mulq14_avx2(t3r, S52));
+			n1i = _mm256_add_epi32(mulq14_avx2(t1i, S51), mulq14_avx2(t3i, S52));
+			n2r = _mm256_sub_epi32(mulq14_avx2(t1r, S52), mulq14_avx2(t3r, S51));
+			n2i = _mm256_sub_epi32(mulq14_avx2(t1i, S52), mulq14_avx2(t3i, S51));
+
+			_re[0] = _mm256_add_epi32(_re[0], _mm256_add_epi32(t0r, t2r));
+			_im[0] = _mm256_add_epi32(_im[0], _mm256_add_epi32(t0i, t2i));
+			_re[1] = _mm256_add_epi32(m1r, n1i);		_im[1] = _mm256_sub_epi32(m1i, n1r);
+			_re[2] = _mm256_add_epi32(m2r, n2i);		_im[2] = _mm256_sub_epi32(m2i, n2r);
+			_re[3] = _mm256_sub_epi32(m2r, n2i);		_im[3] = _mm256_add_epi32(m2i, n2r);
+			_re[4] = _mm256_sub_epi32(m1r, n1i);		_im[4] = _mm256_add_epi32(m1i, n1r);
+			break;
+	}
+
+	for(l = 1; l < _p; l++)
+		twiddle_avx2(&_re[l], &_im[l], _wr[l-1], _wi[l-1]);
+
+}
+
+__attribute__ ((target("avx2"), always_inline))
+static inline void stage_k_avx2(int32 *_x, int32 *_y, int32 *_w, int32 *_wr, int32 *_wi, const int32 _p, int32 _m, int32 _s)
+{
+
+	int32 q, k, j, sm;
+	__m256i re[5], im[5], wr[4], wi[4];
+	int32 *a, *y;
+
+	sm = 2*_s*_m;
+
+	for(q = 0; q < _m; q++, _w += 2*(_p-1))
+	{
+		for(j = 1; j < _p; j++)
+		{
+			wr[j-1] = _mm256_set1_epi32(_wr[(j-1)*_m + q]);
+			wi[j-1] = _mm256_set1_epi32(_wi[(j-1)*_m + q]);
+		}
+
+		for(k = 0; k + 8 <= _s; k += 8)
+		{
+			a = &_x[2*(k + _s*q)];
+			y = &_y[2*(k + _s*_p*q)];
+
+			for(j = 0; j < _p; j++)
+				load_mixed_avx2(a + j*sm, &re[j], &im[j]);
+
+			bfly_mixed_avx2(re, im, wr, wi, _p);
+
+			for(j = 0; j < _p; j++)
+				store_mixed_avx2(y + 2*_s*j, re[j], im[j]);
+		}
+
+		for(; k < _s; k++)
+			bfly_mixed(_p, &_x[2*(k + _s*q)], &_y[2*(k + _s*_p*q)], _w, sm, 2*_s);
+	}
+
+}
+
+__attribute__ ((target("avx2")))
+static void stage_avx2(int32 *_x, int32 *_y, int32 *_w, int32 *_wr, int32 *_wi, int32 _p, int32 _m, int32 _s)
+{
+
+	switch(_p)
+	{
+		case 4: stage_k_avx2(_x, _y, _w, _wr, _wi, 4, _m, _s); break;
+		case 2: stage_k_avx2(_x, _y, _w, _wr, _wi, 2, _m, _s); break;
+		case 3: stage_k_avx2(_x, _y, _w, _wr, _wi, 3, _m, _s); break;
+		case 5: stage_k_avx2(_x, _y, _w, _wr, _wi, 5, _m, _s); break;
+	}
+
+}
+
+/* And 16 at a time, the four 128 bit quarters again split on their own */
+__attribute__ ((target("avx512f,avx512bw")))
+static inline void load_mixed_avx512(int32 *_p, __m512i *_re, __m512i *_im)
+{
+
+	__m512i a, b;
+
+	a = _mm512_shuffle_epi32(_mm512_loadu_si512((void *)_p), (_MM_PERM_ENUM)0xD8);
+	b = _mm512_shuffle_epi32(_mm512_loadu_si512((void *)(_p + 16)), (_MM_PERM_ENUM)0xD8);
+	*_re = _mm512_unpacklo_epi64(a, b);
+	*_im = _mm512_unpackhi_epi64(a, b);
+
+}
+
+__attribute__ ((target("avx512f,avx512bw")))
+static inline void store_mixed_avx512(int32 *_p, __m512i _re, __m512i _im)
+{
+
+	_mm512_storeu_si512((void *)_p, _mm512_unpacklo_epi32(_re, _im));
+	_mm512_storeu_si512((void *)(_p + 16), _mm512_unpackhi_epi32(_re, _im));
+
+}
+
+__attribute__ ((target("avx512f,avx512bw")))
+static inline __m512i mulq14_avx512(__m512i _x, int32 _k)
+{
+
+	__m512i x, hi, lo;
+
+	x = _mm512_or_si512(_mm512_and_si512(_x, _mm512_set1_epi32(0x7fff)), _mm512_slli_epi32(_mm512_srai_epi32(_x, 15), 16));
+	hi = _mm512_madd_epi16(x, _mm512_set1_epi32(_k << 16));
+	lo = _mm512_madd_epi16(x, _mm512_set1_epi32(_k & 0xffff));
+
+	return(_mm512_add_epi32(_mm512_slli_epi32(hi, 1), _mm512_srai_epi32(_mm512_add_epi32(lo, _mm512_set1_epi32(8192)), 14)));
+
+}
+
+__attribute__ ((target("avx512f,avx512bw")))
+static inline void twiddle_avx512(__m512i *_re, __m512i *_im, __m512i _wr, __m512i _wi)
+{
+
+	__m512i l, h, rnd;
+
+	rnd = _mm512_set1_epi32(8192);
+	l = _mm512_and_si512(_mm512_set1_epi32(0x7fff), *_re);
+	l = _mm512_or_si512(l, _mm512_slli_epi32(_mm512_and_si512(_mm512_set1_epi32(0x7fff), *_im), 16));
+	h = _mm512_and_si512(_mm512_set1_epi32(0xffff), _mm512_srai_epi32(*_re, 15));
+	h = _mm512_or_si512(h, _mm512_slli_epi32(_mm512_srai_epi32(*_im, 15), 16));
+
+	*_re = _mm512_add_epi32(_mm512_slli_epi32(_mm512_madd_epi16(h, _wr), 1), _mm512_srai_epi32(_mm512_add_epi32(_mm512_madd_epi16(l, _wr), rnd), 14));
+	*_im = _mm512_add_epi32(_mm512_slli_epi32(_mm512_madd_epi16(h, _wi), 1), _mm512_srai_epi32(_mm512_add_epi32(_mm512_madd_epi16(l, _wi), rnd), 14));
+
+}
+
+__attribute__ ((target("avx512f,avx512bw")))
+static inline void bfly_mixed_avx512(__m512i *_re, __m512i *_im, __m512i *_wr, __m512i *_wi, const int32 _p)
+{
+
+	__m512i t0r, t0i, t1r, t1i, t2r, t2i, t3r, t3i;
+	__m512i m1r, m1i, m2r, m2i, n1r, n1i, n2r, n2i;
+	int32 l;
+
+	switch(_p)
+	{
+		case 2:
+			t0r = _mm512_sub_epi32(_re[0], _re[1]);
+			t0i = _mm512_sub_epi32(_im[0], _im[1]);
+			_re[0] = _mm512_add_epi32(_re[0], _re[1]);
+			_im[0] = _mm512_add_epi32(_im[0], _im[1]);
+			_re[1] = t0r; _im[1] = t0i;
+			break;
+
+		case 4:
+			t0r = _mm512_add_epi32(_re[0], _re[2]);		t0i = _mm512_add_epi32(_im[0], _im[2]);
+			t1r = _mm512_sub_epi32(_re[0], _re[2]);		t1i = _mm512_sub_epi32(_im[0], _im[2]);
+			t2r = _mm512_add_epi32(_re[1], _re[3]);		t2i = _mm512_add_epi32(_im[1], _im[3]);
+			t3r = _mm512_sub_epi32(_re[1], _re[3]);		t3i = _mm512_sub_epi32(_im[1], _im[3]);
+
+			_re[0] = _mm512_add_epi32(t0r, t2r);		_im[0] = _mm512_add_epi32(t0i, t2i);
+			_re[1] = _mm512_add_epi32(t1r, t3i);		_im[1] = _mm512_sub_epi32(t1i, t3r);
+			_re[2] = _mm512_sub_epi32(t0r, t2r);		_im[2] = _mm512_sub_epi32(t0i, t2i);
+			_re[3] = _mm512_sub_epi32(t1r, t3i);		_im[3] = _mm512_add_epi32(t1i, t3r);
+			break;
+
+		case 3:
+			t0r = _mm512_add_epi32(_re[1], _re[2]);		t0i = _mm512_add_epi32(_im[1], _im[2]);
+			t1r = mulq14_avx512(_mm512_sub_epi32(_re[1], _re[2]), C3);
+			t1i = mulq14_avx512(_mm512_sub_epi32(_im[1], _im[2]), C3);
+			m1r = _mm512_sub_epi32(_re[0], _mm512_srai_epi32(_mm512_add_epi32(t0r, _mm512_set1_epi32(1)), 1));
+			m1i = _mm512_sub_epi32(_im[0], _mm512_srai_epi32(_mm512_add_epi32(t0i, _mm512_set1_epi32(1)), 1));
+
+			_re[0] = _mm512_add_epi32(_re[0], t0r);		_im[0] = _mm512_add_epi32(_im[0], t0i);
+			_re[1] = _mm512_add_epi32(m1r, t1i);		_im[1] = _mm512_sub_epi32(m1i, t1r);
+			_re[2] = _mm512_sub_epi32(m1r, t1i);		_im[2] = _mm512_add_epi32(m1i, t1r);
+			break;
+
+		case 5:
+			t0r = _mm512_add_epi32(_re[1], _re[4]);		t0i = _mm512_add_epi32(_im[1], _im[4]);
+			t1r = _mm512_sub_epi32(_re[1], _re[4]);		t1i = _mm512_sub_epi32(_im[1], _im[4]);
+			t2r = _mm512_add_epi32(_re[2], _re[3]);		t2i = _mm512_add_epi32(_im[2], _im[3]);
+			t3r = _mm512_sub_epi32(_re[2], _re[3]);		t3i = _mm512_sub_epi32(_im[2], _im[3]);
+
+			m1r = _mm512_add_epi32(_re[0], _mm512_add_epi32(mulq14_avx512(t0r, C51), mulq14_avx512(t2r, C52)));
+			m1i = _mm512_add_epi32(_im[0], _mm512_add_epi32(mulq14_avx512(t0i, C51), mulq14_avx512(t2i, C52)));
+			m2r = _mm512_add_epi32(_re[0], _mm512_add_epi32(mulq14_avx512(t0r, C52), mulq14_avx512(t2r, C51)));
+			m2i = _mm512_add_epi32(_im[0], _mm512_add_epi32(mulq14_avx512(t0i, C52), mulq14_avx512(t2i, C51)));
+			n1r = _mm512_add_epi32(mulq14_avx512(t1r, S51), mulq14_avx512(t3r, S52));
+			n1i = _mm512_add_epi32(mulq14_avx512(t1i, S51), mulq14_avx512(t3i, S52));
+			n2r = _mm512_sub_epi32(mulq14_avx512(t1r, S52), mulq14_avx512(t3r, S51));
+			n2i = _mm512_sub_epi32(mulq14_avx512(t1i, S52), mulq14_avx512(t3i, S51));
+
+			_re[0] = _mm512_add_epi32(_re[0], _mm512_add_epi32(t0r, t2r));
+			_im[0] = _mm512_add_epi32(_im[0], _mm512_add_epi32(t0i, t2i));
+			_re[1] = _mm512_add_epi32(m1r, n1i);		_im[1] = _mm512_sub_epi32(m1i, n1r);
+			_re[2] = _mm512_add_epi32(m2r, n2i);		_im[2] = _mm512_sub_epi32(m2i, n2r);
+			_re[3] = _mm512_sub_epi32(m2r, n2i);		_im[3] = _mm512_add_epi32(m2i, n2r);
+			_re[4] = _mm512_sub_epi32(m1r, n1i);		_im[4] = _mm512_add_epi32(m1i, n1r);
+			break;
+	}
+
+	for(l = 1; l < _p; l++)
+		twiddle_avx512(&_re[l], &_im[l], _wr[l-1], _wi[l-1]);
+
+}
+
+__attribute__ ((target("avx512f,avx512bw"), always_inline))
+static inline void stage_k_avx512(int32 *_x, int32 *_y, int32 *_w, int32 *_wr, int32 *_wi, const int32 _p, int32 _m, int32 _s)
+{
+
+	int32 q, k, j, sm;
+	__m512i re[5], im[5], wr[4], wi[4];
+	int32 *a, *y;
+
+	sm = 2*_s*_m;
+
+	for(q = 0; q < _m; q++, _w += 2*(_p-1))
+	{
+		for(j = 1; j < _p; j++)
+		{
+			wr[j-1] = _mm512_set1_epi32(_wr[(j-1)*_m + q]);
+			wi[j-1] = _mm512_set1_epi32(_wi[(j-1)*_m + q]);
+		}
+
+		for(k = 0; k + 16 <= _s; k += 16)
+		{
+			a = &_x[2*(k + _s*q)];
+			y = &_y[2*(k + _s*_p*q)];
+
+			for(j = 0; j < _p; j++)
+				load_mixed_avx512(a + j*sm, &re[j], &im[j]);
+
+			bfly_mixed_avx512(re, im, wr, wi, _p);
+
+			for(j = 0; j < _p; j++)
+				store_mixed_avx512(y + 2*_s*j, re[j], im[j]);
+		}
+
+		for(; k < _s; k++)
+			bfly_mixed(_p, &_x[2*(k + _s*q)], &_y[2*(k + _s*_p*q)], _w, sm, 2*_s);
+	}
+
+}
+
+__attribute__ ((target("avx512f,avx512bw")))
+static void stage_avx512(int32 *_x, int32 *_y, int32 *_w, int32 *_wr, int32 *_wi, int32 _p, int32 _m, int32 _s)
+{
+
+	switch(_p)
+	{
+		case 4: stage_k_avx512(_x, _y, _w, _wr, _wi, 4, _m, _s); break;
+		case 2: stage_k_avx512(_x, _y, _w, _wr, _wi, 2, _m, _s); break;
+		case 3: stage_k_avx512(_x, _y, _w, _wr, _wi, 3, _m, _s); break;
+		case 5: stage_k_avx512(_x, _y, _w, _wr, _wi, 5, _m, _s); break;
+	}
+
+}
+
+/* Widen to the 32 bit [Re Im] pairs, conjugating for the inverse */
+static void mixed_in_x86(int32 *_y, CPX *_x, int32 _n, bool _inverse)
+{
+
+	int32 lcv;
+
+	for(lcv = 0; lcv < _n; lcv++)
+	{
+		_y[2*lcv] = _x[lcv].i;
+		_y[2*lcv+1] = _inverse ? -_x[lcv].q : _x[lcv].q;
+	}
+
+}
+
+/* Round, shift and saturate back down to CPX, conjugating for the inverse */
+static void mixed_out_x86(CPX *_x, int32 *_y, int32 _n, int32 _shift, bool _inverse)
+{
+
+	int32 lcv, rnd, re, im;
+
+	rnd = _shift ? 1 << (_shift - 1) : 0;
+
+	for(lcv = 0; lcv < _n; lcv++)
+	{
+		re = (_y[2*lcv] + rnd) >> _shift;
+		im = (_y[2*lcv+1] + rnd) >> _shift;
+		_x[lcv].i = (int16)sat16(re);
+		_x[lcv].q = (int16)sat16(_inverse ? -im : im);
+	}
+
+}
+
+__attribute__ ((target("sse2")))
+static void mixed_in_sse(int32 *_y, CPX *_x, int32 _n, bool _inverse)
+{
+
+	int32 lcv;
+	__m128i v, c;
+
+	c = _inverse ? _mm_set_epi32(-1, 0, -1, 0) : _mm_setzero_si128();
+
+	for(lcv = 0; lcv + 4 <= _n; lcv += 4)
+	{
+		v = _mm_loadu_si128((__m128i *)&_x[lcv]);
+		_mm_storeu_si128((__m128i *)&_y[2*lcv], _mm_sub_epi32(_mm_xor_si128(_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16), c), c));
+		_mm_storeu_si128((__m128i *)&_y[2*lcv+4], _mm_sub_epi32(_mm_xor_si128(_mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16), c), c));
+	}
+
+	mixed_in_x86(&_y[2*lcv], &_x[lcv], _n - lcv, _inverse);
+
+}
+
+__attribute__ ((target("sse2")))
+static void mixed_out_sse(CPX *_x, int32 *_y, int32 _n, int32 _shift, bool _inverse)
+{
+
+	int32 lcv;
+	__m128i r, s, c, lo, hi;
+
+	r = _mm_set1_epi32(_shift ? 1 << (_shift - 1) : 0);
+	s = _mm_cvtsi32_si128(_shift);
+	c = _inverse ? _mm_set_epi32(-1, 0, -1, 0) : _mm_setzero_si128();
+
+	for(lcv = 0; lcv + 4 <= _n; lcv += 4)
+	{
+		lo = _mm_sra_epi32(_mm_add_epi32(_mm_loadu_si128((__m128i *)&_y[2*lcv]), r), s);
+		hi = _mm_sra_epi32(_mm_add_epi32(_mm_loadu_si128((__m128i *)&_y[2*lcv+4]), r), s);
+		lo = _mm_sub_epi32(_mm_xor_si128(lo, c), c);
+		hi = _mm_sub_epi32(_mm_xor_si128(hi, c), c);
+		_mm_storeu_si128((__m128i *)&_x[lcv], _mm_packs_epi32(lo, hi));
+	}
+
+	mixed_out_x86(&_x[lcv], &_y[2*lcv], _n - lcv, _shift, _inverse);
+
+}
+
+
+void FFT::initMixed()
+{
+
+	int32 lcv, lcv2, q, n, m, p, len, plen, ranks, wre, wim;
+
+	mixed = 1;
+	W = iW = NULL;
+	Wr = Wi = iWr = iWi = NULL;
+	BR = BRX = NULL;
+	batch = 1;
+
+	/* Factor, taking out 4s first as they are the cheapest per point */
+	nstages = 0;
+	n = N;
+	while((n % 4) == 0 && (nstages < MAX_STAGES))	{ radix[nstages++] = 4; n /= 4; }
+	while((n % 2) == 0 && (nstages < MAX_STAGES))	{ radix[nstages++] = 2; n /= 2; }
+	while((n % 3) == 0 && (nstages < MAX_STAGES))	{ radix[nstages++] = 3; n /= 3; }
+	while((n % 5) == 0 && (nstages < MAX_STAGES))	{ radix[nstages++] = 5; n /= 5; }
+
+	/* Can not be done, leave the object unusable rather than run a partial set of stages */
+	valid = (n == 1);
+	if(!valid)
+	{
+		fprintf(stderr, "FFT: %d is not a product of 2, 3 and 5\n", N);
+		nstages = 0;
+		width = 1;
+		TW = TWr = TWi = NULL;
+		MX = NULL;
+		return;
+	}
+
+	/* The SIMD stages are exact only while nothing reaches 2^30 */
+#ifdef NO_SIMD
+	width = 1;
+#else
+	if(N > 16384)
+		width = 1;
+	else if(CPU_AVX512())
+		width = 16;
+	else if(CPU_AVX2())
+		width = 8;
+	else
+		width = 4;
+#endif
+
+	/* The ranks a 2^M transform this size would have, and their scaling */
+	ranks = 0;
+	while((1 << ranks) < N)
+		ranks++;
+
+	shift = 0;
+	for(lcv = 0; (lcv < ranks) && (lcv < MAX_RANKS); lcv++)
+		shift += R[lcv] ? 1 : 0;
+
+	/* Stage twiddles, W_n^(q*l) for each q < m and 0 < l < p */
+	len = 0;
+	n = N;
+	for(lcv = 0; lcv < nstages; lcv++)
+	{
+		len += (n/radix[lcv])*(radix[lcv]-1);
+		n /= radix[lcv];
+	}
+
+	TW = (int32 *)malloc((2*len + 2)*sizeof(int32));
+	TWr = (int32 *)malloc((len + 1)*sizeof(int32));
+	TWi = (int32 *)malloc((len + 1)*sizeof(int32));
+	MX = (int32 *)malloc(4*N*sizeof(int32));
+
+	/* TW in q order for stage_x86(), TWr and TWi in l order so the first stage can load a
+	 * register of consecutive q at once */
+	len = plen = 0;
+	n = N;
+	for(lcv = 0; lcv < nstages; lcv++)
+	{
+		p = radix[lcv];
+		m = n/p;
+
+		for(q = 0; q < m; q++)
+			for(lcv2 = 1; lcv2 < p; lcv2++)
+			{
+				wre = (int32)floor(16384.0*cos(-TWO_PI*q*lcv2/n) + 0.5);
+				wim = (int32)floor(16384.0*sin(-TWO_PI*q*lcv2/n) + 0.5);
+
+				TW[len++] = wre;
+				TW[len++] = wim;
+				TWr[plen + (lcv2-1)*m + q] = (int32)(((uint32)(uint16)(-wim) << 16) | (uint16)wre);
+				TWi[plen + (lcv2-1)*m + q] = (int32)(((uint32)(uint16)wre << 16) | (uint16)wim);
+			}
+
+		plen += m*(p-1);
+		n = m;
+	}
+
+}
+
+
+void FFT::doMixed(CPX *_x, bool _inverse)
+{
+
+	int32 lcv, n, m, s, p;
+	int32 *x, *y, *t, *w, *wr, *wi;
+
+	if(!valid)
+		return;
+
+	x = MX;
+	y = MX + 2*N;
+
+	if(width >= 4)
+		mixed_in_sse(x, _x, N, _inverse);
+	else
+		mixed_in_x86(x, _x, N, _inverse);
+
+	n = N;
+	s = 1;
+	w = TW;
+	wr = TWr;
+	wi = TWi;
+
+	for(lcv = 0; lcv < nstages; lcv++)
+	{
+		p = radix[lcv];
+		m = n/p;
+
+		if((width >= 16) && (s >= 16))
+			stage_avx512(x, y, w, wr, wi, p, m, s);
+		else if((width >= 8) && (s >= 8))
+			stage_avx2(x, y, w, wr, wi, p, m, s);
+		else if((width >= 4) && ((s == 1) || (s >= 4)))
+			stage_sse(x, y, w, wr, wi, p, m, s);
+		else
+			stage_x86(x, y, w, p, m, s);
+
+		w += 2*m*(p-1);
+		wr += m*(p-1);
+		wi += m*(p-1);
+		t = x; x = y; y = t;
+		n = m;
+		s *= p;
+	}
+
+	if(width >= 4)
+		mixed_out_sse(_x, x, N, shift, _inverse);
+	else
+		mixed_out_x86(_x, x, N, shift, _inverse);
+
+}
+
+
 #ifdef NO_SIMD  /* Include the cPP FFT Functions */
 
 void rank(CPX *_A, CPX *_B, MIX *_W, int32 _nblocks, int32 _bsize)
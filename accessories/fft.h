@@ -21,6 +21,8 @@ Free Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1
 #define FFT_H_
 
 #define MAX_RANKS (16)
+#define FFT_BATCH_BYTES (32768)	//!< Data a batched FFT keeps in cache between passes
+#define MAX_STAGES (16)				//!< Stages of a mixed radix FFT
 
 /*! \ingroup CLASSES
  * 
@@ -33,25 +35,48 @@ typedef class FFT
 
 		MIX *W;						//!< Twiddle lookup array for FFT
 		MIX *iW;					//!< Twiddle lookup array for iFFT
+		int32 *Wr;					//!< FFT twiddles of each rank laid out in order, [Re -Im] words
+		int32 *Wi;					//!< FFT twiddles of each rank laid out in order, [Im Re] words
+		int32 *iWr;					//!< iFFT twiddles of each rank laid out in order, [Re -Im] words
+		int32 *iWi;					//!< iFFT twiddles of each rank laid out in order, [Im Re] words
 		int32 *BRX;					//!< Re-order temp array
 		int32 *BR;					//!< Re-order index array
 		
 		int32 N;					//!< Length (should be 2^N!!!)
 		int32 M;					//!< Log2(N) (number of ranks)
 		int32 R[16];				//!< Programmable rank scaling
+		int32 width;				//!< Butterflies the widest SIMD unit can do at once
+		int32 batch;				//!< Vectors a batched call takes through each pass together
+
+		int32 mixed;				//!< N is not a power of 2, so the mixed radix stages are used
+		int32 valid;				//!< 0 if N is not a power of 2 or a product of 2, 3 and 5, the transforms then do nothing
+		int32 nstages;				//!< Number of mixed radix stages
+		int32 radix[MAX_STAGES];	//!< Radix of each stage, 4, 2, 3 or 5
+		int32 shift;				//!< Scaling of a mixed radix transform, taken once at the end
+		int32 *TW;					//!< Twiddles of each mixed radix stage, [Re Im] pairs
+		int32 *TWr;					//!< The same twiddles for the SIMD stages, [Re -Im] words
+		int32 *TWi;					//!< The same twiddles for the SIMD stages, [Im Re] words
+		int32 *MX;					//!< Ping pong buffers of the mixed radix stages
 
 		void initW();				//!< Initialize twiddles
 		void initBR();				//!< Initialize re-order array
+		void initRanks();			//!< Initialize the twiddles of each rank and pick the SIMD width
 		void doShuffle(CPX *_x);	//!< Do bit-reverse shuffling
+		void doRanks(CPX *_x, int32 _count, int32 _stride, int32 *_wr, int32 *_wi, bool _shuf);	//!< The ranks of _count vectors, two at a time
+		void initMixed();			//!< Factor N and initialize the twiddles of each mixed radix stage
+		void doMixed(CPX *_x, bool _inverse);	//!< Mixed radix FFT, natural order in and out
 
 	public:
 
 		FFT();								//!< Initialize FFT
-		FFT(int32 _N);						//!< Initialize FFT for 2^N
-		FFT(int32 _N, int32 _R[MAX_RANKS]);			//!< Initialize FFT for 2^N, with ranks
+		FFT(int32 _N);						//!< Initialize FFT for 2^N, or any product of 2, 3 and 5
+		FFT(int32 _N, int32 _R[MAX_RANKS]);			//!< Initialize FFT for 2^N, or any product of 2, 3 and 5, with ranks
 		~FFT();								//!< Destructor
+		int32 getValid(){return(valid);}	//!< Check this after construction, 0 if N could not be factored
 		void doFFT(CPX *_x, bool _shuf);	//!< Forward FFT, decimate in time
 		void doiFFT(CPX *_x, bool _shuf);	//!< Inverse FFT, decimate in time
+		void doFFTBatch(CPX *_x, int32 _count, int32 _stride, bool _shuf);	//!< Forward FFT of _count vectors _stride points apart
+		void doiFFTBatch(CPX *_x, int32 _count, int32 _stride, bool _shuf);	//!< Inverse FFT of _count vectors _stride points apart
 		void doFFTdf(CPX *_x, bool _shuf);	//!< Forward FFT, decimate in frequency
 		void doiFFTdf(CPX *_x, bool _shuf);	//!< Inverse FFT, decimate in frequency
 
@@ -255,32 +255,19 @@ int32 round_2(int32 _N)
 
 /*----------------------------------------------------------------------------------------------*/
 /*!
- * Gather statistics and run AGC
+ * Gather statistics and run AGC, the scaled samples go into _dest, which may be _buff
  * */
-int32 run_agc(CPX *_buff, int32 _samps, int32 bits, int32 *scale)
+int32 run_agc(CPX *_buff, CPX *_dest, int32 _samps, int32 bits, int32 *scale)
 {
-	int32 lcv, num;
-	int16 max, *p;
+	int32 num;
 	int32 lscale;
-	int32 val;
-
-	p = (int16 *)&_buff[0];
 
 	/* Get rid of the divide, replace with a multiply to scale to 2^15, then right shift to get
 	 * back into AGC_BITS of magnitude */
 
 	lscale = (1 << 14) / scale[0];
 
-	max = 1 << bits; num = 0;
-	for(lcv = 0; lcv < 2*_samps; lcv++)
-	{
-		val = p[lcv];
-		val *= lscale;
-		val >>= (14 - bits);
-		if(val > max)
-			num++;
-		p[lcv] = val;
-	}
+	num = simd_agc(_buff, _dest, _samps, lscale, 14 - bits, 1 << bits);
 
 	/* Figure out the shift value */
 	if(num > AGC_HIGH)
@@ -565,3 +552,28 @@ int32 AtanApprox(int32 y, int32 x)
 }
 /*----------------------------------------------------------------------------------------------*/
 
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * tsc_mhz, measure the TSC rate against the monotonic clock, turns the probe cycle counts into time
+ * */
+double tsc_mhz(void)
+{
+	struct timespec t0, t1;
+	uint64 c0, c1;
+	double us;
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	c0 = __builtin_ia32_rdtsc();
+
+	usleep(20000);
+
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	c1 = __builtin_ia32_rdtsc();
+
+	us = (double)(t1.tv_sec - t0.tv_sec)*1e6 + (double)(t1.tv_nsec - t0.tv_nsec)*1e-3;
+
+	return((double)(c1 - c0)/us);
+}
+/*----------------------------------------------------------------------------------------------*/
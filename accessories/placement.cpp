@@ -0,0 +1,422 @@
+/*! \file Placement.cpp
+	Put each receiver thread on its CPUs with its scheduling policy and priority.
+*/
+/************************************************************************************************
+Copyright 2008 Gregory W Heckler
+
+This file is part of the GPS Software Defined Radio (GPS-SDR)
+
+The GPS-SDR is free software; you can redistribute it and/or modify it under the terms of the
+GNU General Public License as published by the Free Software Foundation; either version 2 of the
+License, or (at your option) any later version.
+
+The GPS-SDR is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with GPS-SDR; if not,
+write to the:
+
+Free Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+************************************************************************************************/
+
+
+#include "includes.h"
+
+
+/*! Names used by -cpu and in the placement file, in the order of the THREAD_ defines */
+static const char *thread_names[THREAD_KINDS] = {"fifo", "corr", "acq", "pvt", "ephem", "select", "telem", "key", "post"};
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * parse_cpus: Turn a CPU list like 0,2-5 into a set, false if it does not parse
+ * */
+static int32 parse_cpus(const char *_list, cpu_set_t *_cpus)
+{
+	int32 first, last, lcv;
+	char *end;
+
+	CPU_ZERO(_cpus);
+
+	while(*_list)
+	{
+		first = strtol(_list, &end, 10);
+		if(end == _list)
+			return(false);
+
+		last = first;
+		if(*end == '-')
+		{
+			_list = end + 1;
+			last = strtol(_list, &end, 10);
+			if(end == _list)
+				return(false);
+		}
+
+		if((first < 0) || (last < first) || (last >= CPU_SETSIZE))
+			return(false);
+
+		for(lcv = first; lcv <= last; lcv++)
+			CPU_SET(lcv, _cpus);
+
+		if(*end == ',')
+			end++;
+		else if(*end != '\0')
+			return(false);
+
+		_list = end;
+	}
+
+	return(CPU_COUNT(_cpus) > 0);
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * print_cpus: Write a CPU set back out as a list like 0,2-5, "any" if it is empty
+ * */
+static void print_cpus(cpu_set_t *_cpus, char *_list, int32 _len)
+{
+	int32 lcv, first, used;
+
+	_list[0] = '\0';
+	used = 0;
+
+	for(lcv = 0; lcv < CPU_SETSIZE; lcv++)
+	{
+		if(!CPU_ISSET(lcv, _cpus))
+			continue;
+
+		/* Run to the end of this block of CPUs */
+		first = lcv;
+		while((lcv + 1 < CPU_SETSIZE) && CPU_ISSET(lcv + 1, _cpus))
+			lcv++;
+
+		if(first == lcv)
+			used += snprintf(&_list[used], _len - used, "%s%d", used ? "," : "", first);
+		else
+			used += snprintf(&_list[used], _len - used, "%s%d-%d", used ? "," : "", first, lcv);
+
+		if(used >= _len)
+			return;
+	}
+
+	if(used == 0)
+		snprintf(_list, _len, "any");
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+static const char *policy_name(int32 _policy)
+{
+
+	switch(_policy)
+	{
+		case SCHED_FIFO:
+			return("SCHED_FIFO");
+		case SCHED_RR:
+			return("SCHED_RR");
+		default:
+			return("SCHED_OTHER");
+	}
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * Placement_Defaults: The priorities from config.h, every thread may run on any CPU
+ * */
+void Placement_Defaults(void)
+{
+	Thread_Place_S *p;
+
+	memset(&gopt.place[0], 0x0, THREAD_KINDS*sizeof(Thread_Place_S));
+
+	p = &gopt.place[0];
+	p[THREAD_FIFO].policy = SCHED_FIFO;		p[THREAD_FIFO].priority = FIFO_PRIORITY;
+	p[THREAD_CORR].policy = SCHED_FIFO;		p[THREAD_CORR].priority = CORR_PRIORITY;
+	p[THREAD_ACQ].policy = SCHED_FIFO;		p[THREAD_ACQ].priority = ACQ_PRIORITY;
+	p[THREAD_PVT].policy = SCHED_FIFO;		p[THREAD_PVT].priority = PVT_PRIORITY;
+	p[THREAD_EPHEM].policy = SCHED_FIFO;	p[THREAD_EPHEM].priority = EPHEM_PRIORITY;
+	p[THREAD_SELECT].policy = SCHED_RR;		p[THREAD_SELECT].priority = TRAK_PRIORITY;
+	p[THREAD_TELEM].policy = SCHED_FIFO;	p[THREAD_TELEM].priority = TELEM_PRIORITY;
+	p[THREAD_KEY].policy = SCHED_RR;		p[THREAD_KEY].priority = KEY_PRIORITY;
+	p[THREAD_POST].policy = SCHED_OTHER;	p[THREAD_POST].priority = 0;
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * Placement_Parse: One placement, kind:cpus[:policy[:priority]], for example corr:2-5:fifo:88.
+ * The cpus can be "any", the policy is fifo, rr or other. Returns false if it does not parse.
+ * */
+int32 Placement_Parse(const char *_spec)
+{
+	char buff[256];
+	char *field[4];
+	int32 lcv, nfield, kind;
+	Thread_Place_S place;
+
+	strncpy(buff, _spec, sizeof(buff) - 1);
+	buff[sizeof(buff) - 1] = '\0';
+
+	/* Split on the colons */
+	nfield = 0;
+	field[nfield++] = buff;
+	for(lcv = 0; buff[lcv] != '\0'; lcv++)
+		if(buff[lcv] == ':')
+		{
+			if(nfield == 4)
+				return(false);
+
+			buff[lcv] = '\0';
+			field[nfield++] = &buff[lcv + 1];
+		}
+
+	if(nfield < 2)
+		return(false);
+
+	kind = -1;
+	for(lcv = 0; lcv < THREAD_KINDS; lcv++)
+		if(strcmp(field[0], thread_names[lcv]) == 0)
+			kind = lcv;
+
+	if(kind == -1)
+		return(false);
+
+	place = gopt.place[kind];
+
+	if(strcmp(field[1], "any") == 0)
+		CPU_ZERO(&place.cpus);
+	else if(!parse_cpus(field[1], &place.cpus))
+		return(false);
+
+	if(nfield > 2)
+	{
+		if(strcmp(field[2], "fifo") == 0)
+			place.policy = SCHED_FIFO;
+		else if(strcmp(field[2], "rr") == 0)
+			place.policy = SCHED_RR;
+		else if(strcmp(field[2], "other") == 0)
+			place.policy = SCHED_OTHER;
+		else
+			return(false);
+
+		if(place.policy == SCHED_OTHER)
+			place.priority = 0;
+		else if(place.priority < 1)
+			place.priority = 1;
+	}
+
+	if(nfield > 3)
+	{
+		if(!isdigit(field[3][0]))
+			return(false);
+
+		place.priority = atoi(field[3]);
+	}
+
+	if((place.priority < sched_get_priority_min(place.policy)) || (place.priority > sched_get_priority_max(place.policy)))
+		return(false);
+
+	gopt.place[kind] = place;
+
+	return(true);
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * Placement_Read: A file of placements, one per line in the same form as -cpu, # starts a comment
+ * */
+int32 Placement_Read(const char *_fname)
+{
+	FILE *fp;
+	char line[256];
+	char *p, *end;
+	int32 nline;
+
+	fp = fopen(_fname, "r");
+	if(fp == NULL)
+	{
+		printf("Could not open placement file %s\n", _fname);
+		return(false);
+	}
+
+	nline = 0;
+	while(fgets(line, sizeof(line), fp) != NULL)
+	{
+		nline++;
+
+		/* Drop the comment and the whitespace around the placement */
+		p = strchr(line, '#');
+		if(p != NULL)
+			*p = '\0';
+
+		p = line;
+		while(isspace(*p))
+			p++;
+
+		end = p + strlen(p);
+		while((end > p) && isspace(end[-1]))
+			*--end = '\0';
+
+		if(*p == '\0')
+			continue;
+
+		if(!Placement_Parse(p))
+		{
+			printf("Bad placement on line %d of %s: %s\n", nline, _fname, p);
+			fclose(fp);
+			return(false);
+		}
+	}
+
+	fclose(fp);
+
+	return(true);
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * Placement_Isolate: With -isolate the acquisition gets its own CPUs, or every CPU the receiver
+ * may use, less the ones given to the correlators. Its FFTs then never preempt a correlator.
+ * */
+void Placement_Isolate(void)
+{
+	cpu_set_t *corr, *acq;
+	cpu_set_t left;
+	int32 lcv;
+
+	if(!gopt.isolate_acq)
+		return;
+
+	corr = &gopt.place[THREAD_CORR].cpus;
+	acq = &gopt.place[THREAD_ACQ].cpus;
+
+	if(CPU_COUNT(corr) == 0)
+	{
+		printf("Not isolating the acquisition, the correlators can run on any CPU (set them with -cpu corr:<cpus>)\n");
+		return;
+	}
+
+	if(CPU_COUNT(acq))
+		left = *acq;
+	else
+		sched_getaffinity(0, sizeof(cpu_set_t), &left);
+
+	for(lcv = 0; lcv < CPU_SETSIZE; lcv++)
+		if(CPU_ISSET(lcv, corr))
+			CPU_CLR(lcv, &left);
+
+	if(CPU_COUNT(&left) == 0)
+	{
+		printf("Not isolating the acquisition, the correlators have every CPU it could use\n");
+		return;
+	}
+
+	*acq = left;
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * Thread_Create: Start a thread of the given kind with its policy, priority and CPUs from
+ * gopt.place. Correlator threads get one CPU each, dealt round their set by _index, so they
+ * never migrate. The real time policies need privileges (CAP_SYS_NICE or an rtprio limit),
+ * without them the thread still starts, just not real time. Where the thread really ended up
+ * is printed when it did not get what was asked for, so a missing privilege shows at startup,
+ * and for every thread with -v.
+ * */
+int32 Thread_Create(pthread_t *_thread, int32 _kind, int32 _index, void *(*_start)(void *), void *_arg)
+{
+	Thread_Place_S *p;
+	pthread_attr_t tattr;
+	sched_param param;
+	cpu_set_t cpus;
+	char list[256];
+	int32 ret, lcv, n, fell;
+	int policy;
+
+	p = &gopt.place[_kind];
+	fell = 0;
+
+	pthread_attr_init(&tattr);
+
+	/* Without explicit scheduling the thread inherits the creator's policy and ignores the rest */
+	pthread_attr_setinheritsched(&tattr, PTHREAD_EXPLICIT_SCHED);
+	pthread_attr_setschedpolicy(&tattr, p->policy);
+	param.sched_priority = p->priority;
+	pthread_attr_setschedparam(&tattr, &param);
+
+	cpus = p->cpus;
+	if((_kind == THREAD_CORR) && (CPU_COUNT(&p->cpus) > 1))
+	{
+		n = _index % CPU_COUNT(&p->cpus);
+		CPU_ZERO(&cpus);
+		for(lcv = 0; lcv < CPU_SETSIZE; lcv++)
+			if(CPU_ISSET(lcv, &p->cpus) && (n-- == 0))
+			{
+				CPU_SET(lcv, &cpus);
+				break;
+			}
+	}
+
+	if(CPU_COUNT(&cpus))
+		pthread_attr_setaffinity_np(&tattr, sizeof(cpu_set_t), &cpus);
+
+	ret = pthread_create(_thread, &tattr, _start, _arg);
+
+	/* Not allowed a real time policy, keep the CPUs */
+	if(ret == EPERM)
+	{
+		fell = 1;
+		pthread_attr_setinheritsched(&tattr, PTHREAD_INHERIT_SCHED);
+		ret = pthread_create(_thread, &tattr, _start, _arg);
+	}
+
+	/* CPUs that are offline or outside the receiver's cpuset, run it anywhere */
+	if(ret != 0)
+	{
+		printf("Could not place %s thread %d (%s), starting it unplaced\n", thread_names[_kind], _index, strerror(ret));
+		ret = pthread_create(_thread, NULL, _start, _arg);
+	}
+
+	pthread_attr_destroy(&tattr);
+
+	if(ret != 0)
+	{
+		printf("Could not start %s thread %d (%s)\n", thread_names[_kind], _index, strerror(ret));
+		return(ret);
+	}
+
+	/* Report what it actually got, always if it lost the real time policy, otherwise only with -v */
+	if(!fell && !gopt.verbose)
+		return(0);
+
+	pthread_getschedparam(*_thread, &policy, &param);
+	pthread_getaffinity_np(*_thread, sizeof(cpu_set_t), &cpus);
+	print_cpus(&cpus, list, sizeof(list));
+
+	printf("%s %-6s thread %2d: %-11s priority %2d, CPUs %s\n", fell ? "Demoted" : "Placed", thread_names[_kind], _index, policy_name(policy), param.sched_priority, list);
+
+	return(0);
+
+}
+/*----------------------------------------------------------------------------------------------*/
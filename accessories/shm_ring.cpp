@@ -0,0 +1,391 @@
+/************************************************************************************************
+Copyright 2008 Gregory W Heckler
+
+This file is part of the GPS Software Defined Radio (GPS-SDR)
+
+The GPS-SDR is free software; you can redistribute it and/or modify it under the terms of the
+GNU General Public License as published by the Free Software Foundation; either version 2 of the
+License, or (at your option) any later version.
+
+The GPS-SDR is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with GPS-SDR; if not,
+write to the:
+
+Free Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+************************************************************************************************/
+
+#include <string.h>
+#include <unistd.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+#include "shm_ring.h"
+
+/*----------------------------------------------------------------------------------------------*/
+/* The ring is shared between processes, so these are the non-private futex ops */
+static void futex_wait(unsigned int *_addr, unsigned int _val)
+{
+	struct timespec timeout;
+
+	/* Never sleep forever, so the caller can notice it is shutting down */
+	timeout.tv_sec = 0;
+	timeout.tv_nsec = 100000000;
+
+	syscall(SYS_futex, _addr, FUTEX_WAIT, _val, &timeout, NULL, 0);
+}
+
+static void futex_wake(unsigned int *_addr)
+{
+	syscall(SYS_futex, _addr, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+Shm_Ring::Shm_Ring()
+{
+
+	fd = -1;
+	size = 0;
+	writer = 0;
+	seq = 0;
+	lost = 0;
+	header = NULL;
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+Shm_Ring::~Shm_Ring()
+{
+
+	Close();
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+Shm_Slot_S *Shm_Ring::Slot(unsigned int _seq)
+{
+
+	return((Shm_Slot_S *)((char *)header + sizeof(Shm_Ring_Header_S) + (_seq % header->slots)*header->stride));
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * Create: Make a new ring. If an old ring is still around mark it dead first, so a reader
+ * that is attached to it lets go and attaches to the new one.
+ * */
+int Shm_Ring::Create(int _slot_bytes, int _slots)
+{
+	Shm_Ring_Header_S *old;
+	struct stat st;
+	int stride;
+
+	Close();
+
+	fd = shm_open(SHM_RING_NAME, O_RDWR, 0666);
+	if(fd != -1)
+	{
+		if((fstat(fd, &st) == 0) && (st.st_size >= (int)sizeof(Shm_Ring_Header_S)))
+		{
+			old = (Shm_Ring_Header_S *)mmap(NULL, sizeof(Shm_Ring_Header_S), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+			if(old != MAP_FAILED)
+			{
+				__atomic_store_n(&old->magic, SHM_RING_DEAD, __ATOMIC_SEQ_CST);
+				__atomic_add_fetch(&old->write_seq, 1, __ATOMIC_SEQ_CST);
+				futex_wake(&old->write_seq);
+				__atomic_add_fetch(&old->read_seq, 1, __ATOMIC_SEQ_CST);
+				futex_wake(&old->read_seq);
+				munmap(old, sizeof(Shm_Ring_Header_S));
+			}
+		}
+		close(fd);
+		shm_unlink(SHM_RING_NAME);
+	}
+
+	/* Slot payloads start on a cache line */
+	stride = (sizeof(Shm_Slot_S) + _slot_bytes + 63) & ~63;
+	size = sizeof(Shm_Ring_Header_S) + _slots*stride;
+
+	fd = shm_open(SHM_RING_NAME, O_CREAT | O_EXCL | O_RDWR, 0666);
+	if(fd == -1)
+		return(0);
+
+	if(ftruncate(fd, size) != 0)
+	{
+		Close();
+		return(0);
+	}
+
+	header = (Shm_Ring_Header_S *)mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if(header == MAP_FAILED)
+	{
+		header = NULL;
+		Close();
+		return(0);
+	}
+
+	memset(header, 0x0, size);
+	header->slots = _slots;
+	header->slot_bytes = _slot_bytes;
+	header->stride = stride;
+
+	writer = 1;
+	seq = 0;
+
+	/* Readers only trust the ring once the magic is there */
+	__atomic_store_n(&header->magic, SHM_RING_MAGIC, __ATOMIC_RELEASE);
+
+	return(1);
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * Attach: Map the ring the writer made, and start reading at the newest packet
+ * */
+int Shm_Ring::Attach()
+{
+	struct stat st;
+
+	Close();
+
+	fd = shm_open(SHM_RING_NAME, O_RDWR, 0666);
+	if(fd == -1)
+		return(0);
+
+	if((fstat(fd, &st) != 0) || (st.st_size < (int)sizeof(Shm_Ring_Header_S)))
+	{
+		Close();
+		return(0);
+	}
+
+	size = st.st_size;
+	header = (Shm_Ring_Header_S *)mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if(header == MAP_FAILED)
+	{
+		header = NULL;
+		Close();
+		return(0);
+	}
+
+	if(__atomic_load_n(&header->magic, __ATOMIC_ACQUIRE) != SHM_RING_MAGIC)
+	{
+		Close();
+		return(0);
+	}
+
+	writer = 0;
+	lost = 0;
+	seq = __atomic_load_n(&header->write_seq, __ATOMIC_ACQUIRE);
+
+	__atomic_store_n(&header->read_seq, seq, __ATOMIC_SEQ_CST);
+	__atomic_store_n(&header->attached, 1, __ATOMIC_SEQ_CST);
+	futex_wake(&header->read_seq);
+
+	return(1);
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+void Shm_Ring::Close()
+{
+	Shm_Ring_Header_S *old;
+	int old_fd, old_writer;
+
+	/* Forget the mapping before anything that can be a cancellation point (close()), so a thread
+	 * cancelled in here does not leave the next Close() poking at an unmapped header */
+	old = header;
+	old_fd = fd;
+	old_writer = writer;
+	header = NULL;
+	fd = -1;
+	writer = 0;
+
+	if(old != NULL)
+	{
+		if(old_writer)
+		{
+			__atomic_store_n(&old->magic, SHM_RING_DEAD, __ATOMIC_SEQ_CST);
+			__atomic_add_fetch(&old->write_seq, 1, __ATOMIC_SEQ_CST);
+			futex_wake(&old->write_seq);
+		}
+		else
+		{
+			__atomic_store_n(&old->attached, 0, __ATOMIC_SEQ_CST);
+			futex_wake(&old->read_seq);
+		}
+
+		munmap(old, size);
+	}
+
+	if(old_fd != -1)
+		close(old_fd);
+
+	if(old_writer)
+		shm_unlink(SHM_RING_NAME);
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * Write: Copy a packet into the next slot and publish it. A real time source (the USRP) never
+ * waits, a slow reader gets overrun and finds out from the sequence numbers. A file source
+ * sets _block, and waits for a reader to attach and for room in the ring, so no data is lost.
+ * Returns 1 once the packet is published, or 0 if a blocking write timed out waiting, in which
+ * case the caller should check if it is shutting down and try again.
+ * */
+int Shm_Ring::Write(void *_data, int _bytes, int _block)
+{
+	Shm_Slot_S *slot;
+	unsigned int read_seq;
+
+	if(header == NULL)
+		return(0);
+
+	if(_bytes > (int)header->slot_bytes)
+		_bytes = header->slot_bytes;
+
+	if(_block)
+	{
+		read_seq = __atomic_load_n(&header->read_seq, __ATOMIC_SEQ_CST);
+		if(!__atomic_load_n(&header->attached, __ATOMIC_SEQ_CST) || ((seq - read_seq) >= header->slots))
+		{
+			__atomic_add_fetch(&header->blocked, 1, __ATOMIC_SEQ_CST);
+			futex_wait(&header->read_seq, read_seq);
+			__atomic_sub_fetch(&header->blocked, 1, __ATOMIC_SEQ_CST);
+
+			read_seq = __atomic_load_n(&header->read_seq, __ATOMIC_SEQ_CST);
+			if(!__atomic_load_n(&header->attached, __ATOMIC_SEQ_CST) || ((seq - read_seq) >= header->slots))
+				return(0);
+		}
+	}
+
+	slot = Slot(seq);
+
+	/* Sequence lock, odd while the payload is changing */
+	__atomic_store_n(&slot->seq, 2*seq + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+
+	memcpy((char *)slot + sizeof(Shm_Slot_S), _data, _bytes);
+	slot->bytes = _bytes;
+
+	__atomic_store_n(&slot->seq, 2*seq + 2, __ATOMIC_RELEASE);
+
+	seq++;
+	__atomic_store_n(&header->write_seq, seq, __ATOMIC_SEQ_CST);
+
+	if(__atomic_load_n(&header->waiters, __ATOMIC_SEQ_CST))
+		futex_wake(&header->write_seq);
+
+	return(1);
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * Read: Copy out the next packet. If the writer has lapped the reader, skip ahead to the
+ * newest packet and report how many were lost in _lost. Returns the bytes read, 0 if nothing
+ * showed up within the timeout, or -1 if the writer went away.
+ * */
+int Shm_Ring::Read(void *_data, int _bytes, int *_lost)
+{
+	Shm_Slot_S *slot;
+	unsigned int write_seq, check;
+	int bytes;
+
+	*_lost = 0;
+
+	if(header == NULL)
+		return(-1);
+
+	while(1)
+	{
+		write_seq = __atomic_load_n(&header->write_seq, __ATOMIC_SEQ_CST);
+
+		if(__atomic_load_n(&header->magic, __ATOMIC_ACQUIRE) != SHM_RING_MAGIC)
+			return(-1);
+
+		/* Nothing new, sleep on the write sequence */
+		if(write_seq == seq)
+		{
+			__atomic_add_fetch(&header->waiters, 1, __ATOMIC_SEQ_CST);
+			futex_wait(&header->write_seq, write_seq);
+			__atomic_sub_fetch(&header->waiters, 1, __ATOMIC_SEQ_CST);
+
+			if(__atomic_load_n(&header->write_seq, __ATOMIC_SEQ_CST) == seq)
+				return(0);
+
+			continue;
+		}
+
+		/* Overrun, the slots we wanted are gone, jump to the newest packet */
+		if((write_seq - seq) > header->slots)
+		{
+			*_lost += write_seq - 1 - seq;
+			lost += write_seq - 1 - seq;
+			seq = write_seq - 1;
+		}
+
+		slot = Slot(seq);
+
+		check = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+		if(check != 2*seq + 2)
+		{
+			/* The writer lapped us while we were looking, try again */
+			*_lost += 1;
+			lost += 1;
+			seq++;
+			continue;
+		}
+
+		bytes = slot->bytes;
+		if(bytes > _bytes)
+			bytes = _bytes;
+
+		memcpy(_data, (char *)slot + sizeof(Shm_Slot_S), bytes);
+
+		/* Make sure the slot was not rewritten under the copy */
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		if(__atomic_load_n(&slot->seq, __ATOMIC_RELAXED) != check)
+		{
+			*_lost += 1;
+			lost += 1;
+			seq++;
+			continue;
+		}
+
+		seq++;
+
+		/* Let a blocking writer know there is room */
+		__atomic_store_n(&header->read_seq, seq, __ATOMIC_SEQ_CST);
+		if(__atomic_load_n(&header->blocked, __ATOMIC_SEQ_CST))
+			futex_wake(&header->read_seq);
+
+		return(bytes);
+	}
+
+}
+/*----------------------------------------------------------------------------------------------*/
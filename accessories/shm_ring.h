@@ -0,0 +1,99 @@
+/************************************************************************************************
+Copyright 2008 Gregory W Heckler
+
+This file is part of the GPS Software Defined Radio (GPS-SDR)
+
+The GPS-SDR is free software; you can redistribute it and/or modify it under the terms of the
+GNU General Public License as published by the Free Software Foundation; either version 2 of the
+License, or (at your option) any later version.
+
+The GPS-SDR is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with GPS-SDR; if not,
+write to the:
+
+Free Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+************************************************************************************************/
+
+#ifndef SHM_RING_H_
+#define SHM_RING_H_
+
+/* This file is shared with gps-usrp, so it only uses plain C types and must not pull in includes.h */
+
+#define SHM_RING_NAME		"/gps-sdr-if"	//!< Lives in /dev/shm/gps-sdr-if
+#define SHM_RING_MAGIC		(0x47505352)	//!< "GPSR", written last when the ring is ready
+#define SHM_RING_DEAD		(0x0)			//!< Written by a new writer to kick readers off an old ring
+#define SHM_RING_SLOTS		(256)			//!< In packets (ms)
+#define SHM_RING_SLOT_BYTES	(8192*4)		//!< Largest packet, 8192 complex int16 samples
+
+/*! \ingroup STRUCTS
+ *  Header at the start of the shared ring, every field gets its own cache line
+ */
+typedef struct _Shm_Ring_Header_S
+{
+
+	unsigned int magic;			//!< SHM_RING_MAGIC while the ring is valid
+	unsigned int slots;			//!< Number of slots
+	unsigned int slot_bytes;	//!< Payload bytes per slot
+	unsigned int stride;		//!< Bytes from one slot to the next
+	unsigned int pad0[12];
+
+	unsigned int write_seq;		//!< Packets published so far, readers futex wait on this
+	unsigned int waiters;		//!< Readers asleep on write_seq
+	unsigned int pad1[14];
+
+	unsigned int read_seq;		//!< Packets consumed so far, a blocking writer futex waits on this
+	unsigned int attached;		//!< A reader is attached
+	unsigned int blocked;		//!< Writer asleep on read_seq
+	unsigned int pad2[13];
+
+} Shm_Ring_Header_S;
+
+
+/*! \ingroup STRUCTS
+ *  Header of each slot, seq is odd while the slot is being written and 2*n+2 once packet n is in it
+ */
+typedef struct _Shm_Slot_S
+{
+
+	unsigned int seq;			//!< Sequence lock
+	unsigned int bytes;			//!< Payload bytes in this slot
+	unsigned int pad[14];
+
+} Shm_Slot_S;
+
+
+/*! \ingroup CLASSES
+ * Single writer, single reader ring of IF packets in POSIX shared memory. Replaces the
+ * /tmp/GPSPIPE named pipe between gps-usrp (or the post processor) and the FIFO.
+ */
+typedef class Shm_Ring
+{
+
+	private:
+
+		int fd;							//!< Shared memory file descriptor
+		int size;						//!< Bytes mapped
+		int writer;						//!< This side created the ring
+		unsigned int seq;				//!< Next packet to write (writer) or read (reader)
+		unsigned int lost;				//!< Packets the reader has lost to overruns
+		Shm_Ring_Header_S *header;		//!< Start of the mapping
+
+		Shm_Slot_S *Slot(unsigned int _seq);
+
+	public:
+
+		Shm_Ring();
+		~Shm_Ring();
+		int Create(int _slot_bytes, int _slots);		//!< Writer side, make a new ring, killing any old one
+		int Attach();									//!< Reader side, 1 if attached to a live ring
+		void Close();
+		int Write(void *_data, int _bytes, int _block);	//!< Publish a packet, if _block wait for the reader instead of overrunning it
+		int Read(void *_data, int _bytes, int *_lost);	//!< Get the next packet, returns bytes, 0 on timeout, -1 if the ring died
+		unsigned int getLost(){return(lost);}
+
+} Shm_Ring;
+
+#endif /*SHM_RING_H_*/
@@ -1,6 +1,7 @@
 clear all; close all;
 
-fp = fopen('/tmp/GPSPIPE','r');
+addpath('../matlab');
+fp = fopen('/dev/shm/gps-sdr-if','r');
 pts = 4096;
 paxis = 1:pts/2;
 % edges = -2048:128:2048;
@@ -19,7 +20,11 @@ scale = 1;
 
 while(1)
     
-    B = fread(fp,pts,'int16');
+    B = get_if(fp,pts);
+    if(length(B) ~= pts)
+        pause(0.01);
+        continue;
+    end
 
      mask = B < 0;
      A(mask)  = fix(2*B(mask)/scale-1.0);
@@ -31,16 +31,35 @@ typedef struct _Acquisition_test_options
 	int32 type;				//!< strong, medium, or weak
 	int32 doppler_min;		//!< doppler min (Hz)
 	int32 doppler_max;		//!< doppler max (Hz) 
+	int32 threads;			//!< threads sharing the search
+	int32 check;			//!< check the threaded search against a single thread
+	int32 fine;				//!< fine Doppler bins in each 250 Hz step
+	int32 rate;				//!< samples/ms of the file when it is searched at its own rate, 0 to downsample to 2048
 	char filename[1024]; 	//!< filename of raw data
 } Acquisition_test_options;
 
 void run_acq(Acquisition_test_options *_opt);
 void print_results(Acq_Result_S *_results);
 
+/* The FFT takes any product of 2, 3 and 5 */
+int32 rate_ok(int32 _rate)
+{
+
+	if((_rate < ACQ_MIN_RATE) || (_rate > ACQ_MAX_RATE))
+		return(0);
+
+	while((_rate % 2) == 0)	_rate /= 2;
+	while((_rate % 3) == 0)	_rate /= 3;
+	while((_rate % 5) == 0)	_rate /= 5;
+
+	return(_rate == 1);
+
+}
+
 void usage(char *_str)
 {
 
-    fprintf(stderr, "usage: [-sv] [-s] [-m] [-w] [-min] [-max] [-f] [-r]\n");
+    fprintf(stderr, "usage: [-sv] [-s] [-m] [-w] [-min] [-max] [-f] [-r] [-j] [-x] [-fine] [-rate]\n");
     fprintf(stderr, "[-r] repeat forever \n"); 
     fprintf(stderr, "[-min] <Doppler> minimum Doppler (Hz) \n");
     fprintf(stderr, "[-max] <Doppler> maximum Doppler (Hz) \n"); 
@@ -49,6 +68,10 @@ void usage(char *_str)
     fprintf(stderr, "[-s] Strong signal, 1 ms  coherent integration \n");
     fprintf(stderr, "[-m] Medium signal, 10 ms coherent integration \n");
     fprintf(stderr, "[-w] Weak signal, 10 ms  coherent integration + 15 non-coherent integrations \n");
+    fprintf(stderr, "[-j] <N> share the search over N threads (1:%d)\n",MAX_ACQ_WORKERS);
+    fprintf(stderr, "[-x] check the threaded search of all SVs against a single thread\n");
+    fprintf(stderr, "[-fine] <N> split each 250 Hz step of the medium and weak searches into N bins (1:%d)\n",ACQ_MAX_FINE);
+    fprintf(stderr, "[-rate] <N> the file is N samples/ms, search it at that rate instead of downsampling to %d (%d:%d, a product of 2, 3 and 5)\n",SAMPS_MS,ACQ_MIN_RATE,ACQ_MAX_RATE);
     fflush(stderr);
 
     exit(1);
@@ -61,6 +84,9 @@ void echo_options(Acquisition_test_options *_opt)
     fprintf(stderr, "Filename:\t\t%s\n",_opt->filename);
     fprintf(stderr, "Minimum Doppler (Hz):\t%d\n",_opt->doppler_min);
     fprintf(stderr, "Maximum Doppler (Hz):\t%d\n",_opt->doppler_max);
+    fprintf(stderr, "Threads:\t\t%d\n",_opt->threads);
+    fprintf(stderr, "Fine bins:\t\t%d\n",_opt->fine);
+    fprintf(stderr, "Rate (samps/ms):\t%d\n",_opt->rate ? _opt->rate : SAMPS_MS);
     fprintf(stderr, "Type:\t\t\t%d\n",_opt->type); 
     switch(_opt->type)
     {
@@ -96,6 +122,10 @@ int main(int32 argc, char* argv[])
 	acq_options.type = 0;
 	acq_options.doppler_min = -10000;
 	acq_options.doppler_max = 10000;
+	acq_options.threads = 1;
+	acq_options.check = 0;
+	acq_options.fine = ACQ_FINE;
+	acq_options.rate = 0;
 	strcpy(acq_options.filename, "data.dat");
 	
 	for(int lcv = 1; lcv < argc; lcv++)
@@ -144,6 +174,34 @@ int main(int32 argc, char* argv[])
 		{
 			acq_options.realtime = 1;
 		}
+		else if(!strcmp(argv[lcv], "-j"))
+		{
+			lcv++;
+			if((lcv < argc) && isdigit(argv[lcv][0]))
+				acq_options.threads = atoi(argv[lcv]);
+			if((acq_options.threads < 1) || (acq_options.threads > MAX_ACQ_WORKERS))
+				usage(argv[0]);
+		}
+		else if(!strcmp(argv[lcv], "-x"))
+		{
+			acq_options.check = 1;
+		}
+		else if(!strcmp(argv[lcv], "-fine"))
+		{
+			lcv++;
+			if((lcv < argc) && isdigit(argv[lcv][0]))
+				acq_options.fine = atoi(argv[lcv]);
+			if((acq_options.fine < 1) || (acq_options.fine > ACQ_MAX_FINE))
+				usage(argv[0]);
+		}
+		else if(!strcmp(argv[lcv], "-rate"))
+		{
+			lcv++;
+			if((lcv < argc) && isdigit(argv[lcv][0]))
+				acq_options.rate = atoi(argv[lcv]);
+			if(!rate_ok(acq_options.rate))
+				usage(argv[0]);
+		}
 		else
 			usage(argv[0]);
 	}
@@ -151,6 +209,10 @@ int main(int32 argc, char* argv[])
 	
 	/* Echo the record options */
 	echo_options(&acq_options);
+
+	/* The acquisition sizes its thread pool from the receiver options */
+	gopt.acq_workers = acq_options.threads;
+	gopt.acq_fine = acq_options.fine;
 	
 	/* Call the recording function */
 	run_acq(&acq_options);
@@ -189,12 +251,17 @@ void run_acq(Acquisition_test_options *_opt)
 	FILE *fp = NULL;
 	CPX *buff_in;
 	CPX *buff;
-	char *p;
 	int *ip;
 	Acq_Result_S results[NUM_CODES];
+	Acq_Result_S serial[NUM_CODES];
 	Acquisition *pAcquisition;
-	int32 sv, lcv, npipe;
-	int32 nbytes, bread, bytes_per_read, ms_per_read, agc_scale;
+	Acquisition *pSerial;
+	int32 svs[NUM_CODES];
+	int32 sv, lcv, errors, rate, base;
+	timeval t0, t1;
+	int32 nbytes, ms_per_read, agc_scale;
+	int nlost;		/* Shm_Ring only uses plain C types */
+	Shm_Ring ring;
 	
 	agc_scale = 1300;
 	
@@ -202,9 +269,16 @@ void run_acq(Acquisition_test_options *_opt)
 	time_t start,end;
     double dif;
 
+	/* The rate of the file, and the rate it is searched at. The ring is searched at its own rate,
+	 * the way the receiver does */
+	rate = _opt->rate ? _opt->rate : IF_SAMPS_MS;
+	base = _opt->rate ? _opt->rate : SAMPS_MS;
+	if(_opt->realtime)
+		base = IF_SAMPS_MS;
+
 	memset(results, 0x0, sizeof(Acq_Result_S)*NUM_CODES);
-	buff = new CPX[310*SAMPS_MS];
-	buff_in = new CPX[310*IF_SAMPS_MS];
+	buff = new CPX[310*base];
+	buff_in = new CPX[310*rate];
 	
 	/* Take care of file stuff */
 	if(!_opt->realtime)
@@ -218,26 +292,29 @@ void run_acq(Acquisition_test_options *_opt)
 		else
 		{
 
-			fread(buff_in, sizeof(CPX), 310*IF_SAMPS_MS, fp);
+			fread(buff_in, sizeof(CPX), 310*rate, fp);
 			fclose(fp);
-					
-			/* Downsample to 2048 samps/ms */
-			downsample(buff, buff_in, SAMPLE_FREQUENCY, IF_SAMPLE_FREQUENCY, IF_SAMPS_MS*310); 
+
+			/* Downsample to 2048 samps/ms, unless it is searched at its own rate */
+			if(_opt->rate)
+				memcpy(buff, buff_in, 310*rate*sizeof(CPX));
+			else
+				downsample(buff, buff_in, SAMPLE_FREQUENCY, IF_SAMPLE_FREQUENCY, IF_SAMPS_MS*310);
 	
 			printf("AGC Scale: %d\n",agc_scale);
 			
 			agc_scale = 300;
 
 			/* Init AGC scale value */		
-			init_agc(&buff[0], 10*SAMPS_MS, AGC_BITS, &agc_scale);
+			init_agc(&buff[0], 10*base, AGC_BITS, &agc_scale);
 		
 			/* Now run it */						
 			for(lcv = 0; lcv < 310; lcv++)
-				run_agc(&buff[lcv*SAMPS_MS], SAMPS_MS, AGC_BITS, &agc_scale);
+				run_agc(&buff[lcv*base], &buff[lcv*base], base, AGC_BITS, &agc_scale);
 		}
 	
 		/* Now do the hard work? */
-		pAcquisition = new Acquisition(IF_SAMPLE_FREQUENCY, IF_FREQUENCY);
+		pAcquisition = new Acquisition(rate*1000.0, IF_FREQUENCY, base*1000.0);
 	
 		pAcquisition->doPrepIF(_opt->type, buff);
 	
@@ -265,29 +342,67 @@ void run_acq(Acquisition_test_options *_opt)
 			printf("SV: %02d\t%02d\t%10.2f\t%10.0f\t%15.0f\n",lcv+1, results[sv].type,results[sv].delay,results[sv].doppler,results[sv].magnitude);				
 			
 		}
-		else	/* Loop over all SVs */
+		else	/* All SVs at once, shared over the threads */
 		{
 			for(lcv = 0; lcv < NUM_CODES; lcv++)
+				svs[lcv] = lcv;
+
+			gettimeofday(&t0, NULL);
+			pAcquisition->doAcqBatch(_opt->type, NUM_CODES, svs, _opt->doppler_min, _opt->doppler_max, results);
+			gettimeofday(&t1, NULL);
+
+			for(lcv = 0; lcv < NUM_CODES; lcv++)
+				printf("SV: %02d\t%02d\t%10.2f\t%10.0f\t%15.0f\n",lcv+1, results[lcv].type,results[lcv].delay,results[lcv].doppler,results[lcv].magnitude);
+
+			printf("Searched %d SVs in %.1f ms on %d threads\n",NUM_CODES,
+				(t1.tv_sec - t0.tv_sec)*1e3 + (t1.tv_usec - t0.tv_usec)*1e-3, _opt->threads);
+
+			/* The same search one SV at a time on a single thread has to give the same answers */
+			if(_opt->check)
 			{
-				sv = lcv;
-				switch(_opt->type)
+				gopt.acq_workers = 1;
+				pSerial = new Acquisition(rate*1000.0, IF_FREQUENCY, base*1000.0);
+				pSerial->doPrepIF(_opt->type, buff);
+
+				gettimeofday(&t0, NULL);
+				for(lcv = 0; lcv < NUM_CODES; lcv++)
 				{
-					case 0:
-						results[sv] = pAcquisition->doAcqStrong(sv, _opt->doppler_min, _opt->doppler_max);
-						break;
-					case 1:
-						results[sv] = pAcquisition->doAcqMedium(sv, _opt->doppler_min, _opt->doppler_max);
-						break;
-					case 2:
-						results[sv] = pAcquisition->doAcqWeak(sv, _opt->doppler_min, _opt->doppler_max);
-						break;
-					default:
-						fprintf(stderr, "Bad GPS acquisition type!\n");
-						exit(-1);
+					switch(_opt->type)
+					{
+						case 0:
+							serial[lcv] = pSerial->doAcqStrong(lcv, _opt->doppler_min, _opt->doppler_max);
+							break;
+						case 1:
+							serial[lcv] = pSerial->doAcqMedium(lcv, _opt->doppler_min, _opt->doppler_max);
+							break;
+						default:
+							serial[lcv] = pSerial->doAcqWeak(lcv, _opt->doppler_min, _opt->doppler_max);
+					}
 				}
-				
-				printf("SV: %02d\t%02d\t%10.2f\t%10.0f\t%15.0f\n",lcv+1, results[sv].type,results[sv].delay,results[sv].doppler,results[sv].magnitude);				
-				
+				gettimeofday(&t1, NULL);
+
+				printf("Searched %d SVs in %.1f ms on 1 thread\n",NUM_CODES,
+					(t1.tv_sec - t0.tv_sec)*1e3 + (t1.tv_usec - t0.tv_usec)*1e-3);
+
+				errors = 0;
+				for(lcv = 0; lcv < NUM_CODES; lcv++)
+				{
+					if((serial[lcv].delay != results[lcv].delay) || (serial[lcv].doppler != results[lcv].doppler) ||
+					   (serial[lcv].magnitude != results[lcv].magnitude) || (serial[lcv].success != results[lcv].success))
+					{
+						printf("SV %02d differs: %10.2f %10.0f %15.0f vs %10.2f %10.0f %15.0f\n",lcv+1,
+							results[lcv].delay,results[lcv].doppler,results[lcv].magnitude,serial[lcv].delay,serial[lcv].doppler,serial[lcv].magnitude);
+						errors++;
+					}
+				}
+
+				printf("%s: %d of %d SVs differ\n",errors ? "FAIL" : "PASS",errors,NUM_CODES);
+
+				gopt.acq_workers = _opt->threads;
+				delete pSerial;
+
+				if(errors)
+					exit(-1);
 			}
 		}
 		
@@ -314,30 +429,42 @@ void run_acq(Acquisition_test_options *_opt)
 				ms_per_read = 310;
 		}
 			
-		bytes_per_read = sizeof(CPX)*ms_per_read*IF_SAMPS_MS;
-
 		/* Now do the hard work? */
-		pAcquisition = new Acquisition(IF_SAMPLE_FREQUENCY, IF_FREQUENCY);
+		pAcquisition = new Acquisition(IF_SAMPLE_FREQUENCY, IF_FREQUENCY, IF_SAMPLE_FREQUENCY);
 
 		while(grun)
 		{
 			
-			npipe = open("/tmp/GPSPIPE",O_RDONLY);
-					
-			// Get data from pipe (310 ms)
-			nbytes = 0; p = (char *)&buff[0];
-			while((nbytes < bytes_per_read) && grun)
+			/* Attach to the gps-usrp shared ring, starting at the newest packet */
+			while(!ring.Attach() && grun)
+				usleep(100000);
+
+			// Get data from the ring (310 ms), 1 ms per packet
+			lcv = 0;
+			while((lcv < ms_per_read) && grun)
 			{
-				bread = read(npipe, &p[nbytes], PIPE_BUF);
-				
-				if(bread >= 0)
-					nbytes += bread;
+				nbytes = ring.Read(&buff[lcv*IF_SAMPS_MS], IF_SAMPS_MS*sizeof(CPX), &nlost);
+
+				/* The writer restarted, pick up the new ring and start over */
+				if(nbytes < 0)
+				{
+					while(!ring.Attach() && grun)
+						usleep(100000);
+					lcv = 0;
+				}
+				else if(nlost)
+					lcv = 0;	/* The search needs contiguous data */
+				else if(nbytes > 0)
+					lcv++;
 			}
-			
-			close(npipe);
+
+			ring.Close();
+
+			if(grun == false)
+				break;
 
 			for(lcv = 0; lcv < ms_per_read; lcv++)		
-				run_agc(&buff[lcv*SAMPS_MS], SAMPS_MS, AGC_BITS, &agc_scale);
+				run_agc(&buff[lcv*IF_SAMPS_MS], &buff[lcv*IF_SAMPS_MS], IF_SAMPS_MS, AGC_BITS, &agc_scale);
 				
 			/* Prep the IF Data */
 			pAcquisition->doPrepIF(_opt->type, buff);
@@ -392,7 +519,7 @@ void run_acq(Acquisition_test_options *_opt)
 			
 		}//end while
 		
-		close(npipe);
+		ring.Close();
 		
 	}
 	
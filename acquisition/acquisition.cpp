@@ -22,6 +22,32 @@ Free Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1
 
 //#define ACQ_DEBUG
 
+/*----------------------------------------------------------------------------------------------*/
+/*! Wall time, in us */
+static double wall_us(void)
+{
+	timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+
+	return((double)t.tv_sec*1e6 + (double)t.tv_nsec*1e-3);
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*! CPU time used by the calling thread, in us */
+static double cpu_us(void)
+{
+	timespec t;
+
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t);
+
+	return((double)t.tv_sec*1e6 + (double)t.tv_nsec*1e-3);
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
 /*----------------------------------------------------------------------------------------------*/
 void *Acquisition_Thread(void *_arg)
 {
@@ -42,28 +68,23 @@ void *Acquisition_Thread(void *_arg)
 
 
 /*----------------------------------------------------------------------------------------------*/
-void Acquisition::Start()
+void *Acquisition_Worker_Thread(void *_arg)
 {
-	pthread_attr_t tattr;
-	pthread_t tid;
-	int32 ret;
-	sched_param param;
 
-	/* Unitialized with default attributes */
-	ret = pthread_attr_init (&tattr);
+	Acq_Worker_S *aWorker = (Acq_Worker_S *)_arg;
 
-	/*Ssafe to get existing scheduling param */
-	ret = pthread_attr_getschedparam (&tattr, &param);
+	aWorker->aAcquisition->Work(aWorker->worker);
 
-	/* Set the priority; others are unchanged */
-	param.sched_priority = ACQ_PRIORITY;
+	pthread_exit(0);
 
-	/* Setting the new scheduling param */
-	ret = pthread_attr_setschedparam(&tattr, &param);
-	ret = pthread_attr_setschedpolicy(&tattr, SCHED_FIFO);
+}
+/*----------------------------------------------------------------------------------------------*/
 
-	/* With new priority specified */
-	pthread_create(&thread, NULL, Acquisition_Thread, NULL);
+
+/*----------------------------------------------------------------------------------------------*/
+void Acquisition::Start()
+{
+	Thread_Create(&thread, THREAD_ACQ, 0, Acquisition_Thread, NULL);
 
 	if(gopt.verbose)
 		printf("Acquisition thread started\n");
@@ -87,7 +108,7 @@ void Acquisition::Stop()
 /*!
  * Acquisition(): Constructor
  * */
-Acquisition::Acquisition(float _fsample, float _fif)
+Acquisition::Acquisition(float _fsample, float _fif, float _fbase)
 {
 
 	int32 lcv, lcv2;
@@ -101,24 +122,54 @@ Acquisition::Acquisition(float _fsample, float _fif)
 
 	/* Grab some constants */
 	fif = _fif;
-	fbase = SAMPLE_FREQUENCY;
+	fbase = _fbase;
 	fsample = _fsample;
 	samps_ms = (int32)ceil(fsample/1000.0);
 
-	/* Resample to the nearest 2^N */
-	resamps_ms = SAMPS_MS; //Always decimate to 2048 samples/ms for C/A code
+	/* Either the 2048 samps/ms everything is decimated to, or the data's own rate, which the FFT
+	 * can do as long as it is a product of 2, 3 and 5 */
+	resamps_ms = (int32)floor(fbase/1000.0 + 0.5);
 
-	/* Step one, grab pre-fftd codes from header file */
-	for(lcv = 0; lcv < NUM_CODES_WAAS; lcv++)
-		fft_codes[lcv] = (CPX *)&PRN_Codes[2*lcv*resamps_ms];
+	/* Step one, grab pre-fftd codes from header file, or make them for any other rate */
+	codes = NULL;
+	if(resamps_ms == SAMPS_MS)
+	{
+		for(lcv = 0; lcv < NUM_CODES_WAAS; lcv++)
+			fft_codes[lcv] = (CPX *)&PRN_Codes[2*lcv*resamps_ms];
+	}
+	else
+		initCodes();
+
+	/* Threads sharing each search */
+	nworkers = gopt.acq_workers;
+	if(nworkers < 1)
+		nworkers = 1;
+	if(nworkers > MAX_ACQ_WORKERS)
+		nworkers = MAX_ACQ_WORKERS;
+
+	/* Nothing to block until Acquire() is handed a cross correlation list */
+	ncross = 0;
+
+	/* Fine Doppler bins in each 250 Hz step of the 10 ms searches */
+	nfine = gopt.acq_fine;
+	if(nfine < 1)
+		nfine = ACQ_FINE;
+	if(nfine > ACQ_MAX_FINE)
+		nfine = ACQ_MAX_FINE;
 
 	/* Allocate some buffers that will be used later on */
 	buff	 = new CPX[310 * resamps_ms];
 	rotate   = new CPX[resamps_ms];
-	msbuff   = new CPX[resamps_ms];
-	power    = new CPX[10 * resamps_ms];
-	coherent = new CPX[10 * resamps_ms];
 	baseband = new CPX[4 * 310 * resamps_ms];
+
+	/* Each worker gets its own scratch */
+	for(lcv = 0; lcv < nworkers; lcv++)
+	{
+		msbuff[lcv]   = new CPX[resamps_ms];
+		power[lcv]    = new CPX[nfine * resamps_ms];
+		fine[lcv]     = new CPX[nfine * resamps_ms];
+		coherent[lcv] = new CPX[10 * resamps_ms];
+	}
 	_000Hzwipeoff = new CPX[310 * resamps_ms];
 	_250Hzwipeoff = new CPX[310 * resamps_ms];
 	_500Hzwipeoff = new CPX[310 * resamps_ms];
@@ -130,23 +181,23 @@ Acquisition::Acquisition(float _fsample, float _fif)
 	for(lcv = 0; lcv < 1240; lcv++)
 		baseband_rows[lcv] = &baseband_shift[lcv*(resamps_ms+201)];
 
-	/* Allocate baseband shift vector and map of the row pointers */
-	dft = new MIX[10*10];
-	dft_rows = new MIX *[10];
-	for(lcv = 0; lcv < 10; lcv++)
+	/* Allocate the post correlation DFT and map of the row pointers, one row per fine bin */
+	dft = new MIX[10*nfine];
+	dft_rows = new MIX *[nfine];
+	for(lcv = 0; lcv < nfine; lcv++)
 		dft_rows[lcv] = &dft[lcv*10];
 
-	/* Generate sinusoid */
-	for(lcv = 0; lcv < 10; lcv++)
-		wipeoff_gen(dft_rows[lcv], (float)lcv*25.0 - 112.5, 1000.0, 10);
+	/* Generate sinusoid, the bins are centred in the 250 Hz step */
+	for(lcv = 0; lcv < nfine; lcv++)
+		wipeoff_gen(dft_rows[lcv], ((double)lcv + 0.5)*250.0/nfine - 125.0, 1000.0, 10);
 
 	/* Generate mix to baseband */
-	sine_gen(_000Hzwipeoff, -fif, SAMPLE_FREQUENCY, 10*resamps_ms);
+	sine_gen(_000Hzwipeoff, -fif, fbase, 10*resamps_ms);
 
 	/* Generate 250 Hz offset wipeoff */
-	sine_gen(_250Hzwipeoff, -fif-250.0, SAMPLE_FREQUENCY, 10*resamps_ms);
-	sine_gen(_500Hzwipeoff, -fif-500.0, SAMPLE_FREQUENCY, 10*resamps_ms);
-	sine_gen(_750Hzwipeoff, -fif-750.0, SAMPLE_FREQUENCY, 10*resamps_ms);
+	sine_gen(_250Hzwipeoff, -fif-250.0, fbase, 10*resamps_ms);
+	sine_gen(_500Hzwipeoff, -fif-500.0, fbase, 10*resamps_ms);
+	sine_gen(_750Hzwipeoff, -fif-750.0, fbase, 10*resamps_ms);
 
 	/* Copy to all 310 ms */
 	for(lcv = 1; lcv < 31; lcv++)
@@ -159,8 +210,42 @@ Acquisition::Acquisition(float _fsample, float _fif)
 
 	/* Allocate the FFTs */
 	pFFT = new FFT(resamps_ms, R1);
-	piFFT = new FFT(resamps_ms, R2);
 	pcFFT = new FFT(32);
+	for(lcv = 0; lcv < nworkers; lcv++)
+		piFFT[lcv] = new FFT(resamps_ms, R2);
+
+	if(!pFFT->getValid())
+	{
+		printf("Acquisition can not do a %d point FFT!\n", resamps_ms);
+		exit(1);
+	}
+
+	/* Start the pool, it has to be up before Post_Process does its searches */
+	pthread_mutex_init(&pool_mutex, NULL);
+	pthread_cond_init(&pool_work, NULL);
+	pthread_cond_init(&pool_done, NULL);
+	pool_run = 1;
+	pool_job = 0;
+	pool_busy = 0;
+	units = NULL;
+	nunits = 0;
+	next_unit = 0;
+
+	for(lcv = 0; lcv < nworkers; lcv++)
+	{
+		workers[lcv].aAcquisition = this;
+		workers[lcv].worker = lcv;
+		cpu_last[lcv] = 0;
+	}
+
+	/* An empty bucket, it fills at the budgeted share of a CPU */
+	pthread_mutex_init(&budget_mutex, NULL);
+	budget_rate = (gopt.acq_budget > 0 ? gopt.acq_budget : ACQ_BUDGET)/100.0;
+	budget = 0;
+	budget_time = wall_us();
+
+	for(lcv = 1; lcv < nworkers; lcv++)
+		Thread_Create(&workers[lcv].thread, THREAD_ACQ, lcv, Acquisition_Worker_Thread, &workers[lcv]);
 
 	if(gopt.verbose)
 		printf("Creating Acquisition\n");
@@ -178,24 +263,44 @@ Acquisition::~Acquisition()
 
 	int32 lcv;
 
+	/* Shut down the pool */
+	pthread_mutex_lock(&pool_mutex);
+	pool_run = 0;
+	pthread_cond_broadcast(&pool_work);
+	pthread_mutex_unlock(&pool_mutex);
+
+	for(lcv = 1; lcv < nworkers; lcv++)
+		pthread_join(workers[lcv].thread, NULL);
+
+	pthread_cond_destroy(&pool_work);
+	pthread_cond_destroy(&pool_done);
+	pthread_mutex_destroy(&pool_mutex);
+	pthread_mutex_destroy(&budget_mutex);
+
 	delete pFFT;
-	delete piFFT;
 	delete pcFFT;
 
+	for(lcv = 0; lcv < nworkers; lcv++)
+	{
+		delete piFFT[lcv];
+		delete [] msbuff[lcv];
+		delete [] coherent[lcv];
+		delete [] power[lcv];
+		delete [] fine[lcv];
+	}
+
 	delete [] buff;
 	delete [] rotate;
-	delete [] msbuff;
 	delete [] baseband;
 	delete [] baseband_shift;
 	delete [] baseband_rows;
-	delete [] coherent;
-	delete [] power;
 	delete [] dft;
 	delete [] dft_rows;
 	delete [] _000Hzwipeoff;
 	delete [] _250Hzwipeoff;
 	delete [] _500Hzwipeoff;
 	delete [] _750Hzwipeoff;
+	delete [] codes;
 
 	#ifdef ACQ_DEBUG
 		close(acq_pipe);
@@ -238,16 +343,15 @@ void Acquisition::doPrepIF(int32 _type, CPX *_buff)
 	memcpy(baseband, _buff, ms*resamps_ms*sizeof(CPX));
 
 	/* Do the 250 Hz offsets */
-	sse_cmulsc(&baseband[0], _250Hzwipeoff, &baseband[ms*resamps_ms],   ms*resamps_ms, 14);
-	sse_cmulsc(&baseband[0], _500Hzwipeoff, &baseband[2*ms*resamps_ms], ms*resamps_ms, 14);
-	sse_cmulsc(&baseband[0], _750Hzwipeoff, &baseband[3*ms*resamps_ms], ms*resamps_ms, 14);
+	simd_cmulsc(&baseband[0], _250Hzwipeoff, &baseband[ms*resamps_ms],   ms*resamps_ms, 14);
+	simd_cmulsc(&baseband[0], _500Hzwipeoff, &baseband[2*ms*resamps_ms], ms*resamps_ms, 14);
+	simd_cmulsc(&baseband[0], _750Hzwipeoff, &baseband[3*ms*resamps_ms], ms*resamps_ms, 14);
 
 	/* Mix down to baseband */
 	sse_cmuls(baseband, _000Hzwipeoff, ms*resamps_ms, 14);
 
-	/* Compute forward FFT of IF data */
-	for(lcv = 0; lcv < 4*ms; lcv++)
-		pFFT->doFFT(&baseband[lcv*resamps_ms], true);
+	/* Compute forward FFT of IF data, all 4*ms rows in one go */
+	pFFT->doFFTBatch(baseband, 4*ms, resamps_ms, true);
 
 	/* Now copy into the rows */
 	for(lcv = 0; lcv < 4*ms; lcv++)
@@ -269,58 +373,191 @@ void Acquisition::doPrepIF(int32 _type, CPX *_buff)
 Acq_Result_S Acquisition::doAcqStrong(int32 _sv, int32 _doppmin, int32 _doppmax)
 {
 
-	FILE *fp;
-	int32 lcv, lcv2, mag, magt, index, indext;
-	Acq_Result_S *result = &results[_sv];
-	CPX *p;
+	doSearch(ACQ_STRONG, 1, &_sv, _doppmin, _doppmax);
 
-	index = indext = mag = magt = 0;
+	return(results[_sv]);
 
-	/* Covers the 250 Hz spacing */
-	for(lcv = (_doppmin/1000); lcv <  (_doppmax/1000); lcv++)
-	{
-		/* Sweep through the doppler range */
-		for(lcv2 = 0; lcv2 < 4; lcv2+=1)
-		{
+}
+/*----------------------------------------------------------------------------------------------*/
 
-			if(gopt.realtime)
-				usleep(1000);
 
-			/* Multiply in frequency domain, shifting appropiately */
-			sse_cmulsc(&baseband_rows[lcv2][100+lcv], fft_codes[_sv], msbuff, resamps_ms, 10);
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * doAcqMedium: Acquire using a 10 ms coherent integration
+ * */
+Acq_Result_S Acquisition::doAcqMedium(int32 _sv, int32 _doppmin, int32 _doppmax)
+{
 
-			/* Compute iFFT */
-			piFFT->doiFFT(msbuff, true);
+	doSearch(ACQ_MEDIUM, 1, &_sv, _doppmin, _doppmax);
 
-			/* Convert to a power */
-			x86_cmag(msbuff, resamps_ms);
+	return(results[_sv]);
 
-			/* Find the maximum */
-			x86_max((int32 *)msbuff, &indext, &magt, resamps_ms);
+}
+/*----------------------------------------------------------------------------------------------*/
 
-			/* Found a new maximum */
-			if(magt > mag)
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * doAcqWeak: Acquire using a 10 ms coherent integration and 15 incoherent integrations
+ * */
+Acq_Result_S Acquisition::doAcqWeak(int32 _sv, int32 _doppmin, int32 _doppmax)
+{
+
+	doSearch(ACQ_WEAK, 1, &_sv, _doppmin, _doppmax);
+
+	return(results[_sv]);
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * doAcqBatch: Search every sv in _svs against the same prepped IF in one job, so the pool has
+ * PRNs x Doppler rows to share out rather than just the rows of one sv
+ * */
+void Acquisition::doAcqBatch(int32 _type, int32 _nsvs, const int32 *_svs, int32 _doppmin, int32 _doppmax, Acq_Result_S *_results)
+{
+
+	int32 lcv;
+
+	doSearch(_type, _nsvs, _svs, _doppmin, _doppmax);
+
+	for(lcv = 0; lcv < _nsvs; lcv++)
+		_results[_svs[lcv]] = results[_svs[lcv]];
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * doSearch: Split the search into one unit per sv and 1 kHz Doppler row, run them on the pool,
+ * then merge the rows back in the order the serial search used to visit them. A row only has to
+ * beat the rows before it, so the result is the same whatever order the rows finished in.
+ * */
+void Acquisition::doSearch(int32 _type, int32 _nsvs, const int32 *_svs, int32 _doppmin, int32 _doppmax)
+{
+
+	Acq_Result_S *result;
+	Acq_Unit_S *job, *u;
+	int32 lcv, lcv2, first, rows, mag, index;
+	float thresh;
+
+	/* The medium search includes the top row, the others stop short of it */
+	first = _doppmin/1000;
+	rows = _doppmax/1000 - first;
+	if(_type == ACQ_MEDIUM)
+		rows++;
+	if(rows < 0)
+		rows = 0;
+
+	job = new Acq_Unit_S[_nsvs*rows + 1];
+
+	for(lcv = 0; lcv < _nsvs; lcv++)
+		for(lcv2 = 0; lcv2 < rows; lcv2++)
+		{
+			u = &job[lcv*rows + lcv2];
+			u->sv = _svs[lcv];
+			u->row = first + lcv2;
+			u->bin = 0;
+			u->index = 0;
+			u->mag = 0;
+		}
+
+	doJob(_type, job, _nsvs*rows);
+
+	for(lcv = 0; lcv < _nsvs; lcv++)
+	{
+		result = &results[_svs[lcv]];
+
+		/* Found a new maximum */
+		mag = 0;
+		for(lcv2 = 0; lcv2 < rows; lcv2++)
+		{
+			u = &job[lcv*rows + lcv2];
+			if(u->mag > mag)
 			{
-				mag = magt;
-				index = indext;
-				result->delay = CODE_CHIPS - (float)index*CODE_RATE/fbase;
-				result->doppler = (float)(lcv*1000) + (float)lcv2*250;
+				mag = u->mag;
+				if(_type == ACQ_STRONG)
+				{
+					result->delay = CODE_CHIPS - (float)u->index*CODE_RATE/fbase;
+					result->doppler = (float)(u->row*1000) + (float)u->bin*250;
+				}
+				else
+				{
+					index = u->index % resamps_ms;
+					result->delay = CODE_CHIPS - (float)index*CODE_RATE/fbase;
+					result->doppler = (float)(u->row*1000) + (float)(u->bin*250) + (u->index/resamps_ms)*250.0/nfine;
+				}
 				result->magnitude = (float)mag;
 			}
+		}
 
+		switch(_type)
+		{
+			case ACQ_MEDIUM:
+				thresh = THRESH_MEDIUM;
+				break;
+			case ACQ_WEAK:
+				thresh = THRESH_WEAK;
+				break;
+			default:
+				thresh = THRESH_STRONG;
 		}
+
+		result->sv = _svs[lcv];
+
+		result->type = _type;
+
+		if(result->magnitude > thresh)
+			result->success = 1;
+		else
+			result->success = 0;
 	}
 
-	result->sv = _sv;
+	delete [] job;
 
-	result->type = ACQ_STRONG;
+}
+/*----------------------------------------------------------------------------------------------*/
 
-	if(result->magnitude > THRESH_STRONG)
-		result->success = 1;
-	else
-		result->success = 0;
 
-	return(results[_sv]);
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * doJob: Post the units to the pool and work on them alongside it. Every worker has to check in
+ * and out of each job, so none can still be looking at the units once this returns.
+ * */
+void Acquisition::doJob(int32 _type, Acq_Unit_S *_units, int32 _nunits)
+{
+
+	int cancel;
+
+	/* A cancel while waiting on the pool would leave the pool mutex held */
+	pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &cancel);
+
+	pthread_mutex_lock(&pool_mutex);
+
+	job_type = _type;
+	units = _units;
+	nunits = _nunits;
+	__atomic_store_n(&next_unit, 0, __ATOMIC_RELEASE);
+	pool_busy = nworkers;
+	pool_job++;
+
+	pthread_cond_broadcast(&pool_work);
+	pthread_mutex_unlock(&pool_mutex);
+
+	doUnits(0);
+
+	pthread_mutex_lock(&pool_mutex);
+
+	pool_busy--;
+	while(pool_busy > 0)
+		pthread_cond_wait(&pool_done, &pool_mutex);
+
+	pthread_mutex_unlock(&pool_mutex);
+
+	pthread_setcancelstate(cancel, NULL);
 
 }
 /*----------------------------------------------------------------------------------------------*/
@@ -328,133 +565,356 @@ Acq_Result_S Acquisition::doAcqStrong(int32 _sv, int32 _doppmin, int32 _doppmax)
 
 /*----------------------------------------------------------------------------------------------*/
 /*!
- * doAcqMedium: Acquire using a 10 ms coherent integrationACQ_WEAK
+ * Work: A pool thread, sleeps until a job is posted then helps with it
  * */
-Acq_Result_S Acquisition::doAcqMedium(int32 _sv, int32 _doppmin, int32 _doppmax)
+void Acquisition::Work(int32 _worker)
 {
-	Acq_Result_S *result;
-	int32 lcv, lcv2, lcv3, mag, magt, index, indext, j, k, dopp, skip;
-	int32 iaccum, qaccum;
-	CPX temp[10];
-	int32 data[32];
-	CPX *dp = (CPX *)&data[0];
-	int32 *dt = (int32 *)&temp[0];
-	int32 *p;
-
-	result = &results[_sv];
-	index = indext = mag = magt = 0;
-
-	/* Sweeps through the doppler range */
-	for(lcv = (_doppmin/1000); lcv <=  (_doppmax/1000); lcv++)
+
+	int32 job;
+
+	job = 0;
+
+	while(1)
+	{
+		pthread_mutex_lock(&pool_mutex);
+
+		while(pool_run && (pool_job == job))
+			pthread_cond_wait(&pool_work, &pool_mutex);
+
+		if(!pool_run)
+		{
+			pthread_mutex_unlock(&pool_mutex);
+			break;
+		}
+
+		job = pool_job;
+
+		pthread_mutex_unlock(&pool_mutex);
+
+		doUnits(_worker);
+
+		pthread_mutex_lock(&pool_mutex);
+
+		pool_busy--;
+		if(pool_busy == 0)
+			pthread_cond_signal(&pool_done);
+
+		pthread_mutex_unlock(&pool_mutex);
+	}
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+void Acquisition::doUnits(int32 _worker)
+{
+
+	int32 unit;
+
+	/* Only the search is charged to the budget */
+	cpu_last[_worker] = cpu_us();
+
+	while((unit = __atomic_fetch_add(&next_unit, 1, __ATOMIC_ACQ_REL)) < nunits)
+	{
+		switch(job_type)
+		{
+			case ACQ_MEDIUM:
+				doMediumRow(_worker, &units[unit]);
+				break;
+			case ACQ_WEAK:
+				doWeakRow(_worker, &units[unit]);
+				break;
+			default:
+				doStrongRow(_worker, &units[unit]);
+		}
+	}
+
+	Charge(_worker);
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+void Acquisition::Charge(int32 _worker)
+{
+
+	double cpu;
+
+	if(!gopt.realtime)
+		return;
+
+	cpu = cpu_us();
+
+	pthread_mutex_lock(&budget_mutex);
+	budget -= cpu - cpu_last[_worker];
+	pthread_mutex_unlock(&budget_mutex);
+
+	cpu_last[_worker] = cpu;
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * Pace: Called before each chunk of a search (at most a few ms of work). The bucket fills at
+ * gopt.acq_budget percent of a CPU and each chunk's thread CPU time is taken out of it, so the
+ * search runs back to back when there is budget and only sleeps off an overdraft. Whatever the
+ * budget, the search stands aside while the slowest correlator is falling behind the FIFO head.
+ * Recorded data waits for nothing, so there the search runs flat out.
+ * */
+void Acquisition::Pace(int32 _worker)
+{
+
+	double now, wait;
+	int32 late;
+
+	if(!gopt.realtime)
+		return;
+
+	Charge(_worker);
+
+	pthread_mutex_lock(&budget_mutex);
+
+	while(grun)
 	{
-		/* Covers the 250 Hz spacing */
-		for(lcv2 = 0; lcv2 < 4; lcv2++)
+		/* Top up the bucket for the time gone by, unused budget only carries over so far */
+		now = wall_us();
+		budget += (now - budget_time)*budget_rate;
+		budget_time = now;
+		if(budget > ACQ_BURST*1000.0*budget_rate)
+			budget = ACQ_BURST*1000.0*budget_rate;
+
+		/* The correlators' slack, anything past their own batch means tracking is running late */
+		late = (pFIFO->Backlog() > (gopt.corr_batch + ACQ_MAX_BACKLOG));
+
+		if((budget >= 0) && !late)
+			break;
+
+		/* Sleep off the overdraft, or give tracking a ms to catch up */
+		wait = late ? 1000.0 : -budget/budget_rate;
+		if(wait > ACQ_BURST*1000.0)
+			wait = ACQ_BURST*1000.0;
+
+		pthread_mutex_unlock(&budget_mutex);
+		usleep((useconds_t)wait + 1);
+		pthread_mutex_lock(&budget_mutex);
+	}
+
+	pthread_mutex_unlock(&budget_mutex);
+
+	/* The sleep is not charged */
+	cpu_last[_worker] = cpu_us();
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * doStrongRow: One 1 kHz row of the 1 ms coherent search
+ * */
+void Acquisition::doStrongRow(int32 _worker, Acq_Unit_S *_unit)
+{
+
+	int32 lcv, lcv2, mag, magt, indext;
+	CPX *msbuff = this->msbuff[_worker];
+	FFT *piFFT = this->piFFT[_worker];
+
+	lcv = _unit->row;
+	indext = mag = magt = 0;
+
+	/* Covers the 250 Hz spacing */
+	for(lcv2 = 0; lcv2 < 4; lcv2+=1)
+	{
+
+		/* Wait for spare CPU */
+		Pace(_worker);
+
+		/* Multiply in frequency domain, shifting appropiately */
+		simd_cmulsc(&baseband_rows[lcv2][100+lcv], fft_codes[_unit->sv], msbuff, resamps_ms, 10);
+
+		/* Compute iFFT */
+		piFFT->doiFFT(msbuff, true);
+
+		/* Convert to a power */
+		x86_cmag(msbuff, resamps_ms);
+
+		/* Find the maximum */
+		x86_max((int32 *)msbuff, &indext, &magt, resamps_ms);
+
+		/* Found a new maximum */
+		if(magt > mag)
 		{
-			/* Do both even and odd */
-			//for(k = 0; k < 2; k++)
-			k = 0;
+			mag = magt;
+			_unit->index = indext;
+			_unit->bin = lcv2;
+		}
+
+	}
+
+	_unit->mag = mag;
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * doMediumRow: One 1 kHz row of the 10 ms coherent search
+ * */
+void Acquisition::doMediumRow(int32 _worker, Acq_Unit_S *_unit)
+{
+
+	int32 lcv, lcv2, lcv3, mag, magt, indext, j, k, dopp, skip;
+	CPX *coherent = this->coherent[_worker];
+	CPX *power = this->power[_worker];
+	FFT *piFFT = this->piFFT[_worker];
+
+	lcv = _unit->row;
+	indext = mag = magt = 0;
+
+	/* Covers the 250 Hz spacing */
+	for(lcv2 = 0; lcv2 < 4; lcv2++)
+	{
+		/* Do both even and odd */
+		//for(k = 0; k < 2; k++)
+		k = 0;
+		{
+
+			/* Wait for spare CPU */
+			Pace(_worker);
+
+			/* Do the 10 ms of coherent integration */
+			for(lcv3 = 0; lcv3 < 10; lcv3++)
 			{
+				/* Multiply in frequency domain, shifting appropiately */
+				simd_cmulsc(&baseband_rows[lcv2*20 + lcv3 + k*10][100+lcv], fft_codes[_unit->sv], &coherent[lcv3*resamps_ms], resamps_ms, 10);
+			}
 
-				if(gopt.realtime)
-					usleep(1000);
+			/* Compute the 10 iFFTs together */
+			piFFT->doiFFTBatch(coherent, 10, resamps_ms, true);
 
-				/* Do the 10 ms of coherent integration */
-				for(lcv3 = 0; lcv3 < 10; lcv3++)
-				{
-					/* Multiply in frequency domain, shifting appropiately */
-					sse_cmulsc(&baseband_rows[lcv2*20 + lcv3 + k*10][100+lcv], fft_codes[_sv], &coherent[lcv3*resamps_ms], resamps_ms, 10);
+			/* Split the 10 ms into the fine Doppler bins, straight into the power matrix */
+			doFine(coherent, power);
 
-					/* Compute iFFT */
-					piFFT->doiFFT(&coherent[lcv3*resamps_ms], true);
-				}
+			/* Convert to a power */
+			x86_cmag(&power[0], nfine*resamps_ms);
 
-				/* For each delay do the post-corr FFT, this REALLY needs sped up */
-				for(lcv3 = 0; lcv3 < resamps_ms; lcv3++)
-				{
-					/* Copy over the relevant data pts */
-					p = (int32 *)&coherent[lcv3];
-					data[0] = *p; p += resamps_ms;
-					data[1] = *p; p += resamps_ms;
-					data[2] = *p; p += resamps_ms;
-					data[3] = *p; p += resamps_ms;
-					data[4] = *p; p += resamps_ms;
-					data[5] = *p; p += resamps_ms;
-					data[6] = *p; p += resamps_ms;
-					data[7] = *p; p += resamps_ms;
-					data[8] = *p; p += resamps_ms;
-					data[9] = *p;
-
-					/* Do the post-correlation dft */
-					sse_cacc(dp, dft_rows[0], 10, &iaccum, &qaccum); temp[0].i = iaccum >> 16; temp[0].q = qaccum >> 16;
-					sse_cacc(dp, dft_rows[1], 10, &iaccum, &qaccum); temp[1].i = iaccum >> 16; temp[1].q = qaccum >> 16;
-					sse_cacc(dp, dft_rows[2], 10, &iaccum, &qaccum); temp[2].i = iaccum >> 16; temp[2].q = qaccum >> 16;
-					sse_cacc(dp, dft_rows[3], 10, &iaccum, &qaccum); temp[3].i = iaccum >> 16; temp[3].q = qaccum >> 16;
-					sse_cacc(dp, dft_rows[4], 10, &iaccum, &qaccum); temp[4].i = iaccum >> 16; temp[4].q = qaccum >> 16;
-					sse_cacc(dp, dft_rows[5], 10, &iaccum, &qaccum); temp[5].i = iaccum >> 16; temp[5].q = qaccum >> 16;
-					sse_cacc(dp, dft_rows[6], 10, &iaccum, &qaccum); temp[6].i = iaccum >> 16; temp[6].q = qaccum >> 16;
-					sse_cacc(dp, dft_rows[7], 10, &iaccum, &qaccum); temp[7].i = iaccum >> 16; temp[7].q = qaccum >> 16;
-					sse_cacc(dp, dft_rows[8], 10, &iaccum, &qaccum); temp[8].i = iaccum >> 16; temp[8].q = qaccum >> 16;
-					sse_cacc(dp, dft_rows[9], 10, &iaccum, &qaccum); temp[9].i = iaccum >> 16; temp[9].q = qaccum >> 16;
-
-					/* Put into the power matrix */
-					p = (int32 *)&power[lcv3];
-					*p = dt[0]; p += resamps_ms;
-					*p = dt[1]; p += resamps_ms;
-					*p = dt[2]; p += resamps_ms;
-					*p = dt[3]; p += resamps_ms;
-					*p = dt[4]; p += resamps_ms;
-					*p = dt[5]; p += resamps_ms;
-					*p = dt[6]; p += resamps_ms;
-					*p = dt[7]; p += resamps_ms;
-					*p = dt[8]; p += resamps_ms;
-					*p = dt[9];
+			/* Find the maximum */
+			x86_max((int32 *)power, &indext, &magt, nfine*resamps_ms);
 
+			/* Found a new maximum */
+			if(magt > mag)
+			{
+
+				skip = false;
+				dopp = lcv*1000 + lcv2*250 + ((indext/resamps_ms)*250)/nfine;
+				for(j = 0; j < ncross; j++)
+					if(abs(dopp - cross_doppler[j]) < 100)
+						skip = true;
+
+				if(!skip)
+				{
+					mag = magt;
+					_unit->index = indext;
+					_unit->bin = lcv2;
 				}
 
-				/* Convert to a power */
-				x86_cmag(&power[0], 10*resamps_ms);
+			}
 
-				/* Find the maximum */
-				x86_max((int32 *)power, &indext, &magt, 10*resamps_ms);
+		}//end k
 
-				/* Found a new maximum */
-				if(magt > mag)
-				{
+	}//end lcv2
 
-					skip = false;
-					dopp = lcv*1000 + lcv2*250 + (indext/resamps_ms)*25;
-					for(j = 0; j < ncross; j++)
-						if(abs(dopp - cross_doppler[j]) < 100)
-							skip = true;
-
-					if(!skip)
-					{
-						mag = magt;
-						index = indext % resamps_ms;
-						result->delay = CODE_CHIPS - (float)index*CODE_RATE/fbase;
-						result->doppler = (float)(lcv*1000) + (float)(lcv2*250) + (indext/resamps_ms)*25.0;
-						result->magnitude = (float)mag;
-					}
+	_unit->mag = mag;
 
-				}
+}
+/*----------------------------------------------------------------------------------------------*/
 
-			}//end k
 
-		}//end lcv2
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * doFine: The post correlation DFT of 10 ms of coherent integration, _coherent holds one row of
+ * delays per ms and _out gets one row of delays per fine bin. A block of delays goes through all
+ * the bins before the next, so the 10 rows of it stay in cache, and every bin is one simd_dft
+ * straight along the rows.
+ * */
+void Acquisition::doFine(CPX *_coherent, CPX *_out)
+{
 
-	}//end lcv
+	int32 lcv, lcv2, cnt;
 
+	for(lcv = 0; lcv < resamps_ms; lcv += ACQ_DFT_BLOCK)
+	{
+		cnt = resamps_ms - lcv;
+		if(cnt > ACQ_DFT_BLOCK)
+			cnt = ACQ_DFT_BLOCK;
 
-	result->sv = _sv;
+		for(lcv2 = 0; lcv2 < nfine; lcv2++)
+			simd_dft(&_coherent[lcv], resamps_ms, dft_rows[lcv2], 10, &_out[lcv2*resamps_ms + lcv], cnt);
+	}
 
-	result->type = ACQ_MEDIUM;
+}
+/*----------------------------------------------------------------------------------------------*/
 
-	if(result->magnitude > THRESH_MEDIUM)
-		result->success = 1;
-	else
-		result->success = 0;
 
-	return(results[_sv]);
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * initCodes: What gen_fft_codes.m does for the table, at whatever rate the search runs at. The
+ * chips are sampled at the rate, FFTd, conjugated and scaled so the largest bin of any code is
+ * 9 bits.
+ * */
+void Acquisition::initCodes()
+{
+
+	int32 lcv, lcv2;
+	double mag, peak, scale;
+	CPX chips[CODE_CHIPS];
+	CPX *p;
+	FFT *cFFT;
+
+	codes = new CPX[NUM_CODES_WAAS*resamps_ms];
+	cFFT = new FFT(resamps_ms);
+	if(!cFFT->getValid())
+	{
+		printf("Acquisition can not do a %d point FFT!\n", resamps_ms);
+		exit(1);
+	}
+	peak = 0;
+
+	for(lcv = 0; lcv < NUM_CODES_WAAS; lcv++)
+	{
+		p = fft_codes[lcv] = &codes[lcv*resamps_ms];
+
+		code_gen(chips, lcv);
+		for(lcv2 = 0; lcv2 < resamps_ms; lcv2++)
+		{
+			p[lcv2].i = chips[(lcv2*CODE_CHIPS)/resamps_ms].i ? 16383 : -16383;
+			p[lcv2].q = 0;
+		}
+
+		cFFT->doFFT(p, true);
+
+		for(lcv2 = 0; lcv2 < resamps_ms; lcv2++)
+		{
+			mag = sqrt((double)p[lcv2].i*p[lcv2].i + (double)p[lcv2].q*p[lcv2].q);
+			if(mag > peak)
+				peak = mag;
+		}
+	}
+
+	scale = peak > 0 ? 512.0/peak : 0;
+
+	for(lcv = 0; lcv < NUM_CODES_WAAS*resamps_ms; lcv++)
+	{
+		codes[lcv].i = (int16)floor(codes[lcv].i*scale + 0.5);
+		codes[lcv].q = (int16)-floor(codes[lcv].q*scale + 0.5);
+	}
+
+	delete cFFT;
 
 }
 /*----------------------------------------------------------------------------------------------*/
@@ -462,155 +922,109 @@ Acq_Result_S Acquisition::doAcqMedium(int32 _sv, int32 _doppmin, int32 _doppmax)
 
 /*----------------------------------------------------------------------------------------------*/
 /*!
- * doAcqWeak: Acquire using a 10 ms coherent integration and 15 incoherent integrations
+ * doWeakRow: One 1 kHz row of the 10 ms coherent, 15 incoherent search
  * */
-Acq_Result_S Acquisition::doAcqWeak(int32 _sv, int32 _doppmin, int32 _doppmax)
+void Acquisition::doWeakRow(int32 _worker, Acq_Unit_S *_unit)
 {
 
-	Acq_Result_S *result;
-	int32 lcv, lcv2, lcv3, mag, magt, index, indext, k, i, j, skip, dopp;
-	int32 iaccum, qaccum;
-	int32 data[32];
-	CPX *dp = (CPX *)&data[0];
-	CPX temp[10];
-	int32 *dt = (int32 *)&temp[0];
-	int32 *p;
+	int32 lcv, lcv2, lcv3, mag, magt, indext, k, i, j, skip, dopp;
+	int32 *p, *f;
 	double code_doppler;
 	double doppler;
 	int32 shift;
+	CPX *coherent = this->coherent[_worker];
+	CPX *power = this->power[_worker];
+	CPX *fine = this->fine[_worker];
+	FFT *piFFT = this->piFFT[_worker];
 
-	result = &results[_sv];
-	index = indext = mag = magt = 0;
+	lcv = _unit->row;
+	indext = mag = magt = 0;
 
-	/* Sweeps through the doppler range */
-	for(lcv = (_doppmin/1000); lcv <  (_doppmax/1000); lcv++)
+	/* Covers the 250 Hz spacing */
+	for(lcv2 = 0; lcv2 < 4; lcv2++)
 	{
-
-		/* Covers the 250 Hz spacing */
-		for(lcv2 = 0; lcv2 < 4; lcv2++)
+		/* Do both even and odd */
+		//for(k = 0; k < 2; k++)
+		k = 0;
 		{
-			/* Do both even and odd */
-			//for(k = 0; k < 2; k++)
-			k = 0;
+
+			/* Clear out incoherent int */
+			memset(power, 0x0, nfine*resamps_ms*sizeof(CPX));
+
+			/* Loop over 15 incoherent integrations */
+			for(i = 0; i < 15; i++)
 			{
 
-				/* Clear out incoherent int */
-				memset(power, 0x0, 10*resamps_ms*sizeof(CPX));
+				/* Wait for spare CPU */
+				Pace(_worker);
 
-				/* Loop over 15 incoherent integrations */
-				for(i = 0; i < 15; i++)
+				/* Do the 10 ms of coherent integration */
+				for(lcv3 = 0; lcv3 < 10; lcv3++)
 				{
+					/* Multiply in frequency domain, shifting appropiately */
+					simd_cmulsc(&baseband_rows[lcv2*310 + lcv3 + i*20 + k*10][100+lcv], fft_codes[_unit->sv], &coherent[lcv3*resamps_ms], resamps_ms, 9);
+				}
 
-					if(gopt.realtime)
-						usleep(1000);
-
-					/* Do the 10 ms of coherent integration */
-					for(lcv3 = 0; lcv3 < 10; lcv3++)
-					{
-						/* Multiply in frequency domain, shifting appropiately */
-						sse_cmulsc(&baseband_rows[lcv2*310 + lcv3 + i*20 + k*10][100+lcv], fft_codes[_sv], &coherent[lcv3*resamps_ms], resamps_ms, 9);
-
-						/* Compute iFFT */
-						piFFT->doiFFT(&coherent[lcv3*resamps_ms], true);
-					}
-
-					/* Calculate the frquency doppler */
-					doppler = (double)(lcv*1000) + (float)(lcv2*250);
-
-					/* Calculate shift in samples */
-					code_doppler = (double)i*.02*IF_SAMPLE_FREQUENCY*doppler/L1;
-
-					/* Make an integer */
-					shift = (int32)floor(code_doppler);
-
-					/* For each delay do the post-corr FFT, this REALLY needs sped up */
-					for(lcv3 = 0; lcv3 < resamps_ms; lcv3++)
-					{
-						/* Copy over the relevant data pts */
-						p = (int32 *)&coherent[lcv3];
-						data[0] = *p; p += resamps_ms;
-						data[1] = *p; p += resamps_ms;
-						data[2] = *p; p += resamps_ms;
-						data[3] = *p; p += resamps_ms;
-						data[4] = *p; p += resamps_ms;
-						data[5] = *p; p += resamps_ms;
-						data[6] = *p; p += resamps_ms;
-						data[7] = *p; p += resamps_ms;
-						data[8] = *p; p += resamps_ms;
-						data[9] = *p;
-
-						/* Do the post-correlation dft */
-						sse_cacc(dp, dft_rows[0], 10, &iaccum, &qaccum); temp[0].i = iaccum >> 16; temp[0].q = qaccum >> 16;
-						sse_cacc(dp, dft_rows[1], 10, &iaccum, &qaccum); temp[1].i = iaccum >> 16; temp[1].q = qaccum >> 16;
-						sse_cacc(dp, dft_rows[2], 10, &iaccum, &qaccum); temp[2].i = iaccum >> 16; temp[2].q = qaccum >> 16;
-						sse_cacc(dp, dft_rows[3], 10, &iaccum, &qaccum); temp[3].i = iaccum >> 16; temp[3].q = qaccum >> 16;
-						sse_cacc(dp, dft_rows[4], 10, &iaccum, &qaccum); temp[4].i = iaccum >> 16; temp[4].q = qaccum >> 16;
-						sse_cacc(dp, dft_rows[5], 10, &iaccum, &qaccum); temp[5].i = iaccum >> 16; temp[5].q = qaccum >> 16;
-						sse_cacc(dp, dft_rows[6], 10, &iaccum, &qaccum); temp[6].i = iaccum >> 16; temp[6].q = qaccum >> 16;
-						sse_cacc(dp, dft_rows[7], 10, &iaccum, &qaccum); temp[7].i = iaccum >> 16; temp[7].q = qaccum >> 16;
-						sse_cacc(dp, dft_rows[8], 10, &iaccum, &qaccum); temp[8].i = iaccum >> 16; temp[8].q = qaccum >> 16;
-						sse_cacc(dp, dft_rows[9], 10, &iaccum, &qaccum); temp[9].i = iaccum >> 16; temp[9].q = qaccum >> 16;
-
-						//sse_dft(dp, dft_rows[0], &temp[0]);
-
-						x86_cmag(&temp[0], 10);
-
-						/* Accumulate into the power matrix */
-						p = (int32 *)&power[(lcv3 + shift + SAMPS_MS) % SAMPS_MS];
-						*p += dt[0]; p += resamps_ms;
-						*p += dt[1]; p += resamps_ms;
-						*p += dt[2]; p += resamps_ms;
-						*p += dt[3]; p += resamps_ms;
-						*p += dt[4]; p += resamps_ms;
-						*p += dt[5]; p += resamps_ms;
-						*p += dt[6]; p += resamps_ms;
-						*p += dt[7]; p += resamps_ms;
-						*p += dt[8]; p += resamps_ms;
-						*p += dt[9];
-					}
-
-				}//end i
-
-				/* Find the maximum */
-				x86_max((int32 *)power, &indext, &magt, 10*resamps_ms);
-
-				/* Found a new maximum */
-				if(magt > mag)
-				{
+				/* Compute the 10 iFFTs together */
+				piFFT->doiFFTBatch(coherent, 10, resamps_ms, true);
+
+				/* Calculate the frquency doppler */
+				doppler = (double)(lcv*1000) + (float)(lcv2*250);
+
+				/* Calculate shift in samples */
+				code_doppler = (double)i*.02*fbase*doppler/L1;
 
-					skip = false;
-					dopp = lcv*1000 + lcv2*250 + (indext/resamps_ms)*25;
-					for(j = 0; j < ncross; j++)
-						if(abs(dopp - cross_doppler[j]) < 100)
-							skip = true;
-
-					if(!skip)
-					{
-						mag = magt;
-						index = indext % resamps_ms;
-						result->delay = CODE_CHIPS - (float)index*CODE_RATE/fbase;
-						result->doppler = (float)(lcv*1000) + (float)(lcv2*250) + (indext/resamps_ms)*25.0;
-						result->magnitude = (float)mag;
-					}
+				/* Make an integer */
+				shift = (int32)floor(code_doppler);
+
+				/* Split the 10 ms into the fine Doppler bins */
+				doFine(coherent, fine);
+
+				/* Convert to a power */
+				x86_cmag(fine, nfine*resamps_ms);
+
+				/* Accumulate into the power matrix, rotated by the code doppler */
+				shift = (shift + resamps_ms) % resamps_ms;
+				for(j = 0; j < nfine; j++)
+				{
+					p = (int32 *)&power[j*resamps_ms];
+					f = (int32 *)&fine[j*resamps_ms];
 
+					for(lcv3 = 0; lcv3 < resamps_ms - shift; lcv3++)
+						p[lcv3 + shift] += f[lcv3];
+					for(; lcv3 < resamps_ms; lcv3++)
+						p[lcv3 + shift - resamps_ms] += f[lcv3];
 				}
 
-			}//end k
+			}//end i
 
-		}//end lcv2
+			/* Find the maximum */
+			x86_max((int32 *)power, &indext, &magt, nfine*resamps_ms);
 
-	}//end lcv
+			/* Found a new maximum */
+			if(magt > mag)
+			{
 
-	result->sv = _sv;
+				skip = false;
+				dopp = lcv*1000 + lcv2*250 + ((indext/resamps_ms)*250)/nfine;
+				for(j = 0; j < ncross; j++)
+					if(abs(dopp - cross_doppler[j]) < 100)
+						skip = true;
 
-	result->type = ACQ_WEAK;
+				if(!skip)
+				{
+					mag = magt;
+					_unit->index = indext;
+					_unit->bin = lcv2;
+				}
 
-	if(result->magnitude > THRESH_WEAK)
-		result->success = 1;
-	else
-		result->success = 0;
+			}
 
-	return(results[_sv]);
+		}//end k
+
+	}//end lcv2
+
+	_unit->mag = mag;
 
 }
 /*----------------------------------------------------------------------------------------------*/
@@ -652,13 +1066,16 @@ void Acquisition::Acquire()
  * */
 void Acquisition::Inport()
 {
-	int32 last;
 	int32 bread;
 	int32 lastcount;
 	int32 ms;
 	int32 ms_per_read;
 	int32 lcv;
-	ms_packet *p = NULL;
+	int32 count;
+	int32 last;
+	int32 packets;
+	int32 broken;
+	const ms_packet *p = NULL;
 	timespec ret;
 
 	ret.tv_sec = 0;
@@ -684,56 +1101,59 @@ void Acquisition::Inport()
 
 	//printf("Got request %d\n",request.corr);
 
-	/* Set the flag to high to let FIFO know the acq will be collecting data */
-	pthread_mutex_lock(&mAcq);
-	gAcq_high = true;
-	pthread_mutex_unlock(&mAcq);
+	/* Let the FIFO know the acq will be collecting data */
+	pFIFO->Subscribe(gopt.channels);
 
 	/* Collect necessary data */
 	lastcount = 0; ms = 0;
 	while((ms < ms_per_read) && grun)
 	{
-		/* Get the tail */
-		last = packet.count;
-		pFIFO->Dequeue(MAX_CHANNELS, &packet);
-//		pFIFO->Wait(MAX_CHANNELS); //Pend until everyone has called dequeue
+		/* Get the tail, as many packets at a time as the FIFO allows */
+		packets = ms_per_read - ms;
+		if(packets > FIFO_MAX_BATCH)
+			packets = FIFO_MAX_BATCH;
 
-		while(packet.count == last)
-		{
-			usleep(250);
-			pFIFO->Dequeue(MAX_CHANNELS, &packet);
-		}
+		p = pFIFO->Wait(gopt.channels, packets);
+		if(p == NULL)
+			break;
 
-		memcpy(&buff[SAMPS_MS*ms], &packet.data, SAMPS_MS*sizeof(CPX));
+		/* Copy straight out of the FIFO slots, they hold the IF rate the search runs at */
+		memcpy(&buff[resamps_ms*ms], &p->data[0], packets*resamps_ms*sizeof(CPX));
+		count = p[0].count;
+		last = p[packets-1].count;
+		broken = ((last - count) != (packets-1));
+		pFIFO->Release(gopt.channels, packets);
 
 		/* Detect broken packets */
 		if(ms > 0)
 		{
-			if((packet.count - lastcount) != 1)
-			{
-				//printf("Broken GPS stream %d,%d\n",packet.count,lastcount);
-				ms = 0; /* Recollect data */
-			}
+			if((count - lastcount) != 1)
+				broken = true;
 		}
 		else
-			request.count = packet.count;
+			request.count = count;
+
+		if(broken)
+		{
+			//printf("Broken GPS stream %d,%d\n",count,lastcount);
+			ms = 0; /* Recollect data */
+			continue;
+		}
 
-		ms++;
-		lastcount = packet.count;
+		ms += packets;
+		lastcount = last;
 
 	}
 
 	/* Done collecting data */
-	pthread_mutex_lock(&mAcq);
-	gAcq_high = false;
-	pthread_mutex_unlock(&mAcq);
+	pFIFO->Unsubscribe(gopt.channels);
 
 
 	ncross = 0;
 
 	pthread_mutex_lock(&mInterrupt);
 
-	for(lcv = 0; lcv < MAX_CHANNELS; lcv++)
+	for(lcv = 0; lcv < gopt.channels; lcv++)
 		if(pChannels[lcv]->getActive())
 			if(pChannels[lcv]->getCN0() > 45.0)	//If the CN0 is really high
 			{
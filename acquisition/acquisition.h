@@ -26,6 +26,20 @@ Free Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1
 
 #include "includes.h"
 
+class Acquisition;
+
+/*! \ingroup STRUCTS
+ * One thread of the acquisition pool
+ */
+typedef struct _Acq_Worker_S
+{
+
+	Acquisition *aAcquisition;	//!< The search it works on
+	int32 worker;				//!< Which worker, picks its scratch buffers
+	pthread_t thread;			//!< For the thread
+
+} Acq_Worker_S;
+
 /*! \ingroup CLASSES
  * 
  */
@@ -36,31 +50,33 @@ class Acquisition
 	
 		pthread_t thread;
 		CPX *fft_codes[NUM_CODES_WAAS];			//!< Store the FFTd Codes;
+		CPX *codes;								//!< FFTd codes made at the search rate when it is not 2048 samps/ms
 	
-		ms_packet packet;						//!< Get IF data
 		CPX *buff;								//!< Result after mixing the buffer to baseband
 		CPX *baseband;							//!< Result after mixing the buffer to baseband
 		CPX *baseband_shift;					//!< Result after mixing the buffer to baseband, used for the "circular shifts"
 		CPX **baseband_rows;					//!< Row pointer
-		CPX *coherent;							//!< Used for the 10 ms coherent integration
+		CPX *coherent[MAX_ACQ_WORKERS];			//!< Used for the 10 ms coherent integration, one per worker
 		CPX *_000Hzwipeoff;						//!< Sinusoid used to perform mix to baseband
 		CPX	*_250Hzwipeoff;						//!< Sinusoid to mix by Fif - 250 Hz
 		CPX	*_500Hzwipeoff;						//!< Sinusoid to mix by Fif - 500 Hz
 		CPX	*_750Hzwipeoff;						//!< Sinusoid to mix by Fif - 750 Hz
 		CPX *rotate;							//!< Buffer used for circular rotation of vector
-		CPX *msbuff;							//!< Random buffer for 1 ms stuff
-		CPX *power;
+		CPX *msbuff[MAX_ACQ_WORKERS];			//!< Random buffer for 1 ms stuff, one per worker
+		CPX *power[MAX_ACQ_WORKERS];			//!< Power matrix, one per worker
+		CPX *fine[MAX_ACQ_WORKERS];				//!< Post correlation DFT of one 10 ms block of the weak search, one per worker
 		MIX *dft;								//!< Used for the post correlation DFT
 		MIX **dft_rows;							//!< Used for the post correlation DFT
+		int32 nfine;							//!< Fine Doppler bins in each 250 Hz step
 		
-		float fbase;							//!< The base sample rate (2048 samps/ms);
+		float fbase;							//!< The rate the search runs at, 2048 samps/ms unless the data is searched at its own rate
 		float fsample;							//!< The sample rate of the data
 		float fif;								//!< intermediate frequency
 		int32 samps_ms;							//!< Samples per ms
 		int32 resamps_ms;						//!< Resamples per ms
 		
 		FFT *pFFT;								//!< The FFT used to perform correlation
-		FFT *piFFT;								//!< The FFT used to perform correlation
+		FFT *piFFT[MAX_ACQ_WORKERS];			//!< The FFT used to perform correlation, one per worker as it has its own scratch
 		FFT *pcFFT;								//!< The FFT used to perform the coherent integration
 		
 		int32 sv;								//!< Search for this SV
@@ -72,15 +88,48 @@ class Acquisition
 		
 		Acq_Request_S request;					//!< An acquisition request
 		Acq_Result_S results[NUM_CODES];		//!< Where to store the results
-		
-		
+
+		/* The pool, the prepped IF and FFTd codes are shared read only, each worker has its own scratch */
+		int32 nworkers;							//!< Threads sharing a search, including the one that calls it
+		Acq_Worker_S workers[MAX_ACQ_WORKERS];	//!< workers[0] is whoever calls the search
+		pthread_mutex_t pool_mutex;				//!< Protect the job below
+		pthread_cond_t pool_work;				//!< Signalled when a job is posted
+		pthread_cond_t pool_done;				//!< Signalled when the last worker is done with a job
+		int32 pool_run;							//!< Cleared to shut the pool down
+		int32 pool_job;							//!< Bumped for every job posted
+		int32 pool_busy;						//!< Workers yet to finish the current job
+		int32 job_type;							//!< Type of search (STRONG, MEDIUM, or WEAK)
+		Acq_Unit_S *units;						//!< PRN x Doppler rows of the current job
+		int32 nunits;							//!< Number of units
+		int32 next_unit;						//!< Next unit to hand out, taken with an atomic add
+
+		/* Cooperative scheduler, meters the search against gopt.acq_budget when running realtime */
+		pthread_mutex_t budget_mutex;			//!< Protect the bucket
+		double budget_rate;						//!< CPU us the search may use per us of wall time
+		double budget;							//!< CPU us left in the bucket, negative when overdrawn
+		double budget_time;						//!< Wall time the bucket was last topped up (us)
+		double cpu_last[MAX_ACQ_WORKERS];		//!< Each worker's thread CPU time when it was last charged (us)
+
+		void Charge(int32 _worker);				//!< Take the CPU this worker used since it was last charged out of the bucket
+		void Pace(int32 _worker);				//!< Before each chunk of a search, wait while over budget or while the correlators are behind
+		void doSearch(int32 _type, int32 _nsvs, const int32 *_svs, int32 _doppmin, int32 _doppmax);	//!< Fan the rows out to the pool, then merge them into results
+		void doJob(int32 _type, Acq_Unit_S *_units, int32 _nunits);						//!< Post a job to the pool and help with it until it is done
+		void doUnits(int32 _worker);														//!< Take units off the current job until there are none left
+		void doStrongRow(int32 _worker, Acq_Unit_S *_unit);									//!< One Doppler row of doAcqStrong
+		void doMediumRow(int32 _worker, Acq_Unit_S *_unit);									//!< One Doppler row of doAcqMedium
+		void doWeakRow(int32 _worker, Acq_Unit_S *_unit);									//!< One Doppler row of doAcqWeak
+		void doFine(CPX *_coherent, CPX *_out);												//!< Post correlation DFT of the 10 ms of coherent integration
+		void initCodes();																	//!< FFT the codes at the search rate, for rates there is no table of
+
 	public:
 	
-		Acquisition(float _fsample, float _fif);											//!< Create and initialize object, need _fsample as a necessary argument
+		Acquisition(float _fsample, float _fif, float _fbase);								//!< Create and initialize object, _fbase is the rate the data handed to it is at
 		~Acquisition();																		//!< Shutdown gracefully
 		Acq_Result_S doAcqStrong(int32 _sv, int32 _doppmin, int32 _doppmax); 				//!< Look for this sv in this doppler range using a 1 ms correlation (_buff must be 1 ms long)
 		Acq_Result_S doAcqMedium(int32 _sv, int32 _doppmin, int32 _doppmax); 				//!< Look for this sv in this doppler range using a 10 ms correlation (_buff must be 20 ms long)
 		Acq_Result_S doAcqWeak(int32 _sv, int32 _doppmin, int32 _doppmax); 					//!< Look for this sv in this doppler range using a 10 ms correlation and 15 incoherent integrations (_buff must be 310 ms long)
+		void doAcqBatch(int32 _type, int32 _nsvs, const int32 *_svs, int32 _doppmin, int32 _doppmax, Acq_Result_S *_results); //!< Look for several svs at once in the same prepped IF, _results is indexed by sv
+		void Work(int32 _worker);															//!< Body of a pool thread
 		void doPrepIF(int32 _type, CPX *_buff);												//!< Prep the IF (done once if detecting multiple SVs in same data set)
 		void doDFT(CPX *in);
 		void Inport();																		//!< Get a chuck of data to operate on
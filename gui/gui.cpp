@@ -684,7 +684,7 @@ void GUI::render(wxDC& dc)
 
 	/* Status at the bottom */
 	str.Printf(wxT("Pipe Reads %d\tFIFO:\t%d\t%d\t%d\t%d"),
-			page,(FIFO_DEPTH-(tGUI.tFIFO.head-tGUI.tFIFO.tail)) % FIFO_DEPTH,tGUI.tFIFO.count,tGUI.tFIFO.agc_scale,tGUI.tFIFO.overflw);
+			page,(tGUI.tFIFO.depth-(tGUI.tFIFO.head-tGUI.tFIFO.tail)) % (tGUI.tFIFO.depth ? tGUI.tFIFO.depth : 1),tGUI.tFIFO.count,tGUI.tFIFO.agc_scale,tGUI.tFIFO.overflw);
 
 	str += '\t';
 	str += status_str;
@@ -759,6 +759,64 @@ void GUI::renderEKF()
 /*----------------------------------------------------------------------------------------------*/
 void GUI::renderThreads()
 {
+
+	/* Clear threads panel */
+	tThreads->Clear();
+
+	PrintFIFO(tThreads);
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+void GUI::PrintFIFO(wxTextCtrl* _text)
+{
+
+	FIFO_Consumer_S *c;
+	wxString str, str2;
+	int32 lcv, lcv2;
+	double total;
+
+	str.Printf(wxT("FIFO depth:\t%6d ms\n\n"),tGUI.tFIFO.depth);
+	_text->AppendText(str);
+
+	str.Printf(wxT("Ch#  Backlog   High   Drops  Queue depth, %% of ms spent at each backlog:\n"));
+	_text->AppendText(str);
+	str.Printf(wxT("                               0   1   2   4   8  16  32  64 128 256 512 1k+\n"));
+	_text->AppendText(str);
+	str.Printf(wxT("-----------------------------------------------------------------------------\n"));
+	_text->AppendText(str);
+
+	for(lcv = 0; lcv < (tGUI.tStats.channels+1); lcv++)
+	{
+		c = &tGUI.tStats.consumer[lcv];
+
+		if(lcv < tGUI.tStats.channels)
+			str.Printf(wxT("%2d "),lcv);
+		else
+			str.Printf(wxT("Acq"));
+
+		if(c->active)
+			str2.Printf(wxT("  %7d  %5d  %6d "),c->backlog,c->high,c->drops);
+		else
+			str2.Printf(wxT("  -------  %5d  %6d "),c->high,c->drops);
+		str += str2;
+
+		total = 0;
+		for(lcv2 = 0; lcv2 < FIFO_HIST_BINS; lcv2++)
+			total += c->depth_hist[lcv2];
+
+		for(lcv2 = 0; lcv2 < FIFO_HIST_BINS; lcv2++)
+		{
+			str2.Printf(wxT("%4d"),total > 0 ? (int32)(100.0*c->depth_hist[lcv2]/total + 0.5) : 0);
+			str += str2;
+		}
+
+		str += '\n';
+		_text->AppendText(str);
+	}
+
 }
 /*----------------------------------------------------------------------------------------------*/
 
@@ -796,7 +854,7 @@ void GUI::PrintChan(wxTextCtrl* _text)
 	str.Printf(wxT("-----------------------------------------------------------------------------------------\n"));
 	_text->AppendText(str);
 
-	for(lcv = 0; lcv < MAX_CHANNELS; lcv++)
+	for(lcv = 0; lcv < tGUI.tStats.channels; lcv++)
 	{
 		p = &tGUI.tChan[lcv];
 		if(p->count > 3000)
@@ -864,7 +922,7 @@ void GUI::PrintSV(wxTextCtrl* _text)
 	str.Printf(wxT("-------------------------------------------------------------------------------------\n"));
 	_text->AppendText(str);
 
-	for(lcv	= 0; lcv < MAX_CHANNELS; lcv++)
+	for(lcv	= 0; lcv < tGUI.tStats.channels; lcv++)
 	{
 		pPos    = (SV_Position_S *)	&tGUI.tNav.sv_positions[lcv];
 		pChan   = (Chan_Packet_S *)	&tGUI.tChan[lcv];
@@ -922,7 +980,7 @@ void GUI::PrintNav(wxTextCtrl* _text)
 
 	/* Nav Solution */
 	nsvs = 0;
-	for(lcv = 0; lcv < MAX_CHANNELS; lcv++)
+	for(lcv = 0; lcv < tGUI.tStats.channels; lcv++)
 	{
 		if((pNav->nsvs >> lcv) & 0x1)
 			nsvs++;
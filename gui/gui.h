@@ -179,6 +179,7 @@ public:
 
 	    void initThreads();
 	    void renderThreads();
+			void PrintFIFO(wxTextCtrl* _text);
 
 	    void initCommands();
 	    void renderCommands();
@@ -27,9 +27,10 @@ Free Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1
 
 /* The most important thing, the NUMBER OF CORRELATORS IN THE RECEIVER and the NUMBER OF CPUs */
 /*----------------------------------------------------------------------------------------------*/
-#define MAX_CHANNELS			(12)						//!< Number of channel objects
+#define MAX_CHANNELS			(64)						//!< Most channel objects, sizes the telemetry and GUI packets
+#define DEFAULT_CHANNELS		(12)						//!< Number of channel objects unless set with -ch
 #define CPU_CORES				(2)							//!< 1 for a single core, 2 for a dual core system, etc
-#define CORR_PER_CPU			(MAX_CHANNELS/CPU_CORES)	//!< Distribute them up evenly (this should be an INTEGER!)
+#define CORR_PER_CPU			(DEFAULT_CHANNELS/CPU_CORES)	//!< Distribute them up evenly (this should be an INTEGER!)
 #define MAX_ANTENNAS			(1)							//!< The number of antennas
 /*----------------------------------------------------------------------------------------------*/
 
@@ -41,6 +42,9 @@ Free Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1
 #define LOG_PSEUDO				(0)			//!< Pseudoranges
 #define LOG_SV					(0)			//!< SV Navigation data
 #define LOG_NAV					(1)			//!< Nav Output
+#define CORR_PROBES				(1)			//!< Time the correlator stages with the TSC, 0 compiles the probes out
+#define PROBE_SAMPLE			(16)		//!< Time 1 in this many code periods (power of 2), keeps the probes down in the noise
+#define PROBE_BINS				(24)		//!< Cycle histogram bins, powers of 2 cycles, the last holds everything >= 8M cycles
 /*----------------------------------------------------------------------------------------------*/
 
 
@@ -73,6 +77,15 @@ Free Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1
 #define THRESH_MEDIUM			(1.5e7)		//!< Threshold for medium signal detection
 #define THRESH_WEAK				(1.0e7)		//!< Threshold for weak signal detection
 #define MAX_DOPPLER				(15000)		//!< Set the maximum Doppler frequency
+#define MAX_ACQ_WORKERS			(16)		//!< Most threads that can share an acquisition search
+#define ACQ_BUDGET				(50)		//!< Default CPU the acquisition may use in realtime, % of one CPU
+#define ACQ_BURST				(20)		//!< Unused budget carries over for at most this many ms
+#define ACQ_FINE				(10)		//!< Default fine Doppler bins in each 250 Hz step of the 10 ms searches (25 Hz)
+#define ACQ_MAX_FINE			(50)		//!< Most fine Doppler bins in each 250 Hz step
+#define ACQ_DFT_BLOCK			(256)		//!< Delays taken through the post correlation DFT together, keeps the 10 ms of them in L1
+#define ACQ_MIN_RATE			(2000)		//!< Slowest rate (samps/ms) the acquisition can search data at without decimating to SAMPS_MS
+#define ACQ_MAX_RATE			(8000)		//!< Fastest rate (samps/ms) the acquisition can search data at
+#define ACQ_MAX_BACKLOG			(4)			//!< Acquisition stands aside while the slowest correlator is more than this many ms past its batch behind
 /*----------------------------------------------------------------------------------------------*/
 
 
@@ -80,11 +93,17 @@ Free Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1
 /*----------------------------------------------------------------------------------------------*/
 #define CORR_DELAYS				(1)			//!< Number of delays to calculate (plus-minus)
 #define CORR_SPACING			(.5)		//!< How far should the correlators be spaced (chips)
+#define MAX_TAPS				(21)		//!< Most code delays in a correlator bank, odd so prompt is in the middle
+#define MAX_TAP_SPAN			(16)		//!< Widest earliest to latest spread of the bank (chips), one code word has to cover a SIMD pass
 #define FRAME_SIZE_PLUS_2		(12)		//!< 10 words per frame, 12 = 10 + 2
 #define MEASUREMENT_INT			(100)		//!< Packets of ~1ms data
-#define CODE_BINS				(20)		//!< Partial code offset bins code resolution -> 1 chip/X bins
-#define CARRIER_SPACING			(20)		//!< Spacing of bins (Hz)
-#define CARRIER_BINS			(MAX_DOPPLER/CARRIER_SPACING) //!< Number of pre-sampled carrier wipeoff bins
+#define CODE_NCO_FRAC			(21)		//!< Fractional bits of the code NCO phase, leaves 11 bits of whole chips
+#define CODE_NCO_WRAP			((uint32)CODE_CHIPS << CODE_NCO_FRAC) //!< One code period in code NCO phase units
+#define CODE_NCO_BYTES			((CODE_CHIPS + 64 + 7)/8) //!< One bit packed code period plus 64 wrapped chips for the SIMD code fetch
+#define PHASE_FRAC				(48)		//!< Fractional bits of the correlator code (chips) and carrier (cycles) phase state
+#define CODE_PHASE_WRAP			((uint64)CODE_CHIPS << PHASE_FRAC) //!< One code period of the correlator code phase state
+#define CARRIER_LUT_BITS		(11)		//!< Carrier NCO lookup is indexed by the top bits of the 32 bit phase
+#define CARRIER_LUT_SIZE		(1 << CARRIER_LUT_BITS) //!< Number of entries in the carrier NCO lookup
 #define ICP_TICS				(5)			//!< Number of measurement ints (plus-minus) to calculate ICP,
 											//!< this cannot exceed TICS_PER_SECOND/2 !!!!
 
@@ -105,6 +124,12 @@ Free Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1
 /*----------------------------------------------------------------------------------------------*/
 
 
+/* FIFO defines */
+/*----------------------------------------------------------------------------------------------*/
+#define FIFO_HIST_BINS			(12)		//!< Queue depth histogram bins, powers of 2 packets, the last holds everything >= 1024
+/*----------------------------------------------------------------------------------------------*/
+
+
 /*----------------------------------------------------------------------------------------------*/
 #define FIFO_PRIORITY			(89)
 #define CORR_PRIORITY			(88)
@@ -156,6 +156,40 @@ typedef signed long long	int64;					//!< Signed quadruple word
 /*----------------------------------------------------------------------------------------------*/
 
 
+/* State of a channel in the pool, kept in gInterrupt */
+/*----------------------------------------------------------------------------------------------*/
+#define CHANNEL_FREE			(0)		//!< In the pool, the correlator only takes measurements
+#define CHANNEL_ACTIVE			(1)		//!< Tracking
+#define CHANNEL_CLAIMED			(2)		//!< Taken from the pool, waiting on an acquisition result
+/*----------------------------------------------------------------------------------------------*/
+
+
+/* Kinds of receiver thread, each gets its own CPUs and priority from gopt.place */
+/*----------------------------------------------------------------------------------------------*/
+#define THREAD_FIFO				(0)		//!< FIFO
+#define THREAD_CORR				(1)		//!< Correlators or correlator workers, spread one per CPU
+#define THREAD_ACQ				(2)		//!< Acquisition
+#define THREAD_PVT				(3)		//!< PVT
+#define THREAD_EPHEM			(4)		//!< Ephemeris
+#define THREAD_SELECT			(5)		//!< SV_Select
+#define THREAD_TELEM			(6)		//!< Telemetry
+#define THREAD_KEY				(7)		//!< Keyboard
+#define THREAD_POST				(8)		//!< Post_Process
+#define THREAD_KINDS			(9)		//!< Number of kinds
+/*----------------------------------------------------------------------------------------------*/
+
+
+/* Correlator stages timed by the probes */
+/*----------------------------------------------------------------------------------------------*/
+#define PROBE_WAIT				(0)		//!< Asleep in the FIFO waiting for the next span, per span
+#define PROBE_ACCUM				(1)		//!< Accum, the wipeoff and correlation
+#define PROBE_UPDATE			(2)		//!< UpdateState
+#define PROBE_DUMP				(3)		//!< DumpAccum, including the channel
+#define PROBE_CHANNEL			(4)		//!< Channel::Accum, the tracking loops
+#define PROBE_STAGES			(5)		//!< Number of stages
+/*----------------------------------------------------------------------------------------------*/
+
+
 /* Necessary? */
 /*----------------------------------------------------------------------------------------------*/
 #define CHAN_HEADER 			(0xFEEDBEEF)
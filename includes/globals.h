@@ -39,8 +39,9 @@ EXTERN class FIFO			*pFIFO;							//!< Get data and pass it into the receiver
 EXTERN class PVT			*pPVT;							//!< Do the PVT solution
 EXTERN class Ephemeris		*pEphemeris;					//!< Extract the ephemeris
 EXTERN class Acquisition	*pAcquisition;					//!< Perform acquisitions
-EXTERN class Correlator		*pCorrelators[MAX_CHANNELS];	//!< Bank of correlators
-EXTERN class Channel		*pChannels[MAX_CHANNELS];		//!< Channels (uses correlations to close the loops)
+EXTERN class Correlator		**pCorrelators;					//!< Bank of correlators, gopt.channels of them
+EXTERN class Correlator_Worker **pCorrWorkers;				//!< Threads that run the correlators channel major
+EXTERN class Channel		**pChannels;					//!< Channels (uses correlations to close the loops), gopt.channels of them
 EXTERN class SV_Select		*pSV_Select;					//!< Contains the channels and drives the channel objects
 EXTERN class Telemetry		*pTelemetry;					//!< Gather all relevant receiver data and pipe it to the seperate GUI app
 EXTERN class Post_Process	*pPost_Process;					//!< Drive the receiver from a recorded file
@@ -49,11 +50,8 @@ EXTERN class Post_Process	*pPost_Process;					//!< Drive the receiver from a rec
 
 /* Part 2, Mutexes, semaphores, and their respective protected memory locations */
 /*----------------------------------------------------------------------------------------------*/
-EXTERN pthread_mutex_t		mAcq;							//!< Protect the following variable
-EXTERN int32				gAcq_high;						//!< This is set high when the acquisition is active
-
 EXTERN pthread_mutex_t		mInterrupt;						//!< Protect the following variable
-EXTERN uint32 				gInterrupt[MAX_CHANNELS];		//!< Interrupt for servicing tracking channels
+EXTERN uint32 				*gInterrupt;					//!< Pool state of each channel, CHANNEL_FREE/ACTIVE/CLAIMED
 /*----------------------------------------------------------------------------------------------*/
 
 
@@ -70,9 +68,9 @@ EXTERN int32 Acq_2_Trak_P[2];								//!< \ingroup PIPES Get an acquisition resu
 EXTERN int32 Trak_2_Acq_P[2];								//!< \ingroup PIPES Request an acquisition because some of the channels are empty
 
 /* Interplay between correlator and channels */
-EXTERN int32 Corr_2_PVT_P[MAX_CHANNELS][2];					//!< \ingroup PIPES Output measurements to PVT
-EXTERN int32 PVT_2_Corr_P[MAX_CHANNELS][2];					//!< \ingroup PIPES Output measurements to PVT
-EXTERN int32 Trak_2_Corr_P[MAX_CHANNELS][2];				//!< \ingroup PIPES Have the tracking tell the correlator to start or stop a channel
+EXTERN int32 (*Corr_2_PVT_P)[2];							//!< \ingroup PIPES Output measurements to PVT, one per channel
+EXTERN int32 (*PVT_2_Corr_P)[2];							//!< \ingroup PIPES Output measurements to PVT, one per channel
+EXTERN int32 (*Trak_2_Corr_P)[2];							//!< \ingroup PIPES Have the tracking tell the correlator to start or stop a channel
 
 /* How do we decode the ephemerides? */
 EXTERN int32 Chan_2_Ephem_P[2];								//!< \ingroup PIPES Dump raw subframes to Ephemeris
@@ -45,10 +45,13 @@ Free Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1
 #include <sys/stat.h>
 #include <sys/time.h>
 #include <sys/wait.h>
+#include <sys/mman.h>
 #include <fcntl.h>
 #include <sched.h>
 #include <curses.h>
 #include <limits.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
 /*----------------------------------------------------------------------------------------------*/
 
 /*Herein Lies Many Important File, note thy order is important!*/
@@ -60,14 +63,17 @@ Free Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1
 #include "structs.h"			//!< Structs used for interprocess communication
 #include "protos.h"			//!< Functions & thread prototypes
 #include "simd.h"				//!< Include the SIMD functionality
+#include "probe.h"				//!< TSC probes for the correlators
 /*----------------------------------------------------------------------------------------------*/
 
 /* Include the "Threaded Objects" */
 /*----------------------------------------------------------------------------------------------*/
 #include "fft.h"				//!< Fixed point FFT object
+#include "shm_ring.h"			//!< Shared memory IF transport from gps-usrp
 #include "fifo.h"				//!< Circular buffer for inporting IF data
 #include "keyboard.h"			//!< Handle user input via keyboard
 #include "correlator.h"			//!< Correlator
+#include "corr_worker.h"		//!< Channel major correlator threads
 #include "channel.h"			//!< Tracking channels
 #include "acquisition.h"		//!< Acquisition
 #include "pvt.h"				//!< PVT solution
@@ -20,4 +20,4 @@ write to the:
 Free Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 ************************************************************************************************/
 
-#define _lrotl(X,N)		((X << N) ^ (X >> (32-N)))			//!< Used in the parity check algorithm
+#define ROTL32(X,N)		((X << N) ^ (X >> (32-N)))			//!< Used in the parity check algorithm
@@ -0,0 +1,95 @@
+/*! \file Probe.h
+	TSC probes around the stages of the correlator hot path.
+*/
+/************************************************************************************************
+Copyright 2008 Gregory W Heckler
+
+This file is part of the GPS Software Defined Radio (GPS-SDR)
+
+The GPS-SDR is free software; you can redistribute it and/or modify it under the terms of the
+GNU General Public License as published by the Free Software Foundation; either version 2 of the
+License, or (at your option) any later version.
+
+The GPS-SDR is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with GPS-SDR; if not,
+write to the: 
+
+Free Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+************************************************************************************************/
+
+#ifndef PROBE_H
+#define PROBE_H
+
+/*! Time a stage with the TSC, _t carries on to time the next stage. Only passes with _on set
+ * are timed, PROBE_NEXT sets _on for 1 in PROBE_SAMPLE code periods. With CORR_PROBES at 0
+ * there is nothing left of them */
+/*----------------------------------------------------------------------------------------------*/
+#if CORR_PROBES
+	#define PROBE_NEXT(_on, _tick)		_on = ((++_tick & (PROBE_SAMPLE-1)) == 0)
+	#define PROBE_TIC(_on, _t)			uint64 _t = (_on) ? __builtin_ia32_rdtsc() : 0
+	#define PROBE_TOC(_on, _p, _s, _t)	{ if(_on) { uint64 _now = __builtin_ia32_rdtsc(); Probe_Add(&(_p)->stage[_s], _now - (_t)); _t = _now; } }
+#else
+	#define PROBE_NEXT(_on, _tick)
+	#define PROBE_TIC(_on, _t)
+	#define PROBE_TOC(_on, _p, _s, _t)
+#endif
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*! Add one pass to a stage, only ever called by the thread that owns the probes */
+static inline void Probe_Add(Probe_Stage_S *_s, uint64 _cycles)
+{
+	uint32 c, bin;
+
+	c = (_cycles > 0xffffffffULL) ? 0xffffffff : (uint32)_cycles;
+
+	bin = (c > 1) ? 31 - __builtin_clz((unsigned int)c) : 0;
+	if(bin > PROBE_BINS-1)
+		bin = PROBE_BINS-1;
+
+	_s->count++;
+	_s->cycles += _cycles;
+	if(c > _s->max)
+		_s->max = c;
+	_s->hist[bin]++;
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*! Copy the owner's running probes out to where other threads can read them, seqlock style */
+static inline void Probe_Publish(Probe_S *_pub, const Probe_S *_probe)
+{
+	uint32 seq;
+
+	seq = _pub->seq;
+	__atomic_store_n(&_pub->seq, seq + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+
+	memcpy(&_pub->stage[0], &_probe->stage[0], PROBE_STAGES*sizeof(Probe_Stage_S));
+
+	__atomic_store_n(&_pub->seq, seq + 2, __ATOMIC_RELEASE);
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*! Take a consistent copy of published probes, retries if the owner was publishing at the time */
+static inline void Probe_Copy(Probe_S *_copy, const Probe_S *_pub)
+{
+	uint32 seq;
+
+	do
+	{
+		seq = __atomic_load_n(&_pub->seq, __ATOMIC_ACQUIRE);
+		memcpy(_copy, _pub, sizeof(Probe_S));
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	} while((seq & 0x1) || (seq != __atomic_load_n(&_pub->seq, __ATOMIC_RELAXED)));
+}
+/*----------------------------------------------------------------------------------------------*/
+
+#endif /* PROBE_H */
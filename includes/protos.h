@@ -32,6 +32,17 @@ void Thread_Shutdown(void);							//!< First step to shutdown, stopping the thre
 void Pipes_Shutdown(void);							//!< Close all the pipes
 void Object_Shutdown(void);							//!< Delete/free all objects
 void Hardware_Shutdown(void);						//!< Shutdown any hardware
+int32 Claim_Channel(void);							//!< Take a free channel from the pool, -1 if they are all in use
+void Retire_Channel(int32 _chan);					//!< Hand a channel back to the pool
+/*----------------------------------------------------------------------------------------------*/
+
+/* Found in Placement.cpp */
+/*----------------------------------------------------------------------------------------------*/
+void Placement_Defaults(void);						//!< Default priority for each kind of thread, any CPU
+int32 Placement_Parse(const char *_spec);			//!< Parse one kind:cpus[:policy[:priority]] placement
+int32 Placement_Read(const char *_fname);			//!< Parse a file of placements, one per line
+void Placement_Isolate(void);						//!< Take the correlator CPUs away from the acquisition
+int32 Thread_Create(pthread_t *_thread, int32 _kind, int32 _index, void *(*_start)(void *), void *_arg); //!< Create a thread where it was placed, and report where it ended up
 /*----------------------------------------------------------------------------------------------*/
 
 /* Found in Misc.cpp */
@@ -43,9 +54,10 @@ void wipeoff_gen(MIX *_dest, double _f, double _fs, int32 _samps);
 void resample(CPX *_dest, CPX *_source, double _fdest, double _fsource, int32 _samps);
 void downsample(CPX *_dest, CPX *_source, double _fdest, double _fsource, int32 _samps);
 void init_agc(CPX *_buff, int32 _samps, int32 bits, int32 *scale);
-int32 run_agc(CPX *_buff, int32 _samps, int32 bits, int32 *scale);
+int32 run_agc(CPX *_buff, CPX *_dest, int32 _samps, int32 bits, int32 *scale);
 int32 AtanApprox(int32 y, int32 x);
 int32 Atan2Approx(int32 y, int32 x);
 int32 Invert4x4(double A[4][4], double B[4][4]);
+double tsc_mhz(void);
 /*----------------------------------------------------------------------------------------------*/
 
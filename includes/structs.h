@@ -65,6 +65,19 @@ typedef struct MIX {
 
 
 /*----------------------------------------------------------------------------------------------*/
+/*! \ingroup STRUCTS
+ * Where one kind of receiver thread runs and at what priority
+ */
+typedef struct _Thread_Place_S
+{
+
+	cpu_set_t	cpus;					//!< CPUs the thread may run on, empty for any
+	int32		policy;					//!< SCHED_FIFO, SCHED_RR or SCHED_OTHER
+	int32		priority;				//!< Real time priority, 0 for SCHED_OTHER
+
+} Thread_Place_S;
+
+
 /*! \ingroup STRUCTS
  * Options parsed from command line to start the receiver
  */
@@ -82,33 +95,59 @@ typedef struct _Options_S
 	int32	ncurses;					//!< Use ncurses display
 	int32	doppler_min;				//!< Set minimum Doppler
 	int32	doppler_max;				//!< Set maximum Doppler
-	int32	corr_sleep;					//!< How long to correlators should sleep
+	int32	corr_batch;					//!< Number of ms packets each correlator processes at once
+	int32	channels;					//!< Number of channel/correlator pairs, at most MAX_CHANNELS
+	int32	corr_workers;				//!< Run the correlators channel major on this many threads, 0 for a thread per correlator
+	int32	fifo_depth;					//!< Length of the FIFO, in ms
+	int32	corr_taps;					//!< Number of code delays each correlator runs, odd so prompt is in the middle
+	double	corr_spacing;				//!< Spacing of the code delays (chips)
 	int32	startup;					//!< Startup warm/cold
 	int32	gui;						//!< Run with the external GUI program (disables ncurses)
 	int32	usrp_internal;				//!< Run usrp-gps as a child process of receiver
+	int32	isolate_acq;				//!< Keep the acquisition off the correlator CPUs
+	int32	acq_workers;				//!< Threads sharing each acquisition search, including the acquisition thread
+	int32	acq_budget;					//!< CPU the acquisition may use in realtime, % of one CPU
+	int32	acq_fine;					//!< Fine Doppler bins in each 250 Hz step of the 10 ms searches
+	Thread_Place_S place[THREAD_KINDS];	//!< Where each kind of thread runs, and at what priority
 	char	filename_direct[1024];		//!< Skyview filename
 	char	filename_reflected[1024];	//!< Reflected filename
 
 } Options_S;
 /*----------------------------------------------------------------------------------------------*/
 
-//!< FIFO structure for linked list?
+//!< FIFO structure for the circular IF buffer
 /*----------------------------------------------------------------------------------------------*/
 /*! \ingroup STRUCTS
- *  linked list structure for circular FIFO buffer
+ *  One slot of the circular FIFO buffer, the payloads of consecutive slots are contiguous
+ *  so several packets can be processed as a single span of samples
  */
 typedef struct ms_packet {
 
-	ms_packet *next;
 	int32 measurement;				//!< This packet is flagged for a measurement
 	int32 count;					//!< number of packets
-	int32 accessed[MAX_CHANNELS+1];	//!< keep track of accesses
-	CPX data[SAMPS_MS];				//!< payload size
+	CPX *data;						//!< IF_SAMPS_MS samples of payload
 
 } ms_packet;
 /*----------------------------------------------------------------------------------------------*/
 
 
+/*----------------------------------------------------------------------------------------------*/
+/*! \ingroup STRUCTS
+ *  Read cursor of one FIFO consumer, padded out to its own cache line so the consumers
+ *  do not false share when they bump their cursors
+ */
+typedef struct FIFO_Cursor_S {
+
+	int32 index;					//!< Next slot this consumer will read
+	int32 active;					//!< Consumer holds back the tail when set
+	int32 want;						//!< Number of packets a sleeping consumer is waiting for, 0 if awake
+	int32 wake;						//!< Bumped by the FIFO to wake the consumer, it futex waits on this
+	int32 pad[12];					//!< Pad to 64 bytes
+
+} FIFO_Cursor_S;
+/*----------------------------------------------------------------------------------------------*/
+
+
 //!< Acquisition results
 /*----------------------------------------------------------------------------------------------*/
 /*! \ingroup STRUCTS
@@ -148,6 +187,21 @@ typedef struct _Acq_Request_S
 	int32 antenna;		//!< antenna number
 
 } Acq_Request_S;
+
+
+/*! \ingroup STRUCTS
+ * One PRN and 1 kHz Doppler row of an acquisition search, and the best peak found in it
+ */
+typedef struct _Acq_Unit_S
+{
+
+	int32 sv;			//!< Search for this SV
+	int32 row;			//!< Doppler row, in kHz
+	int32 bin;			//!< 250 Hz bin in the row holding the peak
+	int32 index;		//!< Where the peak is in the power matrix (delay, and 25 Hz bin for medium/weak)
+	int32 mag;			//!< Magnitude of the peak, 0 if nothing got past the cross correlation check
+
+} Acq_Unit_S;
 /*----------------------------------------------------------------------------------------------*/
 
 //!< Correlator and channel structs
@@ -172,13 +226,15 @@ typedef struct _NCO_Command
 
 
 /*! \ingroup STRUCTS
- * Raw correlation values, early, prompt, and late
+ * Raw correlation values, early, prompt, and late, and the bank of code delays they are taken from
  */
 typedef struct _Correlation_S
 {
 
 	int32 I[3];
 	int32 Q[3];
+	int32 I_tap[MAX_TAPS];		//!< Inphase of each code delay, earliest first
+	int32 Q_tap[MAX_TAPS];		//!< Quadrature of each code delay, earliest first
 
 } Correlation_S;
 
@@ -193,22 +249,18 @@ typedef struct _Correlator_State_S
 	int32	navigate;			//!< Is this correlator sending out valid measurements
 	int32	active;				//!< Active flag
 	int32  	count;				//!< How long has this been active (ms)
-	int32   scount;				//!< Number of samples in current accumulation
-	double 	code_phase; 		//!< Code phase (chips)
-	double 	carrier_phase;		//!< Carrier phase (cycles)
-	double  carrier_phase_prev;	//!< Used for phase correction to correlations
-	double 	code_phase_mod;		//!< Code phase (chips), mod 1023
-	double 	carrier_phase_mod;	//!< Carrier phsae (cycles), mod 1
+	int64	code_periods;		//!< Whole code periods since the start of the track
+	int64	carrier_cycles;		//!< Whole carrier cycles since the start of the track
+	uint64	code_phase_mod;		//!< Code phase mod 1023, PHASE_FRAC fractional chip bits
+	uint64	carrier_phase_mod;	//!< Carrier phase mod 1, PHASE_FRAC fractional cycle bits
+	uint64	code_phase_inc;		//!< Code phase step per sample, PHASE_FRAC fractional chip bits
+	int64	carrier_phase_inc;	//!< Carrier phase step per sample, PHASE_FRAC fractional cycle bits
 	double 	code_nco;			//!< Code NCO
 	double 	carrier_nco;		//!< Carrier NCO
 	int32  	_1ms_epoch;			//!< _1ms_epoch
 	int32  	_20ms_epoch;		//!< _20ms_epoch
 	int32 	_z_count;			//!< Keep track of the z count
 	int32  	rollover;			//!< rollover point of C/A code in next ms packet
-	int32	cbin[3];			//!< Code bins
-	int32	sbin;				//!< Carriers bins
-	MIX		*pcode[3];			//!< pointer to early-prompt-late codes
-	CPX		*psine;				//!< pointer to Doppler removal vector
 	int32	nav_history[MEASUREMENT_DELAY]; //!< keep track of the navigate flag
 
 } Correlator_State_S;
@@ -314,6 +366,10 @@ typedef struct _Chan_Packet_S
 	float w;					//!< acceleration accumulator state
 	float x;					//!< velocity accumulator state
 	float z;					//!< proportional feedback to NCO
+	float taps;					//!< Number of code delays in the bank
+	float tap_spacing;			//!< Spacing of the code delays (chips)
+	float I_tap[MAX_TAPS];		//!< Inphase correlations of the bank, earliest first
+	float Q_tap[MAX_TAPS];		//!< Quadrature correlations of the bank, earliest first
 
 } Chan_Packet_S;
 
@@ -460,7 +516,7 @@ typedef struct _Nav_Solution_S
 	double hdop;		//!< hdop diultion of precision
 	double vdop;		//!< vertical dilution of precision
 
-	int32 nsvs;			//!< This is a mask, not a number
+	uint64 nsvs;		//!< This is a mask, not a number
 	int32 converged;	//!< declare convergence
 	int32 tic;			//!< global_tic associated with this solution
 
@@ -580,7 +636,61 @@ typedef struct _Acq_History_S
 /* Structs associated with the telemetry object */
 /*----------------------------------------------------------------------------------------------*/
 /*! \ingroup STRUCTS
- * Data from the FIFO to the Telemetry
+ * How well one consumer (correlator or acquisition) is keeping up with the FIFO
+ */
+typedef struct _FIFO_Consumer_S
+{
+
+	int32 active;		//!< Currently reading from the FIFO
+	int32 backlog;		//!< Packets (ms) behind the head
+	int32 high;			//!< Largest backlog seen
+	int32 drops;		//!< Packets dropped on a full FIFO while this consumer was holding the tail
+	int32 depth_hist[FIFO_HIST_BINS];	//!< Queue depth, ms spent with a backlog of 0, 1, 2-3, 4-7, ... packets
+
+} FIFO_Consumer_S;
+
+
+/*! \ingroup STRUCTS
+ * Cycle counts for one stage of a correlator
+ */
+typedef struct _Probe_Stage_S
+{
+
+	uint32 count;				//!< Number of passes timed
+	uint32 max;					//!< Longest pass, cycles
+	uint64 cycles;				//!< Cycles over all timed passes
+	uint32 hist[PROBE_BINS];	//!< Passes taking 0-1, 2-3, 4-7, 8-15, ... cycles
+
+} Probe_Stage_S;
+
+
+/*! \ingroup STRUCTS
+ * A correlator's probes, the owning thread publishes a copy that anyone can read without a lock
+ */
+typedef struct _Probe_S
+{
+
+	uint32 seq;					//!< Odd while a new copy is being published
+	Probe_Stage_S stage[PROBE_STAGES];	//!< PROBE_DUMP counts the code periods timed
+
+} Probe_S;
+
+
+/*! \ingroup STRUCTS
+ * Per consumer FIFO statistics, the FIFO thread publishes a copy that anyone can read without a lock
+ */
+typedef struct _FIFO_Stats_S
+{
+
+	uint32 seq;			//!< Odd while a new copy is being published
+	int32 channels;		//!< Number of channels running, consumer[channels] is the acquisition
+	FIFO_Consumer_S consumer[MAX_CHANNELS+1];	//!< Each correlator, then the acquisition
+
+} FIFO_Stats_S;
+
+
+/*! \ingroup STRUCTS
+ * Data from the FIFO to the Telemetry, kept well under PIPE_BUF so each write is atomic
  */
 typedef struct _FIFO_2_Telem_S
 {
@@ -592,10 +702,23 @@ typedef struct _FIFO_2_Telem_S
 	int32 agc_scale;	//!< Value used for AGC scale
 	int32 overflw;		//!< Overflows in last ms
 	int32 nactive;		//!< Number of channels to process the measurment packet
+	int32 depth;		//!< Length of the FIFO, in ms
 
 } FIFO_2_Telem_S;
 
 
+/*! \ingroup STRUCTS
+ * Data from the FIFO to the PVT, just the timing of each measurement
+ */
+typedef struct _FIFO_2_PVT_S
+{
+
+	int32 tic;			//!< Receiver tic of the measurement
+	int32 count;		//!< Number of 1 ms packets processed
+
+} FIFO_2_PVT_S;
+
+
 /*! \ingroup STRUCTS
  *
  */
@@ -669,6 +792,7 @@ typedef struct _Telem_2_GUI_S
 {
 
 	FIFO_2_Telem_S 		tFIFO;
+	FIFO_Stats_S		tStats;
 	PVT_2_Telem_S 		tNav;
 	Chan_Packet_S 		tChan[MAX_CHANNELS];
 	Acq_Result_S		tAcq;
@@ -37,6 +37,19 @@ void usage(int32 argc, char* argv[])
 	fprintf(stderr, "[-c] log high rate channel data\n");
 	fprintf(stderr, "[-l] log navigation data\n");
 	fprintf(stderr, "[-d] <N> decimate logged nav data by this N factor\n");
+	fprintf(stderr, "[-b] <N> correlate N ms of IF data at a time (1:%d)\n",FIFO_MAX_BATCH);
+	fprintf(stderr, "[-ch] <N> run N channels (1:%d, default %d)\n",MAX_CHANNELS,DEFAULT_CHANNELS);
+	fprintf(stderr, "[-j] <N> run the correlators channel major on N threads (1:channels), %d gives %d channels each\n",CPU_CORES,CORR_PER_CPU);
+	fprintf(stderr, "[-aj] <N> spread the acquisition search over N threads (1:%d, default 1)\n",MAX_ACQ_WORKERS);
+	fprintf(stderr, "[-acpu] <N> let the acquisition use N%% of a CPU in realtime (1:%d, default %d)\n",100*MAX_ACQ_WORKERS,ACQ_BUDGET);
+	fprintf(stderr, "[-afine] <N> split each 250 Hz step of the 10 ms searches into N Doppler bins (1:%d, default %d)\n",ACQ_MAX_FINE,ACQ_FINE);
+	fprintf(stderr, "[-f] <N> buffer N ms of IF data in the FIFO (%d:%d, default %d)\n",FIFO_MIN_DEPTH,FIFO_MAX_DEPTH,FIFO_DEPTH);
+	fprintf(stderr, "[-t] <N> run N code delays per channel, odd (3:%d, default %d)\n",MAX_TAPS,2*CORR_DELAYS+1);
+	fprintf(stderr, "[-s] <X> space the code delays X chips apart (default %.2f), the whole bank spans at most %d chips\n",CORR_SPACING,MAX_TAP_SPAN);
+	fprintf(stderr, "[-cpu] <kind:cpus[:policy[:priority]]> place a kind of thread, e.g. corr:2-5:fifo:88\n");
+	fprintf(stderr, "      kinds fifo corr acq pvt ephem select telem key post, cpus like 0,2-5 or any, policy fifo rr or other\n");
+	fprintf(stderr, "[-place] <filename> read -cpu placements from a file, one per line\n");
+	fprintf(stderr, "[-isolate] keep the acquisition off the correlator CPUs\n");
 	fprintf(stderr, "[-g] log google earth data\n");
 	fprintf(stderr, "[-v] be verbose \n");
 	fprintf(stderr, "[-n] ncurses OFF \n");
@@ -93,6 +106,16 @@ void echo_options()
 	fprintf(stderr, "log_channel:\t\t %d\n",gopt.log_channel);
 	fprintf(stderr, "log_nav:\t\t %d\n",gopt.log_nav);
 	fprintf(stderr, "log_decimate:\t\t %d\n",gopt.log_decimate);
+	fprintf(stderr, "channels:\t\t %d\n",gopt.channels);
+	fprintf(stderr, "corr_batch:\t\t %d\n",gopt.corr_batch);
+	fprintf(stderr, "corr_workers:\t\t %d\n",gopt.corr_workers);
+	fprintf(stderr, "fifo_depth:\t\t %d\n",gopt.fifo_depth);
+	fprintf(stderr, "corr_taps:\t\t %d\n",gopt.corr_taps);
+	fprintf(stderr, "corr_spacing:\t\t %.3f\n",gopt.corr_spacing);
+	fprintf(stderr, "isolate_acq:\t\t %d\n",gopt.isolate_acq);
+	fprintf(stderr, "acq_workers:\t\t %d\n",gopt.acq_workers);
+	fprintf(stderr, "acq_budget:\t\t %d\n",gopt.acq_budget);
+	fprintf(stderr, "acq_fine:\t\t %d\n",gopt.acq_fine);
 	fprintf(stderr, "google_earth:\t\t %d\n",gopt.google_earth);
 	fprintf(stderr, "ncurses:\t\t %d\n",gopt.ncurses);
 	fprintf(stderr, "filename_direct:\t %s\n",gopt.filename_direct);
@@ -123,9 +146,19 @@ void Parse_Arguments(int32 argc, char* argv[])
 	gopt.gui			= 0;
 	gopt.doppler_min 	= -MAX_DOPPLER;
 	gopt.doppler_max 	= MAX_DOPPLER;
-	gopt.corr_sleep 	= 500;
+	gopt.channels		= DEFAULT_CHANNELS;
+	gopt.corr_batch		= 1;
+	gopt.corr_workers	= 0;
+	gopt.fifo_depth		= FIFO_DEPTH;
+	gopt.corr_taps		= 2*CORR_DELAYS+1;
+	gopt.corr_spacing	= CORR_SPACING;
 	gopt.startup		= COLD_START;
 	gopt.usrp_internal	= 0;
+	gopt.isolate_acq	= 0;
+	gopt.acq_workers	= 1;
+	gopt.acq_budget		= ACQ_BUDGET;
+	gopt.acq_fine		= ACQ_FINE;
+	Placement_Defaults();
 	strcpy(gopt.filename_direct, "data.bda");
 	strcpy(gopt.filename_reflected, "rdata.bda");
 
@@ -136,7 +169,6 @@ void Parse_Arguments(int32 argc, char* argv[])
 			gopt.post_process = 1;
 			gopt.realtime = 0;
 			gopt.ocean = 0;
-			gopt.corr_sleep = 100;
 
 			if(argc < lcv+2)
 				usage(argc, argv);
@@ -173,6 +205,150 @@ void Parse_Arguments(int32 argc, char* argv[])
 				usage(argc, argv);
 			}
 		}
+		else if(strcmp(argv[lcv],"-b") == 0)
+		{
+			if((lcv+1 < argc) && isdigit(argv[lcv+1][0]))
+			{
+				lcv++;
+				gopt.corr_batch = atoi(argv[lcv]);
+				if((gopt.corr_batch < 1) || (gopt.corr_batch > FIFO_MAX_BATCH))
+					usage(argc, argv);
+			}
+			else
+			{
+				usage(argc, argv);
+			}
+		}
+		else if(strcmp(argv[lcv],"-ch") == 0)
+		{
+			if((lcv+1 < argc) && isdigit(argv[lcv+1][0]))
+			{
+				lcv++;
+				gopt.channels = atoi(argv[lcv]);
+				if((gopt.channels < 1) || (gopt.channels > MAX_CHANNELS))
+					usage(argc, argv);
+			}
+			else
+			{
+				usage(argc, argv);
+			}
+		}
+		else if(strcmp(argv[lcv],"-j") == 0)
+		{
+			if((lcv+1 < argc) && isdigit(argv[lcv+1][0]))
+			{
+				lcv++;
+				gopt.corr_workers = atoi(argv[lcv]);
+				if((gopt.corr_workers < 1) || (gopt.corr_workers > MAX_CHANNELS))
+					usage(argc, argv);
+			}
+			else
+			{
+				usage(argc, argv);
+			}
+		}
+		else if(strcmp(argv[lcv],"-aj") == 0)
+		{
+			if((lcv+1 < argc) && isdigit(argv[lcv+1][0]))
+			{
+				lcv++;
+				gopt.acq_workers = atoi(argv[lcv]);
+				if((gopt.acq_workers < 1) || (gopt.acq_workers > MAX_ACQ_WORKERS))
+					usage(argc, argv);
+			}
+			else
+			{
+				usage(argc, argv);
+			}
+		}
+		else if(strcmp(argv[lcv],"-acpu") == 0)
+		{
+			if((lcv+1 < argc) && isdigit(argv[lcv+1][0]))
+			{
+				lcv++;
+				gopt.acq_budget = atoi(argv[lcv]);
+				if((gopt.acq_budget < 1) || (gopt.acq_budget > 100*MAX_ACQ_WORKERS))
+					usage(argc, argv);
+			}
+			else
+			{
+				usage(argc, argv);
+			}
+		}
+		else if(strcmp(argv[lcv],"-afine") == 0)
+		{
+			if((lcv+1 < argc) && isdigit(argv[lcv+1][0]))
+			{
+				lcv++;
+				gopt.acq_fine = atoi(argv[lcv]);
+				if((gopt.acq_fine < 1) || (gopt.acq_fine > ACQ_MAX_FINE))
+					usage(argc, argv);
+			}
+			else
+			{
+				usage(argc, argv);
+			}
+		}
+		else if(strcmp(argv[lcv],"-f") == 0)
+		{
+			if((lcv+1 < argc) && isdigit(argv[lcv+1][0]))
+			{
+				lcv++;
+				gopt.fifo_depth = atoi(argv[lcv]);
+				if((gopt.fifo_depth < FIFO_MIN_DEPTH) || (gopt.fifo_depth > FIFO_MAX_DEPTH))
+					usage(argc, argv);
+			}
+			else
+			{
+				usage(argc, argv);
+			}
+		}
+		else if(strcmp(argv[lcv],"-t") == 0)
+		{
+			if((lcv+1 < argc) && isdigit(argv[lcv+1][0]))
+			{
+				lcv++;
+				gopt.corr_taps = atoi(argv[lcv]);
+				if((gopt.corr_taps < 3) || (gopt.corr_taps > MAX_TAPS) || ((gopt.corr_taps & 1) == 0))
+					usage(argc, argv);
+			}
+			else
+			{
+				usage(argc, argv);
+			}
+		}
+		else if(strcmp(argv[lcv],"-s") == 0)
+		{
+			if((lcv+1 < argc) && (isdigit(argv[lcv+1][0]) || (argv[lcv+1][0] == '.')))
+			{
+				lcv++;
+				gopt.corr_spacing = atof(argv[lcv]);
+				if(gopt.corr_spacing <= 0.0)
+					usage(argc, argv);
+			}
+			else
+			{
+				usage(argc, argv);
+			}
+		}
+		else if(strcmp(argv[lcv],"-cpu") == 0)
+		{
+			if((lcv+1 < argc) && Placement_Parse(argv[lcv+1]))
+				lcv++;
+			else
+				usage(argc, argv);
+		}
+		else if(strcmp(argv[lcv],"-place") == 0)
+		{
+			if((lcv+1 < argc) && Placement_Read(argv[lcv+1]))
+				lcv++;
+			else
+				usage(argc, argv);
+		}
+		else if(strcmp(argv[lcv],"-isolate") == 0)
+		{
+			gopt.isolate_acq = 1;
+		}
 		else if(strcmp(argv[lcv],"-c") == 0)
 		{
 			gopt.log_channel = 1;
@@ -206,6 +382,17 @@ void Parse_Arguments(int32 argc, char* argv[])
 			usage(argc, argv);
 	}
 
+	/* Every worker needs at least one channel */
+	if(gopt.corr_workers > gopt.channels)
+		usage(argc, argv);
+
+	/* The whole bank has to fit in the code word the SIMD correlators fetch */
+	if((gopt.corr_taps-1)*gopt.corr_spacing > (double)MAX_TAP_SPAN)
+		usage(argc, argv);
+
+	/* Once the correlator CPUs are known */
+	Placement_Isolate();
+
 	echo_options();
 
 }
@@ -265,6 +452,24 @@ int32 Hardware_Init(void)
 			printf("Detected SSE4.2\n");
 	}
 
+	if(CPU_AVX2())
+	{
+		if(gopt.verbose)
+			printf("Detected AVX2\n");
+	}
+
+	if(CPU_AVX512())
+	{
+		if(gopt.verbose)
+			printf("Detected AVX-512\n");
+	}
+
+	/* Pick the correlator kernels */
+	Init_SIMD();
+
+	if(gopt.verbose)
+		printf("Using %s kernels\n",simd_level);
+
 	return(1);
 
 }
@@ -278,11 +483,18 @@ int32 Object_Init(void)
 	int32 lcv;
 	int32 failed;
 
+	/* Every channel starts out in the pool */
+	pthread_mutex_init(&mInterrupt, NULL);
+	pthread_mutex_unlock(&mInterrupt);
+	gInterrupt = new uint32[gopt.channels];
+	for(lcv = 0; lcv < gopt.channels; lcv++)
+		gInterrupt[lcv] = CHANNEL_FREE;
+
 	/* Create Keyboard objec to handle user input */
 	pKeyboard = new Keyboard;
 
-	/* Now do the hard work? */
-	pAcquisition = new Acquisition(IF_SAMPLE_FREQUENCY, IF_FREQUENCY);
+	/* Now do the hard work? The search runs at the IF rate the FIFO carries, not decimated */
+	pAcquisition = new Acquisition(IF_SAMPLE_FREQUENCY, IF_FREQUENCY, IF_SAMPLE_FREQUENCY);
 
 	pEphemeris = new Ephemeris;
 
@@ -291,12 +503,22 @@ int32 Object_Init(void)
 
 	pSV_Select = new SV_Select;
 
-	for(lcv = 0; lcv < MAX_CHANNELS; lcv++)
+	pChannels = new Channel *[gopt.channels];
+	for(lcv = 0; lcv < gopt.channels; lcv++)
 		pChannels[lcv] = new Channel(lcv);
 
-	for(lcv = 0; lcv < MAX_CHANNELS; lcv++)
+	pCorrelators = new Correlator *[gopt.channels];
+	for(lcv = 0; lcv < gopt.channels; lcv++)
 		pCorrelators[lcv] =  new Correlator(lcv);
 
+	/* Deal the correlators out over the workers, Claim_Channel() keeps the tracked ones spread evenly */
+	if(gopt.corr_workers)
+	{
+		pCorrWorkers = new Correlator_Worker *[gopt.corr_workers];
+		for(lcv = 0; lcv < gopt.corr_workers; lcv++)
+			pCorrWorkers[lcv] = new Correlator_Worker(lcv, gopt.corr_workers);
+	}
+
 	pTelemetry = new Telemetry(gopt.ncurses);
 
 	pPVT = new PVT(gopt.startup);
@@ -304,14 +526,6 @@ int32 Object_Init(void)
 	if(gopt.post_process)
 		pPost_Process = new Post_Process(gopt.filename_direct);
 
-	pthread_mutex_init(&mAcq, NULL);
-	pthread_mutex_unlock(&mAcq);
-	int32 gAcq_high = false;
-
-	pthread_mutex_init(&mInterrupt, NULL);
-	pthread_mutex_unlock(&mInterrupt);
-	memset(gInterrupt, 0x0, MAX_CHANNELS*sizeof(uint32));
-
 	//if(gopt.verbose)
 	{
 		printf("Cleared Object Init\n");
@@ -348,7 +562,10 @@ int32 Pipes_Init(void)
 	fcntl(PVT_2_SV_Select_P[READ], F_SETFL, O_NONBLOCK);
 
 	/* Channel and correlator */
-	for(lcv = 0; lcv < MAX_CHANNELS; lcv++)
+	Trak_2_Corr_P = new int32[gopt.channels][2];
+	Corr_2_PVT_P = new int32[gopt.channels][2];
+	PVT_2_Corr_P = new int32[gopt.channels][2];
+	for(lcv = 0; lcv < gopt.channels; lcv++)
 	{
 		pipe((int *)Trak_2_Corr_P[lcv]);
 		pipe((int *)Corr_2_PVT_P[lcv]);
@@ -390,8 +607,16 @@ int32 Thread_Init(void)
 	pFIFO->Start();
 
 	/* Start up the correlators */
-	for(lcv = 0; lcv < MAX_CHANNELS; lcv++)
-		pCorrelators[lcv]->Start();
+	if(gopt.corr_workers)
+	{
+		for(lcv = 0; lcv < gopt.corr_workers; lcv++)
+			pCorrWorkers[lcv]->Start();
+	}
+	else
+	{
+		for(lcv = 0; lcv < gopt.channels; lcv++)
+			pCorrelators[lcv]->Start();
+	}
 
 	/* Start up the acquistion */
 	pAcquisition->Start();
@@ -416,3 +641,61 @@ int32 Thread_Init(void)
 
 }
 /*----------------------------------------------------------------------------------------------*/
+
+
+
+/*! Take a free channel from the pool */
+/*----------------------------------------------------------------------------------------------*/
+int32 Claim_Channel(void)
+{
+	int32 lcv, chan, worker, best;
+	int32 load[MAX_CHANNELS];
+
+	chan = -1;
+	best = MAX_CHANNELS+1;
+
+	pthread_mutex_lock(&mInterrupt);
+
+	/* How many channels each worker is already running, without workers every channel has its own thread */
+	memset(load, 0x0, MAX_CHANNELS*sizeof(int32));
+	if(gopt.corr_workers)
+		for(lcv = 0; lcv < gopt.channels; lcv++)
+			if(gInterrupt[lcv] != CHANNEL_FREE)
+				load[lcv % gopt.corr_workers]++;
+
+	/* Take the free channel on the least loaded worker, the lowest numbered one on a tie */
+	for(lcv = 0; lcv < gopt.channels; lcv++)
+	{
+		if(gInterrupt[lcv] != CHANNEL_FREE)
+			continue;
+
+		worker = gopt.corr_workers ? lcv % gopt.corr_workers : 0;
+		if(load[worker] < best)
+		{
+			best = load[worker];
+			chan = lcv;
+		}
+	}
+
+	if(chan != -1)
+		gInterrupt[chan] = CHANNEL_CLAIMED;
+
+	pthread_mutex_unlock(&mInterrupt);
+
+	return(chan);
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*! Hand a channel back to the pool */
+/*----------------------------------------------------------------------------------------------*/
+void Retire_Channel(int32 _chan)
+{
+
+	pthread_mutex_lock(&mInterrupt);
+	gInterrupt[_chan] = CHANNEL_FREE;
+	pthread_mutex_unlock(&mInterrupt);
+
+}
+/*----------------------------------------------------------------------------------------------*/
@@ -41,9 +41,17 @@ void Thread_Shutdown(void)
 	/* Uh-oh */
 	pPVT->Stop();
 
-	/* Start up the correlators */
-	for(lcv = 0; lcv < MAX_CHANNELS; lcv++)
-		pCorrelators[lcv]->Stop();
+	/* Stop the correlators */
+	if(gopt.corr_workers)
+	{
+		for(lcv = 0; lcv < gopt.corr_workers; lcv++)
+			pCorrWorkers[lcv]->Stop();
+	}
+	else
+	{
+		for(lcv = 0; lcv < gopt.channels; lcv++)
+			pCorrelators[lcv]->Stop();
+	}
 
 	/* Stop the acquistion */
 	pAcquisition->Stop();
@@ -85,7 +93,7 @@ void Pipes_Shutdown(void)
 	close(Chan_2_Ephem_P[READ]);
 	close(Chan_2_Ephem_P[WRITE]);
 
-	for(lcv = 0; lcv < MAX_CHANNELS; lcv++)
+	for(lcv = 0; lcv < gopt.channels; lcv++)
 	{
 		close(Trak_2_Corr_P[lcv][READ]);
 		close(Trak_2_Corr_P[lcv][WRITE]);
@@ -95,6 +103,10 @@ void Pipes_Shutdown(void)
 		close(PVT_2_Corr_P[lcv][WRITE]);
 	}
 
+	delete [] Trak_2_Corr_P;
+	delete [] Corr_2_PVT_P;
+	delete [] PVT_2_Corr_P;
+
 }
 /*----------------------------------------------------------------------------------------------*/
 
@@ -105,14 +117,21 @@ void Object_Shutdown(void)
 {
 	int32 lcv;
 
-	pthread_mutex_destroy(&mAcq);
 	pthread_mutex_destroy(&mInterrupt);
 
-	for(lcv = 0; lcv < MAX_CHANNELS; lcv++)
+	for(lcv = 0; lcv < gopt.corr_workers; lcv++)
+		delete pCorrWorkers[lcv];
+	delete [] pCorrWorkers;
+
+	for(lcv = 0; lcv < gopt.channels; lcv++)
 		delete pCorrelators[lcv];
+	delete [] pCorrelators;
 
-	for(lcv = 0; lcv < MAX_CHANNELS; lcv++)
+	for(lcv = 0; lcv < gopt.channels; lcv++)
 		delete pChannels[lcv];
+	delete [] pChannels;
+
+	delete [] gInterrupt;
 
 	if(gopt.post_process)
 		delete pPost_Process;
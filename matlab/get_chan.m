@@ -24,8 +24,12 @@ function [A] = get_chan(chan)
 % 	float w;
 % 	float x;
 % 	float z;	
+% 	float taps;
+% 	float tap_spacing;
+% 	float I_tap[21];
+% 	float Q_tap[21];
 
-pts = 28;
+pts = 72;
 
 fp = fopen(sprintf('../chan%02d.dat',chan),'rb');
 A(:,1) = fread(fp,inf,'float'); 
@@ -0,0 +1,37 @@
+function [B] = get_if(fp, pts)
+
+% Peek at the newest IF packet in the gps-sdr shared ring (/dev/shm/gps-sdr-if), without
+% taking it from the FIFO. See accessories/shm_ring.h for the layout. Returns [] if the ring
+% is not up yet or the packet was rewritten while it was being read.
+
+B = [];
+
+fseek(fp,0,'bof');
+H = fread(fp,48,'uint32');
+if(length(H) < 48)
+    return;
+end
+
+magic = H(1);
+slots = H(2);
+stride = H(4);
+write_seq = H(17);
+
+if((magic ~= hex2dec('47505352')) || (write_seq == 0))
+    return;
+end
+
+% Newest packet, its slot sequence is 2*n+2 once it is complete
+n = write_seq - 1;
+offset = 192 + mod(n,slots)*stride;
+
+fseek(fp,offset,'bof');
+S = fread(fp,2,'uint32');
+fseek(fp,offset+64,'bof');
+B = fread(fp,min(pts,S(2)/2),'int16');
+fseek(fp,offset,'bof');
+check = fread(fp,1,'uint32');
+
+if((S(1) ~= 2*n+2) || (check ~= S(1)))
+    B = [];
+end
@@ -2,7 +2,7 @@
 clear all; close all;
 
 
-fp = fopen('/tmp/GPSPIPE','r')
+fp = fopen('/dev/shm/gps-sdr-if','r')
 pts = 4096;
 paxis = 1:pts/2;
 edges = -2048:128:2048;
@@ -18,8 +18,12 @@ if(fp > 0)
 
 while(1)
 
-    %flush the pipe
-    B = fread(fp,pts,'int16');
+    %newest packet in the ring
+    B = get_if(fp,pts);
+    if(length(B) ~= pts)
+        pause(0.01);
+        continue;
+    end
     
     figure(1)
     set(a(1),'Ydata',B(1:2:end));
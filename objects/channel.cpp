@@ -80,6 +80,8 @@ void Channel::Clear()
 	I[0] = I[1] = I[2] = 1;
 	Q[0] = Q[1] = Q[2] = 1;
 	P[0] = P[1] = P[2] = 1;
+	memset(&I_tap, 0x0, MAX_TAPS*sizeof(int32));
+	memset(&Q_tap, 0x0, MAX_TAPS*sizeof(int32));
 	I_prev = Q_prev = 1;		//Important to prevent divide by zero
 	I_avg = 1;
 	Q_var = 1;
@@ -175,6 +177,8 @@ Chan_Packet_S Channel::getPacket()
 void Channel::Accum(Correlation_S *corr, NCO_Command_S *_feedback)
 {
 
+	int32 lcv;
+
 	corr->I[0] >>= 3;
 	corr->I[1] >>= 3;
 	corr->I[2] >>= 3;
@@ -190,6 +194,13 @@ void Channel::Accum(Correlation_S *corr, NCO_Command_S *_feedback)
 	Q[1] += corr->Q[1];
 	Q[2] += corr->Q[2];
 
+	/* The bank rides along for export only */
+	for(lcv = 0; lcv < gopt.corr_taps; lcv++)
+	{
+		I_tap[lcv] += corr->I_tap[lcv] >> 3;
+		Q_tap[lcv] += corr->Q_tap[lcv] >> 3;
+	}
+
 	/* Always do these, a running sum of past 20 1ms accumulations */
 	I_sum20	+= corr->I[1] - I_buff[_1ms_epoch];
 	Q_sum20 += corr->Q[1] - Q_buff[_1ms_epoch];
@@ -322,6 +333,8 @@ void Channel::DumpAccum()
 	/* Zero out the correlations */
 	I[0] = I[1] = I[2] = 0;
 	Q[0] = Q[1] = Q[2] = 0;
+	memset(&I_tap, 0x0, MAX_TAPS*sizeof(int32));
+	memset(&Q_tap, 0x0, MAX_TAPS*sizeof(int32));
 
 }
 /*----------------------------------------------------------------------------------------------*/
@@ -739,18 +752,18 @@ bool Channel::ParityCheck(uint32 gpsword)
        and-xor loops. */
 
     d1 = gpsword & 0xFBFFBF00;
-    d2 = _lrotl(gpsword,1) & 0x07FFBF01;
-    d3 = _lrotl(gpsword,2) & 0xFC0F8100;
-    d4 = _lrotl(gpsword,3) & 0xF81FFE02;
-    d5 = _lrotl(gpsword,4) & 0xFC00000E;
-    d6 = _lrotl(gpsword,5) & 0x07F00001;
-    d7 = _lrotl(gpsword,6) & 0x00003000;
+    d2 = ROTL32(gpsword,1) & 0x07FFBF01;
+    d3 = ROTL32(gpsword,2) & 0xFC0F8100;
+    d4 = ROTL32(gpsword,3) & 0xF81FFE02;
+    d5 = ROTL32(gpsword,4) & 0xFC00000E;
+    d6 = ROTL32(gpsword,5) & 0x07F00001;
+    d7 = ROTL32(gpsword,6) & 0x00003000;
 
     t = d1 ^ d2 ^ d3 ^ d4 ^ d5 ^ d6 ^ d7;
 
     // Now XOR the 5 6-bit fields together to produce the 6-bit final result.
 
-    parity = t ^ _lrotl(t,6) ^ _lrotl(t,12) ^ _lrotl(t,18) ^ _lrotl(t,24);
+    parity = t ^ ROTL32(t,6) ^ ROTL32(t,12) ^ ROTL32(t,18) ^ ROTL32(t,24);
     parity = parity & 0x3F;
     if (parity == (gpsword&0x3F))
         return(true);
@@ -906,8 +919,8 @@ void Channel::Error()
 	if(count > 30000 && converged == false)
 		Stop();
 
-	/* The channel should be killed if the nco goes outside the pre generated wipeoff table */
-	if(fabs(carrier_nco-IF_FREQUENCY) > CARRIER_BINS*CARRIER_SPACING)
+	/* The channel should be killed if the nco goes outside the Doppler search range */
+	if(fabs(carrier_nco-IF_FREQUENCY) > MAX_DOPPLER)
 		Stop();
 
 	/* Adjust integration length based on CN0 */
@@ -945,7 +958,7 @@ void Channel::Stop()
 void Channel::Export()
 {
 
-	int32 bwrote;
+	int32 lcv, bwrote;
 
 	packet.header 		= (float)CHAN_HEADER;
 	packet.chan 		= (float)chan;
@@ -975,6 +988,14 @@ void Channel::Export()
 	packet.w			= (float)aPLL.w/(float)len;
 	packet.x 			= (float)aPLL.x;
 	packet.z 			= (float)aPLL.z;
+	packet.taps			= (float)gopt.corr_taps;
+	packet.tap_spacing	= (float)gopt.corr_spacing;
+
+	for(lcv = 0; lcv < MAX_TAPS; lcv++)
+	{
+		packet.I_tap[lcv] = (float)I_tap[lcv];
+		packet.Q_tap[lcv] = (float)Q_tap[lcv];
+	}
 
 	if(gopt.log_channel && (fp != NULL))
 		fwrite(&packet, sizeof(Chan_Packet_S), 1,  fp);
@@ -65,6 +65,8 @@ typedef class Channel
 		int32 I[3];				//!< Inphase correlations
 		int32 Q[3];				//!< Quadrature correlations
 		int32 P[3];				//!< Power
+		int32 I_tap[MAX_TAPS];	//!< Inphase correlations of the code delay bank
+		int32 Q_tap[MAX_TAPS];	//!< Quadrature correlations of the code delay bank
 		int32 I_prev;			//!< Previous I prompt correlation
 		int32 Q_prev;			//!< Previous Q prompt correlation
 		float I_avg;			//!< Moving average of I
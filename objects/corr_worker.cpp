@@ -0,0 +1,138 @@
+/*! \file Corr_Worker.cpp
+	Implements member functions of Correlator_Worker class.
+*/
+/************************************************************************************************
+Copyright 2008 Gregory W Heckler
+
+This file is part of the GPS Software Defined Radio (GPS-SDR)
+
+The GPS-SDR is free software; you can redistribute it and/or modify it under the terms of the
+GNU General Public License as published by the Free Software Foundation; either version 2 of the
+License, or (at your option) any later version.
+
+The GPS-SDR is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with GPS-SDR; if not,
+write to the:
+
+Free Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+************************************************************************************************/
+
+
+#include "corr_worker.h"
+
+/*----------------------------------------------------------------------------------------------*/
+void *Correlator_Worker_Thread(void *_arg)
+{
+
+	Correlator_Worker *aWorker = pCorrWorkers[*(int32 *)_arg];
+
+	while(grun)
+	{
+		aWorker->Inport();
+		aWorker->Correlate();
+	}
+
+	pthread_exit(0);
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+void Correlator_Worker::Start()
+{
+	Thread_Create(&thread, THREAD_CORR, worker, Correlator_Worker_Thread, &worker);
+
+	if(gopt.verbose)
+		printf("Started correlator worker %d, every %d channels from %d\n",worker,stride,worker);
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+void Correlator_Worker::Stop()
+{
+	pthread_cancel(thread);
+	pthread_join(thread, NULL);
+
+	if(gopt.verbose)
+		printf("Stopped correlator worker %d\n",worker);
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+Correlator_Worker::Correlator_Worker(int32 _worker, int32 _stride)
+{
+
+	int32 lcv;
+
+	worker = _worker;
+	stride = _stride;
+	packet = NULL;
+	npackets = gopt.corr_batch;
+
+	/* The whole worker reads through its first channel's cursor, the rest must not hold back the tail */
+	for(lcv = worker + stride; lcv < gopt.channels; lcv += stride)
+		pFIFO->Unsubscribe(lcv);
+
+	if(gopt.verbose)
+		printf("Creating Correlator Worker %d\n",worker);
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+Correlator_Worker::~Correlator_Worker()
+{
+
+	if(gopt.verbose)
+		printf("Destructing Correlator Worker %d\n",worker);
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+void Correlator_Worker::Inport()
+{
+
+	/* Hand the last packets back to the FIFO */
+	if(packet != NULL)
+		pFIFO->Release(worker, npackets);
+
+	/* Sleep until the FIFO publishes the next packets, charged to the channel whose cursor it is */
+	PROBE_TIC(1, tsc);
+	packet = pFIFO->Wait(worker, npackets);
+	PROBE_TOC(1, pCorrelators[worker]->getProbe(), PROBE_WAIT, tsc);
+	if(packet == NULL)
+		pthread_exit(0);
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * Correlate: Channel major, every correlator runs over the same span before the next one is
+ * borrowed, so the IF data only comes in from memory once per worker
+ * */
+void Correlator_Worker::Correlate()
+{
+
+	Correlator *aCorrelator;
+	int32 lcv;
+
+	for(lcv = worker; lcv < gopt.channels; lcv += stride)
+	{
+		aCorrelator = pCorrelators[lcv];
+		aCorrelator->SetPacket(packet);
+		aCorrelator->Correlate();
+	}
+
+}
+/*----------------------------------------------------------------------------------------------*/
@@ -0,0 +1,54 @@
+/*! \file Corr_Worker.h
+	Defines the class Correlator_Worker
+*/
+/************************************************************************************************
+Copyright 2008 Gregory W Heckler
+
+This file is part of the GPS Software Defined Radio (GPS-SDR)
+
+The GPS-SDR is free software; you can redistribute it and/or modify it under the terms of the
+GNU General Public License as published by the Free Software Foundation; either version 2 of the
+License, or (at your option) any later version.
+
+The GPS-SDR is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with GPS-SDR; if not,
+write to the:
+
+Free Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+************************************************************************************************/
+
+#ifndef Correlator_Worker_H
+#define Correlator_Worker_H
+
+#include "includes.h"
+
+/*! \ingroup CLASSES
+ * Channel major correlator engine. One worker borrows each span of IF data from the FIFO once
+ * and runs every one of its correlators over it back to back, while the samples are still in
+ * cache, instead of every correlator thread pulling in its own copy.
+ */
+class Correlator_Worker
+{
+
+	private:
+
+		pthread_t 			thread;	 					//!< For the thread
+		int32				worker;						//!< Which worker is this?
+		int32				stride;						//!< Runs every stride-th channel starting at its own number, whose FIFO cursor is used for the whole worker
+		const ms_packet		*packet;					//!< npackets ms of data, borrowed from the FIFO
+		int32				npackets;					//!< Number of 1ms packets processed per span
+
+	public:
+
+		Correlator_Worker(int32 _worker, int32 _stride);
+		~Correlator_Worker();
+		void Inport();												//!< Borrow the next span of IF data
+		void Correlate();											//!< Run all of this worker's correlators over it
+		void Start();												//!< Start the thread
+		void Stop();												//!< Stop the thread
+};
+
+#endif /* Correlator_Worker_H */
@@ -23,10 +23,8 @@ Free Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1
 #include "correlator.h"
 
 /* Be sure to init static variable prior to use by actual objects */
-CPX *Correlator::sine_table = new CPX[(2*CARRIER_BINS+1)*2*SAMPS_MS];
-CPX **Correlator::sine_rows = new CPX*[2*CARRIER_BINS+1];
-MIX *Correlator::main_code_table = new MIX[NUM_CODES*(2*CODE_BINS+1)*2*SAMPS_MS];
-MIX **Correlator::main_code_rows = new MIX*[NUM_CODES*(2*CODE_BINS+1)];
+CPX *Correlator::carrier_lut = new CPX[CARRIER_LUT_SIZE];
+uint8 *Correlator::main_code_table = new uint8[NUM_CODES*CODE_NCO_BYTES];
 
 /*----------------------------------------------------------------------------------------------*/
 void *Correlator_Thread(void *_arg)
@@ -49,25 +47,7 @@ void *Correlator_Thread(void *_arg)
 /*----------------------------------------------------------------------------------------------*/
 void Correlator::Start()
 {
-	pthread_attr_t tattr;
-	sched_param param;
-	int32 ret;
-
-	/* Unitialized with default attributes */
-	ret = pthread_attr_init(&tattr);
-
-	/*Ssafe to get existing scheduling param */
-	ret = pthread_attr_getschedparam(&tattr, &param);
-
-	/* Set the priority; others are unchanged */
-	param.sched_priority = CORR_PRIORITY;
-
-	/* Setting the new scheduling param */
-	ret = pthread_attr_setschedparam(&tattr, &param);
-	ret = pthread_attr_setschedpolicy(&tattr, SCHED_FIFO);
-
-	/* With new priority specified */
-	pthread_create(&thread, NULL, Correlator_Thread, &chan);
+	Thread_Create(&thread, THREAD_CORR, chan, Correlator_Thread, &chan);
 
 	if(gopt.verbose)
 		printf("Started correlator %d\n",chan);
@@ -91,33 +71,36 @@ void Correlator::Stop()
 Correlator::Correlator(int32 _chan)
 {
 
-	int32 lcv;
-
 	chan = _chan;
 	packet_count = 0;
+	packet = NULL;
+	npackets = gopt.corr_batch;
 	state.active = 0;
 	aChannel = pChannels[chan];
 
-	/* Malloc memory for local code vector */
-	code_table = new MIX[(2*CODE_BINS+1)*2*SAMPS_MS];
-	code_rows = new MIX*[2*CODE_BINS+1];
-	for(lcv = 0; lcv < 2*CODE_BINS+1; lcv++)
-		code_rows[lcv] = &code_table[lcv*2*SAMPS_MS];
+	memset(&probe, 0x0, sizeof(Probe_S));
+	memset(&probe_pub, 0x0, sizeof(Probe_S));
+	probe_tick = 0;
+	probing = 0;
 
-	if(chan == 0)
-	{
-		/* Get the pointers */
-		for(lcv = 0; lcv < 2*CARRIER_BINS+1; lcv++)
-			sine_rows[lcv] = &sine_table[lcv*2*SAMPS_MS];
+	/* The code is read straight out of the shared table, there is no local copy */
+	code_chips = &main_code_table[0];
+	code_nco_spacing = (uint32)floor(gopt.corr_spacing*(double)(1 << CODE_NCO_FRAC));
 
-		/* Create the wipeoff */
-		for(lcv = -CARRIER_BINS; lcv <= CARRIER_BINS; lcv++)
-			sine_gen(sine_rows[lcv+CARRIER_BINS], -IF_FREQUENCY-(float)lcv*CARRIER_SPACING, SAMPLE_FREQUENCY, 2*SAMPS_MS);
+	/* The tracking loops get the pair of taps closest to CORR_SPACING either side of prompt */
+	taps = gopt.corr_taps;
+	tap_dll = (int32)floor(CORR_SPACING/gopt.corr_spacing + .5);
+	if(tap_dll < 1)
+		tap_dll = 1;
+	if(tap_dll > (taps >> 1))
+		tap_dll = taps >> 1;
 
-		for(lcv = 0; lcv < (2*CODE_BINS+1)*NUM_CODES; lcv++)
-			main_code_rows[lcv] = &main_code_table[lcv*2*SAMPS_MS];
+	if(chan == 0)
+	{
+		/* One cycle of the wipeoff, the NCO steps through it at the exact carrier frequency */
+		sine_gen(carrier_lut, -1.0, CARRIER_LUT_SIZE, CARRIER_LUT_SIZE, 0.0);
 
-		SamplePRN();
+		PackPRN();
 	}
 
 	if(gopt.verbose)
@@ -131,15 +114,10 @@ Correlator::Correlator(int32 _chan)
 Correlator::~Correlator()
 {
 
-	delete [] code_table;
-	delete [] code_rows;
-
 	if(chan == 0)
 	{
-		delete [] sine_table;
-		delete [] sine_rows;
+		delete [] carrier_lut;
 		delete [] main_code_table;
-		delete [] main_code_rows;
 	}
 
 	if(gopt.verbose)
@@ -150,15 +128,38 @@ Correlator::~Correlator()
 
 /*----------------------------------------------------------------------------------------------*/
 void Correlator::Inport()
+{
+
+	/* Hand the last packets back to the FIFO */
+	if(packet != NULL)
+		pFIFO->Release(chan, npackets);
+
+	/* Sleep until the FIFO publishes the next packets */
+	PROBE_TIC(1, tsc);
+	packet = pFIFO->Wait(chan, npackets);
+	PROBE_TOC(1, &probe, PROBE_WAIT, tsc);
+	if(packet == NULL)
+		pthread_exit(0);
+
+	SetPacket(packet);
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * SetPacket: Point the correlator at the span to correlate next, and pick up any acquisition
+ * result waiting for it. Called from Inport(), or by a Correlator_Worker that borrowed the span.
+ * */
+void Correlator::SetPacket(const ms_packet *_packet)
 {
 	int32 bread;
-	int32 lcv;
-	int32 last;
-	Acq_Request_S temp;
-	ms_packet *p = NULL;
 
-	/* Wait for a command to start a new channel */
-	if(state.active == 0)
+	packet = _packet;
+
+	/* Wait for a command to start a new channel, only claimed channels have one coming */
+	if((state.active == 0) && (gInterrupt[chan] == CHANNEL_CLAIMED))
 	{
 		bread = read(Trak_2_Corr_P[chan][READ], &result, sizeof(Acq_Result_S));
 		if(bread == sizeof(Acq_Result_S))
@@ -180,23 +181,12 @@ void Correlator::Inport()
 
 			/* Set correlator status to active */
 			pthread_mutex_lock(&mInterrupt);
-			gInterrupt[chan] = 1;
+			gInterrupt[chan] = CHANNEL_ACTIVE;
 			pthread_mutex_unlock(&mInterrupt);
 		}
 	}
 
-	/* Should do this ONCE with built in blocking! */
-	last = packet.count;
-	pFIFO->Dequeue(chan, &packet);
-//	pFIFO->Wait(chan); //Pend until everyone has called dequeue
-
-	while(packet.count == last)
-	{
-		usleep(gopt.corr_sleep);
-		pFIFO->Dequeue(chan, &packet);
-	}
-
-	packet_count++;
+	packet_count += npackets;
 
 }
 /*----------------------------------------------------------------------------------------------*/
@@ -205,81 +195,84 @@ void Correlator::Inport()
 /*----------------------------------------------------------------------------------------------*/
 void Correlator::Correlate()
 {
-	Correlation_S *c;
 	CPX *if_data;
-	int32 leftover;
+	int32 lcv, samps;
 
-	if(packet.measurement)
-		TakeMeasurement();
+	/* The borrowed packets are one contiguous span, only break it up to take measurements */
+	if_data = (CPX *)&packet->data[0];
+	samps = 0;
 
-	if(state.active)
+	for(lcv = 0; lcv < npackets; lcv++)
 	{
-		if_data = &packet.data[0];
-		c = &corr;
-		leftover = SAMPS_MS;
-
-		/* If the rollover occurs in this packet */
-		if(state.rollover <= SAMPS_MS)
+		if(packet[lcv].measurement)
 		{
-			/* Do the actual accumulation */
-			Accum(c, if_data, state.rollover);
+			/* Bring the state up to the start of the measurement packet */
+			CorrelateSpan(if_data, samps);
+			if_data += samps;
+			samps = 0;
 
-			/* Remaining number of samples to be processed in this ms packet of data */
-			leftover = SAMPS_MS - state.rollover;
-			if_data += state.rollover;
+			TakeMeasurement(&packet[lcv]);
+		}
 
-			/* Update the code/carrier phase etc */
-			UpdateState(state.rollover);
+		samps += IF_SAMPS_MS;
+	}
 
-			/* Dump the accumulation */
-			DumpAccum(c);
+	CorrelateSpan(if_data, samps);
 
-			if(state.active == 0)
-				return;
+}
+/*----------------------------------------------------------------------------------------------*/
 
-			/* Now process remaining segment of IF data  */
-			if(state.rollover <= leftover) /* Rollover occurs in THIS packet of data */
-			{
-				/* Do the actual accumulation */
-				Accum(c, if_data, state.rollover);
 
-				/* Remaining number of samples to be processed in this ms packet of data */
-				leftover -= state.rollover;
-				if_data += state.rollover;
+/*----------------------------------------------------------------------------------------------*/
+void Correlator::CorrelateSpan(CPX *data, int32 samps)
+{
+	Correlation_S *c;
 
-				/* Update the code/carrier phase etc */
-				UpdateState(state.rollover);
+	if(state.active == 0)
+		return;
 
-				/* Dump the accumulation */
-				DumpAccum(c);
-				if(state.active == 0)
-					return;
+	c = &corr;
 
-				/* Do the actual accumulation */
-				Accum(c, if_data, leftover);
+	/* Dump at every code rollover in the span */
+	while(state.rollover <= samps)
+	{
+		PROBE_TIC(probing, tsc);
 
-				/* Update the code/carrier phase etc */
-				UpdateState(leftover);
+		/* Do the actual accumulation */
+		Accum(c, data, state.rollover);
+		PROBE_TOC(probing, &probe, PROBE_ACCUM, tsc);
 
-			}
-			else /* Rollover occurs in NEXT packet of data */
-			{
-				/* Do the actual accumulation */
-				Accum(c, if_data, leftover);
+		/* Remaining number of samples to be processed in this span */
+		samps -= state.rollover;
+		data += state.rollover;
 
-				/* Update the code/carrier phase */
-				UpdateState(leftover);
-			}
+		/* Update the code/carrier phase etc */
+		UpdateState(state.rollover);
+		PROBE_TOC(probing, &probe, PROBE_UPDATE, tsc);
 
-		}
-		else /* Just accumulate, no dumping */
-		{
-			/* Do the actual accumulation */
-			Accum(c, if_data, SAMPS_MS);
+		/* Dump the accumulation */
+		DumpAccum(c);
+		PROBE_TOC(probing, &probe, PROBE_DUMP, tsc);
 
-			/* Update the code/carrier phase */
-			UpdateState(SAMPS_MS);
-		}
+		/* Pick whether the next code period gets timed, its accumulation may start in this span */
+		PROBE_NEXT(probing, probe_tick);
+
+		if(state.active == 0)
+			return;
+	}
+
+	/* Rollover occurs in the NEXT span, just accumulate */
+	if(samps > 0)
+	{
+		PROBE_TIC(probing, tsc);
+
+		/* Do the actual accumulation */
+		Accum(c, data, samps);
+		PROBE_TOC(probing, &probe, PROBE_ACCUM, tsc);
+
+		/* Update the code/carrier phase */
+		UpdateState(samps);
+		PROBE_TOC(probing, &probe, PROBE_UPDATE, tsc);
 	}
 
 }
@@ -287,14 +280,15 @@ void Correlator::Correlate()
 
 
 /*----------------------------------------------------------------------------------------------*/
-void Correlator::TakeMeasurement()
+void Correlator::TakeMeasurement(const ms_packet *p)
 {
 
-	int32 lcv, tic;
+	int32 tic;
 	int32 n_dp, n_p, n_c;
+	double code_phase_mod, carrier_phase_mod;
 	Measurement_S *pmeas;
 
-	tic = packet.measurement;
+	tic = p->measurement;
 
 	/* Step 1, copy in measurement from ICP_TICS ago */
 	memcpy(&meas, &meas_buff[(tic - ICP_TICS + TICS_PER_SECOND) % TICS_PER_SECOND], sizeof(Measurement_S));
@@ -302,23 +296,27 @@ void Correlator::TakeMeasurement()
 	/* Get carrier phase prev from 2*ICP_TICKS ago */
 	meas.carrier_phase_prev = meas_buff[(tic - 2*ICP_TICS + TICS_PER_SECOND) % TICS_PER_SECOND].carrier_phase;
 
+	/* The phase accumulators only become doubles here */
+	code_phase_mod = (double)state.code_phase_mod/(double)((uint64)1 << PHASE_FRAC);
+	carrier_phase_mod = (double)state.carrier_phase_mod/(double)((uint64)1 << PHASE_FRAC);
+
 	/* Get current carrier phase */
-	meas.carrier_phase = state.carrier_phase;
+	meas.carrier_phase = (double)state.carrier_cycles + carrier_phase_mod;
 
 	/* Store rest of measurement in buffer to do the delay */
 	pmeas = &meas_buff[tic % (TICS_PER_SECOND)];
 	pmeas->chan				 = chan;
-	pmeas->code_phase 		 = state.code_phase;
-	pmeas->code_phase_mod 	 = state.code_phase_mod;
-	pmeas->carrier_phase 	 = state.carrier_phase;
-	pmeas->carrier_phase_mod = state.carrier_phase_mod;
+	pmeas->code_phase 		 = (double)state.code_periods*(double)CODE_CHIPS + code_phase_mod;
+	pmeas->code_phase_mod 	 = code_phase_mod;
+	pmeas->carrier_phase 	 = meas.carrier_phase;
+	pmeas->carrier_phase_mod = carrier_phase_mod;
 	pmeas->code_nco 		 = state.code_nco;
 	pmeas->carrier_nco 		 = state.carrier_nco;
 	pmeas->_1ms_epoch 		 = state._1ms_epoch;
 	pmeas->_20ms_epoch 		 = state._20ms_epoch;
 	pmeas->_z_count 		 = state._z_count;
 	pmeas->sv				 = state.sv;
-	pmeas->count			 = packet.count;
+	pmeas->count			 = p->count;
 	pmeas->navigate			 = state.navigate;
 
 	n_dp = meas_buff[(tic - 2*ICP_TICS + TICS_PER_SECOND) % TICS_PER_SECOND].navigate;
@@ -331,6 +329,11 @@ void Correlator::TakeMeasurement()
 	/* Write over measurement */
 	write(Corr_2_PVT_P[chan][WRITE], &meas, sizeof(Measurement_S));
 
+#if CORR_PROBES
+	/* Let the telemetry see the stage timing */
+	Probe_Publish(&probe_pub, &probe);
+#endif
+
 }
 /*----------------------------------------------------------------------------------------------*/
 
@@ -339,38 +342,29 @@ void Correlator::TakeMeasurement()
 void Correlator::UpdateState(int32 samps)
 {
 
+	int64 t;
+	int32 periods;
 
+	/* Carrier, the whole cycles carry out of the top of the fraction, the step can be negative */
+	t = (int64)state.carrier_phase_mod + (int64)samps*state.carrier_phase_inc;
+	state.carrier_cycles += t >> PHASE_FRAC;
+	state.carrier_phase_mod = (uint64)t & (((uint64)1 << PHASE_FRAC) - 1);
 
-	/* Update phase states */
-	state.code_phase 	 		+= samps*state.code_nco/SAMPLE_FREQUENCY;
-	state.carrier_phase			+= samps*state.carrier_nco/SAMPLE_FREQUENCY;
-
-	/* Do this to catch code epoch rollovers */
-	state.code_phase_mod		+= samps*state.code_nco/SAMPLE_FREQUENCY;
-	state.carrier_phase_mod		+= samps*state.carrier_nco/SAMPLE_FREQUENCY;
+	/* Code, do this to catch code epoch rollovers, a double rollover MIGHT occur? */
+	state.code_phase_mod += (uint64)samps*state.code_phase_inc;
 
-	/* A double rollover MIGHT occur? */
-	if(state.code_phase_mod >= 2.0*(double)CODE_CHIPS)
+	periods = 0;
+	while(state.code_phase_mod >= CODE_PHASE_WRAP)
 	{
-		state._1ms_epoch += 2;
-		if(state._1ms_epoch >= 20)
-		{
-			state._1ms_epoch %= 20;
-			state._20ms_epoch++;
-
-			if(state._20ms_epoch >= 300)
-			{
-				state._20ms_epoch = 0;
-				state._z_count += 6;
+		state.code_phase_mod -= CODE_PHASE_WRAP;
+		periods++;
+	}
 
-				if(state._z_count > SECONDS_IN_WEEK)
-					state._z_count = 0;
-			}
-		}
-	} /* If the C/A code rolls over then the 1ms and 20ms counters need incremented */
-	else if(state.code_phase_mod >= (double)CODE_CHIPS)
+	/* If the C/A code rolls over then the 1ms and 20ms counters need incremented */
+	if(periods)
 	{
-		state._1ms_epoch++;
+		state.code_periods += periods;
+		state._1ms_epoch += periods;
 		if(state._1ms_epoch >= 20)
 		{
 			state._1ms_epoch %= 20;
@@ -387,19 +381,26 @@ void Correlator::UpdateState(int32 samps)
 		}
 	}
 
-	/* Update partial phase states */
-	state.carrier_phase_mod  	 = fmod(state.carrier_phase_mod, 1.0);
-	state.code_phase_mod	  	 = fmod(state.code_phase_mod, CODE_CHIPS);
-
 	state.rollover -= samps;
 
-	/* Update pointers to presampled Doppler and PRN vectors */
-	state.psine    += samps;
-	state.pcode[0] += samps;
-	state.pcode[1] += samps;
-	state.pcode[2] += samps;
-	state.scount   += samps;
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+void Correlator::SetRates()
+{
+
+	/* Phase steps for the state, the NCOs run off the same steps so they stay locked to it */
+	state.carrier_phase_inc = (int64)floor(state.carrier_nco*(double)((uint64)1 << PHASE_FRAC)/(double)IF_SAMPLE_FREQUENCY);
+	state.code_phase_inc = (uint64)floor(state.code_nco*(double)((uint64)1 << PHASE_FRAC)/(double)IF_SAMPLE_FREQUENCY);
 
+	nco_phase_inc = (uint32)(state.carrier_phase_inc >> (PHASE_FRAC - 32));
+	code_nco_phase_inc = (uint32)(state.code_phase_inc >> (PHASE_FRAC - CODE_NCO_FRAC));
+
+	/* Calculate when next rollover occurs (in samples), exactly where UpdateState() will see it */
+	if(state.code_phase_inc)
+		state.rollover = (int32)((CODE_PHASE_WRAP - state.code_phase_mod + state.code_phase_inc - 1)/state.code_phase_inc);
 
 }
 /*----------------------------------------------------------------------------------------------*/
@@ -409,25 +410,35 @@ void Correlator::UpdateState(int32 samps)
 void Correlator::Accum(Correlation_S *c, CPX *data, int32 samps)
 {
 
-	CPX_ACCUM EPL[3];
+	CPX_ACCUM TAP[MAX_TAPS];
+	int32 lcv, lcv2, blk;
 
-	//SineGen(samps);
-	//state.psine = sine_rows[chan];
+	/* The carrier is generated a block at a time, so it is still in cache for the wipeoff */
+	for(lcv = 0; lcv < samps; lcv += blk)
+	{
+		blk = samps - lcv;
+		if(blk > IF_SAMPS_MS)
+			blk = IF_SAMPS_MS;
 
-	/* First do the wipeoff */
-	sse_cmulsc(data, state.psine, scratch, samps, 14);
+		SineGen(blk);
 
-	/* Now do the accumulation */
-	//sse_prn_accum(scratch, state.pcode[0], state.pcode[1], state.pcode[2], samps, &EPL[0]);
-	sse_prn_accum_new(scratch, state.pcode[0], state.pcode[1], state.pcode[2], samps, &EPL[0]);
+		/* Wipeoff and accumulation in one pass, the code delays are made around the prompt code phase,
+		 * plain E/P/L has its own kernel */
+		if(taps == 3)
+			simd_wipe_accum_code(&data[lcv], &carrier[0], code_chips, code_nco_phase, code_nco_phase_inc, code_nco_spacing, blk, 14, &TAP[0]);
+		else
+			simd_wipe_accum_taps(&data[lcv], &carrier[0], code_chips, code_nco_phase, code_nco_phase_inc, code_nco_spacing, taps, blk, 14, &TAP[0]);
 
-	c->I[0] += (int32) EPL[0].i;
-	c->I[1] += (int32) EPL[1].i;
-	c->I[2] += (int32) EPL[2].i;
+		code_nco_phase += (uint32)blk*code_nco_phase_inc;
+		while(code_nco_phase >= CODE_NCO_WRAP)
+			code_nco_phase -= CODE_NCO_WRAP;
 
-	c->Q[0] += (int32) EPL[0].q;
-	c->Q[1] += (int32) EPL[1].q;
-	c->Q[2] += (int32) EPL[2].q;
+		for(lcv2 = 0; lcv2 < taps; lcv2++)
+		{
+			c->I_tap[lcv2] += (int32) TAP[lcv2].i;
+			c->Q_tap[lcv2] += (int32) TAP[lcv2].q;
+		}
+	}
 
 }
 /*----------------------------------------------------------------------------------------------*/
@@ -436,35 +447,21 @@ void Correlator::Accum(Correlation_S *c, CPX *data, int32 samps)
 /*----------------------------------------------------------------------------------------------*/
 void Correlator::DumpAccum(Correlation_S *c)
 {
-	float f1, f2, fix, ang;
-	float code_phase;
-	int32 bin, offset, lcv, bread;
-	float sang, cang, tI, tQ;
-
-	/* First rotate correlation based on nco frequency and actually frequency used for correlation */
-	f1 = ((state.sbin - CARRIER_BINS) * CARRIER_SPACING) + IF_FREQUENCY;
-	f2 = state.carrier_nco;
-	fix = (float)PI*(f2-f1)*(float)state.scount/(float)SAMPLE_FREQUENCY;
-
-	ang = state.carrier_phase_prev*(float)TWO_PI + fix;
-	ang = -ang; cang = cos(ang); sang = sin(ang);
 
-	state.carrier_phase_prev = state.carrier_phase_mod;
+	/* The wipeoff came from the NCO at the commanded frequency and phase, nothing to rotate out */
 
-	tI = c->I[0];	tQ = c->Q[0];
-	c->I[0] = (int32)floor(cang*tI - sang*tQ);
-	c->Q[0] = (int32)floor(sang*tI + cang*tQ);
-
-	tI = c->I[1];	tQ = c->Q[1];
-	c->I[1] = (int32)floor(cang*tI - sang*tQ);
-	c->Q[1] = (int32)floor(sang*tI + cang*tQ);
-
-	tI = c->I[2];	tQ = c->Q[2];
-	c->I[2] = (int32)floor(cang*tI - sang*tQ);
-	c->Q[2] = (int32)floor(sang*tI + cang*tQ);
+	/* Early, prompt, and late come out of the bank */
+	c->I[0] = c->I_tap[(taps >> 1) - tap_dll];
+	c->I[1] = c->I_tap[taps >> 1];
+	c->I[2] = c->I_tap[(taps >> 1) + tap_dll];
+	c->Q[0] = c->Q_tap[(taps >> 1) - tap_dll];
+	c->Q[1] = c->Q_tap[taps >> 1];
+	c->Q[2] = c->Q_tap[(taps >> 1) + tap_dll];
 
 	/* Get the feedback */
+	PROBE_TIC(probing, tsc);
 	aChannel->Accum(c, &feedback);
+	PROBE_TOC(probing, &probe, PROBE_CHANNEL, tsc);
 
 	 /* Apply feedback */
 	ProcessFeedback(&feedback);
@@ -475,35 +472,12 @@ void Correlator::DumpAccum(Correlation_S *c)
 	/* Now clear out accumulation */
 	c->I[0] = c->I[1] = c->I[2] = 0;
 	c->Q[0] = c->Q[1] = c->Q[2] = 0;
+	memset(&c->I_tap[0], 0x0, MAX_TAPS*sizeof(int32));
+	memset(&c->Q_tap[0], 0x0, MAX_TAPS*sizeof(int32));
 
-	/* Calculate when next rollover occurs (in samples) */
-	state.rollover = (int32) ceil(((double)CODE_CHIPS - state.code_phase_mod)*SAMPLE_FREQUENCY/state.code_nco);
-
-	bin = (int32) floor((state.code_phase_mod + 0.5)*CODE_BINS + 0.5) + CODE_BINS/2;
-	if(bin < 0)	bin = 0; if(bin > 2*CODE_BINS) bin = 2*CODE_BINS;
-	state.pcode[0] = code_rows[bin];
-	state.cbin[0] = bin;
-
-	bin = (int32) floor((state.code_phase_mod + 0.0)*CODE_BINS + 0.5) + CODE_BINS/2;
-	if(bin < 0)	bin = 0; if(bin > 2*CODE_BINS) bin = 2*CODE_BINS;
-	state.pcode[1] = code_rows[bin];
-	state.cbin[1] = bin;
-
-	bin = (int32) floor((state.code_phase_mod - 0.5)*CODE_BINS + 0.5) + CODE_BINS/2;
-	if(bin < 0)	bin = 0; if(bin > 2*CODE_BINS) bin = 2*CODE_BINS;
-	state.pcode[2] = code_rows[bin];
-	state.cbin[2] = bin;
-
-	/* Update pointer to pre-sampled sine vector */
-	bin = (int32) floor((state.carrier_nco - IF_FREQUENCY)/CARRIER_SPACING + 0.5) + CARRIER_BINS;
-
-	/* Catch errors if Doppler goes out of range */
-	if(bin < 0)	bin = 0; if(bin > 2*CARRIER_BINS) bin = 2*CARRIER_BINS;
-	state.psine = sine_rows[bin];
-	state.sbin = bin;
-
-	/* Remember to nuke this! */
-	state.scount = 0;
+	/* Slave the NCOs to the code and carrier phase, their steps carry fewer fraction bits */
+	nco_phase = (uint32)(state.carrier_phase_mod >> (PHASE_FRAC - 32));
+	code_nco_phase = (uint32)(state.code_phase_mod >> (PHASE_FRAC - CODE_NCO_FRAC));
 
 }
 /*----------------------------------------------------------------------------------------------*/
@@ -517,7 +491,7 @@ void Correlator::ProcessFeedback(NCO_Command_S *f)
 	state.code_nco 	   	= f->code_nco;
 	state.navigate		= f->navigate;
 
-	nco_phase_inc = (uint32)floor((double)state.carrier_nco*(double)2.097152000000000e+03);
+	SetRates();
 
 	if(f->reset_1ms)
 		state._1ms_epoch = 0;
@@ -536,10 +510,8 @@ void Correlator::ProcessFeedback(NCO_Command_S *f)
 		memset(&meas, 		0x0, sizeof(Measurement_S));
 		memset(&meas_buff, 	0x0, TICS_PER_SECOND*sizeof(Measurement_S));
 
-		/* Set correlator status to inactive */
-		pthread_mutex_lock(&mInterrupt);
-		gInterrupt[chan] = 0;
-		pthread_mutex_unlock(&mInterrupt);
+		/* Back into the pool */
+		Retire_Channel(chan);
 	}
 
 }
@@ -559,58 +531,36 @@ void Correlator::Export()
 void Correlator::SineGen(int32 _samps)
 {
 
-	int32 lcv;
-	uint32 index;
-
-	for(lcv = 0; lcv < _samps; lcv++)
-	{
-		index = nco_phase >> 21;
-		sine_rows[chan][lcv].i = lookup[index].i;
-		sine_rows[chan][lcv].q = lookup[index].q;
-		nco_phase += nco_phase_inc;
-	}
+	simd_nco(&carrier[0], carrier_lut, nco_phase, nco_phase_inc, _samps);
+	nco_phase += (uint32)_samps*nco_phase_inc;
 
 }
 /*----------------------------------------------------------------------------------------------*/
 
 
 /*----------------------------------------------------------------------------------------------*/
-void Correlator::SamplePRN()
+void Correlator::PackPRN()
 {
-	MIX *row;
-	int32 lcv, lcv2, sv, k;
+	uint8 *row;
+	int32 lcv, sv;
 	int32 index;
-	float phase_step, phase;
-
-	k = 0;
 
 	for(sv = 0; sv < NUM_CODES; sv++)
 	{
 
 		code_gen(&scratch[0], sv);
 
-		for(lcv = 0; lcv < 2*CODE_BINS+1; lcv++)
-		{
-
-			row = main_code_rows[k];
-			k++;
+		row = &main_code_table[sv*CODE_NCO_BYTES];
+		memset(row, 0x0, CODE_NCO_BYTES);
 
-			phase = -0.5 + (float)lcv/(float)CODE_BINS;
-			phase_step = CODE_RATE/SAMPLE_FREQUENCY;
-
-			for(lcv2 = 0; lcv2 < 2*SAMPS_MS; lcv2++)
-			{
-				index  = (int32)floor(phase + CODE_CHIPS) % CODE_CHIPS;
-
-				if(scratch[index].i)
-					row[lcv2].i = row[lcv2].ni = 0x0001; /* Map 1 to 0x0000, and 0 to 0xffff for SIMD code */
-				else
-					row[lcv2].i = row[lcv2].ni = 0xffff;
-
-				row[lcv2].q = row[lcv2].nq = 0x0;
+		/* One bit a chip, LSB first, set for a 1 (+1) chip. The tail repeats the start of the
+		 * code, so the SIMD code NCO can read across the end of the period */
+		for(lcv = 0; lcv < 8*CODE_NCO_BYTES; lcv++)
+		{
+			index = lcv % CODE_CHIPS;
 
-				phase += phase_step;
-			}
+			if(scratch[index].i)
+				row[lcv >> 3] |= 1 << (lcv & 7);
 		}
 
 	}
@@ -623,15 +573,8 @@ void Correlator::SamplePRN()
 void Correlator::GetPRN(int32 _sv)
 {
 
-	int32 lcv;
-
 	if(_sv >= 0 && _sv <= 31)
-	{
-		for(lcv = 0; lcv < (2*CODE_BINS+1); lcv++)
-		{
-			memcpy(code_rows[lcv], main_code_rows[lcv + _sv*(2*CODE_BINS+1)], 2*SAMPS_MS*sizeof(CPX));
-		}
-	}
+		code_chips = &main_code_table[_sv*CODE_NCO_BYTES];
 
 }
 /*----------------------------------------------------------------------------------------------*/
@@ -640,13 +583,10 @@ void Correlator::GetPRN(int32 _sv)
 /*----------------------------------------------------------------------------------------------*/
 void Correlator::InitCorrelator()
 {
-	double code_phase;
 	double dt;
-	int32 bin;
-	int32 inc;
 
 	/* Update delay based on current packet count */
-	dt = (double)packet.count - (double)result.count;
+	dt = (double)packet->count - (double)result.count;
 	dt *= (double).001;
 	dt *= (double)result.doppler*(double)CODE_RATE/(double)L1;
 	result.delay += (double)CODE_CHIPS + dt;
@@ -656,50 +596,27 @@ void Correlator::InitCorrelator()
 	state.navigate				= false;
 	state.active 				= 1;
 	state.count					= 0;
-	state.scount				= 0;
-	state.code_phase 			= result.delay;
-	state.code_phase_mod 		= result.delay;
-	state.carrier_phase 		= 0;
+	state.code_periods			= 0;
+	state.carrier_cycles		= 0;
+	state.code_phase_mod 		= (uint64)floor(result.delay*(double)((uint64)1 << PHASE_FRAC));
 	state.carrier_phase_mod 	= 0;
 	state.code_nco				= CODE_RATE + result.doppler*CODE_RATE/L1;
 	state.carrier_nco			= IF_FREQUENCY + result.doppler;
 	state._1ms_epoch 			= 0;
 	state._20ms_epoch			= 0;
-	state.rollover 				= (int32) ceil(((double)CODE_CHIPS - state.code_phase)*SAMPLE_FREQUENCY/state.code_nco); /* Calculate rollover point */
+
+	/* Phase steps and rollover point */
+	SetRates();
 
 	GetPRN(state.sv);
 
-	nco_phase_inc = (uint32)floor((double)state.carrier_nco*(double)2.097152000000000e+03);
+	/* Nothing left over in the bank from the last SV */
+	memset(&corr, 0x0, sizeof(Correlation_S));
+
 	nco_phase = 0;
 
-	//inc = (int32)floor(result.delay*2048.0/1023.0);
-
-	/* Initialize the code bin pointers */
-	bin = (int32) floor((state.code_phase_mod + 0.5)*CODE_BINS + 0.5) + CODE_BINS/2;
-	if(bin < 0)	bin = 0; if(bin > 2*CODE_BINS) bin = 2*CODE_BINS;
-	state.pcode[0] = code_rows[bin];
-	state.pcode[0] += inc;
-	state.cbin[0] = bin;
-
-	bin = (int32) floor((state.code_phase_mod + 0.0)*CODE_BINS + 0.5) + CODE_BINS/2;
-	if(bin < 0)	bin = 0; if(bin > 2*CODE_BINS) bin = 2*CODE_BINS;
-	state.pcode[1] = code_rows[bin];
-	state.pcode[1] += inc;
-	state.cbin[1] = bin;
-
-	bin = (int32) floor((state.code_phase_mod - 0.5)*CODE_BINS + 0.5) + CODE_BINS/2;
-	if(bin < 0)	bin = 0; if(bin > 2*CODE_BINS) bin = 2*CODE_BINS;
-	state.pcode[2] = code_rows[bin];
-	state.pcode[2] += inc;
-	state.cbin[2] = bin;
-
-	/* Update pointer to pre-sampled sine vector */
-	bin = (int32) floor((state.carrier_nco - IF_FREQUENCY)/CARRIER_SPACING + 0.5) + CARRIER_BINS;
-
-	/* Catch errors if Doppler goes out of range */
-	if(bin < 0)	bin = 0; if(bin > 2*CARRIER_BINS) bin = 2*CARRIER_BINS;
-	state.psine = sine_rows[bin];
-	state.sbin = bin;
+	/* Start the code NCO at the acquired code phase */
+	code_nco_phase = (uint32)(state.code_phase_mod >> (PHASE_FRAC - CODE_NCO_FRAC));
 
 	//printf("Correlator initialized %d,%d,%f,%f,%f,%d,%d\n",chan,result.sv,state.carrier_nco,state.code_nco,state.code_phase,packet.count,result.count);
 
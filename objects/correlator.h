@@ -38,7 +38,8 @@ class Correlator
 		pthread_t 			thread;	 					//!< For the thread
 
 		int32				packet_count;				//!< Count 1ms packets
-		ms_packet			packet;						//!< 1ms of data
+		const ms_packet		*packet;					//!< npackets ms of data, borrowed from the FIFO
+		int32				npackets;					//!< Number of 1ms packets processed per call to Correlate()
 
 		int32 				chan;			 			//!< Which channel is this?
 		Acq_Result_S 		result; 					//!< An acquisition result has been returned!
@@ -51,36 +52,47 @@ class Correlator
 
 		/* This  is important, the following array is large and is constant, so it is
 		 * shared among all instances of this class */
-		static CPX 			*sine_table;				//!< Hold the sine wipeoff table
-		static CPX 			**sine_rows;				//!< Row pointers to above
-		static MIX  		*main_code_table;			//!< Hold the PRN lookup table for all 32 SVs  [2*CODE_BINS+1][2*SAMPS_MS];
-		static MIX 			**main_code_rows;			//!< Row pointers to above
-
-		MIX					*code_table;				//!< Local code table
-		MIX					**code_rows;				//!< Row pointers to above
-		CPX					scratch[2*SAMPS_MS];		//!< Scratch data
-		CPX					lookup[SAMPS_MS];			//!< Hold the sine lookup
-		uint32				nco_phase_inc;				//!< For dynamically generating the wipeoff
-		uint32				nco_phase;					//!< For dynamically generating the wipeoff
+		static CPX 			*carrier_lut;				//!< One cycle of the carrier, CARRIER_LUT_SIZE samples
+		static uint8  		*main_code_table;			//!< Bit packed C/A codes for all 32 SVs [NUM_CODES][CODE_NCO_BYTES], bit set for a +1 chip
+
+		uint8				*code_chips;				//!< Row of main_code_table for the current SV
+		uint32				code_nco_phase_inc;			//!< Code NCO phase step per sample, 2^CODE_NCO_FRAC is one chip
+		uint32				code_nco_phase;				//!< Prompt code NCO phase, wraps at CODE_NCO_WRAP
+		uint32				code_nco_spacing;			//!< Spacing of the code delays, in code NCO phase
+		int32				taps;						//!< Number of code delays, prompt is the middle one
+		int32				tap_dll;					//!< Early and late are this many taps either side of prompt
+		CPX					scratch[2*IF_SAMPS_MS];		//!< Scratch data
+		CPX					carrier[IF_SAMPS_MS];		//!< Carrier wipeoff for the current block
+		uint32				nco_phase_inc;				//!< Carrier NCO phase step per sample, 2^32 is one cycle
+		uint32				nco_phase;					//!< Carrier NCO phase, 2^32 is one cycle
+		Probe_S				probe;						//!< Stage timing, only the thread running this correlator writes it
+		Probe_S				probe_pub;					//!< Copy of the stage timing published for the telemetry
+		uint32				probe_tick;					//!< Code periods dumped, picks which ones get timed
+		int32				probing;					//!< Time the current code period
 
 	public:
 
 		Correlator(int32 _chan);
 		~Correlator();
 		void Inport();												//!< Get IF data, NCO commands, and acq results
+		void SetPacket(const ms_packet *_packet);					//!< Correlate this span next, and check for acq results
 		void Correlate();											//!< Run the actual correlation
+		void CorrelateSpan(CPX *data, int32 samps);				//!< Correlate a contiguous span of samples, dumping at every code rollover
 		void Export();												//!< Dump results to channels and Navigation
 		void Start();												//!< Start the thread
 		void Stop();												//!< Stop the thread
-		void TakeMeasurement();									//!< Take some measurements
-		void SamplePRN();											//!< Sample all 32 PRN codes and put it into the code table
-		void GetPRN(int32 _sv);									//!< Get row pointers to specific PRN
+		void TakeMeasurement(const ms_packet *p);					//!< Take some measurements
+		void PackPRN();											//!< Bit pack all 32 PRN codes into the code table
+		void GetPRN(int32 _sv);									//!< Point code_chips at a specific PRN
 		void InitCorrelator();									//!< Initialize a correlator/channel with an acquisition result
 		void DumpAccum(Correlation_S *c);							//!< Dump accumulation to channel for processing
 		void UpdateState(int32 samps);							//!< Update correlator state
 		void ProcessFeedback(NCO_Command_S *f);
+		void SetRates();											//!< Turn the NCO frequencies into phase steps and find the next rollover
 		void Accum(Correlation_S *c, CPX *data, int32 samps);		//!< Do the actual accumulation
-		void SineGen(int32 samps);									//!< Dynamic wipeoff generation
+		void SineGen(int32 samps);									//!< Generate the next samps of carrier wipeoff from the NCO
+		Probe_S *getProbe(){return(&probe);}						//!< Running stage timing, only for the thread running this correlator
+		void getProbes(Probe_S *_p){Probe_Copy(_p, &probe_pub);}	//!< Copy of the published stage timing, from any thread
 };
 
 #endif /* Correlator_H */
@@ -43,26 +43,7 @@ void *Ephemeris_Thread(void *_arg)
 /*----------------------------------------------------------------------------------------------*/
 void Ephemeris::Start()
 {
-	pthread_attr_t tattr;
-	pthread_t tid;
-	int32 ret;
-	sched_param param;
-
-	/* Unitialized with default attributes */
-	ret = pthread_attr_init (&tattr);
-
-	/*Ssafe to get existing scheduling param */
-	ret = pthread_attr_getschedparam (&tattr, &param);
-
-	/* Set the priority; others are unchanged */
-	param.sched_priority = EPHEM_PRIORITY;
-
-	/* Setting the new scheduling param */
-	ret = pthread_attr_setschedparam(&tattr, &param);
-	ret = pthread_attr_setschedpolicy(&tattr, SCHED_FIFO);
-
-	/* With new priority specified */
-	pthread_create(&thread, NULL, Ephemeris_Thread, NULL);
+	Thread_Create(&thread, THREAD_EPHEM, 0, Ephemeris_Thread, NULL);
 
 	if(gopt.verbose)
 		printf("Ephemeris thread started\n");
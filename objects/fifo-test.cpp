@@ -0,0 +1,824 @@
+/*! \file fifo-test.cpp
+	Check the FIFO ring, then measure how quickly FIFO consumers wake up on a new packet, and
+	what they burn when idle
+*/
+/************************************************************************************************
+Copyright 2008 Gregory W Heckler
+
+This file is part of the GPS Software Defined Radio (GPS-SDR)
+
+The GPS-SDR is free software; you can redistribute it and/or modify it under the terms of the
+GNU General Public License as published by the Free Software Foundation; either version 2 of the
+License, or (at your option) any later version.
+
+The GPS-SDR is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with GPS-SDR; if not,
+write to the:
+
+Free Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+************************************************************************************************/
+
+#define GLOBALS_HERE
+
+#include "includes.h"
+
+typedef struct _FIFO_test_options
+{
+	int32 consumers;		//!< Number of consumer threads (correlators)
+	int32 poll;				//!< If non zero poll with usleep(poll) instead of blocking in FIFO::Wait()
+	int32 batch;			//!< Packets borrowed at a time
+	int32 seconds;			//!< Seconds to stream, then seconds to sit idle
+	int32 depth;			//!< FIFO depth in ms
+	int32 workers;			//!< If non zero group the consumers channel major onto this many threads
+	int32 load;				//!< Run a correlator's wipeoff and E/P/L accumulation on every ms
+	int32 taps;				//!< Number of code delays the correlator work runs
+} FIFO_test_options;
+
+/*! One consumer thread, serves a block of consecutive channels through the first one's cursor */
+typedef struct _FIFO_test_block
+{
+	int32 first;
+	int32 nchan;
+} FIFO_test_block;
+
+FIFO_test_options opt;
+double *stamp;				//!< Time each packet was written into the pipe
+double latency[MAX_CHANNELS];		//!< Summed wakeup latency per consumer
+double latency_max[MAX_CHANNELS];	//!< Worst wakeup latency per consumer
+int32 packets[MAX_CHANNELS];		//!< Packets seen per consumer
+int32 next_count[MAX_CHANNELS];		//!< Count the next packet should carry, per consumer
+int32 order_errs[MAX_CHANNELS];		//!< Packets seen out of order, twice or not at all, per consumer
+int32 wakeups[MAX_CHANNELS];		//!< Spans seen per consumer
+int32 streaming;			//!< High while the writer is running
+CPX *sine[MAX_CHANNELS];		//!< Per channel wipeoff, like the correlator carrier block
+CPX *lut;				//!< One cycle of the carrier, like the correlator carrier lookup
+uint32 nco_phase[MAX_CHANNELS];		//!< Per channel carrier NCO phase
+uint32 nco_phase_inc[MAX_CHANNELS];	//!< Per channel carrier NCO phase step
+uint8 *chips;				//!< One bit packed code period, like the correlator code table
+uint32 code_phase[MAX_CHANNELS];	//!< Per channel code NCO phase
+uint32 code_phase_inc[MAX_CHANNELS];	//!< Per channel code NCO phase step
+CPX_ACCUM accum[MAX_CHANNELS][MAX_TAPS];	//!< Keep the compiler from throwing the work away
+
+/*----------------------------------------------------------------------------------------------*/
+double now()
+{
+	timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return((double)t.tv_sec + (double)t.tv_nsec*1e-9);
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+double cpu()
+{
+	timespec t;
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &t);
+	return((double)t.tv_sec + (double)t.tv_nsec*1e-9);
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+void usage(char *_str)
+{
+
+    fprintf(stderr, "usage: [-c] [-s] [-b] [-t] [-f] [-w] [-x] [-k]\n");
+    fprintf(stderr, "[-c] <consumers> number of consumer threads (1:%d)\n",MAX_CHANNELS);
+    fprintf(stderr, "[-s] <usec> poll the FIFO with usleep, like the old correlators\n");
+    fprintf(stderr, "[-b] <packets> packets to borrow at a time (1:%d)\n",FIFO_MAX_BATCH);
+    fprintf(stderr, "[-t] <seconds> seconds to stream, followed by the same number of seconds idle\n");
+    fprintf(stderr, "[-f] <ms> FIFO depth (%d:%d)\n",FIFO_MIN_DEPTH,FIFO_MAX_DEPTH);
+    fprintf(stderr, "[-w] <threads> run the consumers channel major on this many threads\n");
+    fprintf(stderr, "[-x] do the correlator work (wipeoff and E/P/L) for every consumer\n");
+    fprintf(stderr, "[-k] <taps> run a bank of this many code delays instead of E/P/L (3:%d, odd)\n",MAX_TAPS);
+    fflush(stderr);
+
+    exit(1);
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*! Fill a packet's payload with a pattern that says which packet and sample it is */
+void Stamp(ms_packet *_p, int32 _seq)
+{
+	int32 lcv;
+
+	for(lcv = 0; lcv < IF_SAMPS_MS; lcv++)
+	{
+		_p->data[lcv].i = (int16)_seq;
+		_p->data[lcv].q = (int16)lcv;
+	}
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*! 0 if the payload is the one Stamp() wrote for _seq, only the ends and middle unless _full */
+int32 Check(const ms_packet *_p, int32 _seq, int32 _full)
+{
+	int32 lcv, step;
+
+	step = _full ? 1 : IF_SAMPS_MS/2 - 1;
+
+	for(lcv = 0; lcv < IF_SAMPS_MS; lcv += step)
+		if((_p->data[lcv].i != (int16)_seq) || (_p->data[lcv].q != (int16)lcv))
+			return(1);
+
+	return(0);
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*! Stand in for the FIFO thread, publish one stamped packet, 0 if the FIFO was full */
+int32 Push(FIFO *_f, int32 _seq)
+{
+	ms_packet *p;
+
+	p = _f->Reserve();
+	if(p == NULL)
+		return(0);
+
+	Stamp(p, _seq);
+	_f->Enqueue();
+
+	return(1);
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*! A FIFO for _channels consumers at the shortest depth, not started, the test feeds it */
+FIFO *Make(int32 _channels)
+{
+	gopt.channels = _channels;
+	gopt.fifo_depth = FIFO_MIN_DEPTH;
+	return(new FIFO);
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+int32 Report(const char *_what, int32 _err)
+{
+	if(_err)
+		printf("FIFO %-40s FAILED: %d\n",_what,_err);
+	else
+		printf("FIFO %-40s PASSED\n",_what);
+
+	return(_err);
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*! Consumers borrowing 1, 2 and 3 packets at a time each see every packet once, in order, many
+ * times round the ring */
+int32 check_order()
+{
+	FIFO *f;
+	const ms_packet *p;
+	int32 lcv, chan, total, err;
+	int32 next[3];
+
+	f = Make(3);
+	total = 10*FIFO_MIN_DEPTH + 1;
+	err = 0;
+	memset(next, 0x0, sizeof(next));
+
+	for(lcv = 0; lcv < total; lcv++)
+	{
+		if(!Push(f, lcv))
+			err++;
+
+		for(chan = 0; chan < 3; chan++)
+			while((next[chan] + chan < lcv + 1) && ((p = f->Borrow(chan, chan+1)) != NULL))
+			{
+				for(int32 k = 0; k <= chan; k++)
+					err += Check(&p[k], next[chan]++, 1);
+				f->Release(chan, chan+1);
+			}
+	}
+
+	for(chan = 0; chan < 3; chan++)
+		if(next[chan] != total - (total % (chan+1)))
+			err++;
+
+	delete f;
+
+	return(Report("every packet once and in order", err));
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*! Borrow only hands out a batch once all of it has arrived */
+int32 check_borrow()
+{
+	FIFO *f;
+	int32 lcv, err;
+
+	f = Make(1);
+	err = 0;
+
+	for(lcv = 0; lcv < FIFO_MAX_BATCH; lcv++)
+	{
+		if(f->Borrow(0, lcv+1) != NULL)
+			err++;
+
+		Push(f, lcv);
+
+		if(f->Borrow(0, lcv+1) == NULL)
+			err++;
+		if(f->Borrow(0, lcv+2) != NULL)
+			err++;
+	}
+
+	delete f;
+
+	return(Report("Borrow NULL until the batch is there", err));
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*! A consumer that stops releasing holds the tail, nothing it has not read is overwritten, and
+ * the FIFO fills up rather than pass it. Unsubscribing lets the tail go. */
+int32 check_tail()
+{
+	FIFO *f;
+	const ms_packet *p;
+	int32 lcv, seq, err, err2;
+
+	f = Make(2);
+	err = err2 = 0;
+
+	/* Consumer 0 stalls on the first packet, consumer 1 keeps up */
+	seq = 0;
+	while(Push(f, seq) && (seq < 2*FIFO_MIN_DEPTH))
+	{
+		seq++;
+		if(f->Borrow(1, 1) != NULL)
+			f->Release(1, 1);
+	}
+
+	/* One slot is always kept empty */
+	if(seq != FIFO_MIN_DEPTH-1)
+		err++;
+
+	for(lcv = 0; lcv < seq; lcv++)
+	{
+		p = f->Borrow(0, 1);
+		if((p == NULL) || Check(p, lcv, 1))
+			err++;
+		f->Release(0, 1);
+	}
+
+	/* Full again behind the stalled consumer, then let it go */
+	lcv = seq + 2*FIFO_MIN_DEPTH;
+	while(Push(f, seq) && (seq < lcv))
+	{
+		seq++;
+		if(f->Borrow(1, 1) != NULL)
+			f->Release(1, 1);
+	}
+
+	f->Unsubscribe(0);
+	if(!Push(f, seq++))
+		err2++;
+
+	/* Subscribing again starts at the head */
+	f->Subscribe(0);
+	if(f->Borrow(0, 1) != NULL)
+		err2++;
+
+	delete f;
+
+	return(Report("tail held by the slowest cursor", err) + Report("Unsubscribe releases the tail", err2));
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*! A batch that runs off the end of the ring comes back from the mirrored slots, contiguous and
+ * intact */
+int32 check_wrap()
+{
+	FIFO *f;
+	const ms_packet *p;
+	int32 lcv, first, seq, err;
+
+	f = Make(1);
+	err = 0;
+
+	/* Walk the cursor to half a batch short of the end */
+	for(seq = 0; seq < FIFO_MIN_DEPTH - FIFO_MAX_BATCH/2; seq++)
+	{
+		Push(f, seq);
+		f->Borrow(0, 1);
+		f->Release(0, 1);
+	}
+
+	first = seq;
+	for(lcv = 0; lcv < FIFO_MAX_BATCH; lcv++)
+		Push(f, seq++);
+
+	p = f->Borrow(0, FIFO_MAX_BATCH);
+	if(p == NULL)
+		err++;
+	else
+		for(lcv = 0; lcv < FIFO_MAX_BATCH; lcv++)
+		{
+			if(p[lcv].data != p[0].data + lcv*IF_SAMPS_MS)
+				err++;
+			err += Check(&p[lcv], first + lcv, 1);
+		}
+
+	delete f;
+
+	return(Report("batch across the wrap", err));
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+typedef struct _FIFO_test_wait
+{
+	FIFO *f;
+	const ms_packet *p;
+	int32 done;
+} FIFO_test_wait;
+
+void *Wait_Thread(void *_arg)
+{
+	FIFO_test_wait *w = (FIFO_test_wait *)_arg;
+
+	w->p = w->f->Wait(0, 1);
+	__atomic_store_n(&w->done, 1, __ATOMIC_RELEASE);
+
+	pthread_exit(0);
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*! A consumer blocked on an empty FIFO comes back, with nothing, once grun drops */
+int32 check_wait()
+{
+	FIFO_test_wait w;
+	pthread_t thread;
+	double t0;
+	int32 err;
+
+	w.f = Make(1);
+	w.p = NULL;
+	w.done = 0;
+	err = 0;
+
+	pthread_create(&thread, NULL, Wait_Thread, &w);
+	usleep(20000);
+	if(__atomic_load_n(&w.done, __ATOMIC_ACQUIRE))
+		err++;
+
+	grun = 0;
+	t0 = now();
+	while(!__atomic_load_n(&w.done, __ATOMIC_ACQUIRE) && (now() - t0 < 1.0))
+		usleep(1000);
+	grun = 1;
+
+	/* Stuck for good, leave it be rather than free the FIFO under it */
+	if(!__atomic_load_n(&w.done, __ATOMIC_ACQUIRE))
+		return(Report("Wait returns once grun drops", 1));
+
+	pthread_join(thread, NULL);
+	if(w.p != NULL)
+		err++;
+
+	delete w.f;
+
+	return(Report("Wait returns once grun drops", err));
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+typedef struct _FIFO_test_stress
+{
+	FIFO *f;
+	int32 chan;
+	int32 total;
+	int32 err;
+	double *pushed;		//!< When each packet went in
+	double longest;		//!< Longest a packet waited for this consumer to wake up
+} FIFO_test_stress;
+
+void *Stress_Thread(void *_arg)
+{
+	FIFO_test_stress *s = (FIFO_test_stress *)_arg;
+	const ms_packet *p;
+	int32 lcv, batch, next;
+	double delta;
+
+	batch = (s->chan & 1) + 1;
+	next = 0;
+
+	while(next < s->total)
+	{
+		p = s->f->Wait(s->chan, batch);
+
+		if(p == NULL)
+		{
+			s->err++;
+			break;
+		}
+
+		/* From when the batch was all there, not from when Wait() was called */
+		delta = now() - s->pushed[next + batch - 1];
+		if(delta > s->longest)
+			s->longest = delta;
+
+		for(lcv = 0; lcv < batch; lcv++)
+			s->err += Check(&p[lcv], next++, 0);
+
+		s->f->Release(s->chan, batch);
+	}
+
+	pthread_exit(0);
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*! Lots of consumers on batches of 1 and 2, fed in irregular bursts so they keep dropping into
+ * the futex just as packets arrive. A wakeup lost between the want and Wake() would leave a
+ * consumer asleep for the whole 100 ms timeout with its packets sitting there. */
+int32 check_stress()
+{
+	FIFO_test_stress s[32];
+	pthread_t thread[32];
+	FIFO *f;
+	int32 lcv, seq, total, err;
+	double longest, *pushed;
+
+	f = Make(32);
+	total = 20000;
+	pushed = new double[total];
+
+	for(lcv = 0; lcv < 32; lcv++)
+	{
+		s[lcv].f = f;
+		s[lcv].chan = lcv;
+		s[lcv].total = total;
+		s[lcv].err = 0;
+		s[lcv].pushed = pushed;
+		s[lcv].longest = 0;
+		pthread_create(&thread[lcv], NULL, Stress_Thread, &s[lcv]);
+	}
+
+	for(seq = 0; seq < total; seq++)
+	{
+		pushed[seq] = now();
+		while(!Push(f, seq))
+			sched_yield();
+
+		if((rand() & 7) == 0)
+			usleep(rand() % 100);
+
+		/* Now and then stop for longer than the timeout, so a wakeup missed on the last
+		 * packet of a burst is not covered up by the next one */
+		if((seq % 2500) == 2499)
+			usleep(120000);
+	}
+
+	err = 0;
+	longest = 0;
+	for(lcv = 0; lcv < 32; lcv++)
+	{
+		pthread_join(thread[lcv], NULL);
+		err += s[lcv].err;
+		if(s[lcv].longest > longest)
+			longest = s[lcv].longest;
+	}
+
+	/* Nobody should have needed the timeout */
+	if(longest >= 0.09)
+		err++;
+
+	delete f;
+	delete [] pushed;
+
+	printf("FIFO stress worst wakeup \t\t\t%.1f ms\n",longest*1e3);
+
+	return(Report("no lost wakeups under stress", err));
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*! Write 1 ms of IF data into the shared ring every ms, like gps-usrp */
+void *Writer_Thread(void *_arg)
+{
+	Shm_Ring ring;
+	CPX *buff;
+	int32 lcv, total;
+	timespec next;
+
+	buff = new CPX[IF_SAMPS_MS];
+	for(lcv = 0; lcv < IF_SAMPS_MS; lcv++)
+	{
+		buff[lcv].i = (int16)((rand() % 32) - 16);
+		buff[lcv].q = (int16)((rand() % 32) - 16);
+	}
+
+	ring.Create(IF_SAMPS_MS*sizeof(CPX), SHM_RING_SLOTS);
+
+	/* Give the FIFO time to attach, so the packet counts on both sides line up */
+	usleep(500000);
+
+	total = opt.seconds*1000;
+	clock_gettime(CLOCK_MONOTONIC, &next);
+
+	for(lcv = 0; lcv < total; lcv++)
+	{
+		next.tv_nsec += 1000000;
+		if(next.tv_nsec >= 1000000000)
+		{
+			next.tv_nsec -= 1000000000;
+			next.tv_sec++;
+		}
+		clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+
+		stamp[lcv] = now();
+		ring.Write(buff, IF_SAMPS_MS*sizeof(CPX), 0);
+	}
+
+	streaming = 0;
+
+	delete [] buff;
+
+	/* Leave the ring up so the FIFO does not go looking for a new one */
+	while(grun)
+		usleep(100000);
+
+	pthread_exit(0);
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*! What Correlator::Accum() does to each ms, on every packet of the span */
+void Work(int32 _chan, const ms_packet *_p)
+{
+	int32 lcv;
+
+	for(lcv = 0; lcv < opt.batch; lcv++)
+	{
+		simd_nco(sine[_chan], lut, nco_phase[_chan], nco_phase_inc[_chan], IF_SAMPS_MS);
+		nco_phase[_chan] += (uint32)IF_SAMPS_MS*nco_phase_inc[_chan];
+
+		if(opt.taps == 3)
+			simd_wipe_accum_code(_p[lcv].data, sine[_chan], chips, code_phase[_chan], code_phase_inc[_chan], 1 << (CODE_NCO_FRAC-1), IF_SAMPS_MS, 14, &accum[_chan][0]);
+		else
+			simd_wipe_accum_taps(_p[lcv].data, sine[_chan], chips, code_phase[_chan], code_phase_inc[_chan], (MAX_TAP_SPAN << CODE_NCO_FRAC)/(MAX_TAPS-1), opt.taps, IF_SAMPS_MS, 14, &accum[_chan][0]);
+		code_phase[_chan] += (uint32)IF_SAMPS_MS*code_phase_inc[_chan];
+		while(code_phase[_chan] >= CODE_NCO_WRAP)
+			code_phase[_chan] -= CODE_NCO_WRAP;
+	}
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*! Stand in for a correlator (or a channel major worker), measure when the packet arrives */
+void *Consumer_Thread(void *_arg)
+{
+	FIFO_test_block *block = (FIFO_test_block *)_arg;
+	int32 chan = block->first;
+	int32 lcv;
+	const ms_packet *p;
+	double delta;
+
+	while(grun)
+	{
+		if(opt.poll)
+		{
+			p = pFIFO->Borrow(chan, opt.batch);
+			while((p == NULL) && grun)
+			{
+				usleep(opt.poll);
+				p = pFIFO->Borrow(chan, opt.batch);
+			}
+		}
+		else
+			p = pFIFO->Wait(chan, opt.batch);
+
+		if(p == NULL)
+			break;
+
+		/* Every packet, once and in order, the count comes from the FIFO thread */
+		for(lcv = 0; lcv < opt.batch; lcv++)
+		{
+			if(p[lcv].count != next_count[chan])
+				order_errs[chan]++;
+			next_count[chan] = p[lcv].count + 1;
+		}
+
+		/* Latency is measured from the last packet of the span */
+		delta = now() - stamp[p[opt.batch-1].count];
+		latency[chan] += delta;
+		if(delta > latency_max[chan])
+			latency_max[chan] = delta;
+		wakeups[chan]++;
+
+		/* Every channel of the block runs over the span while it is in cache */
+		for(lcv = block->first; lcv < block->first + block->nchan; lcv++)
+		{
+			if(opt.load)
+				Work(lcv, p);
+			packets[lcv] += opt.batch;
+		}
+
+		pFIFO->Release(chan, opt.batch);
+	}
+
+	pthread_exit(0);
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+int main(int32 argc, char* argv[])
+{
+	pthread_t writer, consumer[MAX_CHANNELS];
+	FIFO_test_block blocks[MAX_CHANNELS];
+	int32 lcv, total, spans, nthreads, per, errs;
+	double t0, c0, t1, c1, ts, cs, mean, worst;
+
+	opt.consumers = DEFAULT_CHANNELS;
+	opt.poll = 0;
+	opt.batch = 1;
+	opt.seconds = 5;
+	opt.depth = FIFO_DEPTH;
+	opt.workers = 0;
+	opt.load = 0;
+	opt.taps = 3;
+
+	for(lcv = 1; lcv < argc; lcv++)
+	{
+		if((strcmp(argv[lcv],"-c") == 0) && (lcv+1 < argc))
+			opt.consumers = atoi(argv[++lcv]);
+		else if((strcmp(argv[lcv],"-s") == 0) && (lcv+1 < argc))
+			opt.poll = atoi(argv[++lcv]);
+		else if((strcmp(argv[lcv],"-b") == 0) && (lcv+1 < argc))
+			opt.batch = atoi(argv[++lcv]);
+		else if((strcmp(argv[lcv],"-t") == 0) && (lcv+1 < argc))
+			opt.seconds = atoi(argv[++lcv]);
+		else if((strcmp(argv[lcv],"-f") == 0) && (lcv+1 < argc))
+			opt.depth = atoi(argv[++lcv]);
+		else if((strcmp(argv[lcv],"-w") == 0) && (lcv+1 < argc))
+			opt.workers = atoi(argv[++lcv]);
+		else if(strcmp(argv[lcv],"-x") == 0)
+			opt.load = 1;
+		else if((strcmp(argv[lcv],"-k") == 0) && (lcv+1 < argc))
+			opt.taps = atoi(argv[++lcv]);
+		else
+			usage(argv[0]);
+	}
+
+	if((opt.consumers < 1) || (opt.consumers > MAX_CHANNELS) || (opt.seconds < 1) || (opt.batch < 1) || (opt.batch > FIFO_MAX_BATCH) || (opt.depth < FIFO_MIN_DEPTH) || (opt.depth > FIFO_MAX_DEPTH) || (opt.workers < 0) || (opt.workers > opt.consumers) || (opt.taps < 3) || (opt.taps > MAX_TAPS) || ((opt.taps & 1) == 0))
+		usage(argv[0]);
+
+	/* Thread per consumer, or blocks of consecutive channels per worker */
+	per = opt.workers ? (opt.consumers + opt.workers - 1) / opt.workers : 1;
+	nthreads = (opt.consumers + per - 1) / per;
+
+	printf("FIFO_Test\n");
+	if(opt.poll)
+		printf("%d consumers on %d threads polling every %d us\n",opt.consumers,nthreads,opt.poll);
+	else
+		printf("%d consumers on %d threads blocking in FIFO::Wait()\n",opt.consumers,nthreads);
+
+	memset(&gopt, 0x0, sizeof(Options_S));
+	gopt.realtime = 0;
+	grun = 1;
+	streaming = 1;
+	Init_SIMD();
+
+	/* The FIFO sends its measurement tic down these, nobody is listening */
+	FIFO_2_Telem_P[WRITE] = open("/dev/null", O_WRONLY);
+	FIFO_2_PVT_P[WRITE] = open("/dev/null", O_WRONLY);
+
+	/* The ring on its own, fed straight from here */
+	errs = 0;
+	errs += check_order();
+	errs += check_borrow();
+	errs += check_tail();
+	errs += check_wrap();
+	errs += check_wait();
+	errs += check_stress();
+
+	gopt.fifo_depth = opt.depth;
+	gopt.channels = opt.consumers;
+	gopt.verbose = 1;
+
+	stamp = new double[opt.seconds*1000];
+
+	pFIFO = new FIFO;
+
+	lut = new CPX[CARRIER_LUT_SIZE];
+	sine_gen(lut, -1.0, CARRIER_LUT_SIZE, CARRIER_LUT_SIZE, 0.0);
+
+	chips = new uint8[CODE_NCO_BYTES];
+	for(lcv = 0; lcv < CODE_NCO_BYTES; lcv++)
+		chips[lcv] = (uint8)rand();
+
+	/* Every channel gets its own tables and NCO, like the correlators */
+	for(lcv = 0; lcv < opt.consumers; lcv++)
+	{
+		sine[lcv] = new CPX[IF_SAMPS_MS];
+		nco_phase[lcv] = 0;
+		nco_phase_inc[lcv] = (uint32)floor((IF_FREQUENCY + 20.0*lcv)*(double)4294967296.0/(double)IF_SAMPLE_FREQUENCY);
+		code_phase[lcv] = 0;
+		code_phase_inc[lcv] = (uint32)floor(CODE_RATE*(double)(1 << CODE_NCO_FRAC)/(double)IF_SAMPLE_FREQUENCY);
+	}
+
+	/* Only the first channel of each block reads from the FIFO */
+	for(lcv = 0; lcv < opt.consumers; lcv++)
+		if(lcv % per)
+			pFIFO->Unsubscribe(lcv);
+
+	for(lcv = 0; lcv < nthreads; lcv++)
+	{
+		blocks[lcv].first = lcv*per;
+		blocks[lcv].nchan = (lcv*per + per <= opt.consumers) ? per : opt.consumers - lcv*per;
+		pthread_create(&consumer[lcv], NULL, Consumer_Thread, &blocks[lcv]);
+	}
+
+	pthread_create(&writer, NULL, Writer_Thread, NULL);
+	pFIFO->Start();
+
+	/* Streaming */
+	ts = now(); cs = cpu();
+	while(streaming)
+		usleep(10000);
+	ts = now() - ts; cs = cpu() - cs;
+	usleep(100000);
+
+	/* Now idle, nothing is being written */
+	t0 = now(); c0 = cpu();
+	sleep(opt.seconds);
+	t1 = now(); c1 = cpu();
+
+	mean = worst = 0; total = spans = 0;
+	for(lcv = 0; lcv < opt.consumers; lcv++)
+	{
+		mean += latency[lcv];
+		total += packets[lcv];
+		spans += wakeups[lcv];
+		if(latency_max[lcv] > worst)
+			worst = latency_max[lcv];
+	}
+
+	if(spans)
+		mean /= (double)spans;
+
+	printf("Packets delivered \t\t%d of %d\n",total,opt.consumers*opt.seconds*1000);
+	printf("Wakeups \t\t\t%d\n",spans);
+	printf("Wakeup latency mean \t\t%.1f us\n",mean*1e6);
+	printf("Wakeup latency max \t\t%.1f us\n",worst*1e6);
+	printf("Idle CPU \t\t\t%.2f %%\n",100.0*(c1 - c0)/(t1 - t0));
+	printf("Streaming CPU \t\t\t%.2f %%\n",100.0*cs/ts);
+	if(opt.load)
+		printf("Channels per core \t\t%.1f\n",(double)opt.consumers*ts/cs);
+
+	/* Each consumer gets every whole batch the writer sent */
+	per = 0;
+	for(lcv = 0; lcv < opt.consumers; lcv++)
+		per += order_errs[lcv] + (packets[lcv] != (opt.seconds*1000/opt.batch)*opt.batch);
+	errs += Report("streamed packets once and in order", per);
+
+	grun = 0;
+	for(lcv = 0; lcv < nthreads; lcv++)
+		pthread_join(consumer[lcv], NULL);
+
+	pFIFO->Stop();
+	pthread_join(writer, NULL);
+
+	delete pFIFO;
+	delete [] stamp;
+	delete [] lut;
+	delete [] chips;
+
+	for(lcv = 0; lcv < opt.consumers; lcv++)
+	{
+		delete [] sine[lcv];
+	}
+
+	return(errs ? -1 : 0);
+}
+/*----------------------------------------------------------------------------------------------*/
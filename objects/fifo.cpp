@@ -44,24 +44,7 @@ void *FIFO_Thread(void *_arg)
 /*----------------------------------------------------------------------------------------------*/
 void FIFO::Start()
 {
-
-	pthread_attr_t tattr;
-	pthread_t tid;
-	int32 ret;
-	sched_param param;
-
-	/* Unitialized with default attributes */
-	ret = pthread_attr_init(&tattr);
-
-	/*Ssafe to get existing scheduling param */
-	ret = pthread_attr_getschedparam(&tattr, &param);
-
-	/* Set the priority; others are unchanged */
-	param.sched_priority = FIFO_PRIORITY;
-	ret = pthread_attr_setschedparam (&tattr, &param);
-	ret = pthread_attr_setschedpolicy(&tattr, SCHED_FIFO);
-
-	pthread_create(&thread, NULL, FIFO_Thread, NULL);
+	Thread_Create(&thread, THREAD_FIFO, 0, FIFO_Thread, NULL);
 
 	if(gopt.verbose)
 		printf("FIFO thread started\n");
@@ -94,18 +77,60 @@ FIFO::FIFO()
 {
 	int32 lcv;
 
-	/* Create the buffer */
-	buff = new ms_packet[FIFO_DEPTH];
+	depth = gopt.fifo_depth;
+	if((depth < FIFO_MIN_DEPTH) || (depth > FIFO_MAX_DEPTH))
+		depth = FIFO_DEPTH;
 
-	memset(buff, 0x0, sizeof(ms_packet)*FIFO_DEPTH);
+	/* Create the buffer, the first FIFO_MAX_BATCH slots are repeated at the end so that any
+	 * FIFO_MAX_BATCH consecutive slots are contiguous in memory */
+	buff = new ms_packet[depth+FIFO_MAX_BATCH];
+	memset(buff, 0x0, sizeof(ms_packet)*(depth+FIFO_MAX_BATCH));
+
+	/* The payload is a whole number of 2 MB pages, every slot starts on a page boundary */
+	samples_bytes = sizeof(CPX)*(depth+FIFO_MAX_BATCH)*IF_SAMPS_MS;
+	samples_bytes = (samples_bytes + FIFO_HUGE_PAGE - 1) & ~(FIFO_HUGE_PAGE - 1);
+
+	/* Take real hugepages if some are reserved (/proc/sys/vm/nr_hugepages), fault them all in now */
+	samples = (CPX *)MAP_FAILED;
+#ifdef MAP_HUGETLB
+	samples = (CPX *)mmap(NULL, samples_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_POPULATE, -1, 0);
+#endif
+
+	if(samples != (CPX *)MAP_FAILED)
+	{
+		huge = 1;
+	}
+	else
+	{
+		/* Otherwise hugepage aligned normal memory, and hope for transparent hugepages */
+		huge = 0;
+		if(posix_memalign((void **)&samples, FIFO_HUGE_PAGE, samples_bytes) != 0)
+		{
+			printf("Could not allocate FIFO!\n");
+			exit(1);
+		}
+#ifdef MADV_HUGEPAGE
+		madvise(samples, samples_bytes, MADV_HUGEPAGE);
+#endif
+		memset(samples, 0x0, samples_bytes);
+	}
 
-	head = &buff[0];
-	tail = &buff[0];
+	for(lcv = 0; lcv < depth+FIFO_MAX_BATCH; lcv++)
+		buff[lcv].data = &samples[lcv*IF_SAMPS_MS];
 
-	for(lcv = 0; lcv < FIFO_DEPTH-1; lcv++)
-		buff[lcv].next = &buff[lcv+1];
+	head = 0;
+	tail = 0;
 
-	buff[FIFO_DEPTH-1].next = &buff[0];
+	/* The correlators always consume, the acquisition only subscribes while it collects data */
+	consumers = gopt.channels + 1;
+	if(posix_memalign((void **)&cursor, 64, sizeof(FIFO_Cursor_S)*consumers) != 0)
+	{
+		printf("Could not allocate FIFO cursors!\n");
+		exit(1);
+	}
+	memset(&cursor[0], 0x0, sizeof(FIFO_Cursor_S)*consumers);
+	for(lcv = 0; lcv < gopt.channels; lcv++)
+		cursor[lcv].active = 1;
 
 	/* Buffer for the raw IF data */
 	if_buff = new CPX[IF_SAMPS_MS];
@@ -115,21 +140,16 @@ FIFO::FIFO()
 	 * receiving continguous data packets */
 	//fcntl(npipe, F_SETFL, O_NONBLOCK);
 
-	tic = overflw = count = 0;
+	tic = overflw = count = lost = shorts = 0;
 
-	agc_scale = 1 << AGC_BITS;
+	memset(&stats, 0x0, sizeof(FIFO_Stats_S));
+	memset(&stats_pub, 0x0, sizeof(FIFO_Stats_S));
+	stats.channels = stats_pub.channels = gopt.channels;
 
-	pthread_mutex_init(&mutex, NULL);
-	pthread_mutex_unlock(&mutex);
-
-	for(lcv = 0; lcv < MAX_CHANNELS; lcv++)
-	{
-		pthread_mutex_init(&chan_mutex[lcv], NULL);
-		pthread_mutex_unlock(&chan_mutex[lcv]);
-	}
+	agc_scale = 1 << AGC_BITS;
 
 	if(gopt.verbose)
-		printf("Creating FIFO\n");
+		printf("Creating FIFO, %d ms on %s pages\n",depth,huge ? "2 MB" : "normal");
 
 }
 /*----------------------------------------------------------------------------------------------*/
@@ -138,19 +158,17 @@ FIFO::FIFO()
 /*----------------------------------------------------------------------------------------------*/
 FIFO::~FIFO()
 {
-	int32 lcv;
-
-	pthread_mutex_destroy(&mutex);
-
-	for(lcv = 0; lcv < MAX_CHANNELS; lcv++)
-	{
-		pthread_mutex_destroy(&chan_mutex[lcv]);
-	}
 
 	delete [] if_buff;
 	delete [] buff;
+	free(cursor);
 
-	close(npipe);
+	if(huge)
+		munmap(samples, samples_bytes);
+	else
+		free(samples);
+
+	ring.Close();
 
 	if(gopt.verbose)
 		printf("Destructing FIFO\n");
@@ -171,20 +189,47 @@ void kill_program(int _sig)
 /*----------------------------------------------------------------------------------------------*/
 void FIFO::Inport()
 {
-	int32 lcv;
-	char *p;
-	int32 nbytes, bread, bytes_per_read, agc_scale_p = agc_scale;
+	int32 nbytes, full;
+	int nread, nlost;		/* Shm_Ring only uses plain C types */
+	ms_packet *p;
+
+	/* Get 1 ms of data from the shared ring */
+	full = IF_SAMPS_MS*sizeof(CPX);
+	nbytes = 0; nlost = 0;
+	while((nbytes != full) && grun)
+	{
+		nbytes = ring.Read(&if_buff[0], full, &nread);
+		nlost += nread;
+
+		/* The writer restarted, pick up the new ring */
+		if(nbytes < 0)
+		{
+			Open();
+			nbytes = 0;
+		}
+		else if((nbytes > 0) && (nbytes != full))
+		{
+			/* The rest of if_buff is still the last ms, drop the packet rather than let the AGC publish it */
+			if((shorts % 1000) == 0)
+				printf("Short IF packet, %d of %d bytes, dropped\n", nbytes, full);
+
+			shorts++;
+			nlost++;
+			nbytes = 0;
+		}
+	}
 
-	bytes_per_read = IF_SAMPS_MS*sizeof(CPX);
+	if(nbytes != full)
+		return;
 
-	/* Get data from pipe (1 ms) */
-	nbytes = 0; p = (char *)&if_buff[0];
-	while((nbytes < bytes_per_read) && grun)
+	/* Keep the packet count in step with the source */
+	if(nlost)
 	{
-		//signal(SIGPIPE, kill_program); /* This only matters for a pipe WRITER */
-		bread = read(npipe, &p[nbytes], PIPE_BUF);
-		if(bread >= 0)
-			nbytes += bread;
+		if((lost == 0) || ((lost / 1000) != ((lost + nlost) / 1000)))
+			printf("IF ring overrun!\n");
+
+		lost += nlost;
+		count += nlost;
 	}
 
 	/* Add to the buff */
@@ -194,12 +239,25 @@ void FIFO::Inport()
 	}
 	else if(gopt.realtime && count < 1000)
 	{
-		overflw = run_agc(&if_buff[0], IF_SAMPS_MS, AGC_BITS, &agc_scale);
+		overflw = run_agc(&if_buff[0], &if_buff[0], IF_SAMPS_MS, AGC_BITS, &agc_scale);
 	}
 	else
 	{
-		overflw = run_agc(&if_buff[0], IF_SAMPS_MS, AGC_BITS, &agc_scale);
-		Enqueue();
+		/* The AGC writes straight into the next free slot */
+		p = Reserve();
+		if(p != NULL)
+		{
+			overflw = run_agc(&if_buff[0], &p->data[0], IF_SAMPS_MS, AGC_BITS, &agc_scale);
+			Enqueue();
+		}
+		else
+		{
+			/* Nowhere to put it, still keep the AGC tracking */
+			overflw = run_agc(&if_buff[0], &if_buff[0], IF_SAMPS_MS, AGC_BITS, &agc_scale);
+			overflw++;
+			if((overflw % 1000) == 0)
+				printf("FIFO overflow!\n");
+		}
 	}
 
 	/* Resample? */
@@ -209,143 +267,354 @@ void FIFO::Inport()
 
 
 /*----------------------------------------------------------------------------------------------*/
-void FIFO::Enqueue()
+/*!
+ * Reserve: Get the next free slot for the AGC to write into, NULL if the FIFO is full. Nothing
+ * is visible to the consumers until Enqueue() publishes it.
+ * */
+ms_packet *FIFO::Reserve()
 {
+	int32 lcv;
 
-	Lock();
+	Reclaim();
+
+	/* Keep one slot empty so a full buffer can be told apart from an empty one */
+	if(((head + 1) % depth) == tail)
+	{
+		/* Charge the drop to whoever is holding the tail */
+		for(lcv = 0; lcv < consumers; lcv++)
+			if(stats.consumer[lcv].active && (stats.consumer[lcv].backlog == depth-1))
+				stats.consumer[lcv].drops++;
+
+		return(NULL);
+	}
+
+	return(&buff[head]);
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * Enqueue: Publish the slot handed out by Reserve(), its samples must already be written
+ * */
+void FIFO::Enqueue()
+{
 
-	int32 lcv;
 	ms_packet *p;
 
-	if(head->next == tail)
+	p = &buff[head];
+	p->count = count;
+
+	/* Actual measurement rate needs to be double to properly calculate ICP */
+	if((count % (MEASUREMENT_INT)) == 0)
 	{
-		overflw++;
-		if((overflw % 1000) == 0)
-			printf("FIFO overflow!\n");
+		tic++;
+		p->measurement = tic;
 	}
 	else
-	{
-		memcpy(&head->data[0], &if_buff[0], SAMPS_MS*sizeof(CPX));
-		head->count = count;
-
-		/* Actual measurement rate needs to be double to properly calculate ICP */
-		if((count % (MEASUREMENT_INT)) == 0)
-		{
-			tic++;
-			head->measurement = tic;
-		}
-		else
-			head->measurement = 0;
-
-		for(lcv = 0; lcv < (MAX_CHANNELS+1); lcv++)
-			head->accessed[lcv] = 666;
+		p->measurement = 0;
 
-		head = head->next;
+	/* Keep the mirror past the end up to date */
+	if(head < FIFO_MAX_BATCH)
+	{
+		memcpy(&buff[depth+head].data[0], &p->data[0], IF_SAMPS_MS*sizeof(CPX));
+		buff[depth+head].count = p->count;
+		buff[depth+head].measurement = p->measurement;
 	}
 
-	Unlock();
+	/* Publish the slot, this must be ordered before Wake() reads the consumers want flags */
+	__atomic_store_n(&head, (head + 1) % depth, __ATOMIC_SEQ_CST);
+
+	Wake();
 
 }
 /*----------------------------------------------------------------------------------------------*/
 
 
 /*----------------------------------------------------------------------------------------------*/
-void FIFO::Dequeue(int32 _resource, ms_packet *p)
+/*!
+ * Reclaim: Only called from the FIFO thread. The slowest active cursor defines the new tail,
+ * every measurement packet the tail moves past has been seen by all consumers and is
+ * passed on to the telemetry and PVT.
+ * */
+void FIFO::Reclaim()
 {
-	int32 lcv, complete;
+	int32 lcv, lag, used, index, bin;
+	uint32 seq;
+	FIFO_Consumer_S *c;
+	FIFO_2_Telem_S telem;
+	FIFO_2_PVT_S pvt;
 
-	Lock();
+	/* Distance from the tail to the head, no consumer can be further behind than this */
+	used = (head - tail + depth) % depth;
 
-	if(tail->accessed[_resource] = 666)
+	lag = 0;
+	for(lcv = 0; lcv < consumers; lcv++)
 	{
-		memcpy(p, tail, sizeof(ms_packet));
-		tail->accessed[_resource] = 333;
-	}
+		c = &stats.consumer[lcv];
+		c->active = __atomic_load_n(&cursor[lcv].active, __ATOMIC_ACQUIRE);
 
-	complete = 1;
+		if(c->active)
+		{
+			index = (head - __atomic_load_n(&cursor[lcv].index, __ATOMIC_ACQUIRE) + depth) % depth;
 
-	/* Check to see if all correlators have gotten the data */
-	for(lcv = 0; lcv < MAX_CHANNELS; lcv++)
-		complete &= (tail->accessed[lcv] == 333);
+			/* A consumer that just subscribed may start behind the tail, hold the tail until it catches up */
+			if(index > used)
+				index = used;
 
-	/* If the acquisition is active add one more to the count */
-	pthread_mutex_lock(&mAcq);
-	if(gAcq_high)
-		complete &= (tail->accessed[MAX_CHANNELS] == 333);
-	pthread_mutex_unlock(&mAcq);
+			if(index > lag)
+				lag = index;
 
-	if(complete == 1)
-	{
-		for(lcv = 0; lcv < MAX_CHANNELS+1; lcv++)
-			tail->accessed[lcv] = 0;
+			/* Sampled once per ms, this is queue depth, not how long any one packet waited */
+			c->backlog = index;
+			if(index > c->high)
+				c->high = index;
+
+			bin = 0;
+			while((index >> bin) && (bin < FIFO_HIST_BINS-1))
+				bin++;
+			c->depth_hist[bin]++;
+		}
+		else
+			c->backlog = 0;
+	}
 
-//		for(lcv = 0; lcv < MAX_CHANNELS; lcv++)
-//			pthread_mutex_unlock(&chan_mutex[_resource]);
+	/* Publish the statistics, seqlock style, only the consumers that exist */
+	seq = stats_pub.seq;
+	__atomic_store_n(&stats_pub.seq, seq + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	memcpy(&stats_pub.consumer[0], &stats.consumer[0], consumers*sizeof(FIFO_Consumer_S));
+	__atomic_store_n(&stats_pub.seq, seq + 2, __ATOMIC_RELEASE);
 
-		if(tail->measurement)
+	index = (head - lag + depth) % depth;
+
+	while(tail != index)
+	{
+		if(buff[tail].measurement)
 		{
-			telem.tic = tail->measurement;
+			/* Small messages, each write to the pipes is atomic */
+			memset(&telem, 0x0, sizeof(FIFO_2_Telem_S));
+			telem.tic = buff[tail].measurement;
 			telem.count = count;
-			telem.head = ((uint32)head - (uint32)&buff[0])/sizeof(ms_packet);
-			telem.tail = ((uint32)tail - (uint32)&buff[0])/sizeof(ms_packet);
+			telem.head = head;
+			telem.tail = tail;
 			telem.agc_scale = agc_scale;
 			telem.overflw = overflw;
+			telem.depth = depth;
+
+			pvt.tic = telem.tic;
+			pvt.count = telem.count;
 
 			write(FIFO_2_Telem_P[WRITE], &telem, sizeof(FIFO_2_Telem_S));
-			write(FIFO_2_PVT_P[WRITE], &telem, sizeof(FIFO_2_Telem_S));
+			write(FIFO_2_PVT_P[WRITE], &pvt, sizeof(FIFO_2_PVT_S));
 
-			tail->measurement = 0;
+			buff[tail].measurement = 0;
 		}
 
-		if(tail->next != head)
-			tail = tail->next;
+		tail = (tail + 1) % depth;
 	}
 
-	Unlock();
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * Wake: Only called from the FIFO thread, right after a new head is published. A sleeping
+ * consumer is only woken once it has all the packets it asked for, not on every packet.
+ * */
+void FIFO::Wake()
+{
+	int32 lcv, want;
+
+	for(lcv = 0; lcv < consumers; lcv++)
+	{
+		want = __atomic_load_n(&cursor[lcv].want, __ATOMIC_SEQ_CST);
+
+		if(want && (((head - cursor[lcv].index + depth) % depth) >= want))
+		{
+			__atomic_store_n(&cursor[lcv].want, 0, __ATOMIC_SEQ_CST);
+			__atomic_add_fetch(&cursor[lcv].wake, 1, __ATOMIC_SEQ_CST);
+			syscall(SYS_futex, &cursor[lcv].wake, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+		}
+	}
 
 }
 /*----------------------------------------------------------------------------------------------*/
 
 
 /*----------------------------------------------------------------------------------------------*/
-void FIFO::Open()
+/*!
+ * Borrow: Return a pointer straight into the FIFO for the next _packets packets of this
+ * consumer, or NULL if that many have not arrived yet. The packets are consecutive in the
+ * returned array, and their payloads form one contiguous span of _packets*IF_SAMPS_MS samples.
+ * They stay valid until Release() is called, calling Borrow() again before then returns the
+ * same slots. Each cursor is only ever written by its own consumer, so no lock is needed.
+ * */
+const ms_packet *FIFO::Borrow(int32 _resource, int32 _packets)
 {
+	int32 index;
 
-	/* Open the USRP_Uno pipe to get IF data */
-	if(gopt.verbose)
-		printf("Opening GPS pipe.\n");
+	index = cursor[_resource].index;
 
-	npipe = open("/tmp/GPSPIPE", O_RDONLY);
+	if(((__atomic_load_n(&head, __ATOMIC_SEQ_CST) - index + depth) % depth) >= _packets)
+		return(&buff[index]);
+	else
+		return(NULL);
 
-	if(gopt.verbose)
-		printf("GPS pipe open.\n");
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * Release: Hand the borrowed slots back, the release store orders all reads of the slots
+ * before the tail can move past them
+ * */
+void FIFO::Release(int32 _resource, int32 _packets)
+{
+	int32 index;
+
+	index = cursor[_resource].index;
+
+	__atomic_store_n(&cursor[_resource].index, (index + _packets) % depth, __ATOMIC_RELEASE);
 
 }
 /*----------------------------------------------------------------------------------------------*/
 
 
 /*----------------------------------------------------------------------------------------------*/
-void FIFO::Wait(int32 _resource)
+/*!
+ * Wait: Block until there are _packets packets for this consumer and borrow them. The
+ * consumer posts how many packets it wants before checking the head, and the FIFO publishes
+ * the head before checking the wants, so either the consumer sees the packets or the FIFO
+ * sees the want and bumps the wake count, which makes the futex return. No wakeup is lost.
+ * The timeout lets the thread notice grun going low. Returns NULL only when shutting down.
+ * */
+const ms_packet *FIFO::Wait(int32 _resource, int32 _packets)
 {
-	pthread_mutex_lock(&chan_mutex[_resource]);
+	const ms_packet *p;
+	int32 sequence;
+	timespec timeout;
+
+	while(grun)
+	{
+		__atomic_store_n(&cursor[_resource].want, _packets, __ATOMIC_SEQ_CST);
+		sequence = __atomic_load_n(&cursor[_resource].wake, __ATOMIC_SEQ_CST);
+
+		p = Borrow(_resource, _packets);
+		if(p != NULL)
+		{
+			__atomic_store_n(&cursor[_resource].want, 0, __ATOMIC_SEQ_CST);
+			return(p);
+		}
+
+		timeout.tv_sec = 0;
+		timeout.tv_nsec = 100000000;
+
+		syscall(SYS_futex, &cursor[_resource].wake, FUTEX_WAIT_PRIVATE, sequence, &timeout, NULL, 0);
+	}
+
+	__atomic_store_n(&cursor[_resource].want, 0, __ATOMIC_SEQ_CST);
+
+	return(Borrow(_resource, _packets));
+
+}
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * Subscribe: Start reading at the current head
+ * */
+void FIFO::Subscribe(int32 _resource)
+{
+
+	__atomic_store_n(&cursor[_resource].index, __atomic_load_n(&head, __ATOMIC_ACQUIRE), __ATOMIC_RELEASE);
+	__atomic_store_n(&cursor[_resource].active, 1, __ATOMIC_RELEASE);
+
 }
 /*----------------------------------------------------------------------------------------------*/
 
 
 /*----------------------------------------------------------------------------------------------*/
-void FIFO::Lock()
+/*!
+ * Unsubscribe: Stop holding back the tail
+ * */
+void FIFO::Unsubscribe(int32 _resource)
 {
-	pthread_mutex_lock(&mutex);
+
+	__atomic_store_n(&cursor[_resource].active, 0, __ATOMIC_RELEASE);
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * Backlog: How far the slowest correlator is behind the head, in ms. Safe from any thread, the
+ * acquisition uses it to see how much slack the correlators have left
+ * */
+int32 FIFO::Backlog()
+{
+
+	int32 lcv, h, index, lag;
+
+	h = __atomic_load_n(&head, __ATOMIC_ACQUIRE);
+
+	lag = 0;
+	for(lcv = 0; lcv < consumers-1; lcv++)
+	{
+		if(__atomic_load_n(&cursor[lcv].active, __ATOMIC_ACQUIRE))
+		{
+			index = (h - __atomic_load_n(&cursor[lcv].index, __ATOMIC_ACQUIRE) + depth) % depth;
+			if(index > lag)
+				lag = index;
+		}
+	}
+
+	return(lag);
+
 }
 /*----------------------------------------------------------------------------------------------*/
 
 
 /*----------------------------------------------------------------------------------------------*/
-void FIFO::Unlock()
+/*!
+ * getStats: Take a consistent copy of the published per consumer statistics, safe from any
+ * thread, retries if the FIFO thread was publishing at the time
+ * */
+void FIFO::getStats(FIFO_Stats_S *_s)
 {
-	pthread_mutex_unlock(&mutex);
+
+	uint32 seq;
+
+	do
+	{
+		seq = __atomic_load_n(&stats_pub.seq, __ATOMIC_ACQUIRE);
+		_s->channels = stats_pub.channels;
+		memcpy(&_s->consumer[0], &stats_pub.consumer[0], consumers*sizeof(FIFO_Consumer_S));
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	} while((seq & 0x1) || (seq != __atomic_load_n(&stats_pub.seq, __ATOMIC_RELAXED)));
+
+	_s->seq = seq;
+
 }
 /*----------------------------------------------------------------------------------------------*/
 
 
+/*----------------------------------------------------------------------------------------------*/
+void FIFO::Open()
+{
+
+	/* Attach to the gps-usrp shared ring to get IF data */
+	if(gopt.verbose)
+		printf("Attaching to GPS shared ring.\n");
+
+	while(!ring.Attach() && grun)
+		usleep(100000);
+
+	if(gopt.verbose)
+		printf("GPS shared ring attached.\n");
+
+}
+/*----------------------------------------------------------------------------------------------*/
 
@@ -25,7 +25,11 @@ Free Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1
 
 #include "includes.h"
 
-#define FIFO_DEPTH (1000)	//!< In ms
+#define FIFO_MAX_BATCH (20)	//!< Most packets a consumer can borrow at once, in ms
+#define FIFO_DEPTH (1000)	//!< Default depth, in ms
+#define FIFO_MIN_DEPTH (5*FIFO_MAX_BATCH)	//!< Shortest allowed depth, in ms, a borrowed batch, one arriving, and slack
+#define FIFO_MAX_DEPTH (60000)	//!< Longest allowed depth, in ms
+#define FIFO_HUGE_PAGE (2*1024*1024)	//!< Slot payload is allocated in these
 
 /*! \ingroup CLASSES
  * 
@@ -36,40 +40,49 @@ class FIFO
 	private:
 
 		pthread_t thread;	//!< For the thread
-		pthread_mutex_t	mutex;	//!< Semaphore to protect the FIFO
-		
-		pthread_mutex_t	mutex_head;	//!< Semaphore to protect the FIFO's head
-		pthread_mutex_t	mutex_tail;	//!< Semaphore to protect the FIFO's tail
-		pthread_mutex_t	chan_mutex[MAX_CHANNELS+1];
-		
 
 		CPX *if_buff;		//!< Get the data from the named pipe
-		ms_packet *buff;	//!< 1 second buffer (in 1 ms packets)
-		ms_packet *head;	//!< Pointer to the head
-		ms_packet *tail;	//!< Pointer to the tail
-
-		int32 	npipe;		//!< Get the IF data from the USRP_Uno program, and its pipe ("/tmp/GPSPIPE")
+		ms_packet *buff;	//!< 1 second buffer (in 1 ms packets), the first FIFO_MAX_BATCH slots are mirrored past the end
+		CPX *samples;		//!< Payload for all the slots, contiguous so a borrowed span never wraps
+		int32 samples_bytes;	//!< Size of the payload allocation
+		int32 huge;			//!< Payload came from hugepages (munmap it), otherwise free it
+		int32 depth;		//!< Number of slots (ms), from gopt.fifo_depth
+		int32 head;			//!< Next slot to be written, only the FIFO thread writes this
+		int32 tail;			//!< Oldest slot still held by a consumer, only the FIFO thread writes this
+		FIFO_Cursor_S *cursor;	//!< Read cursor for each correlator and then the acquisition, cache line aligned
+		int32 consumers;	//!< Number of cursors, gopt.channels+1
+
+		Shm_Ring ring;		//!< Get the IF data from the gps-usrp program through shared memory
+		int32 	lost;		//!< IF packets lost to overruns of the shared ring
+		int32 	shorts;		//!< IF packets dropped because they were shorter than 1 ms
 		int32 	count;		//!< Count the number of packets received	
 		int32	agc_scale;	//!< To do the AGC
 		int32	overflw;
 		int32	tic;		//!< Master receiver tic
 		
-		FIFO_2_Telem_S telem; //!< Stuff to dump to the telemetry
+		FIFO_Stats_S stats;	//!< Running per consumer statistics, only the FIFO thread touches these
+		FIFO_Stats_S stats_pub;	//!< Published copy of stats, read with getStats()
 		
 	public:
 
 		FIFO();				//!< Create circular FIFO
 		~FIFO();			//!< Destroy circular IFO
 		void Open();
-		void Inport();		//!< Get data from USRP_Uno
+		void Inport();		//!< Get data from gps-usrp
 		void Start();		//!< Start up the thread
 		void Stop();		//!< End the thread
-		void Enqueue();
-		void Lock();
-		void Unlock();
-		void Dequeue(int32 _resource, ms_packet *p);	
+		ms_packet *Reserve();	//!< Next free slot to write into, NULL if full
+		void Enqueue();		//!< Publish the reserved slot
+		void Reclaim();		//!< Move the tail up to the slowest active consumer
+		void Wake();		//!< Wake any consumer that now has the packets it is waiting for
+		const ms_packet *Borrow(int32 _resource, int32 _packets);	//!< Get a pointer to the next packets for this consumer, NULL if there are not enough
+		void Release(int32 _resource, int32 _packets);				//!< Done with the borrowed packets, hand them back to the FIFO
+		const ms_packet *Wait(int32 _resource, int32 _packets);		//!< Block until there are enough packets to borrow
+		void Subscribe(int32 _resource);	//!< Start reading from the head
+		void Unsubscribe(int32 _resource);	//!< Stop holding back the tail
+		int32 Backlog();					//!< How far the slowest correlator is behind the head, in ms
+		void getStats(FIFO_Stats_S *_s);	//!< Consistent copy of the per consumer statistics, from any thread
 		void SetScale(int32 _agc_scale);
-		void Wait(int32 _resource);
 };
 
 #endif /* FIFO_H */
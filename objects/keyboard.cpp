@@ -61,6 +61,23 @@ void *Keyboard_Thread(void *_arg)
 			pTelemetry->Unlock();
 		}
 
+		if((char)key == 'f') //FIFO consumers
+		{
+			pTelemetry->Lock();
+			pTelemetry->SetDisplay(3);
+			pTelemetry->Unlock();
+		}
+
+		if((char)key == 'p') //Correlator probes
+		{
+			pTelemetry->Lock();
+			pTelemetry->SetDisplay(4);
+			pTelemetry->Unlock();
+		}
+
+		if((char)key == 'P') //Dump the correlator probes to probes.txt
+			pTelemetry->DumpProbes();
+
 
 	}
 
@@ -73,27 +90,7 @@ void *Keyboard_Thread(void *_arg)
 /*----------------------------------------------------------------------------------------------*/
 void Keyboard::Start()
 {
-
-	pthread_attr_t tattr;
-	pthread_t tid;
-	int32 ret;
-	sched_param param;
-
-	/* Unitialized with default attributes */
-	ret = pthread_attr_init (&tattr);
-
-	/*Ssafe to get existing scheduling param */
-	ret = pthread_attr_getschedparam (&tattr, &param);
-
-	/* Set the priority; others are unchanged */
-	param.sched_priority = KEY_PRIORITY;
-
-	/* Setting the new scheduling param */
-	ret = pthread_attr_setschedparam(&tattr, &param);
-	ret = pthread_attr_setschedpolicy(&tattr, SCHED_RR);
-
-	/* With new priority specified */
-	pthread_create(&thread, &tattr, Keyboard_Thread, NULL);
+	Thread_Create(&thread, THREAD_KEY, 0, Keyboard_Thread, NULL);
 
 	if(gopt.verbose)
 		printf("Keyboard thread started\n");
@@ -45,7 +45,7 @@ void *Post_Process_Thread(void *_arg)
 /*----------------------------------------------------------------------------------------------*/
 void Post_Process::Start()
 {
-	pthread_create(&thread, NULL, Post_Process_Thread, NULL);
+	Thread_Create(&thread, THREAD_POST, 0, Post_Process_Thread, NULL);
 }
 /*----------------------------------------------------------------------------------------------*/
 
@@ -62,17 +62,19 @@ void Post_Process::Stop()
 /*----------------------------------------------------------------------------------------------*/
 Post_Process::Post_Process(char *_fname)
 {
-	int32 lcv, k, type, agc_scale;
+	int32 lcv, k, type, agc_scale, nsvs;
+	int32 svs[NUM_CODES];
 
 	buff_in = new CPX[310*IF_SAMPS_MS];
-	buff = new CPX[310*SAMPS_MS];
+	buff = new CPX[IF_SAMPS_MS];
 	memset(&results[0], 0x0, NUM_CODES*sizeof(Acq_Result_S));
 	Acq_Result_S *p;
 
 	agc_scale = 0;
 
-	/* Create named pipe */
-	fifo = mkfifo("/tmp/GPSPIPE", 0666);
+	/* Create the shared ring, before the FIFO thread starts looking for it */
+	if(!ring.Create(IF_SAMPS_MS*sizeof(CPX), SHM_RING_SLOTS))
+		printf("Could not create the shared IF ring %s\n",SHM_RING_NAME);
 
 	/* Open the source file */
 	strcpy(fname, _fname);
@@ -86,15 +88,12 @@ Post_Process::Post_Process(char *_fname)
 	/* Rewind the data */
 	fseek(fp, 0x0, SEEK_SET);
 
-	/* Downsample to 2048 samps/ms */
-	downsample(buff, buff_in, SAMPLE_FREQUENCY, IF_SAMPLE_FREQUENCY, IF_SAMPS_MS*310);
-
-	/* Init the AGC scale value */
-	init_agc(&buff[0], SAMPS_MS, AGC_BITS, &agc_scale);
+	/* Init the AGC scale value, the data is searched at the IF rate like the FIFO carries it */
+	init_agc(&buff_in[0], IF_SAMPS_MS, AGC_BITS, &agc_scale);
 
 	/* Now actually run the AGC */
 	for(lcv = 0; lcv < 310; lcv++)
-		run_agc(&buff[lcv*SAMPS_MS], SAMPS_MS, AGC_BITS, &agc_scale);
+		run_agc(&buff_in[lcv*IF_SAMPS_MS], &buff_in[lcv*IF_SAMPS_MS], IF_SAMPS_MS, AGC_BITS, &agc_scale);
 
 	pFIFO->SetScale(agc_scale);
 	printf("AGC Scale: %d\n",agc_scale);
@@ -106,38 +105,37 @@ Post_Process::Post_Process(char *_fname)
 	/* Now do the acquisition(s) */
 	for(type = 0; type < 1; type++)
 	{
-		pAcquisition->doPrepIF(type, buff);
+		pAcquisition->doPrepIF(type, buff_in);
 
+		/* Search all the SVs not found yet in one go, so the acquisition threads share all of them */
+		nsvs = 0;
 		for(lcv = 0; lcv < NUM_CODES; lcv++)
-		{
 			if(results[lcv].success == 0)
-			{
-				if(type == 0)
-					results[lcv] = pAcquisition->doAcqStrong(lcv, gopt.doppler_min, gopt.doppler_max);
-				else if(type == 1)
-					results[lcv] = pAcquisition->doAcqMedium(lcv, gopt.doppler_min, gopt.doppler_max);
-				else
-					results[lcv] = pAcquisition->doAcqWeak(lcv, gopt.doppler_min, gopt.doppler_max);
-
-				p = &results[lcv];
-				printf("  %02d,  %02d,  %10.2f,  %10.0f,  %15.0f,          %1d\n",p->type,lcv+1,p->delay,p->doppler,p->magnitude,p->success);
-			}
+				svs[nsvs++] = lcv;
+
+		pAcquisition->doAcqBatch(type, nsvs, svs, gopt.doppler_min, gopt.doppler_max, results);
 
+		for(k = 0; k < nsvs; k++)
+		{
+			lcv = svs[k];
+			p = &results[lcv];
+			printf("  %02d,  %02d,  %10.2f,  %10.0f,  %15.0f,          %1d\n",p->type,lcv+1,p->delay,p->doppler,p->magnitude,p->success);
 		}
 	}
 
 	pAcquisition->Export("AcqPP.txt");
 
 	/* For the detected SVs, start up correlators */
-	k = 0;
 	for(lcv = 0; lcv < NUM_CODES; lcv++)
 	{
 		if(results[lcv].success)
 		{
 			/* Map receiver channels to channels on correlator */
-			write(Trak_2_Corr_P[k][WRITE], &results[lcv], sizeof(Acq_Result_S));
-			if(++k >= MAX_CHANNELS)
+			k = Claim_Channel();
+			if(k == -1)
 				break;
+
+			write(Trak_2_Corr_P[k][WRITE], &results[lcv], sizeof(Acq_Result_S));
 		}
 	}
 
@@ -153,7 +151,7 @@ Post_Process::Post_Process(char *_fname)
 Post_Process::~Post_Process()
 {
 
-	close(npipe);
+	ring.Close();
 	delete [] buff;
 	delete [] buff_in;
 
@@ -186,25 +184,10 @@ void Post_Process::Parse()
 /*----------------------------------------------------------------------------------------------*/
 void Post_Process::Export()
 {
-//
-//	int32 nbytes, bwrote, bread;;
-//	char *pbuff;
-//
-//	bread = IF_SAMPS_MS*sizeof(CPX);
-//
-//	/* Dump to the pipe */
-//	nbytes = 0; pbuff = (char *)&buff[0];
-//	while((nbytes < bread) && grun)
-//	{
-//		bwrote = write(npipe, buff[nbytes], PIPE_BUF);
-//
-//		signal(SIGPIPE, SIG_IGN);
-//		if(bwrote > 0)
-//			nbytes += bwrote;
-//	}
-//
-	write(npipe, &buff[0], sizeof(CPX)*IF_SAMPS_MS);
-	usleep(250);
+
+	/* Block rather than overrun the FIFO, nothing is lost when running from a file */
+	while(!ring.Write(&buff[0], sizeof(CPX)*IF_SAMPS_MS, 1) && grun);
+
 }
 /*----------------------------------------------------------------------------------------------*/
 
@@ -213,8 +196,6 @@ void Post_Process::Export()
 void Post_Process::Open()
 {
 
-	npipe = open("/tmp/GPSPIPE", O_WRONLY);
-
 }
 /*----------------------------------------------------------------------------------------------*/
 
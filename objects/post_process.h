@@ -35,8 +35,7 @@ typedef class Post_Process
 
 		pthread_t	thread;	//!< For the thread
 		FILE 		*fp;	//!< file pointer to source GPS data
-		int32 		npipe;	//!< spoof the FIFO's named pipe
-		int32		fifo;
+		Shm_Ring	ring;	//!< Feed the FIFO through the same shared ring as gps-usrp
 		char		fname[1024];
 		CPX			*buff;
 		CPX 		*buff_in;
@@ -47,26 +47,7 @@ void *PVT_Thread(void *_arg)
 /*----------------------------------------------------------------------------------------------*/
 void PVT::Start()
 {
-	pthread_attr_t tattr;
-	pthread_t tid;
-	int32 ret;
-	sched_param param;
-
-	/* Unitialized with default attributes */
-	ret = pthread_attr_init (&tattr);
-
-	/*Ssafe to get existing scheduling param */
-	ret = pthread_attr_getschedparam (&tattr, &param);
-
-	/* Set the priority; others are unchanged */
-	param.sched_priority = PVT_PRIORITY;
-
-	/* Setting the new scheduling param */
-	ret = pthread_attr_setschedparam(&tattr, &param);
-	ret = pthread_attr_setschedpolicy(&tattr, SCHED_FIFO);
-
-	/* With new priority specified */
-	pthread_create(&thread, NULL, PVT_Thread, NULL);
+	Thread_Create(&thread, THREAD_PVT, 0, PVT_Thread, NULL);
 
 	if(gopt.verbose)
 		printf("PVT thread started\n");
@@ -93,6 +74,25 @@ void PVT::Stop()
 PVT::PVT(int32 _mode)
 {
 
+	int32 lcv;
+
+	/* Per channel buffers */
+	ephemerides = new Ephemeris_S[gopt.channels];
+	sv_positions = new SV_Position_S[gopt.channels];
+	pseudoranges = new Pseudorange_S[gopt.channels];
+	measurements = new Measurement_S[gopt.channels];
+	good_channels = new int32[gopt.channels];
+	master_iode = new int32[gopt.channels];
+	master_sv = new int32[gopt.channels];
+	sv_codes = new int32[gopt.channels];
+
+	alpha = new double *[gopt.channels];
+	for(lcv = 0; lcv < 4; lcv++)
+		alpha_pinv[lcv] = new double[gopt.channels];
+	dircos = new double[gopt.channels][4];
+	pseudorangeres = new double[gopt.channels];
+	pseudorangerateres = new double[gopt.channels];
+
 	Reset();
 
 	if(_mode == WARM_START)
@@ -120,6 +120,23 @@ PVT::PVT(int32 _mode)
 PVT::~PVT()
 {
 
+	int32 lcv;
+
+	delete [] ephemerides;
+	delete [] sv_positions;
+	delete [] pseudoranges;
+	delete [] measurements;
+	delete [] good_channels;
+	delete [] master_iode;
+	delete [] master_sv;
+	delete [] sv_codes;
+
+	delete [] alpha;
+	for(lcv = 0; lcv < 4; lcv++)
+		delete [] alpha_pinv[lcv];
+	delete [] dircos;
+	delete [] pseudorangeres;
+	delete [] pseudorangerateres;
 
 	pthread_mutex_destroy(&mutex);
 
@@ -140,24 +157,24 @@ void PVT::Inport()
 	int32 sv, chan, bread;
 	Measurement_S temp;
 
-	/* Get number of channels coming off the pipe */
-	read(FIFO_2_PVT_P[READ], &telem, sizeof(FIFO_2_Telem_S));
+	/* Get number of channels coming off the pipe, only whole messages */
+	while((read(FIFO_2_PVT_P[READ], &telem, sizeof(FIFO_2_PVT_S)) != sizeof(FIFO_2_PVT_S)) && grun);
 
 	master_nav.nav_channels = 0;
 
 	/* Set good_channels to false */
-	for(lcv = 0; lcv < MAX_CHANNELS; lcv++)
+	for(lcv = 0; lcv < gopt.channels; lcv++)
 	{
 		good_channels[lcv] = false;
 		measurements[lcv].navigate = false; //important!
 	}
 
 	/* Always clear out this sheit */
-	memset(&measurements[0], 0x0, MAX_CHANNELS*sizeof(Measurement_S));
-	memset(&pseudoranges[0], 0x0, MAX_CHANNELS*sizeof(Pseudorange_S));
+	memset(&measurements[0], 0x0, gopt.channels*sizeof(Measurement_S));
+	memset(&pseudoranges[0], 0x0, gopt.channels*sizeof(Pseudorange_S));
 
 	/* Initial set of Nav Channels, gets refined in Error_Check() */
-	for(lcv = 0; lcv < MAX_CHANNELS; lcv++)
+	for(lcv = 0; lcv < gopt.channels; lcv++)
 	{
 		read(Corr_2_PVT_P[lcv][READ], &temp, sizeof(Measurement_S));
 
@@ -187,7 +204,7 @@ void PVT::Inport()
 			Reset(lcv);
 	}
 
-	for(lcv = 0; lcv < MAX_CHANNELS; lcv++)
+	for(lcv = 0; lcv < gopt.channels; lcv++)
 	{
 		if(good_channels[lcv])
 		{
@@ -209,11 +226,11 @@ void PVT::Export()
 	int32 lcv;
 
 	master_nav.nsvs = 0;
-	for(lcv = 0; lcv < MAX_CHANNELS; lcv++)
+	for(lcv = 0; lcv < gopt.channels; lcv++)
 	{
 		if(good_channels[lcv] && ephemerides[lcv].valid)
 		{
-			master_nav.nsvs += (0x1 << lcv);
+			master_nav.nsvs += ((uint64)0x1 << lcv);
 		}
 		master_nav.chanmap[lcv] = ephemerides[lcv].valid;
 	}
@@ -221,9 +238,9 @@ void PVT::Export()
 	/* Dump to Telemetry */
 	memcpy(&output.master_nav,   &master_nav,   sizeof(Nav_Solution_S));
 	memcpy(&output.master_clock, &master_clock, sizeof(Clock_S));
-	memcpy(&output.sv_positions, &sv_positions, MAX_CHANNELS*sizeof(SV_Position_S));
-	memcpy(&output.pseudoranges, &pseudoranges, MAX_CHANNELS*sizeof(Pseudorange_S));
-	memcpy(&output.measurements, &measurements, MAX_CHANNELS*sizeof(Measurement_S));
+	memcpy(&output.sv_positions[0], &sv_positions[0], gopt.channels*sizeof(SV_Position_S));
+	memcpy(&output.pseudoranges[0], &pseudoranges[0], gopt.channels*sizeof(Pseudorange_S));
+	memcpy(&output.measurements[0], &measurements[0], gopt.channels*sizeof(Measurement_S));
 
 	write(PVT_2_Telem_P[WRITE], &output, sizeof(PVT_2_Telem_S));
 
@@ -369,7 +386,7 @@ void PVT::Get_Ephemerides()
 	/* Protect the Ephemeris object with a mutex */
 	pEphemeris->Lock();
 
-	for(lcv = 0; lcv < MAX_CHANNELS; lcv++)
+	for(lcv = 0; lcv < gopt.channels; lcv++)
 	{
 		if(good_channels[lcv])
 		{
@@ -390,7 +407,7 @@ void PVT::Get_Ephemerides()
 	pEphemeris->Unlock();
 
 	/* Recalculate good channels */
-	for(lcv = 0; lcv < MAX_CHANNELS; lcv++)
+	for(lcv = 0; lcv < gopt.channels; lcv++)
 	{
 		if(good_channels[lcv] && ephemerides[lcv].valid)
 			good_channels[lcv] = true;
@@ -411,7 +428,7 @@ void PVT::ClockInit()
 
 	/* Initialize the clock to the time-of-transmission of the first GPS signal that we find, this is accurate to within the transit time */
 	if(master_clock.state == CLOCK_UNINITIALIZED)
-		for(lcv = 0; lcv < MAX_CHANNELS; lcv++)
+		for(lcv = 0; lcv < gopt.channels; lcv++)
 			if(good_channels[lcv])
 			{
 				time_of_transmission		= (double)measurements[lcv]._z_count + measurements[lcv].code_time;
@@ -449,7 +466,7 @@ void PVT::SV_Positions()
 
 	Ephemeris_S* ephem;
 
-	for(lcv = 0; lcv < MAX_CHANNELS; lcv++)
+	for(lcv = 0; lcv < gopt.channels; lcv++)
 	{
 		if(good_channels[lcv] && ephemerides[lcv].valid)
 		{
@@ -602,7 +619,7 @@ void PVT::SV_TransitTime()
 
 
 	/* Calculate transit time to SV */
-	for(lcv = 0; lcv < MAX_CHANNELS; lcv++)
+	for(lcv = 0; lcv < gopt.channels; lcv++)
 	{
 		if(good_channels[lcv])
 		{
@@ -628,7 +645,7 @@ void PVT::SV_Correct()
 	int32 lcv;
 
 
-	for(lcv = 0; lcv < MAX_CHANNELS; lcv++)
+	for(lcv = 0; lcv < gopt.channels; lcv++)
 	{
 
 		if(good_channels[lcv])
@@ -671,7 +688,7 @@ void PVT::SV_Elevations()
 	ct = cos(theta); st = sin(theta);
 	cp = cos(phi);   sp = sin(phi);
 
-	for(lcv = 0; lcv < MAX_CHANNELS; lcv++)
+	for(lcv = 0; lcv < gopt.channels; lcv++)
 	{
 
 		if(good_channels[lcv])
@@ -704,7 +721,7 @@ void PVT::PseudoRange()
 
 	cp_scale = (double)TICS_PER_SECOND/(double)(2*ICP_TICS);
 
-	for(lcv = 0; lcv < MAX_CHANNELS; lcv++)
+	for(lcv = 0; lcv < gopt.channels; lcv++)
 	{
 		if(good_channels[lcv])
 		{
@@ -758,7 +775,7 @@ bool PVT::PreErrorCheck()
 	dtime = MEASUREMENT_INT*.001 + (dpseudo / SPEED_OF_LIGHT);
 
 	/* Channel by channel resets */
-	for(lcv = 0; lcv < MAX_CHANNELS; lcv++)
+	for(lcv = 0; lcv < gopt.channels; lcv++)
 	{
 		if(good_channels[lcv])
 		{
@@ -815,7 +832,7 @@ bool PVT::PreErrorCheck()
 
 	/* Recompute number of good channels */
 	master_nav.nav_channels = 0;
-	for(lcv = 0; lcv < MAX_CHANNELS; lcv++)
+	for(lcv = 0; lcv < gopt.channels; lcv++)
 	{
 		if(good_channels[lcv])
 			master_nav.nav_channels++;
@@ -838,7 +855,7 @@ void PVT::ErrorCheckCrossCorr()
 	double a, in0, ecc;
 
 	/* Channel by channel resets */
-	for(lcv = 0; lcv < MAX_CHANNELS; lcv++)
+	for(lcv = 0; lcv < gopt.channels; lcv++)
 	{
 		if(good_channels[lcv] && (pChannels[lcv]->getCN0() > 45.0))
 		{
@@ -847,7 +864,7 @@ void PVT::ErrorCheckCrossCorr()
 			in0 = ephemerides[lcv].in0;
 			ecc = ephemerides[lcv].ecc;
 
-			for(lcv2 = 0; lcv2 < MAX_CHANNELS; lcv2++)
+			for(lcv2 = 0; lcv2 < gopt.channels; lcv2++)
 			{
 				if(lcv2 == lcv)
 					continue;
@@ -889,7 +906,7 @@ void PVT::FormModel()
 	int32 lcv;
 	double relvel, range;
 
-	for(lcv = 0; lcv < MAX_CHANNELS; lcv++)
+	for(lcv = 0; lcv < gopt.channels; lcv++)
 	{
 
 		if(good_channels[lcv])
@@ -932,7 +949,7 @@ void PVT::PVT_Estimation()
 	nav_channels = master_nav.nav_channels;
 
 	k = 0;
-	for(lcv = 0; lcv < MAX_CHANNELS; lcv++)
+	for(lcv = 0; lcv < gopt.channels; lcv++)
 	{
 		if(good_channels[lcv])
 		{
@@ -1089,7 +1106,7 @@ void PVT::Residuals()
 	double range, dx, dy, dz, relvel;
 
 	/* Pseudorange Residuals */
-	for(lcv = 0; lcv < MAX_CHANNELS; lcv++)
+	for(lcv = 0; lcv < gopt.channels; lcv++)
 	{
 		if(good_channels[lcv])
 		{
@@ -1125,7 +1142,7 @@ bool PVT::Converged()
 	double residual_avg = 0.0;
 
 	/* Check residuals? */
-	for(lcv = 0; lcv < MAX_CHANNELS; lcv++)
+	for(lcv = 0; lcv < gopt.channels; lcv++)
 	{
 		if(good_channels[lcv])
 		{
@@ -1261,7 +1278,7 @@ void PVT::Reset()
 	memset(&master_nav,0x0,sizeof(Nav_Solution_S));
 
 	/* Reset Each Channel */
-	for(lcv = 0; lcv < MAX_CHANNELS; lcv++)
+	for(lcv = 0; lcv < gopt.channels; lcv++)
 		Reset(lcv);
 
 }
@@ -1340,7 +1357,7 @@ void PVT::Raim()
 
 	max_sum = 0;
 
-	for(lcv = 0; lcv < MAX_CHANNELS; lcv++)
+	for(lcv = 0; lcv < gopt.channels; lcv++)
 	{
 		if(good_channels[lcv])
 		{
@@ -1355,7 +1372,7 @@ void PVT::Raim()
 			residual_sum = 0;
 
 			/* Check residuals? */
-			for(lcv2 = 0; lcv2 < MAX_CHANNELS; lcv2++)
+			for(lcv2 = 0; lcv2 < gopt.channels; lcv2++)
 				if(good_channels[lcv2])
 					residual_sum += fabs(pseudoranges[lcv2].residual);
 
@@ -37,34 +37,33 @@ typedef class PVT
 		pthread_mutex_t	mutex;									//!< Protect the following variable
 		PVT_2_Telem_S output;									//!< Structure to dump to telemetry
 		PVT_2_SV_Select_S sv_select;							//!< Structure to dump to telemetry
-		FIFO_2_Telem_S telem;									//!< Structure to dump to telemetry
+		FIFO_2_PVT_S telem;										//!< Timing of the measurement from the FIFO
 		
-		/* Satellite related stuff */
-		Ephemeris_S		ephemerides[MAX_CHANNELS];				//!< Decoded ephemerides
-		SV_Position_S	sv_positions[MAX_CHANNELS];				//!< Calculated SV positions
-		Pseudorange_S	pseudoranges[MAX_CHANNELS];				//!< Pseudoranges
-		Measurement_S	measurements[MAX_CHANNELS];				//!< Raw measurements
-
-		int32 good_channels[MAX_CHANNELS];						//!< Is this a good channel (used to navigate)
-		int32 master_iode[MAX_CHANNELS];						//!< Keep track of current IODE
-		int32 master_sv[MAX_CHANNELS];							//!< Channel->SV map
-		int32 sv_codes[MAX_CHANNELS];							//!< Error codes
-		int32 doppler_suspect[MAX_CHANNELS][MAX_CHANNELS];		//!< For the cross-corr check
+		/* Satellite related stuff, one per channel, sized from gopt.channels */
+		Ephemeris_S		*ephemerides;							//!< Decoded ephemerides
+		SV_Position_S	*sv_positions;							//!< Calculated SV positions
+		Pseudorange_S	*pseudoranges;							//!< Pseudoranges
+		Measurement_S	*measurements;							//!< Raw measurements
+
+		int32 *good_channels;									//!< Is this a good channel (used to navigate)
+		int32 *master_iode;										//!< Keep track of current IODE
+		int32 *master_sv;										//!< Channel->SV map
+		int32 *sv_codes;										//!< Error codes
 
 		/* Position and clock solutions */
 		Nav_Solution_S	master_nav;								//!< Master nav sltn
 		Nav_Solution_S	temp_nav;								//!< Temp nav sltn	
 		Clock_S			master_clock;							//!< Master clock
 
-		/* Matrices used in nav solution */
-		double *alpha[MAX_CHANNELS];
+		/* Matrices used in nav solution, the channel dimension is sized from gopt.channels */
+		double **alpha;
 		double alpha_2[4][4];
 		double alpha_inv[4][4];
-		double alpha_pinv[4][MAX_CHANNELS];
+		double *alpha_pinv[4];
 		
-		double dircos[MAX_CHANNELS][4];
-		double pseudorangeres[MAX_CHANNELS];
-		double pseudorangerateres[MAX_CHANNELS];
+		double (*dircos)[4];
+		double *pseudorangeres;
+		double *pseudorangerateres;
 		double dr[4];
 
 
@@ -45,26 +45,7 @@ void *SV_Select_Thread(void *_arg)
 /*----------------------------------------------------------------------------------------------*/
 void SV_Select::Start()
 {
-	pthread_attr_t tattr;
-	pthread_t tid;
-	int32 ret;
-	sched_param param;
-
-	/* Unitialized with default attributes */
-	ret = pthread_attr_init (&tattr);
-
-	/*Ssafe to get existing scheduling param */
-	ret = pthread_attr_getschedparam (&tattr, &param);
-
-	/* Set the priority; others are unchanged */
-	param.sched_priority = TRAK_PRIORITY;
-
-	/* Setting the new scheduling param */
-	ret = pthread_attr_setschedparam(&tattr, &param);
-	ret = pthread_attr_setschedpolicy(&tattr, SCHED_RR);
-
-	/* With new priority specified */
-	pthread_create(&thread, NULL, SV_Select_Thread, NULL);
+	Thread_Create(&thread, THREAD_SELECT, 0, SV_Select_Thread, NULL);
 
 	if(gopt.verbose)
 		printf("SV_Select thread started\n");
@@ -142,26 +123,17 @@ void SV_Select::Inport()
 /*----------------------------------------------------------------------------------------------*/
 void SV_Select::Acquire()
 {
-	int32 lcv, chan, already;
+	int32 lcv, chan, already, handed;
 
-	chan = 666;
 	already = 0;
+	handed = 0;
 
-	/* See if any correlators are available */
 	pthread_mutex_lock(&mInterrupt);
 
-		/* If an empty channel exists, ask for an acquisition */
-		for(lcv = 0; lcv < MAX_CHANNELS; lcv++)
-			if(gInterrupt[lcv] == 0)
-			{
-				chan = lcv;
-				break;
-			}
-
 		sv_prediction[sv].tracked = false;
 
 		/* If the SV is already being tracked skip the acquisition */
-		for(lcv = 0; lcv < MAX_CHANNELS; lcv++)
+		for(lcv = 0; lcv < gopt.channels; lcv++)
 			if(pChannels[lcv]->getActive())
 				if(pChannels[lcv]->getSV() == sv)
 				{
@@ -188,8 +160,9 @@ void SV_Select::Acquire()
 	SV_LatLong(sv);
 	SV_Predict(sv);
 
-	/* Do something with acquisition */
-	if(chan != 666)
+	/* If an empty channel exists, ask for an acquisition */
+	chan = Claim_Channel();
+	if(chan != -1)
 	{
 		/* Tell the acquisition what to try */
 		if(SetupRequest())
@@ -206,10 +179,17 @@ void SV_Select::Acquire()
 
 			/* Do something! */
 			if(already != 666)
+			{
 				ProcessResult();
+				handed = result.success;
+			}
 
 		}
 
+		/* Unless the result went to the correlator the channel goes straight back to the pool */
+		if(!handed)
+			Retire_Channel(chan);
+
 		UpdateState();
 
 	}
@@ -45,25 +45,7 @@ void *Telemetry_Thread(void *_arg)
 /*----------------------------------------------------------------------------------------------*/
 void Telemetry::Start()
 {
-	pthread_attr_t tattr;
-	sched_param param;
-	int32 ret;
-
-	/* Unitialized with default attributes */
-	ret = pthread_attr_init(&tattr);
-
-	/*Ssafe to get existing scheduling param */
-	ret = pthread_attr_getschedparam(&tattr, &param);
-
-	/* Set the priority; others are unchanged */
-	param.sched_priority = TELEM_PRIORITY;
-
-	/* Setting the new scheduling param */
-	ret = pthread_attr_setschedparam(&tattr, &param);
-	ret = pthread_attr_setschedpolicy(&tattr, SCHED_FIFO);
-
-	/* With new priority specified */
-	pthread_create(&thread, NULL, Telemetry_Thread, NULL);
+	Thread_Create(&thread, THREAD_TELEM, 0, Telemetry_Thread, NULL);
 
 	if(gopt.verbose)
 		printf("Telemetry thread started\n");
@@ -98,6 +80,9 @@ Telemetry::Telemetry(int32 _ncurses_on)
 		fp_meas = fopen("measurement.tlm","wt");
 		fp_chan = fopen("tracking.tlm","wt");
 		fp_sv = fopen("satellites.tlm","wt");
+#if CORR_PROBES
+		fp_probe = fopen("probes.tlm","wt");
+#endif
 	}
 
 	if(gopt.google_earth)
@@ -120,6 +105,10 @@ Telemetry::Telemetry(int32 _ncurses_on)
 	pthread_mutex_init(&mutex, NULL);
 	pthread_mutex_unlock(&mutex);
 
+	memset(&tProbe[0], 0x0, MAX_CHANNELS*sizeof(Probe_S));
+	memset(&tStats, 0x0, sizeof(FIFO_Stats_S));
+	tsc_rate = tsc_mhz();
+
 	if(gopt.verbose)
 		printf("Creating Telemetry\n");
 
@@ -138,6 +127,9 @@ Telemetry::~Telemetry()
 		fclose(fp_meas);
 		fclose(fp_chan);
 		fclose(fp_sv);
+#if CORR_PROBES
+		fclose(fp_probe);
+#endif
 	}
 
 	if(gopt.google_earth)
@@ -181,14 +173,17 @@ void Telemetry::Inport()
 	Chan_Packet_S temp;
 	int32 bread, lcv, num_chans;
 
-	read(FIFO_2_Telem_P[READ], &tFIFO, sizeof(FIFO_2_Telem_S));
+	/* Only whole messages */
+	while((read(FIFO_2_Telem_P[READ], &tFIFO, sizeof(FIFO_2_Telem_S)) != sizeof(FIFO_2_Telem_S)) && grun);
+
+	pFIFO->getStats(&tStats);
 
 	/* Lock correlator status */
 	pthread_mutex_lock(&mInterrupt);
 
-	for(lcv = 0; lcv < MAX_CHANNELS; lcv++)
+	for(lcv = 0; lcv < gopt.channels; lcv++)
 	{
-		if(gInterrupt[lcv])
+		if(gInterrupt[lcv] == CHANNEL_ACTIVE)
 		{
 			tChan[lcv] = pChannels[lcv]->getPacket();
 			active[lcv] = 1;
@@ -203,6 +198,10 @@ void Telemetry::Inport()
 	/* Unlock correlator status */
 	pthread_mutex_unlock(&mInterrupt);
 
+#if CORR_PROBES
+	GetProbes();
+#endif
+
 	read(PVT_2_Telem_P[READ], &tNav, sizeof(PVT_2_Telem_S));
 
 	bread = sizeof(Acq_Result_S);
@@ -235,6 +234,9 @@ void Telemetry::Export()
 		LogPseudo();
 		LogTracking();
 		LogSV();
+#if CORR_PROBES
+		LogProbes();
+#endif
 	}
 
 	if(gopt.google_earth && (count++ % gopt.log_decimate == 0))
@@ -278,6 +280,7 @@ void Telemetry::ExportGUI()
 	char *pbuff;
 
 	memcpy(&tGUI.tFIFO, 	&tFIFO,		sizeof(FIFO_2_Telem_S));
+	memcpy(&tGUI.tStats, 	&tStats,	sizeof(FIFO_Stats_S));
 	memcpy(&tGUI.tNav, 		&tNav, 		sizeof(PVT_2_Telem_S));
 	memcpy(&tGUI.tAcq, 		&tAcq, 		sizeof(Acq_Result_S));
 	memcpy(&tGUI.tSelect, 	&tSelect, 	sizeof(SV_Select_2_Telem_S));
@@ -351,7 +354,7 @@ void Telemetry::UpdateScreen()
 	wclear(screen);
 
 	mvwprintw(screen,line,1,"                                                                               ");
-	mvwprintw(screen,line++,1,"FIFO:\t%d\t%d\t%d\t%d",(FIFO_DEPTH-(tFIFO.head-tFIFO.tail)) % FIFO_DEPTH,tFIFO.count,tFIFO.agc_scale,tFIFO.overflw);
+	mvwprintw(screen,line++,1,"FIFO:\t%d\t%d\t%d\t%d",(tFIFO.depth-(tFIFO.head-tFIFO.tail)) % (tFIFO.depth ? tFIFO.depth : 1),tFIFO.count,tFIFO.agc_scale,tFIFO.overflw);
 
 	Lock();
 
@@ -369,6 +372,12 @@ void Telemetry::UpdateScreen()
 		case 2:
 			PrintHistory();
 			break;
+		case 3:
+			PrintFIFO();
+			break;
+		case 4:
+			PrintProbes();
+			break;
 		default:
 			PrintChan();
 			PrintSV();
@@ -410,7 +419,7 @@ void Telemetry::PrintChan()
 	mvwprintw(screen,line++,1,"Ch#  SV   CL       Faccel          Doppler     CN0   BE       Locks        Power   Active\n");
 	mvwprintw(screen,line++,1,"-----------------------------------------------------------------------------------------\n");
 
-	for(lcv = 0; lcv < MAX_CHANNELS; lcv++)
+	for(lcv = 0; lcv < gopt.channels; lcv++)
 	{
 		p = &tChan[lcv];
 		if(active[lcv] && p->count > 3000)
@@ -472,7 +481,7 @@ void Telemetry::PrintSV()
 	mvwprintw(screen,line++,1,"Ch#  SV         SV Time        VX        VY        VZ    Transit Time        Residual\n");
 	mvwprintw(screen,line++,1,"-------------------------------------------------------------------------------------\n");
 
-	for(lcv	= 0; lcv < MAX_CHANNELS; lcv++)
+	for(lcv	= 0; lcv < gopt.channels; lcv++)
 	{
 		pPos    = (SV_Position_S *)	&tNav.sv_positions[lcv];
 		pChan   = (Chan_Packet_S *)	&tChan[lcv];
@@ -527,7 +536,7 @@ void Telemetry::PrintNav()
 
 	/* Nav Solution */
 	nsvs = 0;
-	for(lcv = 0; lcv < MAX_CHANNELS; lcv++)
+	for(lcv = 0; lcv < gopt.channels; lcv++)
 	{
 		if((pNav->nsvs >> lcv) & 0x1)
 			nsvs++;
@@ -723,6 +732,196 @@ void Telemetry::PrintHistory()
 /*----------------------------------------------------------------------------------------------*/
 
 
+/*----------------------------------------------------------------------------------------------*/
+void Telemetry::PrintFIFO()
+{
+
+	int32 lcv, lcv2;
+	FIFO_Consumer_S *c;
+	double total;
+	char buff[64];
+
+	line++;
+
+	mvwprintw(screen,line++,1,"FIFO depth:\t%6d ms\n",tFIFO.depth);
+
+	line++;
+	mvwprintw(screen,line++,1,"Ch#  Backlog   High   Drops  Queue depth, %% of ms spent at each backlog:\n");
+	mvwprintw(screen,line++,1,"                               0   1   2   4   8  16  32  64 128 256 512 1k+\n");
+	mvwprintw(screen,line++,1,"-----------------------------------------------------------------------------\n");
+
+	for(lcv = 0; lcv < (gopt.channels+1); lcv++)
+	{
+		c = &tStats.consumer[lcv];
+
+		if(lcv < gopt.channels)
+			sprintf(buff,"%2d ",lcv);
+		else
+			sprintf(buff,"Acq");
+
+		total = 0;
+		for(lcv2 = 0; lcv2 < FIFO_HIST_BINS; lcv2++)
+			total += c->depth_hist[lcv2];
+
+		if(c->active)
+			mvwprintw(screen,line,1,"%s  %7d  %5d  %6d ",buff,c->backlog,c->high,c->drops);
+		else
+			mvwprintw(screen,line,1,"%s  -------  %5d  %6d ",buff,c->high,c->drops);
+
+		for(lcv2 = 0; lcv2 < FIFO_HIST_BINS; lcv2++)
+			wprintw(screen,"%4d",total > 0 ? (int32)(100.0*c->depth_hist[lcv2]/total + 0.5) : 0);
+
+		line++;
+	}
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * probe_percentile: Upper edge of the histogram bin holding the given fraction of the passes, cycles
+ * */
+static double probe_percentile(const Probe_Stage_S *_s, double _frac)
+{
+	int32 lcv;
+	double target, total;
+
+	target = _frac*(double)_s->count;
+	total = 0;
+
+	for(lcv = 0; lcv < PROBE_BINS-1; lcv++)
+	{
+		total += _s->hist[lcv];
+		if(total >= target)
+			break;
+	}
+
+	return((lcv < PROBE_BINS-1) ? (double)((uint64)2 << lcv) : (double)_s->max);
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+void Telemetry::GetProbes()
+{
+
+	int32 lcv;
+
+	Lock();
+
+	for(lcv = 0; lcv < gopt.channels; lcv++)
+		pCorrelators[lcv]->getProbes(&tProbe[lcv]);
+
+	Unlock();
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * PrintProbes: Wait is per span, the rest are per code period, the p99 is of a single pass
+ * */
+void Telemetry::PrintProbes()
+{
+
+	int32 lcv, lcv2;
+	Probe_S *p;
+	Probe_Stage_S *s;
+	double periods, load;
+
+	line++;
+
+	mvwprintw(screen,line++,1,"Correlator probes:\t1 in %d code periods timed, TSC %.0f MHz\n",PROBE_SAMPLE,tsc_rate);
+
+	line++;
+	mvwprintw(screen,line++,1,"Ch#  Periods      Wait        Accum       Update         Dump      Channel   Load\n");
+	mvwprintw(screen,line++,1,"              us avg/max  us avg/p99  us avg/p99  us avg/p99  us avg/p99  %% 1ms\n");
+	mvwprintw(screen,line++,1,"-------------------------------------------------------------------------------\n");
+
+	for(lcv = 0; lcv < gopt.channels; lcv++)
+	{
+		p = &tProbe[lcv];
+		periods = (double)p->stage[PROBE_DUMP].count;
+
+		s = &p->stage[PROBE_WAIT];
+		mvwprintw(screen,line,1,"%2d  %8d  %5.0f/%-5.0f",lcv,(int32)periods,
+			s->count ? (double)s->cycles/(double)s->count/tsc_rate : 0.0,(double)s->max/tsc_rate);
+
+		load = 0;
+		for(lcv2 = PROBE_ACCUM; lcv2 < PROBE_STAGES; lcv2++)
+		{
+			s = &p->stage[lcv2];
+			wprintw(screen," %5.1f/%-5.1f",
+				periods > 0 ? (double)s->cycles/periods/tsc_rate : 0.0,probe_percentile(s, .99)/tsc_rate);
+
+			/* The channel is already inside the dump */
+			if(lcv2 != PROBE_CHANNEL)
+				load += periods > 0 ? (double)s->cycles/periods/tsc_rate : 0.0;
+		}
+
+		wprintw(screen," %5.1f",load/10.0);
+
+		line++;
+	}
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * DumpProbes: Called from the keyboard, the full histograms go to probes.txt so the screen is left alone
+ * */
+void Telemetry::DumpProbes()
+{
+
+	int32 lcv, lcv2, lcv3;
+	Probe_Stage_S *s;
+	FILE *fp;
+	time_t now;
+	const char *names[PROBE_STAGES] = {"wait","accum","update","dump","channel"};
+
+	fp = fopen("probes.txt","at");
+	if(fp == NULL)
+		return;
+
+	now = time(NULL);
+
+	Lock();
+
+	fprintf(fp,"Correlator probes, %s",ctime(&now));
+	fprintf(fp,"1 in %d code periods timed, TSC %.1f MHz, bin n holds passes of 2^n to 2^(n+1)-1 cycles\n",PROBE_SAMPLE,tsc_rate);
+
+	for(lcv = 0; lcv < gopt.channels; lcv++)
+	{
+		fprintf(fp,"Ch %02d, %d code periods\n",lcv,(int32)tProbe[lcv].stage[PROBE_DUMP].count);
+
+		for(lcv2 = 0; lcv2 < PROBE_STAGES; lcv2++)
+		{
+			s = &tProbe[lcv].stage[lcv2];
+
+			fprintf(fp,"  %-8s %10d passes, %12.0f avg, %10d max cycles:",names[lcv2],(int32)s->count,
+				s->count ? (double)s->cycles/(double)s->count : 0.0,(int32)s->max);
+
+			for(lcv3 = 0; lcv3 < PROBE_BINS; lcv3++)
+				fprintf(fp," %d",(int32)s->hist[lcv3]);
+
+			fprintf(fp,"\n");
+		}
+	}
+
+	fprintf(fp,"\n");
+
+	Unlock();
+
+	fclose(fp);
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
 /*----------------------------------------------------------------------------------------------*/
 void Telemetry::LogNav()
 {
@@ -734,7 +933,7 @@ void Telemetry::LogNav()
 	Clock_S				*pClock		= &tNav.master_clock;			/* Clock solution */
 
 	nsvs = 0;
-	for(lcv = 0; lcv < MAX_CHANNELS; lcv++)
+	for(lcv = 0; lcv < gopt.channels; lcv++)
 	{
 		if((pNav->nsvs >> lcv) & 0x1)
 			nsvs++;
@@ -771,7 +970,7 @@ void Telemetry::LogPseudo()
 	Measurement_S *pMeas;
 
 	/* Pseudo ranges */
-	for(lcv = 0; lcv < MAX_CHANNELS; lcv++)
+	for(lcv = 0; lcv < gopt.channels; lcv++)
 	{
 		pPseudo = (Pseudorange_S *)	&tNav.pseudoranges[lcv];
 		pMeas = (Measurement_S *)	&tNav.measurements[lcv];
@@ -811,7 +1010,7 @@ void Telemetry::LogTracking()
 	Chan_Packet_S *pChan;
 
 	/* Pseudo ranges */
-	for(lcv = 0; lcv < MAX_CHANNELS; lcv++)
+	for(lcv = 0; lcv < gopt.channels; lcv++)
 	{
 		pChan = (Chan_Packet_S *) &tChan[lcv];
 
@@ -834,6 +1033,31 @@ void Telemetry::LogTracking()
 /*----------------------------------------------------------------------------------------------*/
 
 
+/*----------------------------------------------------------------------------------------------*/
+void Telemetry::LogProbes()
+{
+
+	int32 lcv, lcv2;
+	Probe_Stage_S *s;
+
+	/* Per channel, then count, average and max cycles of each stage */
+	for(lcv = 0; lcv < gopt.channels; lcv++)
+	{
+		fprintf(fp_probe,"%02d",lcv);
+
+		for(lcv2 = 0; lcv2 < PROBE_STAGES; lcv2++)
+		{
+			s = &tProbe[lcv].stage[lcv2];
+			fprintf(fp_probe,",%d,%.0f,%d",(int32)s->count,s->count ? (double)s->cycles/(double)s->count : 0.0,(int32)s->max);
+		}
+
+		fprintf(fp_probe,"\n");
+	}
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
 /*----------------------------------------------------------------------------------------------*/
 void Telemetry::LogSV()
 {
@@ -843,7 +1067,7 @@ void Telemetry::LogSV()
 	Chan_Packet_S *pChan;
 
 	/* Pseudo ranges */
-	for(lcv = 0; lcv < MAX_CHANNELS; lcv++)
+	for(lcv = 0; lcv < gopt.channels; lcv++)
 	{
 		pSV = (SV_Position_S *) &tNav.sv_positions[lcv];
 		pChan = (Chan_Packet_S *) &tChan[lcv];
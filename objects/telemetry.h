@@ -45,12 +45,15 @@ typedef class Telemetry
 		WINDOW *my_win;
 
 		FIFO_2_Telem_S 		tFIFO;
+		FIFO_Stats_S		tStats;					//!< Copy of the per consumer FIFO statistics
 		PVT_2_Telem_S 		tNav;
 		Chan_Packet_S 		tChan[MAX_CHANNELS];
 		Acq_Result_S		tAcq;
 		Ephem_2_Telem_S 	tEphem;
 		SV_Select_2_Telem_S tSelect;
 		Telem_2_GUI_S 		tGUI;
+		Probe_S				tProbe[MAX_CHANNELS];	//!< Copies of the correlator stage timing
+		double				tsc_rate;				//!< TSC ticks per us, turns the probe cycles into time
 
 		int32 active[MAX_CHANNELS];
 		int32 line;
@@ -64,6 +67,7 @@ typedef class Telemetry
 		FILE *fp_meas;		//!< Raw measurements
 		FILE *fp_sv;		//!< SV position/velocity output
 		FILE *fp_ge;		//!< Google Earth Output
+		FILE *fp_probe;		//!< Correlator stage timing
 		uint32 fp_ge_end;	//!< Hold place of last Google earth pointer, minus the header
 
 	public:
@@ -89,10 +93,15 @@ typedef class Telemetry
 		void PrintEphem();
 		void PrintAlmanac();
 		void PrintHistory();
+		void PrintFIFO();
+		void PrintProbes();
 		void LogNav();
 		void LogPseudo();
 		void LogTracking();
 		void LogSV();
+		void LogProbes();
+		void GetProbes();		//!< Copy in the stage timing each correlator last published
+		void DumpProbes();		//!< Write the full stage timing histograms out to probes.txt
 		void LogGoogleEarth();
 		void GoogleEarthFooter();
 		void GoogleEarthHeader();
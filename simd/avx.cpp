@@ -0,0 +1,839 @@
+/*! \file AVX.cpp
+	256 and 512 bit versions of the correlator kernels, picked at run time by Init_SIMD()
+*/
+
+/************************************************************************************************
+Copyright 2008 Gregory W Heckler
+
+This file is part of the GPS Software Defined Radio (GPS-SDR)
+
+The GPS-SDR is free software; you can redistribute it and/or modify it under the terms of the
+GNU General Public License as published by the Free Software Foundation; either version 2 of the
+License, or (at your option) any later version.
+
+The GPS-SDR is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with GPS-SDR; if not,
+write to the:
+
+Free Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+************************************************************************************************/
+
+#include "includes.h"
+
+#include <immintrin.h>
+
+/* Each function carries its own target attribute, so the rest of the build stays plain -m32 and
+ * nothing in here runs unless Init_SIMD() found the instructions. Results are bit for bit the
+ * same as the SSE versions, including the saturation in cmulsc and the wrap of the accumulators. */
+
+
+/*----------------------------------------------------------------------------------------------*/
+/* Leftover samples, done exactly the way pmullw/pmaddwd/psrad/packssdw would */
+static void tail_cmulsc(CPX *_A, CPX *_B, CPX *_C, int32 _cnt, int32 _shift, int32 _round)
+{
+
+	int32 lcv;
+	int32 ai, aq;
+	int32 bi, bq, nbq;
+	int32 ti, tq;
+
+	for(lcv = 0; lcv < _cnt; lcv++)
+	{
+		ai = _A[lcv].i;
+		aq = _A[lcv].q;
+		bi = _B[lcv].i;
+		bq = _B[lcv].q;
+		nbq = (int16)(-bq);
+
+		ti = (int32)((uint32)(ai*bi) + (uint32)(aq*nbq) + (uint32)_round);
+		tq = (int32)((uint32)(ai*bq) + (uint32)(aq*bi) + (uint32)_round);
+
+		ti >>= _shift;
+		tq >>= _shift;
+
+		_C[lcv].i = (ti > 32767) ? 32767 : ((ti < -32768) ? -32768 : ti);
+		_C[lcv].q = (tq > 32767) ? 32767 : ((tq < -32768) ? -32768 : tq);
+	}
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/* Leftover samples for the bit packed codes, tail_cmulsc and then a sign flip for the code */
+static void tail_wipe_accum_bits(CPX *_A, CPX *_B, uint8 *_E, uint8 *_P, uint8 *_L, int32 _offset, int32 _cnt, int32 _shift, int32 _round, uint32 *_sum)
+{
+
+	int32 lcv, lcv2, bit;
+	uint8 *code[3];
+	CPX w;
+
+	code[0] = _E;
+	code[1] = _P;
+	code[2] = _L;
+
+	for(lcv = 0; lcv < _cnt; lcv++)
+	{
+		tail_cmulsc(&_A[lcv], &_B[lcv], &w, 1, _shift, _round);
+
+		bit = _offset + lcv;
+
+		for(lcv2 = 0; lcv2 < 3; lcv2++)
+		{
+			if((code[lcv2][bit >> 3] >> (bit & 7)) & 1)
+			{
+				_sum[2*lcv2]   += (uint32)w.i;
+				_sum[2*lcv2+1] += (uint32)w.q;
+			}
+			else
+			{
+				_sum[2*lcv2]   -= (uint32)w.i;
+				_sum[2*lcv2+1] -= (uint32)w.q;
+			}
+		}
+	}
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/* Leftover samples for the code NCO, the code for them goes through x86_code_nco first */
+static void tail_wipe_accum_code(CPX *_A, CPX *_B, uint8 *_C, uint32 _late, uint32 _inc, uint32 _spacing, int32 _cnt, int32 _shift, int32 _round, uint32 *_sum)
+{
+
+	uint8 code[3][4];
+	uint32 phase;
+	int32 lcv;
+
+	for(lcv = 0; lcv < 3; lcv++)
+	{
+		phase = _late + (2 - lcv)*_spacing;
+		if(phase >= CODE_NCO_WRAP)
+			phase -= CODE_NCO_WRAP;
+
+		x86_code_nco(_C, &code[lcv][0], phase, _inc, _cnt);
+	}
+
+	tail_wipe_accum_bits(_A, _B, code[0], code[1], code[2], 0, _cnt, _shift, _round, _sum);
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/* Leftover samples for the tap bank, the code for each tap comes straight off its NCO phase */
+static void tail_wipe_accum_taps(CPX *_A, CPX *_B, uint8 *_C, uint32 _late, uint32 _inc, uint32 _spacing, int32 _taps, int32 _cnt, int32 _shift, int32 _round, uint32 *_sum)
+{
+
+	int32 lcv, tap;
+	uint32 phase, index;
+	CPX w;
+
+	for(lcv = 0; lcv < _cnt; lcv++)
+	{
+		tail_cmulsc(&_A[lcv], &_B[lcv], &w, 1, _shift, _round);
+
+		for(tap = 0; tap < _taps; tap++)
+		{
+			phase = _late + (_taps - 1 - tap)*_spacing;
+			if(phase >= CODE_NCO_WRAP)
+				phase -= CODE_NCO_WRAP;
+
+			index = phase >> CODE_NCO_FRAC;
+			if((_C[index >> 3] >> (index & 7)) & 1)
+			{
+				_sum[2*tap]   += (uint32)w.i;
+				_sum[2*tap+1] += (uint32)w.q;
+			}
+			else
+			{
+				_sum[2*tap]   -= (uint32)w.i;
+				_sum[2*tap+1] -= (uint32)w.q;
+			}
+		}
+
+		_late += _inc;
+		if(_late >= CODE_NCO_WRAP)
+			_late -= CODE_NCO_WRAP;
+	}
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/* The code bits for sample _bit onward in the low bits, the rows carry 4 bytes of padding for this */
+static inline unsigned int code_bits(uint8 *_C, int32 _bit)
+{
+
+	unsigned int w;
+
+	memcpy(&w, &_C[_bit >> 3], sizeof(w));
+
+	return(w >> (_bit & 7));
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * avx2_cmulsc: Same as sse_cmulsc, 8 samples a pass. The real parts come from pmaddwd against
+ * [Re -Im], the imaginary parts against [Im Re], then they get interleaved back before the pack.
+ * */
+__attribute__ ((target("avx2")))
+void avx2_cmulsc(CPX *_A, CPX *_B, CPX *_C, int32 _cnt, int32 _shift)
+{
+
+	int32 lcv;
+	int32 cnt1;
+	int32 round;
+	__m256i a, b, br, bq, re, im, lo, hi;
+	__m256i sign, rnd;
+	__m128i shift;
+
+	cnt1 = _cnt & ~7;
+	round = 1 << (_shift-1);
+
+	sign = _mm256_set1_epi32(0xffff0001);	//{1,-1,1,-1...}
+	rnd = _mm256_set1_epi32(round);
+	shift = _mm_cvtsi32_si128(_shift);
+
+	for(lcv = 0; lcv < cnt1; lcv += 8)
+	{
+		a = _mm256_loadu_si256((__m256i *)&_A[lcv]);
+		b = _mm256_loadu_si256((__m256i *)&_B[lcv]);
+
+		br = _mm256_mullo_epi16(b, sign);												//[Re -Im]
+		bq = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(b, 0xB1), 0xB1);			//[Im Re]
+
+		re = _mm256_sra_epi32(_mm256_add_epi32(_mm256_madd_epi16(a, br), rnd), shift);
+		im = _mm256_sra_epi32(_mm256_add_epi32(_mm256_madd_epi16(a, bq), rnd), shift);
+
+		/* Interleave within each 128 bit lane, so the pack puts everything back in order */
+		lo = _mm256_unpacklo_epi32(re, im);
+		hi = _mm256_unpackhi_epi32(re, im);
+
+		_mm256_storeu_si256((__m256i *)&_C[lcv], _mm256_packs_epi32(lo, hi));
+	}
+
+	tail_cmulsc(&_A[cnt1], &_B[cnt1], &_C[cnt1], _cnt - cnt1, _shift, round);
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * avx512_cmulsc: avx2_cmulsc at 16 samples a pass
+ * */
+__attribute__ ((target("avx512f,avx512bw")))
+void avx512_cmulsc(CPX *_A, CPX *_B, CPX *_C, int32 _cnt, int32 _shift)
+{
+
+	int32 lcv;
+	int32 cnt1;
+	int32 round;
+	__m512i a, b, br, bq, re, im, lo, hi;
+	__m512i rnd;
+	__m128i shift;
+
+	cnt1 = _cnt & ~15;
+	round = 1 << (_shift-1);
+
+	rnd = _mm512_set1_epi32(round);
+	shift = _mm_cvtsi32_si128(_shift);
+
+	for(lcv = 0; lcv < cnt1; lcv += 16)
+	{
+		a = _mm512_loadu_si512((void *)&_A[lcv]);
+		b = _mm512_loadu_si512((void *)&_B[lcv]);
+
+		br = _mm512_mask_sub_epi16(b, 0xAAAAAAAA, _mm512_setzero_si512(), b);			//[Re -Im]
+		bq = _mm512_rol_epi32(b, 16);													//[Im Re]
+
+		re = _mm512_sra_epi32(_mm512_add_epi32(_mm512_madd_epi16(a, br), rnd), shift);
+		im = _mm512_sra_epi32(_mm512_add_epi32(_mm512_madd_epi16(a, bq), rnd), shift);
+
+		lo = _mm512_unpacklo_epi32(re, im);
+		hi = _mm512_unpackhi_epi32(re, im);
+
+		_mm512_storeu_si512((void *)&_C[lcv], _mm512_packs_epi32(lo, hi));
+	}
+
+	tail_cmulsc(&_A[cnt1], &_B[cnt1], &_C[cnt1], _cnt - cnt1, _shift, round);
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * avx2_nco: The carrier NCO 8 samples at a time, 8 phases are stepped by 8*inc and the top bits
+ * of each one gather its sample out of the lookup. Same output as x86_nco.
+ * */
+__attribute__ ((target("avx2")))
+void avx2_nco(CPX *_A, CPX *_LUT, uint32 _phase, uint32 _inc, int32 _cnt)
+{
+
+	int32 lcv;
+	int32 cnt1;
+	__m256i phase, step, index, a;
+
+	cnt1 = _cnt & ~7;
+
+	phase = _mm256_mullo_epi32(_mm256_set1_epi32((int)_inc), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+	phase = _mm256_add_epi32(phase, _mm256_set1_epi32((int)_phase));
+	step = _mm256_set1_epi32((int)(_inc << 3));
+
+	for(lcv = 0; lcv < cnt1; lcv += 8)
+	{
+		index = _mm256_srli_epi32(phase, 32-CARRIER_LUT_BITS);
+		a = _mm256_i32gather_epi32((const int *)_LUT, index, 4);
+		_mm256_storeu_si256((__m256i *)&_A[lcv], a);
+		phase = _mm256_add_epi32(phase, step);
+	}
+
+	x86_nco(&_A[cnt1], _LUT, _phase + (uint32)cnt1*_inc, _inc, _cnt - cnt1);
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * avx512_nco: avx2_nco at 16 samples a pass
+ * */
+__attribute__ ((target("avx512f,avx512bw")))
+void avx512_nco(CPX *_A, CPX *_LUT, uint32 _phase, uint32 _inc, int32 _cnt)
+{
+
+	int32 lcv;
+	int32 cnt1;
+	__m512i phase, step, index, a;
+
+	cnt1 = _cnt & ~15;
+
+	phase = _mm512_mullo_epi32(_mm512_set1_epi32((int)_inc), _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+	phase = _mm512_add_epi32(phase, _mm512_set1_epi32((int)_phase));
+	step = _mm512_set1_epi32((int)(_inc << 4));
+
+	for(lcv = 0; lcv < cnt1; lcv += 16)
+	{
+		index = _mm512_srli_epi32(phase, 32-CARRIER_LUT_BITS);
+		a = _mm512_i32gather_epi32(index, (const void *)_LUT, 4);
+		_mm512_storeu_si512((void *)&_A[lcv], a);
+		phase = _mm512_add_epi32(phase, step);
+	}
+
+	x86_nco(&_A[cnt1], _LUT, _phase + (uint32)cnt1*_inc, _inc, _cnt - cnt1);
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * avx2_wipe_accum_code: sse_wipe_accum_bits 8 samples a pass, with the code made on the fly by
+ * the code NCO, so there is no code table to walk and the early/late spacing is not tied to the
+ * sample grid.
+ * Everything runs off the late phase. The 8 samples of all three codes span less than 32 chips,
+ * so one 32 bit word of the code is broadcast, and each lane shifts its own chip into the sign
+ * bit. That makes a -1 (+1 chip) or +1 (-1 chip) per sample, which pmaddwd applies to the
+ * saturated [Re Im] words, so the correlation comes out negated. The word can read past the
+ * end of the period into the wrapped chips at the end of the table, so only the late phase at
+ * the start of each pass wraps. spacing has to stay under a couple of chips.
+ * */
+__attribute__ ((target("avx2")))
+void avx2_wipe_accum_code(CPX *_A, CPX *_B, uint8 *_C, uint32 _phase, uint32 _inc, uint32 _spacing, int32 _cnt, int32 _shift, CPX_ACCUM *_accum)
+{
+
+	int32 lcv;
+	int32 cnt1;
+	int32 round;
+	uint32 late, step;
+	uint32 sum[6];
+	__m256i a, b, br, bq, re, im, x, c, code, index;
+	__m256i sign, rnd, one, offset, ke, kp, kl;
+	__m256i e, p, l;
+	__m128i shift, t;
+
+	cnt1 = _cnt & ~7;
+	round = 1 << (_shift-1);
+	step = _inc << 3;
+
+	late = _phase + CODE_NCO_WRAP - _spacing;
+	if(late >= CODE_NCO_WRAP)
+		late -= CODE_NCO_WRAP;
+
+	sign = _mm256_set1_epi32(0xffff0001);	//{1,-1,1,-1...}
+	rnd = _mm256_set1_epi32(round);
+	shift = _mm_cvtsi32_si128(_shift);
+	one = _mm256_set1_epi32(1);
+
+	/* Phase of each lane from the start of the pass, and 31 minus that in chips for each code */
+	offset = _mm256_mullo_epi32(_mm256_set1_epi32((int)_inc), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+	kl = _mm256_set1_epi32((32 << CODE_NCO_FRAC) - 1);
+	kp = _mm256_set1_epi32((int)((32 << CODE_NCO_FRAC) - 1 - _spacing));
+	ke = _mm256_set1_epi32((int)((32 << CODE_NCO_FRAC) - 1 - 2*_spacing));
+
+	e = _mm256_setzero_si256();
+	p = _mm256_setzero_si256();
+	l = _mm256_setzero_si256();
+
+	for(lcv = 0; lcv < cnt1; lcv += 8)
+	{
+		a = _mm256_loadu_si256((__m256i *)&_A[lcv]);
+		b = _mm256_loadu_si256((__m256i *)&_B[lcv]);
+
+		br = _mm256_mullo_epi16(b, sign);												//[Re -Im]
+		bq = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(b, 0xB1), 0xB1);			//[Im Re]
+
+		re = _mm256_sra_epi32(_mm256_add_epi32(_mm256_madd_epi16(a, br), rnd), shift);
+		im = _mm256_sra_epi32(_mm256_add_epi32(_mm256_madd_epi16(a, bq), rnd), shift);
+
+		/* Saturated [Re Re Re Re Im Im Im Im] in each half, same as the packssdw in sse_cmulsc */
+		x = _mm256_packs_epi32(re, im);
+
+		index = _mm256_add_epi32(offset, _mm256_set1_epi32((int)(late & ((8 << CODE_NCO_FRAC) - 1))));
+		code = _mm256_set1_epi32((int)code_bits(_C, (late >> CODE_NCO_FRAC) & ~7));
+
+		c = _mm256_srli_epi32(_mm256_sub_epi32(ke, index), CODE_NCO_FRAC);
+		c = _mm256_or_si256(_mm256_srai_epi32(_mm256_sllv_epi32(code, c), 31), one);
+		e = _mm256_add_epi32(e, _mm256_madd_epi16(x, _mm256_packs_epi32(c, c)));
+
+		c = _mm256_srli_epi32(_mm256_sub_epi32(kp, index), CODE_NCO_FRAC);
+		c = _mm256_or_si256(_mm256_srai_epi32(_mm256_sllv_epi32(code, c), 31), one);
+		p = _mm256_add_epi32(p, _mm256_madd_epi16(x, _mm256_packs_epi32(c, c)));
+
+		c = _mm256_srli_epi32(_mm256_sub_epi32(kl, index), CODE_NCO_FRAC);
+		c = _mm256_or_si256(_mm256_srai_epi32(_mm256_sllv_epi32(code, c), 31), one);
+		l = _mm256_add_epi32(l, _mm256_madd_epi16(x, _mm256_packs_epi32(c, c)));
+
+		late += step;
+		if(late >= CODE_NCO_WRAP)
+			late -= CODE_NCO_WRAP;
+	}
+
+	/* Each half is [Re Re Im Im] */
+	t = _mm_add_epi32(_mm256_castsi256_si128(e), _mm256_extracti128_si256(e, 1));
+	sum[0] = -(uint32)(_mm_cvtsi128_si32(t) + _mm_cvtsi128_si32(_mm_srli_si128(t, 4)));
+	sum[1] = -(uint32)(_mm_cvtsi128_si32(_mm_srli_si128(t, 8)) + _mm_cvtsi128_si32(_mm_srli_si128(t, 12)));
+
+	t = _mm_add_epi32(_mm256_castsi256_si128(p), _mm256_extracti128_si256(p, 1));
+	sum[2] = -(uint32)(_mm_cvtsi128_si32(t) + _mm_cvtsi128_si32(_mm_srli_si128(t, 4)));
+	sum[3] = -(uint32)(_mm_cvtsi128_si32(_mm_srli_si128(t, 8)) + _mm_cvtsi128_si32(_mm_srli_si128(t, 12)));
+
+	t = _mm_add_epi32(_mm256_castsi256_si128(l), _mm256_extracti128_si256(l, 1));
+	sum[4] = -(uint32)(_mm_cvtsi128_si32(t) + _mm_cvtsi128_si32(_mm_srli_si128(t, 4)));
+	sum[5] = -(uint32)(_mm_cvtsi128_si32(_mm_srli_si128(t, 8)) + _mm_cvtsi128_si32(_mm_srli_si128(t, 12)));
+
+	tail_wipe_accum_code(&_A[cnt1], &_B[cnt1], _C, late, _inc, _spacing, _cnt - cnt1, _shift, round, &sum[0]);
+
+	for(lcv = 0; lcv < 3; lcv++)
+	{
+		_accum[lcv].i = (int32)sum[2*lcv];
+		_accum[lcv].q = (int32)sum[2*lcv+1];
+	}
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * avx2_wipe_accum_taps: avx2_wipe_accum_code for a bank of taps code delays spaced spacing
+ * apart, prompt in the middle and the earliest first. The wipeoff, the code word and the lane
+ * phases are done once a pass and shared by the whole bank. Each tap only makes a 0/-1 mask of
+ * its +1 chips, two taps are packed into one mask and pmaddwd'd against [Re Re] and [Im Im], and
+ * the correlation is put back together at the end from the masked sum and the plain sum of the
+ * samples, -2*masked - sum. The whole bank plus 16 samples at about half a chip each has to
+ * fit in the 32 bit code word, so (taps-1)*spacing is held to MAX_TAP_SPAN.
+ * */
+__attribute__ ((target("avx2")))
+void avx2_wipe_accum_taps(CPX *_A, CPX *_B, uint8 *_C, uint32 _phase, uint32 _inc, uint32 _spacing, int32 _taps, int32 _cnt, int32 _shift, CPX_ACCUM *_accum)
+{
+
+	int32 lcv, tap, pairs;
+	int32 cnt1;
+	int32 round;
+	uint32 late, step;
+	uint32 sre, sim;
+	uint32 sum[2*(MAX_TAPS+1)];
+	__m256i a, b, br, bq, re, im, xr, xi, m, code, index;
+	__m256i sign, rnd, ones, offset, x;
+	__m256i k[MAX_TAPS+1], tr[(MAX_TAPS+1)/2], ti[(MAX_TAPS+1)/2];
+	__m128i shift, t, u;
+
+	cnt1 = _cnt & ~7;
+	round = 1 << (_shift-1);
+	step = _inc << 3;
+	pairs = (_taps + 1) >> 1;
+
+	late = _phase + CODE_NCO_WRAP - (_taps >> 1)*_spacing;
+	if(late >= CODE_NCO_WRAP)
+		late -= CODE_NCO_WRAP;
+
+	sign = _mm256_set1_epi32(0xffff0001);	//{1,-1,1,-1...}
+	rnd = _mm256_set1_epi32(round);
+	shift = _mm_cvtsi32_si128(_shift);
+	ones = _mm256_set1_epi16(1);
+
+	/* Phase of each lane from the start of the pass, and 31 minus that in chips for each tap, the
+	 * odd tap out gets paired with a copy of itself */
+	offset = _mm256_mullo_epi32(_mm256_set1_epi32((int)_inc), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+	for(tap = 0; tap < 2*pairs; tap++)
+		k[tap] = _mm256_set1_epi32((int)((32 << CODE_NCO_FRAC) - 1 - (_taps - 1 - (tap < _taps ? tap : _taps - 1))*_spacing));
+
+	for(tap = 0; tap < pairs; tap++)
+	{
+		tr[tap] = _mm256_setzero_si256();
+		ti[tap] = _mm256_setzero_si256();
+	}
+	x = _mm256_setzero_si256();
+
+	for(lcv = 0; lcv < cnt1; lcv += 8)
+	{
+		a = _mm256_loadu_si256((__m256i *)&_A[lcv]);
+		b = _mm256_loadu_si256((__m256i *)&_B[lcv]);
+
+		br = _mm256_mullo_epi16(b, sign);												//[Re -Im]
+		bq = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(b, 0xB1), 0xB1);			//[Im Re]
+
+		re = _mm256_sra_epi32(_mm256_add_epi32(_mm256_madd_epi16(a, br), rnd), shift);
+		im = _mm256_sra_epi32(_mm256_add_epi32(_mm256_madd_epi16(a, bq), rnd), shift);
+
+		/* Saturated [Re Re Re Re Re Re Re Re] and [Im ...] in each half, and the plain sum */
+		xr = _mm256_packs_epi32(re, re);
+		xi = _mm256_packs_epi32(im, im);
+		x = _mm256_add_epi32(x, _mm256_madd_epi16(_mm256_packs_epi32(re, im), ones));
+
+		index = _mm256_add_epi32(offset, _mm256_set1_epi32((int)(late & ((8 << CODE_NCO_FRAC) - 1))));
+		code = _mm256_set1_epi32((int)code_bits(_C, (late >> CODE_NCO_FRAC) & ~7));
+
+		/* Two taps a mask, the chip lands in the sign bit and the pack keeps it there */
+		for(tap = 0; tap < pairs; tap++)
+		{
+			m = _mm256_packs_epi32(_mm256_sllv_epi32(code, _mm256_srli_epi32(_mm256_sub_epi32(k[2*tap], index), CODE_NCO_FRAC)),
+								   _mm256_sllv_epi32(code, _mm256_srli_epi32(_mm256_sub_epi32(k[2*tap+1], index), CODE_NCO_FRAC)));
+			m = _mm256_srai_epi16(m, 15);
+
+			tr[tap] = _mm256_add_epi32(tr[tap], _mm256_madd_epi16(xr, m));
+			ti[tap] = _mm256_add_epi32(ti[tap], _mm256_madd_epi16(xi, m));
+		}
+
+		late += step;
+		if(late >= CODE_NCO_WRAP)
+			late -= CODE_NCO_WRAP;
+	}
+
+	/* The plain sum is [Re Re Im Im] in each half, the masked sums are [even even odd odd] */
+	t = _mm_add_epi32(_mm256_castsi256_si128(x), _mm256_extracti128_si256(x, 1));
+	sre = (uint32)(_mm_cvtsi128_si32(t) + _mm_cvtsi128_si32(_mm_srli_si128(t, 4)));
+	sim = (uint32)(_mm_cvtsi128_si32(_mm_srli_si128(t, 8)) + _mm_cvtsi128_si32(_mm_srli_si128(t, 12)));
+
+	for(tap = 0; tap < pairs; tap++)
+	{
+		t = _mm_add_epi32(_mm256_castsi256_si128(tr[tap]), _mm256_extracti128_si256(tr[tap], 1));
+		u = _mm_add_epi32(_mm256_castsi256_si128(ti[tap]), _mm256_extracti128_si256(ti[tap], 1));
+		t = _mm_add_epi32(t, _mm_srli_epi64(t, 32));
+		u = _mm_add_epi32(u, _mm_srli_epi64(u, 32));
+
+		sum[4*tap]   = -2*(uint32)_mm_cvtsi128_si32(t) - sre;
+		sum[4*tap+1] = -2*(uint32)_mm_cvtsi128_si32(u) - sim;
+		sum[4*tap+2] = -2*(uint32)_mm_cvtsi128_si32(_mm_srli_si128(t, 8)) - sre;
+		sum[4*tap+3] = -2*(uint32)_mm_cvtsi128_si32(_mm_srli_si128(u, 8)) - sim;
+	}
+
+	tail_wipe_accum_taps(&_A[cnt1], &_B[cnt1], _C, late, _inc, _spacing, _taps, _cnt - cnt1, _shift, round, &sum[0]);
+
+	for(tap = 0; tap < _taps; tap++)
+	{
+		_accum[tap].i = (int32)sum[2*tap];
+		_accum[tap].q = (int32)sum[2*tap+1];
+	}
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * avx512_wipe_accum_code: avx2_wipe_accum_code at 16 samples a pass
+ * */
+__attribute__ ((target("avx512f,avx512bw")))
+void avx512_wipe_accum_code(CPX *_A, CPX *_B, uint8 *_C, uint32 _phase, uint32 _inc, uint32 _spacing, int32 _cnt, int32 _shift, CPX_ACCUM *_accum)
+{
+
+	int32 lcv;
+	int32 cnt1;
+	int32 round;
+	uint32 late, step;
+	uint32 sum[6];
+	__m512i a, b, br, bq, re, im, x, c, code, index;
+	__m512i rnd, zero, one, offset, ke, kp, kl;
+	__m512i e, p, l;
+	__m128i shift;
+
+	cnt1 = _cnt & ~15;
+	round = 1 << (_shift-1);
+	step = _inc << 4;
+
+	late = _phase + CODE_NCO_WRAP - _spacing;
+	if(late >= CODE_NCO_WRAP)
+		late -= CODE_NCO_WRAP;
+
+	rnd = _mm512_set1_epi32(round);
+	shift = _mm_cvtsi32_si128(_shift);
+	zero = _mm512_setzero_si512();
+	one = _mm512_set1_epi32(1);
+
+	offset = _mm512_mullo_epi32(_mm512_set1_epi32((int)_inc), _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+	kl = _mm512_set1_epi32((32 << CODE_NCO_FRAC) - 1);
+	kp = _mm512_set1_epi32((int)((32 << CODE_NCO_FRAC) - 1 - _spacing));
+	ke = _mm512_set1_epi32((int)((32 << CODE_NCO_FRAC) - 1 - 2*_spacing));
+
+	e = zero;
+	p = zero;
+	l = zero;
+
+	for(lcv = 0; lcv < cnt1; lcv += 16)
+	{
+		a = _mm512_loadu_si512((void *)&_A[lcv]);
+		b = _mm512_loadu_si512((void *)&_B[lcv]);
+
+		br = _mm512_mask_sub_epi16(b, 0xAAAAAAAA, zero, b);	//[Re -Im]
+		bq = _mm512_rol_epi32(b, 16);							//[Im Re]
+
+		re = _mm512_sra_epi32(_mm512_add_epi32(_mm512_madd_epi16(a, br), rnd), shift);
+		im = _mm512_sra_epi32(_mm512_add_epi32(_mm512_madd_epi16(a, bq), rnd), shift);
+
+		x = _mm512_packs_epi32(re, im);
+
+		index = _mm512_add_epi32(offset, _mm512_set1_epi32((int)(late & ((8 << CODE_NCO_FRAC) - 1))));
+		code = _mm512_set1_epi32((int)code_bits(_C, (late >> CODE_NCO_FRAC) & ~7));
+
+		c = _mm512_srli_epi32(_mm512_sub_epi32(ke, index), CODE_NCO_FRAC);
+		c = _mm512_or_si512(_mm512_srai_epi32(_mm512_sllv_epi32(code, c), 31), one);
+		e = _mm512_add_epi32(e, _mm512_madd_epi16(x, _mm512_packs_epi32(c, c)));
+
+		c = _mm512_srli_epi32(_mm512_sub_epi32(kp, index), CODE_NCO_FRAC);
+		c = _mm512_or_si512(_mm512_srai_epi32(_mm512_sllv_epi32(code, c), 31), one);
+		p = _mm512_add_epi32(p, _mm512_madd_epi16(x, _mm512_packs_epi32(c, c)));
+
+		c = _mm512_srli_epi32(_mm512_sub_epi32(kl, index), CODE_NCO_FRAC);
+		c = _mm512_or_si512(_mm512_srai_epi32(_mm512_sllv_epi32(code, c), 31), one);
+		l = _mm512_add_epi32(l, _mm512_madd_epi16(x, _mm512_packs_epi32(c, c)));
+
+		late += step;
+		if(late >= CODE_NCO_WRAP)
+			late -= CODE_NCO_WRAP;
+	}
+
+	/* Each 128 bit lane is [Re Re Im Im] */
+	sum[0] = -(uint32)_mm512_mask_reduce_add_epi32(0x3333, e);
+	sum[1] = -(uint32)_mm512_mask_reduce_add_epi32(0xCCCC, e);
+	sum[2] = -(uint32)_mm512_mask_reduce_add_epi32(0x3333, p);
+	sum[3] = -(uint32)_mm512_mask_reduce_add_epi32(0xCCCC, p);
+	sum[4] = -(uint32)_mm512_mask_reduce_add_epi32(0x3333, l);
+	sum[5] = -(uint32)_mm512_mask_reduce_add_epi32(0xCCCC, l);
+
+	tail_wipe_accum_code(&_A[cnt1], &_B[cnt1], _C, late, _inc, _spacing, _cnt - cnt1, _shift, round, &sum[0]);
+
+	for(lcv = 0; lcv < 3; lcv++)
+	{
+		_accum[lcv].i = (int32)sum[2*lcv];
+		_accum[lcv].q = (int32)sum[2*lcv+1];
+	}
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * avx512_wipe_accum_taps: avx2_wipe_accum_taps at 16 samples a pass
+ * */
+__attribute__ ((target("avx512f,avx512bw")))
+void avx512_wipe_accum_taps(CPX *_A, CPX *_B, uint8 *_C, uint32 _phase, uint32 _inc, uint32 _spacing, int32 _taps, int32 _cnt, int32 _shift, CPX_ACCUM *_accum)
+{
+
+	int32 lcv, tap, pairs;
+	int32 cnt1;
+	int32 round;
+	uint32 late, step;
+	uint32 sre, sim;
+	uint32 sum[2*(MAX_TAPS+1)];
+	__m512i a, b, br, bq, re, im, xr, xi, m, code, index;
+	__m512i rnd, zero, ones, offset, x;
+	__m512i k[MAX_TAPS+1], tr[(MAX_TAPS+1)/2], ti[(MAX_TAPS+1)/2];
+	__m128i shift;
+
+	cnt1 = _cnt & ~15;
+	round = 1 << (_shift-1);
+	step = _inc << 4;
+	pairs = (_taps + 1) >> 1;
+
+	late = _phase + CODE_NCO_WRAP - (_taps >> 1)*_spacing;
+	if(late >= CODE_NCO_WRAP)
+		late -= CODE_NCO_WRAP;
+
+	rnd = _mm512_set1_epi32(round);
+	shift = _mm_cvtsi32_si128(_shift);
+	zero = _mm512_setzero_si512();
+	ones = _mm512_set1_epi16(1);
+
+	offset = _mm512_mullo_epi32(_mm512_set1_epi32((int)_inc), _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+	for(tap = 0; tap < 2*pairs; tap++)
+		k[tap] = _mm512_set1_epi32((int)((32 << CODE_NCO_FRAC) - 1 - (_taps - 1 - (tap < _taps ? tap : _taps - 1))*_spacing));
+
+	for(tap = 0; tap < pairs; tap++)
+	{
+		tr[tap] = zero;
+		ti[tap] = zero;
+	}
+	x = zero;
+
+	for(lcv = 0; lcv < cnt1; lcv += 16)
+	{
+		a = _mm512_loadu_si512((void *)&_A[lcv]);
+		b = _mm512_loadu_si512((void *)&_B[lcv]);
+
+		br = _mm512_mask_sub_epi16(b, 0xAAAAAAAA, zero, b);	//[Re -Im]
+		bq = _mm512_rol_epi32(b, 16);							//[Im Re]
+
+		re = _mm512_sra_epi32(_mm512_add_epi32(_mm512_madd_epi16(a, br), rnd), shift);
+		im = _mm512_sra_epi32(_mm512_add_epi32(_mm512_madd_epi16(a, bq), rnd), shift);
+
+		xr = _mm512_packs_epi32(re, re);
+		xi = _mm512_packs_epi32(im, im);
+		x = _mm512_add_epi32(x, _mm512_madd_epi16(_mm512_packs_epi32(re, im), ones));
+
+		index = _mm512_add_epi32(offset, _mm512_set1_epi32((int)(late & ((8 << CODE_NCO_FRAC) - 1))));
+		code = _mm512_set1_epi32((int)code_bits(_C, (late >> CODE_NCO_FRAC) & ~7));
+
+		for(tap = 0; tap < pairs; tap++)
+		{
+			m = _mm512_packs_epi32(_mm512_sllv_epi32(code, _mm512_srli_epi32(_mm512_sub_epi32(k[2*tap], index), CODE_NCO_FRAC)),
+								   _mm512_sllv_epi32(code, _mm512_srli_epi32(_mm512_sub_epi32(k[2*tap+1], index), CODE_NCO_FRAC)));
+			m = _mm512_srai_epi16(m, 15);
+
+			tr[tap] = _mm512_add_epi32(tr[tap], _mm512_madd_epi16(xr, m));
+			ti[tap] = _mm512_add_epi32(ti[tap], _mm512_madd_epi16(xi, m));
+		}
+
+		late += step;
+		if(late >= CODE_NCO_WRAP)
+			late -= CODE_NCO_WRAP;
+	}
+
+	/* Each 128 bit lane of the plain sum is [Re Re Im Im], of the masked sums [even even odd odd] */
+	sre = (uint32)_mm512_mask_reduce_add_epi32(0x3333, x);
+	sim = (uint32)_mm512_mask_reduce_add_epi32(0xCCCC, x);
+
+	for(tap = 0; tap < pairs; tap++)
+	{
+		sum[4*tap]   = -2*(uint32)_mm512_mask_reduce_add_epi32(0x3333, tr[tap]) - sre;
+		sum[4*tap+1] = -2*(uint32)_mm512_mask_reduce_add_epi32(0x3333, ti[tap]) - sim;
+		sum[4*tap+2] = -2*(uint32)_mm512_mask_reduce_add_epi32(0xCCCC, tr[tap]) - sre;
+		sum[4*tap+3] = -2*(uint32)_mm512_mask_reduce_add_epi32(0xCCCC, ti[tap]) - sim;
+	}
+
+	tail_wipe_accum_taps(&_A[cnt1], &_B[cnt1], _C, late, _inc, _spacing, _taps, _cnt - cnt1, _shift, round, &sum[0]);
+
+	for(tap = 0; tap < _taps; tap++)
+	{
+		_accum[tap].i = (int32)sum[2*tap];
+		_accum[tap].q = (int32)sum[2*tap+1];
+	}
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * avx2_dft: Same as sse_dft, 8 series a pass.
+ * */
+__attribute__ ((target("avx2")))
+void avx2_dft(CPX *_A, int32 _stride, MIX *_W, int32 _taps, CPX *_C, int32 _cnt)
+{
+
+	int32 lcv, tap;
+	int32 cnt1;
+	int wi, wq;
+	__m256i a, re, im, mask;
+	CPX *p;
+
+	cnt1 = _cnt & ~7;
+	mask = _mm256_set1_epi32(0xffff0000);
+
+	for(lcv = 0; lcv < cnt1; lcv += 8)
+	{
+		re = _mm256_setzero_si256();
+		im = _mm256_setzero_si256();
+		p = &_A[lcv];
+
+		for(tap = 0; tap < _taps; tap++)
+		{
+			a = _mm256_loadu_si256((__m256i *)p);
+			memcpy(&wi, &_W[tap].i, sizeof(wi));
+			memcpy(&wq, &_W[tap].q, sizeof(wq));
+			re = _mm256_add_epi32(re, _mm256_madd_epi16(a, _mm256_set1_epi32(wi)));	//[Re -Im]
+			im = _mm256_add_epi32(im, _mm256_madd_epi16(a, _mm256_set1_epi32(wq)));	//[Im Re]
+			p += _stride;
+		}
+
+		_mm256_storeu_si256((__m256i *)&_C[lcv], _mm256_or_si256(_mm256_srli_epi32(re, 16), _mm256_and_si256(im, mask)));
+	}
+
+	x86_dft(&_A[cnt1], _stride, _W, _taps, &_C[cnt1], _cnt - cnt1);
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * avx512_dft: Same as sse_dft, 16 series a pass.
+ * */
+__attribute__ ((target("avx512f,avx512bw")))
+void avx512_dft(CPX *_A, int32 _stride, MIX *_W, int32 _taps, CPX *_C, int32 _cnt)
+{
+
+	int32 lcv, tap;
+	int32 cnt1;
+	int wi, wq;
+	__m512i a, re, im, mask;
+	CPX *p;
+
+	cnt1 = _cnt & ~15;
+	mask = _mm512_set1_epi32(0xffff0000);
+
+	for(lcv = 0; lcv < cnt1; lcv += 16)
+	{
+		re = _mm512_setzero_si512();
+		im = _mm512_setzero_si512();
+		p = &_A[lcv];
+
+		for(tap = 0; tap < _taps; tap++)
+		{
+			a = _mm512_loadu_si512((void *)p);
+			memcpy(&wi, &_W[tap].i, sizeof(wi));
+			memcpy(&wq, &_W[tap].q, sizeof(wq));
+			re = _mm512_add_epi32(re, _mm512_madd_epi16(a, _mm512_set1_epi32(wi)));	//[Re -Im]
+			im = _mm512_add_epi32(im, _mm512_madd_epi16(a, _mm512_set1_epi32(wq)));	//[Im Re]
+			p += _stride;
+		}
+
+		_mm512_storeu_si512((void *)&_C[lcv], _mm512_or_si512(_mm512_srli_epi32(re, 16), _mm512_and_si512(im, mask)));
+	}
+
+	x86_dft(&_A[cnt1], _stride, _W, _taps, &_C[cnt1], _cnt - cnt1);
+
+}
+/*----------------------------------------------------------------------------------------------*/
@@ -23,6 +23,8 @@ Free Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1
 
 #include "includes.h"
 
+#include <cpuid.h>
+
 bool CPU_MMX()
 {
 	
@@ -157,40 +159,130 @@ bool CPU_SSE42()
 }
 
 
-void Init_SIMD()
+/*----------------------------------------------------------------------------------------------*/
+/* The AVX checks need leaf 7 and XGETBV, so they go through cpuid.h rather than the tricks above.
+ * A CPU bit is not enough, the OS also has to save the wider registers (XCR0) on a context switch. */
+static uint32 OS_XCR0()
 {
 
-//	if(CPU_SSE3())
-//	{
-//		simd_add = &sse_add;
-//		simd_sub = &sse_sub;
-//		simd_mul = &sse_mul;
-//		simd_dot = &sse_dot;
-//
-//		simd_conj = &sse_conj;
-//		simd_cacc = &sse_cacc;
-//		simd_cmul = &sse_cmul;
-//		simd_cmuls = &sse_cmuls;
-//		simd_cmulsc = &sse_cmulsc;	
-//	}
-//	else
-//	{
-//		simd_add = &x86_add;
-//		simd_sub = &x86_sub;
-//		simd_mul = &x86_mul;
-//		simd_dot = &x86_dot;
-//
-//		simd_conj = &x86_conj;
-//		simd_cacc = &x86_cacc;
-//		simd_cmul = &x86_cmul;
-//		simd_cmuls = &x86_cmuls;
-//		simd_cmulsc = &x86_cmulsc;
-//		
-//	}
-//	
-//	simd_cmag = &x86_cmag;
-//	simd_max = &x86_max;
-	
+	unsigned int eax, ebx, ecx, edx;
+	unsigned int lo, hi;
+
+	if(!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+		return(0);
+
+	/* OSXSAVE */
+	if(!(ecx & (1 << 27)))
+		return(0);
+
+	__asm volatile ("xgetbv" : "=a" (lo), "=d" (hi) : "c" (0));
+
+	return(lo);
+
+}
+
+
+bool CPU_AVX()
+{
+
+	unsigned int eax, ebx, ecx, edx;
+
+	if(!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+		return(false);
+
+	/* AVX, and the OS saves XMM and YMM state */
+	return((ecx & (1 << 28)) && ((OS_XCR0() & 0x6) == 0x6));
+
+}
+
+
+bool CPU_AVX2()
+{
+
+	unsigned int eax, ebx, ecx, edx;
+
+	if(!CPU_AVX())
+		return(false);
+
+	if(!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx))
+		return(false);
+
+	return((ebx & (1 << 5)) != 0);
+
+}
+
+
+bool CPU_AVX512()
+{
+
+	unsigned int eax, ebx, ecx, edx;
+
+	if(!CPU_AVX())
+		return(false);
+
+	/* Opmask and both halves of the ZMM state */
+	if((OS_XCR0() & 0xE6) != 0xE6)
+		return(false);
+
+	if(!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx))
+		return(false);
+
+	/* AVX-512F and AVX-512BW */
+	return((ebx & (1 << 16)) && (ebx & (1 << 30)));
 
 }
+/*----------------------------------------------------------------------------------------------*/
+
 
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * Init_SIMD: Point the kernel table at the widest version this machine can run. Call it once at
+ * startup, before any thread uses the simd_ pointers. Without SSE2 it falls back to the plain x86
+ * versions.
+ * */
+void Init_SIMD()
+{
+
+	if(CPU_AVX512())
+	{
+		simd_cmulsc = &avx512_cmulsc;
+		simd_nco = &avx512_nco;
+		simd_wipe_accum_code = &avx512_wipe_accum_code;
+		simd_wipe_accum_taps = &avx512_wipe_accum_taps;
+		simd_dft = &avx512_dft;
+		simd_agc = &sse_agc;	/* Memory bound, nothing to gain from wider */
+		simd_level = "AVX-512";
+	}
+	else if(CPU_AVX2())
+	{
+		simd_cmulsc = &avx2_cmulsc;
+		simd_nco = &avx2_nco;
+		simd_wipe_accum_code = &avx2_wipe_accum_code;
+		simd_wipe_accum_taps = &avx2_wipe_accum_taps;
+		simd_dft = &avx2_dft;
+		simd_agc = &sse_agc;
+		simd_level = "AVX2";
+	}
+	else if(CPU_SSE2())
+	{
+		simd_cmulsc = &sse_cmulsc;
+		simd_nco = &x86_nco;	/* No gather before AVX2 */
+		simd_wipe_accum_code = &sse_wipe_accum_code;
+		simd_wipe_accum_taps = &sse_wipe_accum_taps;
+		simd_dft = &sse_dft;
+		simd_agc = &sse_agc;
+		simd_level = "SSE";
+	}
+	else
+	{
+		simd_cmulsc = &x86_cmulsc;
+		simd_nco = &x86_nco;
+		simd_wipe_accum_code = &x86_wipe_accum_code;
+		simd_wipe_accum_taps = &x86_wipe_accum_taps;
+		simd_dft = &x86_dft;
+		simd_agc = &x86_agc;
+		simd_level = "x86";
+	}
+
+}
+/*----------------------------------------------------------------------------------------------*/
@@ -102,6 +102,37 @@ void fill_prn_new(MIX *_vect, int32 _samps)
 
 }
 
+void fill_code(uint8 *_code)
+{
+	int32 lcv;
+
+	/* A random code period, with the wrapped chips at the end like the correlator code table */
+	for(lcv = 0; lcv < CODE_NCO_BYTES; lcv++)
+		_code[lcv] = (uint8)rand();
+
+	for(lcv = CODE_CHIPS; lcv < 8*CODE_NCO_BYTES; lcv++)
+	{
+		if((_code[(lcv - CODE_CHIPS) >> 3] >> ((lcv - CODE_CHIPS) & 7)) & 0x1)
+			_code[lcv >> 3] |= 1 << (lcv & 7);
+		else
+			_code[lcv >> 3] &= ~(1 << (lcv & 7));
+	}
+
+}
+
+void pack_prn(MIX *_vect, uint8 *_bits, int32 _offset, int32 _samps)
+{
+	int32 lcv;
+
+	/* Same layout as the correlator code rows, a set bit is a +1 chip */
+	memset(_bits, 0x0, (_offset + _samps)/8 + 5);
+
+	for(lcv = 0; lcv < _samps; lcv++)
+		if(_vect[lcv].i == 0x0001)
+			_bits[(_offset + lcv) >> 3] |= 1 << ((_offset + lcv) & 7);
+
+}
+
 int main(int32 argc, char* argv[])
 {
 
@@ -115,10 +146,15 @@ int main(int32 argc, char* argv[])
 	MIX *testvectf;
 	MIX *testvectg;
 	MIX *testvecth;
+	uint8 *testbitsf;
+	uint8 *testbitsg;
+	uint8 *testbitsh;
+	uint8 *testcode;
 
 	int32 err;
 	int32 lcv;
 	int32 lcv2;
+	int32 lcv3;
 	int32 pts;
 	int32 val1;
 	int32 val2;
@@ -136,6 +172,11 @@ int main(int32 argc, char* argv[])
 	testvectg = new MIX[VECTSIZE];
 	testvecth = new MIX[VECTSIZE];
 
+	testbitsf = new uint8[VECTSIZE/8 + 8];
+	testbitsg = new uint8[VECTSIZE/8 + 8];
+	testbitsh = new uint8[VECTSIZE/8 + 8];
+	testcode = new uint8[CODE_NCO_BYTES];
+
 
 
 	/* SIMD ADD */
@@ -423,6 +464,59 @@ int main(int32 argc, char* argv[])
 	/*----------------------------------------------------------------------------------------------*/
 
 
+	/* SIMD AGC */
+	/*----------------------------------------------------------------------------------------------*/
+	err = 0;
+
+	for(lcv = 0; lcv < REPEATS; lcv++)
+	{
+
+		pts = rand() % VECTSIZE;
+		val1 = (rand() % (1 << 14)) + 1;
+
+		/* Small shifts make it saturate */
+		shift = rand() % (15 - AGC_BITS);
+
+		fill_vect(testvecta, pts);
+
+		ai1 = x86_agc(testvecta, testvectc, pts, val1, shift, 1 << AGC_BITS);
+		ai2 = sse_agc(testvecta, testvectd, pts, val1, shift, 1 << AGC_BITS);
+
+		if(ai1 != ai2)
+			err++;
+
+		for(lcv2 = 0; lcv2 < pts; lcv2++)
+		{
+			if(testvectc[lcv2].i != testvectd[lcv2].i)
+				err++;
+
+			if(testvectc[lcv2].q != testvectd[lcv2].q)
+				err++;
+		}
+
+		/* And in place */
+		ai2 = sse_agc(testvecta, testvecta, pts, val1, shift, 1 << AGC_BITS);
+
+		if(ai1 != ai2)
+			err++;
+
+		for(lcv2 = 0; lcv2 < pts; lcv2++)
+		{
+			if(testvectc[lcv2].i != testvecta[lcv2].i)
+				err++;
+
+			if(testvectc[lcv2].q != testvecta[lcv2].q)
+				err++;
+		}
+
+	}
+	if(err)
+		printf("CPX AGC \t\t\tFAILED: %d\n",err);
+	else
+		printf("CPX AGC \t\t\tPASSED\n",err);
+	/*----------------------------------------------------------------------------------------------*/
+
+
 	/* SIMD CACC */
 	/*----------------------------------------------------------------------------------------------*/
 	err = 0;
@@ -549,6 +643,523 @@ int main(int32 argc, char* argv[])
 		printf("CPX PRN ACCUM NEW\t\tPASSED\n",err);
 	/*----------------------------------------------------------------------------------------------*/
 
+	/* SIMD wipeoff and accum in one pass, against the two pass version */
+	/*----------------------------------------------------------------------------------------------*/
+	err = 0;
+
+	for(lcv = 0; lcv < REPEATS; lcv++)
+	{
+
+		CPX_ACCUM caccuma[3];
+		CPX_ACCUM caccumb[3];
+		CPX_ACCUM caccumc[3];
+		CPX_ACCUM caccumd[3];
+
+		pts = rand() % VECTSIZE;
+
+		fill_vect(testvecta, pts);
+		fill_vect(testvectb, pts);
+
+		fill_prn_new(testvectf, pts);
+		fill_prn_new(testvectg, pts);
+		fill_prn_new(testvecth, pts);
+
+		x86_cmulsc(testvecta, testvectb, testvectc, pts, 5);
+		x86_prn_accum_new(testvectc, testvectf, testvectg, testvecth, pts, &caccuma[0]);
+		x86_wipe_accum(testvecta, testvectb, testvectf, testvectg, testvecth, pts, 5, &caccumb[0]);
+
+		sse_cmulsc(testvecta, testvectb, testvectd, pts, 5);
+		sse_prn_accum_new(testvectd, testvectf, testvectg, testvecth, pts, &caccumc[0]);
+		sse_wipe_accum(testvecta, testvectb, testvectf, testvectg, testvecth, pts, 5, &caccumd[0]);
+
+		for(lcv2 = 0; lcv2 < 3; lcv2++)
+		{
+			if(caccuma[lcv2].i != caccumb[lcv2].i)
+				err++;
+
+			if(caccuma[lcv2].q != caccumb[lcv2].q)
+				err++;
+
+			if(caccumc[lcv2].i != caccumd[lcv2].i)
+				err++;
+
+			if(caccumc[lcv2].q != caccumd[lcv2].q)
+				err++;
+		}
+
+	}
+	if(err)
+		printf("CPX WIPE ACCUM \t\t\tFAILED: %d\n",err);
+	else
+		printf("CPX WIPE ACCUM \t\t\tPASSED\n");
+	/*----------------------------------------------------------------------------------------------*/
+
+
+	/* SIMD wipeoff and accum with a bit packed code, against the MIX code version */
+	/*----------------------------------------------------------------------------------------------*/
+	err = 0;
+
+	for(lcv = 0; lcv < REPEATS; lcv++)
+	{
+
+		CPX_ACCUM caccuma[3];
+		CPX_ACCUM caccumb[3];
+		CPX_ACCUM caccumc[3];
+		CPX_ACCUM caccumd[3];
+		int32 offset;
+
+		pts = rand() % VECTSIZE;
+		offset = rand() % 8;
+
+		fill_vect(testvecta, pts);
+		fill_vect(testvectb, pts);
+
+		fill_prn_new(testvectf, pts);
+		fill_prn_new(testvectg, pts);
+		fill_prn_new(testvecth, pts);
+
+		pack_prn(testvectf, testbitsf, offset, pts);
+		pack_prn(testvectg, testbitsg, offset, pts);
+		pack_prn(testvecth, testbitsh, offset, pts);
+
+		x86_wipe_accum(testvecta, testvectb, testvectf, testvectg, testvecth, pts, 5, &caccuma[0]);
+		x86_wipe_accum_bits(testvecta, testvectb, testbitsf, testbitsg, testbitsh, offset, pts, 5, &caccumb[0]);
+
+		sse_wipe_accum(testvecta, testvectb, testvectf, testvectg, testvecth, pts, 5, &caccumc[0]);
+		sse_wipe_accum_bits(testvecta, testvectb, testbitsf, testbitsg, testbitsh, offset, pts, 5, &caccumd[0]);
+
+		for(lcv2 = 0; lcv2 < 3; lcv2++)
+		{
+			if(caccuma[lcv2].i != caccumb[lcv2].i)
+				err++;
+
+			if(caccuma[lcv2].q != caccumb[lcv2].q)
+				err++;
+
+			if(caccumc[lcv2].i != caccumd[lcv2].i)
+				err++;
+
+			if(caccumc[lcv2].q != caccumd[lcv2].q)
+				err++;
+		}
+
+	}
+	if(err)
+		printf("CPX WIPE ACCUM BITS \t\tFAILED: %d\n",err);
+	else
+		printf("CPX WIPE ACCUM BITS \t\tPASSED\n");
+	/*----------------------------------------------------------------------------------------------*/
+
+
+	/* SIMD wipeoff and accum against the code NCO, against the code NCO rows and the bit version */
+	/*----------------------------------------------------------------------------------------------*/
+	err = 0;
+
+	for(lcv = 0; lcv < REPEATS; lcv++)
+	{
+
+		CPX_ACCUM caccuma[3];
+		CPX_ACCUM caccumb[3];
+		CPX_ACCUM caccumc[3];
+		CPX_ACCUM caccumd[3];
+		uint32 phase, inc, spacing, pe, pl;
+
+		pts = rand() % VECTSIZE;
+
+		/* Random phase, a step around the code rate and up to a chip of spacing */
+		phase = (((uint32)rand() << 16) ^ (uint32)rand()) % CODE_NCO_WRAP;
+		inc = (uint32)((double)(1 << CODE_NCO_FRAC)*(0.25 + (double)rand()/(double)RAND_MAX));
+		spacing = (uint32)rand() % (1 << CODE_NCO_FRAC);
+
+		pe = (phase + spacing) % CODE_NCO_WRAP;
+		pl = (phase + CODE_NCO_WRAP - spacing) % CODE_NCO_WRAP;
+
+		fill_vect(testvecta, pts);
+		fill_vect(testvectb, pts);
+		fill_code(testcode);
+
+		x86_code_nco(testcode, testbitsf, pe, inc, pts);
+		x86_code_nco(testcode, testbitsg, phase, inc, pts);
+		x86_code_nco(testcode, testbitsh, pl, inc, pts);
+
+		x86_wipe_accum_bits(testvecta, testvectb, testbitsf, testbitsg, testbitsh, 0, pts, 5, &caccuma[0]);
+		x86_wipe_accum_code(testvecta, testvectb, testcode, phase, inc, spacing, pts, 5, &caccumb[0]);
+
+		sse_wipe_accum_bits(testvecta, testvectb, testbitsf, testbitsg, testbitsh, 0, pts, 5, &caccumc[0]);
+		sse_wipe_accum_code(testvecta, testvectb, testcode, phase, inc, spacing, pts, 5, &caccumd[0]);
+
+		for(lcv2 = 0; lcv2 < 3; lcv2++)
+		{
+			if(caccuma[lcv2].i != caccumb[lcv2].i)
+				err++;
+
+			if(caccuma[lcv2].q != caccumb[lcv2].q)
+				err++;
+
+			if(caccumc[lcv2].i != caccumd[lcv2].i)
+				err++;
+
+			if(caccumc[lcv2].q != caccumd[lcv2].q)
+				err++;
+		}
+
+	}
+	if(err)
+		printf("CPX WIPE ACCUM CODE \t\tFAILED: %d\n",err);
+	else
+		printf("CPX WIPE ACCUM CODE \t\tPASSED\n");
+	/*----------------------------------------------------------------------------------------------*/
+
+
+	/* SIMD wipeoff and accum against a bank of code delays, each tap against its own code NCO row */
+	/*----------------------------------------------------------------------------------------------*/
+	err = 0;
+
+	for(lcv = 0; lcv < REPEATS; lcv++)
+	{
+
+		CPX_ACCUM caccuma[3];
+		CPX_ACCUM caccumb[MAX_TAPS];
+		CPX_ACCUM caccumc[MAX_TAPS];
+		uint32 phase, inc, spacing, pt;
+		int32 taps;
+
+		pts = rand() % VECTSIZE;
+
+		/* Any odd bank that fits in MAX_TAP_SPAN, around the code rate as the bank has to fit in one code word */
+		taps = 2*(rand() % (MAX_TAPS/2)) + 3;
+		phase = (((uint32)rand() << 16) ^ (uint32)rand()) % CODE_NCO_WRAP;
+		inc = (uint32)((double)(1 << CODE_NCO_FRAC)*(0.45 + 0.08*(double)rand()/(double)RAND_MAX));
+		spacing = (uint32)rand() % (((uint32)MAX_TAP_SPAN << CODE_NCO_FRAC)/(taps - 1));
+
+		fill_vect(testvecta, pts);
+		fill_vect(testvectb, pts);
+		fill_code(testcode);
+
+		x86_wipe_accum_taps(testvecta, testvectb, testcode, phase, inc, spacing, taps, pts, 5, &caccumb[0]);
+		sse_wipe_accum_taps(testvecta, testvectb, testcode, phase, inc, spacing, taps, pts, 5, &caccumc[0]);
+
+		for(lcv2 = 0; lcv2 < taps; lcv2++)
+		{
+			pt = (phase + CODE_NCO_WRAP + ((taps >> 1) - lcv2)*spacing) % CODE_NCO_WRAP;
+			x86_code_nco(testcode, testbitsg, pt, inc, pts);
+			x86_wipe_accum_bits(testvecta, testvectb, testbitsg, testbitsg, testbitsg, 0, pts, 5, &caccuma[0]);
+
+			if(caccuma[0].i != caccumb[lcv2].i)
+				err++;
+
+			if(caccuma[0].q != caccumb[lcv2].q)
+				err++;
+
+			if(caccumb[lcv2].i != caccumc[lcv2].i)
+				err++;
+
+			if(caccumb[lcv2].q != caccumc[lcv2].q)
+				err++;
+		}
+
+	}
+	if(err)
+		printf("CPX WIPE ACCUM TAPS \t\tFAILED: %d\n",err);
+	else
+		printf("CPX WIPE ACCUM TAPS \t\tPASSED\n");
+	/*----------------------------------------------------------------------------------------------*/
+
+
+	/* Post correlation DFT, each series gathered and run through x86_cacc */
+	/*----------------------------------------------------------------------------------------------*/
+	err = 0;
+
+	for(lcv = 0; lcv < REPEATS; lcv++)
+	{
+
+		CPX series[16];
+		int32 taps, stride, iaccum, qaccum;
+
+		taps = (rand() % 16) + 1;
+		stride = VECTSIZE/taps;
+		pts = rand() % stride;
+
+		fill_vect(testvecta, VECTSIZE);
+		fill_vect((CPX *)testvectf, 2*taps);
+
+		x86_dft(testvecta, stride, testvectf, taps, testvectc, pts);
+		sse_dft(testvecta, stride, testvectf, taps, testvectd, pts);
+
+		for(lcv2 = 0; lcv2 < pts; lcv2++)
+		{
+			for(lcv3 = 0; lcv3 < taps; lcv3++)
+				series[lcv3] = testvecta[lcv3*stride + lcv2];
+
+			x86_cacc(series, testvectf, taps, &iaccum, &qaccum);
+
+			if(testvectc[lcv2].i != (int16)(iaccum >> 16))
+				err++;
+
+			if(testvectc[lcv2].q != (int16)(qaccum >> 16))
+				err++;
+
+			if(testvectc[lcv2].i != testvectd[lcv2].i)
+				err++;
+
+			if(testvectc[lcv2].q != testvectd[lcv2].q)
+				err++;
+		}
+
+	}
+	if(err)
+		printf("CPX DFT \t\t\tFAILED: %d\n",err);
+	else
+		printf("CPX DFT \t\t\tPASSED\n");
+	/*----------------------------------------------------------------------------------------------*/
+
+
+	/* AVX2 and AVX-512 against SSE, odd lengths so the leftover code gets hit */
+	/*----------------------------------------------------------------------------------------------*/
+	for(lcv3 = 0; lcv3 < 2; lcv3++)
+	{
+
+		void (*cmulsc)(CPX *, CPX *, CPX *, int32, int32);
+		void (*nco)(CPX *, CPX *, uint32, uint32, int32);
+		void (*wipe_accum_code)(CPX *, CPX *, uint8 *, uint32, uint32, uint32, int32, int32, CPX_ACCUM *);
+		void (*wipe_accum_taps)(CPX *, CPX *, uint8 *, uint32, uint32, uint32, int32, int32, int32, CPX_ACCUM *);
+		void (*dft)(CPX *, int32, MIX *, int32, CPX *, int32);
+		const char *name;
+
+		if(lcv3 == 0)
+		{
+			if(!CPU_AVX2())
+			{
+				printf("AVX2 \t\t\t\tNOT PRESENT\n");
+				continue;
+			}
+			cmulsc = &avx2_cmulsc;
+			nco = &avx2_nco;
+			wipe_accum_code = &avx2_wipe_accum_code;
+			wipe_accum_taps = &avx2_wipe_accum_taps;
+			dft = &avx2_dft;
+			name = "AVX2  ";
+		}
+		else
+		{
+			if(!CPU_AVX512())
+			{
+				printf("AVX-512 \t\t\tNOT PRESENT\n");
+				continue;
+			}
+			cmulsc = &avx512_cmulsc;
+			nco = &avx512_nco;
+			wipe_accum_code = &avx512_wipe_accum_code;
+			wipe_accum_taps = &avx512_wipe_accum_taps;
+			dft = &avx512_dft;
+			name = "AVX512";
+		}
+
+		/* Full scale inputs, so the saturation has to match too */
+		err = 0;
+
+		for(lcv = 0; lcv < REPEATS; lcv++)
+		{
+
+			pts = rand() % VECTSIZE;
+			shift = (rand() % 14) + 1;
+
+			for(lcv2 = 0; lcv2 < pts; lcv2++)
+			{
+				testvecta[lcv2].i = (int16)rand();
+				testvecta[lcv2].q = (int16)rand();
+				testvectb[lcv2].i = (int16)rand();
+				testvectb[lcv2].q = (int16)rand();
+			}
+
+			sse_cmulsc(testvecta, testvectb, testvectc, pts, shift);
+			cmulsc(testvecta, testvectb, testvectd, pts, shift);
+
+			for(lcv2 = 0; lcv2 < pts; lcv2++)
+			{
+				if(testvectc[lcv2].i != testvectd[lcv2].i)
+					err++;
+
+				if(testvectc[lcv2].q != testvectd[lcv2].q)
+					err++;
+			}
+
+		}
+		if(err)
+			printf("%s CPX MUL SHIFT PRESERVE \tFAILED: %d\n",name,err);
+		else
+			printf("%s CPX MUL SHIFT PRESERVE \tPASSED\n",name);
+
+		/* Full scale inputs against the code NCO */
+		err = 0;
+
+		for(lcv = 0; lcv < REPEATS; lcv++)
+		{
+
+			CPX_ACCUM caccuma[3];
+			CPX_ACCUM caccumb[3];
+			uint32 phase, inc, spacing;
+
+			pts = rand() % VECTSIZE;
+			shift = (rand() % 14) + 1;
+
+			phase = (((uint32)rand() << 16) ^ (uint32)rand()) % CODE_NCO_WRAP;
+			inc = (uint32)((double)(1 << CODE_NCO_FRAC)*(0.25 + (double)rand()/(double)RAND_MAX));
+			spacing = (uint32)rand() % (1 << CODE_NCO_FRAC);
+
+			for(lcv2 = 0; lcv2 < pts; lcv2++)
+			{
+				testvecta[lcv2].i = (int16)rand();
+				testvecta[lcv2].q = (int16)rand();
+				testvectb[lcv2].i = (int16)rand();
+				testvectb[lcv2].q = (int16)rand();
+			}
+
+			fill_code(testcode);
+
+			sse_wipe_accum_code(testvecta, testvectb, testcode, phase, inc, spacing, pts, shift, &caccuma[0]);
+			wipe_accum_code(testvecta, testvectb, testcode, phase, inc, spacing, pts, shift, &caccumb[0]);
+
+			for(lcv2 = 0; lcv2 < 3; lcv2++)
+			{
+				if(caccuma[lcv2].i != caccumb[lcv2].i)
+					err++;
+
+				if(caccuma[lcv2].q != caccumb[lcv2].q)
+					err++;
+			}
+
+		}
+		if(err)
+			printf("%s CPX WIPE ACCUM CODE \t\tFAILED: %d\n",name,err);
+		else
+			printf("%s CPX WIPE ACCUM CODE \t\tPASSED\n",name);
+
+		/* Full scale inputs against a bank of code delays */
+		err = 0;
+
+		for(lcv = 0; lcv < REPEATS; lcv++)
+		{
+
+			CPX_ACCUM caccuma[MAX_TAPS];
+			CPX_ACCUM caccumb[MAX_TAPS];
+			uint32 phase, inc, spacing;
+			int32 taps;
+
+			pts = rand() % VECTSIZE;
+			shift = (rand() % 14) + 1;
+
+			taps = 2*(rand() % (MAX_TAPS/2)) + 3;
+			phase = (((uint32)rand() << 16) ^ (uint32)rand()) % CODE_NCO_WRAP;
+			inc = (uint32)((double)(1 << CODE_NCO_FRAC)*(0.45 + 0.08*(double)rand()/(double)RAND_MAX));
+			spacing = (uint32)rand() % (((uint32)MAX_TAP_SPAN << CODE_NCO_FRAC)/(taps - 1));
+
+			for(lcv2 = 0; lcv2 < pts; lcv2++)
+			{
+				testvecta[lcv2].i = (int16)rand();
+				testvecta[lcv2].q = (int16)rand();
+				testvectb[lcv2].i = (int16)rand();
+				testvectb[lcv2].q = (int16)rand();
+			}
+
+			fill_code(testcode);
+
+			sse_wipe_accum_taps(testvecta, testvectb, testcode, phase, inc, spacing, taps, pts, shift, &caccuma[0]);
+			wipe_accum_taps(testvecta, testvectb, testcode, phase, inc, spacing, taps, pts, shift, &caccumb[0]);
+
+			for(lcv2 = 0; lcv2 < taps; lcv2++)
+			{
+				if(caccuma[lcv2].i != caccumb[lcv2].i)
+					err++;
+
+				if(caccuma[lcv2].q != caccumb[lcv2].q)
+					err++;
+			}
+
+		}
+		if(err)
+			printf("%s CPX WIPE ACCUM TAPS \t\tFAILED: %d\n",name,err);
+		else
+			printf("%s CPX WIPE ACCUM TAPS \t\tPASSED\n",name);
+
+		/* Full scale inputs and coefficients, so the sums wrap */
+		err = 0;
+
+		for(lcv = 0; lcv < REPEATS; lcv++)
+		{
+
+			int32 taps, stride;
+
+			taps = (rand() % 16) + 1;
+			stride = VECTSIZE/taps;
+			pts = rand() % stride;
+
+			for(lcv2 = 0; lcv2 < VECTSIZE; lcv2++)
+			{
+				testvecta[lcv2].i = (int16)rand();
+				testvecta[lcv2].q = (int16)rand();
+			}
+
+			for(lcv2 = 0; lcv2 < taps; lcv2++)
+			{
+				testvectf[lcv2].i = testvectf[lcv2].ni = (int16)rand();
+				testvectf[lcv2].q = (int16)rand();
+				testvectf[lcv2].nq = -testvectf[lcv2].q;
+			}
+
+			sse_dft(testvecta, stride, testvectf, taps, testvectc, pts);
+			dft(testvecta, stride, testvectf, taps, testvectd, pts);
+
+			for(lcv2 = 0; lcv2 < pts; lcv2++)
+			{
+				if(testvectc[lcv2].i != testvectd[lcv2].i)
+					err++;
+
+				if(testvectc[lcv2].q != testvectd[lcv2].q)
+					err++;
+			}
+
+		}
+		if(err)
+			printf("%s CPX DFT \t\t\tFAILED: %d\n",name,err);
+		else
+			printf("%s CPX DFT \t\t\tPASSED\n",name);
+
+		/* Random phase and step, so the phase wraps inside the vector */
+		err = 0;
+
+		fill_vect(testvecte, CARRIER_LUT_SIZE);
+
+		for(lcv = 0; lcv < REPEATS; lcv++)
+		{
+
+			uint32 phase, inc;
+
+			pts = rand() % VECTSIZE;
+			phase = ((uint32)rand() << 16) ^ (uint32)rand();
+			inc = ((uint32)rand() << 16) ^ (uint32)rand();
+
+			x86_nco(testvectc, testvecte, phase, inc, pts);
+			nco(testvectd, testvecte, phase, inc, pts);
+
+			for(lcv2 = 0; lcv2 < pts; lcv2++)
+			{
+				if(testvectc[lcv2].i != testvectd[lcv2].i)
+					err++;
+
+				if(testvectc[lcv2].q != testvectd[lcv2].q)
+					err++;
+			}
+
+		}
+		if(err)
+			printf("%s CPX NCO \t\t\tFAILED: %d\n",name,err);
+		else
+			printf("%s CPX NCO \t\t\tPASSED\n",name);
+
+	}
+	/*----------------------------------------------------------------------------------------------*/
+
 	delete [] testvecta;
 	delete [] testvectb;
 	delete [] testvectc;
@@ -557,6 +1168,10 @@ int main(int32 argc, char* argv[])
 	delete [] testvectf;
 	delete [] testvectg;
 	delete [] testvecth;
+	delete [] testbitsf;
+	delete [] testbitsg;
+	delete [] testbitsh;
+	delete [] testcode;
 
 	return(1);
 
@@ -42,6 +42,9 @@ bool CPU_SSE3();	//!< Does the CPU support SSE3?
 bool CPU_SSSE3();	//!< Does the CPU support SSSE3? No thats not a typo!
 bool CPU_SSE41();	//!< Does the CPU support SSE4.1?
 bool CPU_SSE42();	//!< Does the CPU support SSE4.2?
+bool CPU_AVX();		//!< Does the CPU (and OS) support AVX?
+bool CPU_AVX2();	//!< Does the CPU (and OS) support AVX2?
+bool CPU_AVX512();	//!< Does the CPU (and OS) support AVX-512F and AVX-512BW?
 void Init_SIMD();	//!< Initialize the global function pointers
 /*----------------------------------------------------------------------------------------------*/
 
@@ -60,6 +63,12 @@ void  sse_cmulsc(CPX *A, CPX *B, CPX *C, int32 cnt, int32 shift) __attribute__ (
 void  sse_prn_accum(CPX *A, CPX *E, CPX *P, CPX *L, int32 cnt, CPX *accum) __attribute__ ((noinline));  //!< This is a long story
 void  sse_prn_accum_new(CPX *A, MIX *E, MIX *P, MIX *L, int32 cnt, CPX_ACCUM *accum) __attribute__ ((noinline));  //!< This is a long story
 void  sse_max(int32 *_A, int32 *_index, int32 *_magt, int32 _cnt) __attribute__ ((noinline));
+int32 sse_agc(CPX *A, CPX *B, int32 cnt, int32 scale, int32 shift, int32 max) __attribute__ ((noinline));	//!< Scale, saturate and count overflows, dump results into B
+void  sse_wipe_accum(CPX *A, CPX *B, MIX *E, MIX *P, MIX *L, int32 cnt, int32 shift, CPX_ACCUM *accum) __attribute__ ((noinline));	//!< cmulsc and prn_accum_new in one pass, only simd-test uses it now
+void  sse_wipe_accum_bits(CPX *A, CPX *B, uint8 *E, uint8 *P, uint8 *L, int32 offset, int32 cnt, int32 shift, CPX_ACCUM *accum);	//!< wipe_accum with bit packed codes applied as a sign, simd-test checks the code NCO kernels against it
+void  sse_wipe_accum_code(CPX *A, CPX *B, uint8 *C, uint32 phase, uint32 inc, uint32 spacing, int32 cnt, int32 shift, CPX_ACCUM *accum);	//!< wipe_accum_bits with E/P/L made on the fly by the code NCO
+void  sse_wipe_accum_taps(CPX *A, CPX *B, uint8 *C, uint32 phase, uint32 inc, uint32 spacing, int32 taps, int32 cnt, int32 shift, CPX_ACCUM *accum);	//!< wipe_accum_code for a bank of taps code delays, the wipeoff shared by all of them
+void  sse_dft(CPX *A, int32 stride, MIX *W, int32 taps, CPX *C, int32 cnt);		//!< x86_dft, 4 series at a time
 /*----------------------------------------------------------------------------------------------*/
 
 /* Found in x86.cpp */
@@ -78,6 +87,39 @@ void  x86_cmag(CPX *A, int32 cnt);											//!< Convert from complex to a powe
 void  x86_prn_accum(CPX *A, CPX *E, CPX *P, CPX *L, int32 cnt, CPX *accum);  //!< This is a long story
 void  x86_prn_accum_new(CPX *A, MIX *E, MIX *P, MIX *L, int32 cnt, CPX_ACCUM *accum);  //!< This is a long story
 void  x86_max(int32 *_A, int32 *_index, int32 *_magt, int32 _cnt);
+int32 x86_agc(CPX *A, CPX *B, int32 cnt, int32 scale, int32 shift, int32 max);	//!< Scale, saturate and count overflows, dump results into B
+void  x86_wipe_accum(CPX *A, CPX *B, MIX *E, MIX *P, MIX *L, int32 cnt, int32 shift, CPX_ACCUM *accum);	//!< cmulsc and prn_accum_new in one pass
+void  x86_wipe_accum_bits(CPX *A, CPX *B, uint8 *E, uint8 *P, uint8 *L, int32 offset, int32 cnt, int32 shift, CPX_ACCUM *accum);	//!< wipe_accum with bit packed codes applied as a sign
+void  x86_nco(CPX *A, CPX *LUT, uint32 phase, uint32 inc, int32 cnt);		//!< Carrier NCO, phase accumulator into a sine lookup
+void  x86_code_nco(uint8 *C, uint8 *A, uint32 phase, uint32 inc, int32 cnt);	//!< Code NCO, fixed point chip phase into a bit packed code, bit packed replica out
+void  x86_wipe_accum_code(CPX *A, CPX *B, uint8 *C, uint32 phase, uint32 inc, uint32 spacing, int32 cnt, int32 shift, CPX_ACCUM *accum);	//!< wipe_accum_bits with E/P/L from the code NCO, +-spacing around phase
+void  x86_wipe_accum_taps(CPX *A, CPX *B, uint8 *C, uint32 phase, uint32 inc, uint32 spacing, int32 taps, int32 cnt, int32 shift, CPX_ACCUM *accum);	//!< wipe_accum_code for a bank of taps code delays spaced spacing apart, prompt in the middle
+void  x86_dft(CPX *A, int32 stride, MIX *W, int32 taps, CPX *C, int32 cnt);	//!< One bin of a taps point DFT for cnt series stored stride apart
+/*----------------------------------------------------------------------------------------------*/
+
+/* Found in AVX.cpp */
+/*----------------------------------------------------------------------------------------------*/
+void  avx2_cmulsc(CPX *A, CPX *B, CPX *C, int32 cnt, int32 shift);							//!< sse_cmulsc, 8 samples at a time
+void  avx512_cmulsc(CPX *A, CPX *B, CPX *C, int32 cnt, int32 shift);						//!< sse_cmulsc, 16 samples at a time
+void  avx2_nco(CPX *A, CPX *LUT, uint32 phase, uint32 inc, int32 cnt);						//!< x86_nco, 8 samples at a time
+void  avx512_nco(CPX *A, CPX *LUT, uint32 phase, uint32 inc, int32 cnt);					//!< x86_nco, 16 samples at a time
+void  avx2_wipe_accum_code(CPX *A, CPX *B, uint8 *C, uint32 phase, uint32 inc, uint32 spacing, int32 cnt, int32 shift, CPX_ACCUM *accum);	//!< sse_wipe_accum_code, 8 samples at a time
+void  avx512_wipe_accum_code(CPX *A, CPX *B, uint8 *C, uint32 phase, uint32 inc, uint32 spacing, int32 cnt, int32 shift, CPX_ACCUM *accum);	//!< sse_wipe_accum_code, 16 samples at a time
+void  avx2_wipe_accum_taps(CPX *A, CPX *B, uint8 *C, uint32 phase, uint32 inc, uint32 spacing, int32 taps, int32 cnt, int32 shift, CPX_ACCUM *accum);	//!< sse_wipe_accum_taps, 8 samples at a time
+void  avx512_wipe_accum_taps(CPX *A, CPX *B, uint8 *C, uint32 phase, uint32 inc, uint32 spacing, int32 taps, int32 cnt, int32 shift, CPX_ACCUM *accum);	//!< sse_wipe_accum_taps, 16 samples at a time
+void  avx2_dft(CPX *A, int32 stride, MIX *W, int32 taps, CPX *C, int32 cnt);					//!< sse_dft, 8 series at a time
+void  avx512_dft(CPX *A, int32 stride, MIX *W, int32 taps, CPX *C, int32 cnt);					//!< sse_dft, 16 series at a time
+/*----------------------------------------------------------------------------------------------*/
+
+/* Function pointers, pointed at the widest version the CPU can run by Init_SIMD() */
+/*----------------------------------------------------------------------------------------------*/
+EXTERN void (*simd_cmulsc)(CPX *A, CPX *B, CPX *C, int32 cnt, int32 shift);							//!< Pointwise vector multiply with shift, dump results into C
+EXTERN void (*simd_nco)(CPX *A, CPX *LUT, uint32 phase, uint32 inc, int32 cnt);						//!< Carrier NCO
+EXTERN void (*simd_wipe_accum_code)(CPX *A, CPX *B, uint8 *C, uint32 phase, uint32 inc, uint32 spacing, int32 cnt, int32 shift, CPX_ACCUM *accum);	//!< Wipeoff and accum against the code NCO
+EXTERN void (*simd_wipe_accum_taps)(CPX *A, CPX *B, uint8 *C, uint32 phase, uint32 inc, uint32 spacing, int32 taps, int32 cnt, int32 shift, CPX_ACCUM *accum);	//!< Wipeoff and accum against a bank of code delays
+EXTERN void (*simd_dft)(CPX *A, int32 stride, MIX *W, int32 taps, CPX *C, int32 cnt);				//!< Post correlation DFT across a block of delays
+EXTERN int32 (*simd_agc)(CPX *A, CPX *B, int32 cnt, int32 scale, int32 shift, int32 max);			//!< Scale, saturate and count overflows, dump results into B
+EXTERN const char *simd_level;																		//!< Name of the kernel set that got picked
 /*----------------------------------------------------------------------------------------------*/
 
 
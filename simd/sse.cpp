@@ -33,6 +33,8 @@ Free Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1
 //	);
 #include "includes.h"
 
+#include <emmintrin.h>
+
 
 void sse_add(int16 *A, int16 *B, int32 cnt)
 {
@@ -494,7 +496,6 @@ void sse_cmul(CPX *A, CPX *B, int32 cnt)
 	int32 cnt1;
 	int32 cnt2;
 
-	volatile int32 M[4] = {0xffff0001, 0x00010001, 0xffff0001, 0x00010001}; //{1,-1,1,1,1,-1,1,1};
 
 	cnt1 = cnt/4;
 	cnt2 = cnt-4*cnt1;
@@ -568,7 +569,6 @@ void sse_cmuls(CPX *A, CPX *B, int32 cnt, int32 shift)
 	int32 cnt2;
 	int32 round;
 
-	volatile int32 M[4] = {0xffff0001, 0x00010001, 0xffff0001, 0x00010001}; //{1,-1,1,1,1,-1,1,1};
 
 	cnt1 = cnt/4;
 	cnt2 = cnt-4*cnt1;
@@ -650,7 +650,6 @@ void sse_cmulsc(CPX *A, CPX *B, CPX *C, int32 cnt, int32 shift)
 	int32 cnt2;
 	int32 round;
 
-	volatile int32 M[4] = {0xffff0001, 0x00010001, 0xffff0001, 0x00010001}; //{1,-1,1,1,1,-1,1,1};
 
 	cnt1 = cnt/4;
 	cnt2 = cnt-4*cnt1;
@@ -1030,6 +1029,554 @@ void sse_prn_accum_new(CPX *A, MIX *E, MIX *P, MIX *L, int32 cnt, CPX_ACCUM *acc
 }
 
 
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * AGC: B = saturate((A*scale) >> shift), returns how many of the I and Q values in B are above
+ * max. A and B may be the same buffer. scale must fit in 16 bits.
+ * */
+__attribute__ ((target("sse2")))
+int32 sse_agc(CPX *A, CPX *B, int32 cnt, int32 scale, int32 shift, int32 max)
+{
+
+	int32 lcv, cnt1;
+	int32 num[4];
+	__m128i a, lo, hi, s, m, one, count, sh;
+
+	cnt1 = cnt & ~3;
+	s = _mm_set1_epi16((int16)scale);
+	m = _mm_set1_epi16((int16)max);
+	sh = _mm_cvtsi32_si128(shift);
+	one = _mm_set1_epi16(1);
+	count = _mm_setzero_si128();
+
+	for(lcv = 0; lcv < cnt1; lcv += 4)
+	{
+		a = _mm_loadu_si128((__m128i *)&A[lcv]);				//4 samples from A
+		lo = _mm_mullo_epi16(a, s);								//Low 16 bits of A*scale
+		hi = _mm_mulhi_epi16(a, s);								//High 16 bits of A*scale
+		a = _mm_packs_epi32(_mm_sra_epi32(_mm_unpacklo_epi16(lo, hi), sh),
+							_mm_sra_epi32(_mm_unpackhi_epi16(lo, hi), sh));	//Full products shifted down and saturated back to 16 bits
+		_mm_storeu_si128((__m128i *)&B[lcv], a);
+		count = _mm_sub_epi32(count, _mm_madd_epi16(_mm_cmpgt_epi16(a, m), one));	//-1 where above the threshold, summed in pairs
+	}
+
+	_mm_storeu_si128((__m128i *)&num[0], count);
+
+	return(num[0] + num[1] + num[2] + num[3] + x86_agc(&A[cnt1], &B[cnt1], cnt - cnt1, scale, shift, max));
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * Wipeoff and accumulate in one pass: sse_cmulsc(A, B, scratch, cnt, shift) followed by
+ * sse_prn_accum_new(scratch, E, P, L, cnt, accum), without ever writing scratch. 2 samples a pass.
+ * */
+void sse_wipe_accum(CPX *A, CPX *B, MIX *E, MIX *P, MIX *L, int32 cnt, int32 shift, CPX_ACCUM *accum)
+{
+
+	int32 cnt1;
+	volatile int32 *Q;
+	volatile int32 R[18]; //{M[4], round[4], shift, L, leftover, pad, E.i, E.q, P.i, P.q, L.i, L.q}
+
+	cnt1 = cnt/2;
+
+	R[0] = R[2] = 0xffff0001;	//{1,-1,1,1,1,-1,1,1}
+	R[1] = R[3] = 0x00010001;
+	R[4] = R[5] = R[6] = R[7] = 1 << (shift-1);
+	R[8] = shift;
+	R[9] = (int32)L;
+	R[10] = cnt-2*cnt1;
+
+	Q = &R[0];
+
+	/* Every general register is taken, so the parameter pointer is parked in mm0 and its
+	 * register carries L through the loop */
+	__asm volatile
+	(
+		".intel_syntax noprefix			\n\t" //Set up for loop
+		"movdqu xmm7, [%[Q]]			\n\t" //Multiply thingie
+		"movdqu xmm6, [%[Q]+16]			\n\t" //Round thingie
+		"movd xmm5, [%[Q]+32]			\n\t" //Shift
+		"pxor xmm2, xmm2				\n\t" //Clear the running sum for E
+		"pxor xmm3, xmm3				\n\t" //Clear the running sum for P
+		"pxor xmm4, xmm4				\n\t" //Clear the running sum for L
+		"movd mm0, %[Q]					\n\t" //Park it
+		"mov %[Q], [%[Q]+36]			\n\t" //Address of L
+		"test %[c], %[c]				\n\t"
+		"jz Z%=							\n\t"
+		"L%=:							\n\t"
+			"movq xmm0, [%[A]]			\n\t" //Copy 2 samples from A
+			"movq xmm1, [%[B]]			\n\t" //Copy 2 samples from B
+			"punpckldq xmm0, xmm0		\n\t" //[A0 A0 A1 A1]
+			"punpckldq xmm1, xmm1		\n\t" //[B0 B0 B1 B1]
+			"pshuflw xmm1, xmm1, 0x14	\n\t" //Shuffle Low 64 bits to get [Re Im Im Re]
+			"pshufhw xmm1, xmm1, 0x14	\n\t" //Shuffle High 64 bits to get [Re Im Im Re]
+			"pmullw xmm1, xmm7			\n\t" //Multiply to get [Re -Im Im Re]
+			"pmaddwd xmm0, xmm1			\n\t" //Complex multiply and add
+			"paddd xmm0, xmm6			\n\t" //Add in 2^(shift-1)
+			"psrad xmm0, xmm5			\n\t" //Shift by X bits
+			"packssdw xmm0, xmm0		\n\t" //The 2 wiped off samples, [W0 W1 W0 W1]
+			"punpckldq xmm0, xmm0		\n\t" //[W0 W0 W1 W1]
+			"movdqu xmm1, [%[E]]		\n\t" //load E data
+			"pmaddwd xmm1, xmm0			\n\t" //complex multiply E by IF
+			"paddd xmm2, xmm1			\n\t" //add into E accumulator
+			"movdqu xmm1, [%[P]]		\n\t" //load P data
+			"pmaddwd xmm1, xmm0			\n\t" //complex multiply P by IF
+			"paddd xmm3, xmm1			\n\t" //add into P accumulator
+			"movdqu xmm1, [%[Q]]		\n\t" //load L data
+			"pmaddwd xmm1, xmm0			\n\t" //complex multiply L by IF
+			"paddd xmm4, xmm1			\n\t" //add into L accumulator
+			"add %[A], 8				\n\t"
+			"add %[B], 8				\n\t"
+			"add %[E], 16				\n\t"
+			"add %[P], 16				\n\t"
+			"add %[Q], 16				\n\t"
+		"dec %[c]						\n\t"
+		"jnz L%=						\n\t" //Loop if not done
+		"Z%=:							\n\t"
+		"movd %[c], mm0					\n\t"
+		"mov %[c], [%[c]+40]			\n\t" //Leftover sample
+		"test %[c], %[c]				\n\t"
+		"jz ZZ%=						\n\t"
+			"movd xmm0, [%[A]]			\n\t" //Same as above, 1 sample
+			"movd xmm1, [%[B]]			\n\t"
+			"punpckldq xmm0, xmm0		\n\t"
+			"punpckldq xmm1, xmm1		\n\t"
+			"pshuflw xmm1, xmm1, 0x14	\n\t"
+			"pmullw xmm1, xmm7			\n\t"
+			"pmaddwd xmm0, xmm1			\n\t"
+			"paddd xmm0, xmm6			\n\t"
+			"psrad xmm0, xmm5			\n\t"
+			"packssdw xmm0, xmm0		\n\t"
+			"punpckldq xmm0, xmm0		\n\t"
+			"movq xmm1, [%[E]]			\n\t" //Upper 64 bits are zero, so only this sample
+			"pmaddwd xmm1, xmm0			\n\t"
+			"paddd xmm2, xmm1			\n\t"
+			"movq xmm1, [%[P]]			\n\t"
+			"pmaddwd xmm1, xmm0			\n\t"
+			"paddd xmm3, xmm1			\n\t"
+			"movq xmm1, [%[Q]]			\n\t"
+			"pmaddwd xmm1, xmm0			\n\t"
+			"paddd xmm4, xmm1			\n\t"
+		"ZZ%=:							\n\t"
+		"movd %[Q], mm0					\n\t" //Get the parameters back
+		"pshufd xmm0, xmm2, 0x4E		\n\t" //Add the 2 [I Q] pairs
+		"paddd xmm2, xmm0				\n\t"
+		"movq [%[Q]+48], xmm2			\n\t"
+		"pshufd xmm0, xmm3, 0x4E		\n\t"
+		"paddd xmm3, xmm0				\n\t"
+		"movq [%[Q]+56], xmm3			\n\t"
+		"pshufd xmm0, xmm4, 0x4E		\n\t"
+		"paddd xmm4, xmm0				\n\t"
+		"movq [%[Q]+64], xmm4			\n\t"
+		"EMMS							\n\t"
+		".att_syntax					\n\t"
+		: [A] "+r" (A), [B] "+r" (B), [E] "+r" (E), [P] "+r" (P), [c] "+r" (cnt1), [Q] "+r" (Q)
+		:
+		: "memory"
+	);
+
+	accum[0].i = R[12];
+	accum[0].q = R[13];
+	accum[1].i = R[14];
+	accum[1].q = R[15];
+	accum[2].i = R[16];
+	accum[2].q = R[17];
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*! Two code bits to a mask over two [Re Im] pairs, a set bit (+1 chip) keeps its pair */
+static const int pair_mask[4][4] __attribute__ ((aligned(16))) =
+{
+	{ 0,  0,  0,  0},
+	{-1, -1,  0,  0},
+	{ 0,  0, -1, -1},
+	{-1, -1, -1, -1}
+};
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * sse_wipe_accum_bits: sse_wipe_accum against bit packed codes, 4 samples a pass. The wiped off
+ * samples are kept as 32 bit [Re Im] pairs, and only the ones on a +1 chip get summed. With S the
+ * sum of every sample the correlation is 2*(that sum) - S, so there are no multiplies for the code.
+ * Written with intrinsics and left to the compiler, there are not enough xmm registers to hand
+ * allocate it like the rest of this file.
+ * */
+__attribute__ ((target("sse2")))
+void sse_wipe_accum_bits(CPX *A, CPX *B, uint8 *E, uint8 *P, uint8 *L, int32 offset, int32 cnt, int32 shift, CPX_ACCUM *accum)
+{
+
+	int32 lcv, bit;
+	int32 cnt1;
+	unsigned int ce, cp, cl;
+	uint32 sum[8];
+	__m128i a, b, br, bq, re, im, lo, hi, t;
+	__m128i sign, rnd, sh;
+	__m128i e, p, l, s;
+	CPX ta[4], tb[4];
+
+	cnt1 = cnt & ~3;
+
+	sign = _mm_set1_epi32(0xffff0001);	//{1,-1,1,-1...}
+	rnd = _mm_set1_epi32(1 << (shift-1));
+	sh = _mm_cvtsi32_si128(shift);
+
+	e = _mm_setzero_si128();
+	p = _mm_setzero_si128();
+	l = _mm_setzero_si128();
+	s = _mm_setzero_si128();
+
+	for(lcv = 0; lcv < cnt; lcv += 4)
+	{
+		if(lcv < cnt1)
+		{
+			a = _mm_loadu_si128((__m128i *)&A[lcv]);
+			b = _mm_loadu_si128((__m128i *)&B[lcv]);
+		}
+		else
+		{
+			/* Leftovers are padded with zeros, which come out as zero whatever the code says */
+			memset(&ta[0], 0x0, sizeof(ta));
+			memset(&tb[0], 0x0, sizeof(tb));
+			memcpy(&ta[0], &A[lcv], (cnt-lcv)*sizeof(CPX));
+			memcpy(&tb[0], &B[lcv], (cnt-lcv)*sizeof(CPX));
+			a = _mm_loadu_si128((__m128i *)&ta[0]);
+			b = _mm_loadu_si128((__m128i *)&tb[0]);
+		}
+
+		br = _mm_mullo_epi16(b, sign);									//[Re -Im]
+		bq = _mm_shufflehi_epi16(_mm_shufflelo_epi16(b, 0xB1), 0xB1);	//[Im Re]
+
+		re = _mm_sra_epi32(_mm_add_epi32(_mm_madd_epi16(a, br), rnd), sh);
+		im = _mm_sra_epi32(_mm_add_epi32(_mm_madd_epi16(a, bq), rnd), sh);
+
+		/* Interleave to [Re Im] pairs, saturate with packssdw, then sign extend back out */
+		t = _mm_packs_epi32(_mm_unpacklo_epi32(re, im), _mm_unpackhi_epi32(re, im));
+		lo = _mm_srai_epi32(_mm_unpacklo_epi16(t, t), 16);	//Samples 0 and 1
+		hi = _mm_srai_epi32(_mm_unpackhi_epi16(t, t), 16);	//Samples 2 and 3
+
+		s = _mm_add_epi32(s, _mm_add_epi32(lo, hi));
+
+		bit = offset + lcv;
+		memcpy(&ce, &E[bit >> 3], sizeof(ce));
+		memcpy(&cp, &P[bit >> 3], sizeof(cp));
+		memcpy(&cl, &L[bit >> 3], sizeof(cl));
+		ce >>= (bit & 7);
+		cp >>= (bit & 7);
+		cl >>= (bit & 7);
+
+		e = _mm_add_epi32(e, _mm_and_si128(lo, *(__m128i *)pair_mask[ce & 0x3]));
+		e = _mm_add_epi32(e, _mm_and_si128(hi, *(__m128i *)pair_mask[(ce >> 2) & 0x3]));
+		p = _mm_add_epi32(p, _mm_and_si128(lo, *(__m128i *)pair_mask[cp & 0x3]));
+		p = _mm_add_epi32(p, _mm_and_si128(hi, *(__m128i *)pair_mask[(cp >> 2) & 0x3]));
+		l = _mm_add_epi32(l, _mm_and_si128(lo, *(__m128i *)pair_mask[cl & 0x3]));
+		l = _mm_add_epi32(l, _mm_and_si128(hi, *(__m128i *)pair_mask[(cl >> 2) & 0x3]));
+	}
+
+	e = _mm_add_epi32(e, _mm_unpackhi_epi64(e, e));
+	sum[0] = _mm_cvtsi128_si32(e);
+	sum[1] = _mm_cvtsi128_si32(_mm_srli_si128(e, 4));
+
+	p = _mm_add_epi32(p, _mm_unpackhi_epi64(p, p));
+	sum[2] = _mm_cvtsi128_si32(p);
+	sum[3] = _mm_cvtsi128_si32(_mm_srli_si128(p, 4));
+
+	l = _mm_add_epi32(l, _mm_unpackhi_epi64(l, l));
+	sum[4] = _mm_cvtsi128_si32(l);
+	sum[5] = _mm_cvtsi128_si32(_mm_srli_si128(l, 4));
+
+	s = _mm_add_epi32(s, _mm_unpackhi_epi64(s, s));
+	sum[6] = _mm_cvtsi128_si32(s);
+	sum[7] = _mm_cvtsi128_si32(_mm_srli_si128(s, 4));
+
+	for(lcv = 0; lcv < 3; lcv++)
+	{
+		accum[lcv].i = (int32)(2*sum[2*lcv]   - sum[6]);
+		accum[lcv].q = (int32)(2*sum[2*lcv+1] - sum[7]);
+	}
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * sse_wipe_accum_code: sse_wipe_accum_bits with the code made on the fly by the code NCO, 4
+ * samples a pass, see avx2_wipe_accum_code. There is no per lane shift before AVX2, so each
+ * lane makes 1 << chip out of a float exponent and tests the code word against it.
+ * */
+__attribute__ ((target("sse2")))
+void sse_wipe_accum_code(CPX *A, CPX *B, uint8 *C, uint32 phase, uint32 inc, uint32 spacing, int32 cnt, int32 shift, CPX_ACCUM *accum)
+{
 
+	int32 lcv;
+	int32 cnt1;
+	uint32 late, step;
+	unsigned int w;
+	__m128i a, b, br, bq, re, im, x, c, code, index;
+	__m128i sign, rnd, sh, one, offset, ke, kp, kl;
+	__m128i e, p, l;
+	CPX ta[4], tb[4];
+
+	cnt1 = cnt & ~3;
+	step = inc << 2;
+
+	late = phase + CODE_NCO_WRAP - spacing;
+	if(late >= CODE_NCO_WRAP)
+		late -= CODE_NCO_WRAP;
+
+	sign = _mm_set1_epi32(0xffff0001);	//{1,-1,1,-1...}
+	rnd = _mm_set1_epi32(1 << (shift-1));
+	sh = _mm_cvtsi32_si128(shift);
+	one = _mm_set1_epi32(1);
+
+	/* Phase of each lane from the start of the pass, with the float exponent bias on top */
+	offset = _mm_setr_epi32(0, inc, 2*inc, 3*inc);
+	kl = _mm_set1_epi32(127 << CODE_NCO_FRAC);
+	kp = _mm_set1_epi32((int)((127 << CODE_NCO_FRAC) + spacing));
+	ke = _mm_set1_epi32((int)((127 << CODE_NCO_FRAC) + 2*spacing));
+
+	e = _mm_setzero_si128();
+	p = _mm_setzero_si128();
+	l = _mm_setzero_si128();
+
+	for(lcv = 0; lcv < cnt; lcv += 4)
+	{
+		if(lcv < cnt1)
+		{
+			a = _mm_loadu_si128((__m128i *)&A[lcv]);
+			b = _mm_loadu_si128((__m128i *)&B[lcv]);
+		}
+		else
+		{
+			/* Leftovers are padded with zeros, which come out as zero whatever the code says */
+			memset(&ta[0], 0x0, sizeof(ta));
+			memset(&tb[0], 0x0, sizeof(tb));
+			memcpy(&ta[0], &A[lcv], (cnt-lcv)*sizeof(CPX));
+			memcpy(&tb[0], &B[lcv], (cnt-lcv)*sizeof(CPX));
+			a = _mm_loadu_si128((__m128i *)&ta[0]);
+			b = _mm_loadu_si128((__m128i *)&tb[0]);
+		}
+
+		br = _mm_mullo_epi16(b, sign);									//[Re -Im]
+		bq = _mm_shufflehi_epi16(_mm_shufflelo_epi16(b, 0xB1), 0xB1);	//[Im Re]
+
+		re = _mm_sra_epi32(_mm_add_epi32(_mm_madd_epi16(a, br), rnd), sh);
+		im = _mm_sra_epi32(_mm_add_epi32(_mm_madd_epi16(a, bq), rnd), sh);
+
+		/* Saturated [Re Re Re Re Im Im Im Im] */
+		x = _mm_packs_epi32(re, im);
+
+		index = _mm_add_epi32(offset, _mm_set1_epi32((int)(late & ((8 << CODE_NCO_FRAC) - 1))));
+		memcpy(&w, &C[late >> (CODE_NCO_FRAC + 3)], sizeof(w));
+		code = _mm_set1_epi32((int)w);
+
+		/* -1 on a +1 chip, +1 on a -1 chip, packed to line up with x */
+		c = _mm_slli_epi32(_mm_srli_epi32(_mm_add_epi32(ke, index), CODE_NCO_FRAC), 23);
+		c = _mm_cvttps_epi32(_mm_castsi128_ps(c));
+		c = _mm_or_si128(_mm_cmpeq_epi32(_mm_and_si128(code, c), c), one);
+		e = _mm_add_epi32(e, _mm_madd_epi16(x, _mm_packs_epi32(c, c)));
+
+		c = _mm_slli_epi32(_mm_srli_epi32(_mm_add_epi32(kp, index), CODE_NCO_FRAC), 23);
+		c = _mm_cvttps_epi32(_mm_castsi128_ps(c));
+		c = _mm_or_si128(_mm_cmpeq_epi32(_mm_and_si128(code, c), c), one);
+		p = _mm_add_epi32(p, _mm_madd_epi16(x, _mm_packs_epi32(c, c)));
+
+		c = _mm_slli_epi32(_mm_srli_epi32(_mm_add_epi32(kl, index), CODE_NCO_FRAC), 23);
+		c = _mm_cvttps_epi32(_mm_castsi128_ps(c));
+		c = _mm_or_si128(_mm_cmpeq_epi32(_mm_and_si128(code, c), c), one);
+		l = _mm_add_epi32(l, _mm_madd_epi16(x, _mm_packs_epi32(c, c)));
+
+		late += step;
+		if(late >= CODE_NCO_WRAP)
+			late -= CODE_NCO_WRAP;
+	}
+
+	/* [Re Re Im Im] */
+	e = _mm_add_epi32(e, _mm_srli_si128(e, 4));
+	accum[0].i = -(int32)_mm_cvtsi128_si32(e);
+	accum[0].q = -(int32)_mm_cvtsi128_si32(_mm_srli_si128(e, 8));
 
+	p = _mm_add_epi32(p, _mm_srli_si128(p, 4));
+	accum[1].i = -(int32)_mm_cvtsi128_si32(p);
+	accum[1].q = -(int32)_mm_cvtsi128_si32(_mm_srli_si128(p, 8));
+
+	l = _mm_add_epi32(l, _mm_srli_si128(l, 4));
+	accum[2].i = -(int32)_mm_cvtsi128_si32(l);
+	accum[2].q = -(int32)_mm_cvtsi128_si32(_mm_srli_si128(l, 8));
+
+}
+/*----------------------------------------------------------------------------------------------*/
 
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * sse_wipe_accum_taps: sse_wipe_accum_code for a bank of taps code delays spaced spacing apart,
+ * prompt in the middle and the earliest first, see avx2_wipe_accum_taps. The compare already
+ * gives the 0/-1 mask of the +1 chips, so two taps pack straight into one mask.
+ * */
+__attribute__ ((target("sse2")))
+void sse_wipe_accum_taps(CPX *A, CPX *B, uint8 *C, uint32 phase, uint32 inc, uint32 spacing, int32 taps, int32 cnt, int32 shift, CPX_ACCUM *accum)
+{
+
+	int32 lcv, tap, pairs;
+	int32 cnt1;
+	uint32 late, step;
+	uint32 sre, sim;
+	unsigned int w;
+	__m128i a, b, br, bq, re, im, xr, xi, c, d, code, index;
+	__m128i sign, rnd, sh, ones, offset, x;
+	__m128i k[MAX_TAPS+1], tr[(MAX_TAPS+1)/2], ti[(MAX_TAPS+1)/2];
+	CPX ta[4], tb[4];
+
+	cnt1 = cnt & ~3;
+	step = inc << 2;
+	pairs = (taps + 1) >> 1;
+
+	late = phase + CODE_NCO_WRAP - (taps >> 1)*spacing;
+	if(late >= CODE_NCO_WRAP)
+		late -= CODE_NCO_WRAP;
+
+	sign = _mm_set1_epi32(0xffff0001);	//{1,-1,1,-1...}
+	rnd = _mm_set1_epi32(1 << (shift-1));
+	sh = _mm_cvtsi32_si128(shift);
+	ones = _mm_set1_epi16(1);
+
+	/* Phase of each lane from the start of the pass, with the float exponent bias and the tap offset on top */
+	offset = _mm_setr_epi32(0, inc, 2*inc, 3*inc);
+	for(tap = 0; tap < 2*pairs; tap++)
+		k[tap] = _mm_set1_epi32((int)((127 << CODE_NCO_FRAC) + (taps - 1 - (tap < taps ? tap : taps - 1))*spacing));
+
+	for(tap = 0; tap < pairs; tap++)
+	{
+		tr[tap] = _mm_setzero_si128();
+		ti[tap] = _mm_setzero_si128();
+	}
+	x = _mm_setzero_si128();
+
+	for(lcv = 0; lcv < cnt; lcv += 4)
+	{
+		if(lcv < cnt1)
+		{
+			a = _mm_loadu_si128((__m128i *)&A[lcv]);
+			b = _mm_loadu_si128((__m128i *)&B[lcv]);
+		}
+		else
+		{
+			/* Leftovers are padded with zeros, which come out as zero whatever the code says */
+			memset(&ta[0], 0x0, sizeof(ta));
+			memset(&tb[0], 0x0, sizeof(tb));
+			memcpy(&ta[0], &A[lcv], (cnt-lcv)*sizeof(CPX));
+			memcpy(&tb[0], &B[lcv], (cnt-lcv)*sizeof(CPX));
+			a = _mm_loadu_si128((__m128i *)&ta[0]);
+			b = _mm_loadu_si128((__m128i *)&tb[0]);
+		}
+
+		br = _mm_mullo_epi16(b, sign);									//[Re -Im]
+		bq = _mm_shufflehi_epi16(_mm_shufflelo_epi16(b, 0xB1), 0xB1);	//[Im Re]
+
+		re = _mm_sra_epi32(_mm_add_epi32(_mm_madd_epi16(a, br), rnd), sh);
+		im = _mm_sra_epi32(_mm_add_epi32(_mm_madd_epi16(a, bq), rnd), sh);
+
+		/* Saturated [Re Re Re Re Re Re Re Re] and [Im ...], and the plain sum */
+		xr = _mm_packs_epi32(re, re);
+		xi = _mm_packs_epi32(im, im);
+		x = _mm_add_epi32(x, _mm_madd_epi16(_mm_packs_epi32(re, im), ones));
+
+		index = _mm_add_epi32(offset, _mm_set1_epi32((int)(late & ((8 << CODE_NCO_FRAC) - 1))));
+		memcpy(&w, &C[late >> (CODE_NCO_FRAC + 3)], sizeof(w));
+		code = _mm_set1_epi32((int)w);
+
+		for(tap = 0; tap < pairs; tap++)
+		{
+			c = _mm_slli_epi32(_mm_srli_epi32(_mm_add_epi32(k[2*tap], index), CODE_NCO_FRAC), 23);
+			c = _mm_cvttps_epi32(_mm_castsi128_ps(c));
+			c = _mm_cmpeq_epi32(_mm_and_si128(code, c), c);
+
+			d = _mm_slli_epi32(_mm_srli_epi32(_mm_add_epi32(k[2*tap+1], index), CODE_NCO_FRAC), 23);
+			d = _mm_cvttps_epi32(_mm_castsi128_ps(d));
+			d = _mm_cmpeq_epi32(_mm_and_si128(code, d), d);
+
+			c = _mm_packs_epi32(c, d);
+			tr[tap] = _mm_add_epi32(tr[tap], _mm_madd_epi16(xr, c));
+			ti[tap] = _mm_add_epi32(ti[tap], _mm_madd_epi16(xi, c));
+		}
+
+		late += step;
+		if(late >= CODE_NCO_WRAP)
+			late -= CODE_NCO_WRAP;
+	}
+
+	/* The plain sum is [Re Re Im Im], the masked sums [even even odd odd] */
+	x = _mm_add_epi32(x, _mm_srli_si128(x, 4));
+	sre = (uint32)_mm_cvtsi128_si32(x);
+	sim = (uint32)_mm_cvtsi128_si32(_mm_srli_si128(x, 8));
+
+	for(tap = 0; tap < pairs; tap++)
+	{
+		c = _mm_add_epi32(tr[tap], _mm_srli_si128(tr[tap], 4));
+		d = _mm_add_epi32(ti[tap], _mm_srli_si128(ti[tap], 4));
+
+		accum[2*tap].i = (int32)(-2*(uint32)_mm_cvtsi128_si32(c) - sre);
+		accum[2*tap].q = (int32)(-2*(uint32)_mm_cvtsi128_si32(d) - sim);
+
+		if(2*tap+1 < taps)
+		{
+			accum[2*tap+1].i = (int32)(-2*(uint32)_mm_cvtsi128_si32(_mm_srli_si128(c, 8)) - sre);
+			accum[2*tap+1].q = (int32)(-2*(uint32)_mm_cvtsi128_si32(_mm_srli_si128(d, 8)) - sim);
+		}
+	}
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * sse_dft: x86_dft 4 series a pass. The series run along the rows of A, so each tap is one
+ * straight load of 4 samples, pmaddwd'd against the [Re -Im] and [Im Re] words of its
+ * coefficient. The real sums keep their top halves as the real part, the imaginary sums already
+ * have theirs in the right place.
+ * */
+__attribute__ ((target("sse2")))
+void sse_dft(CPX *A, int32 stride, MIX *W, int32 taps, CPX *C, int32 cnt)
+{
+
+	int32 lcv, tap;
+	int32 cnt1;
+	int wi, wq;
+	__m128i a, re, im, mask;
+	CPX *p;
+
+	cnt1 = cnt & ~3;
+	mask = _mm_set1_epi32(0xffff0000);
+
+	for(lcv = 0; lcv < cnt1; lcv += 4)
+	{
+		re = _mm_setzero_si128();
+		im = _mm_setzero_si128();
+		p = &A[lcv];
+
+		for(tap = 0; tap < taps; tap++)
+		{
+			a = _mm_loadu_si128((__m128i *)p);
+			memcpy(&wi, &W[tap].i, sizeof(wi));
+			memcpy(&wq, &W[tap].q, sizeof(wq));
+			re = _mm_add_epi32(re, _mm_madd_epi16(a, _mm_set1_epi32(wi)));	//[Re -Im]
+			im = _mm_add_epi32(im, _mm_madd_epi16(a, _mm_set1_epi32(wq)));	//[Im Re]
+			p += stride;
+		}
+
+		_mm_storeu_si128((__m128i *)&C[lcv], _mm_or_si128(_mm_srli_epi32(re, 16), _mm_and_si128(im, mask)));
+	}
+
+	x86_dft(&A[cnt1], stride, W, taps, &C[cnt1], cnt - cnt1);
+
+}
+/*----------------------------------------------------------------------------------------------*/
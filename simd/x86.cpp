@@ -278,6 +278,42 @@ void x86_max(int32 *_A, int32 *_index, int32 *_magt, int32 _cnt)
 /*----------------------------------------------------------------------------------------------*/
 
 
+/*----------------------------------------------------------------------------------------------*/
+int32 x86_agc(CPX *_A, CPX *_B, int32 _cnt, int32 _scale, int32 _shift, int32 _max)
+{
+
+	int32 lcv, num;
+	int32 val;
+	int16 *a, *b;
+
+	a = (int16 *)_A;
+	b = (int16 *)_B;
+
+	num = 0;
+
+	for(lcv = 0; lcv < 2*_cnt; lcv++)
+	{
+		val = a[lcv]*_scale;
+		val >>= _shift;
+
+		/* Saturate, like packssdw */
+		if(val > 32767)
+			val = 32767;
+		if(val < -32768)
+			val = -32768;
+
+		if(val > _max)
+			num++;
+
+		b[lcv] = (int16)val;
+	}
+
+	return(num);
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
 /*----------------------------------------------------------------------------------------------*/
 void x86_prn_accum(CPX *A, CPX *E, CPX *P, CPX *L, int32 cnt, CPX *accum)  //!< This is a long story
 {
@@ -371,6 +407,361 @@ void x86_prn_accum_new(CPX *A, MIX *E, MIX *P, MIX *L, int32 cnt, CPX_ACCUM *acc
 /*----------------------------------------------------------------------------------------------*/
 
 
+/*----------------------------------------------------------------------------------------------*/
+void x86_wipe_accum(CPX *A, CPX *B, MIX *E, MIX *P, MIX *L, int32 cnt, int32 shift, CPX_ACCUM *accum)
+{
+
+	CPX_ACCUM Ea, Pa, La;
+	int32 lcv;
+	int32 ai, aq;
+	int32 bi, bq;
+	int32 ti, tq;
+	int32 round;
+
+	round = 1 << (shift-1);
+
+	Ea.i = 0;	Ea.q = 0;
+	Pa.i = 0;	Pa.q = 0;
+	La.i = 0;	La.q = 0;
+
+	for(lcv = 0; lcv < cnt; lcv++)
+	{
+
+		/* Same as x86_cmulsc */
+		ai = A[lcv].i;
+		aq = A[lcv].q;
+		bi = B[lcv].i;
+		bq = B[lcv].q;
+
+		ti = ai*bi-aq*bq;
+		tq = ai*bq+aq*bi;
+
+		ti += round;
+		tq += round;
+
+		ti >>= shift;
+		tq >>= shift;
+
+		ti = (int16)ti;
+		tq = (int16)tq;
+
+		/* Same as x86_prn_accum_new */
+		Ea.i += ti*E[lcv].i;
+		Ea.q += tq*E[lcv].ni;
+		Pa.i += ti*P[lcv].i;
+		Pa.q += tq*P[lcv].ni;
+		La.i += ti*L[lcv].i;
+		La.q += tq*L[lcv].ni;
+	}
+
+	accum[0].i = Ea.i;
+	accum[0].q = Ea.q;
+	accum[1].i = Pa.i;
+	accum[1].q = Pa.q;
+	accum[2].i = La.i;
+	accum[2].q = La.q;
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+void x86_wipe_accum_bits(CPX *A, CPX *B, uint8 *E, uint8 *P, uint8 *L, int32 offset, int32 cnt, int32 shift, CPX_ACCUM *accum)
+{
+
+	CPX_ACCUM Ea, Pa, La;
+	int32 lcv, bit;
+	int32 ai, aq;
+	int32 bi, bq;
+	int32 ti, tq;
+	int32 round;
+
+	round = 1 << (shift-1);
+
+	Ea.i = 0;	Ea.q = 0;
+	Pa.i = 0;	Pa.q = 0;
+	La.i = 0;	La.q = 0;
+
+	for(lcv = 0; lcv < cnt; lcv++)
+	{
+
+		/* Same as x86_cmulsc */
+		ai = A[lcv].i;
+		aq = A[lcv].q;
+		bi = B[lcv].i;
+		bq = B[lcv].q;
+
+		ti = ai*bi-aq*bq;
+		tq = ai*bq+aq*bi;
+
+		ti += round;
+		tq += round;
+
+		ti >>= shift;
+		tq >>= shift;
+
+		ti = (int16)ti;
+		tq = (int16)tq;
+
+		/* A set bit is a +1 chip, a clear bit flips the sign */
+		bit = offset + lcv;
+
+		if((E[bit >> 3] >> (bit & 7)) & 1)	{ Ea.i += ti;	Ea.q += tq; }
+		else								{ Ea.i -= ti;	Ea.q -= tq; }
+
+		if((P[bit >> 3] >> (bit & 7)) & 1)	{ Pa.i += ti;	Pa.q += tq; }
+		else								{ Pa.i -= ti;	Pa.q -= tq; }
+
+		if((L[bit >> 3] >> (bit & 7)) & 1)	{ La.i += ti;	La.q += tq; }
+		else								{ La.i -= ti;	La.q -= tq; }
+	}
+
+	accum[0].i = Ea.i;
+	accum[0].q = Ea.q;
+	accum[1].i = Pa.i;
+	accum[1].q = Pa.q;
+	accum[2].i = La.i;
+	accum[2].q = La.q;
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+void x86_nco(CPX *A, CPX *LUT, uint32 phase, uint32 inc, int32 cnt)
+{
+
+	int32 lcv;
+	uint32 index;
+
+	/* The top CARRIER_LUT_BITS of the 32 bit phase pick the sample */
+	for(lcv = 0; lcv < cnt; lcv++)
+	{
+		index = (phase >> (32-CARRIER_LUT_BITS)) & (CARRIER_LUT_SIZE-1);
+		A[lcv] = LUT[index];
+		phase += inc;
+	}
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+void x86_code_nco(uint8 *C, uint8 *A, uint32 phase, uint32 inc, int32 cnt)
+{
+
+	int32 lcv;
+	uint32 index;
+
+	/* The whole chips of the phase pick the chip, one bit a sample out, LSB first */
+	for(lcv = 0; lcv < cnt; lcv++)
+	{
+		if((lcv & 7) == 0)
+			A[lcv >> 3] = 0;
+
+		index = phase >> CODE_NCO_FRAC;
+		A[lcv >> 3] |= ((C[index >> 3] >> (index & 7)) & 0x1) << (lcv & 7);
+
+		phase += inc;
+		if(phase >= CODE_NCO_WRAP)
+			phase -= CODE_NCO_WRAP;
+	}
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+void x86_wipe_accum_code(CPX *A, CPX *B, uint8 *C, uint32 phase, uint32 inc, uint32 spacing, int32 cnt, int32 shift, CPX_ACCUM *accum)
+{
+
+	CPX_ACCUM Ea, Pa, La;
+	int32 lcv;
+	int32 ai, aq;
+	int32 bi, bq;
+	int32 ti, tq;
+	int32 round;
+	uint32 pe, pl, index;
+
+	round = 1 << (shift-1);
+
+	Ea.i = 0;	Ea.q = 0;
+	Pa.i = 0;	Pa.q = 0;
+	La.i = 0;	La.q = 0;
+
+	/* Early and late ride spacing either side of prompt */
+	pe = phase + spacing;
+	if(pe >= CODE_NCO_WRAP)
+		pe -= CODE_NCO_WRAP;
+
+	pl = phase + CODE_NCO_WRAP - spacing;
+	if(pl >= CODE_NCO_WRAP)
+		pl -= CODE_NCO_WRAP;
+
+	for(lcv = 0; lcv < cnt; lcv++)
+	{
+
+		/* Same as x86_cmulsc */
+		ai = A[lcv].i;
+		aq = A[lcv].q;
+		bi = B[lcv].i;
+		bq = B[lcv].q;
+
+		ti = ai*bi-aq*bq;
+		tq = ai*bq+aq*bi;
+
+		ti += round;
+		tq += round;
+
+		ti >>= shift;
+		tq >>= shift;
+
+		ti = (int16)ti;
+		tq = (int16)tq;
+
+		/* A set bit is a +1 chip, a clear bit flips the sign */
+		index = pe >> CODE_NCO_FRAC;
+		if((C[index >> 3] >> (index & 7)) & 1)	{ Ea.i += ti;	Ea.q += tq; }
+		else									{ Ea.i -= ti;	Ea.q -= tq; }
+
+		index = phase >> CODE_NCO_FRAC;
+		if((C[index >> 3] >> (index & 7)) & 1)	{ Pa.i += ti;	Pa.q += tq; }
+		else									{ Pa.i -= ti;	Pa.q -= tq; }
+
+		index = pl >> CODE_NCO_FRAC;
+		if((C[index >> 3] >> (index & 7)) & 1)	{ La.i += ti;	La.q += tq; }
+		else									{ La.i -= ti;	La.q -= tq; }
+
+		pe += inc;
+		if(pe >= CODE_NCO_WRAP)
+			pe -= CODE_NCO_WRAP;
+
+		phase += inc;
+		if(phase >= CODE_NCO_WRAP)
+			phase -= CODE_NCO_WRAP;
+
+		pl += inc;
+		if(pl >= CODE_NCO_WRAP)
+			pl -= CODE_NCO_WRAP;
+	}
+
+	accum[0].i = Ea.i;
+	accum[0].q = Ea.q;
+	accum[1].i = Pa.i;
+	accum[1].q = Pa.q;
+	accum[2].i = La.i;
+	accum[2].q = La.q;
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+void x86_wipe_accum_taps(CPX *A, CPX *B, uint8 *C, uint32 phase, uint32 inc, uint32 spacing, int32 taps, int32 cnt, int32 shift, CPX_ACCUM *accum)
+{
+
+	int32 lcv, tap;
+	int32 ai, aq;
+	int32 bi, bq;
+	int32 ti, tq;
+	int32 round;
+	uint32 late, pt, index;
+
+	round = 1 << (shift-1);
+
+	for(tap = 0; tap < taps; tap++)
+	{
+		accum[tap].i = 0;
+		accum[tap].q = 0;
+	}
+
+	/* The last tap is the latest, every tap before it is spacing further ahead, prompt is in the middle */
+	late = phase + CODE_NCO_WRAP - (taps >> 1)*spacing;
+	if(late >= CODE_NCO_WRAP)
+		late -= CODE_NCO_WRAP;
+
+	for(lcv = 0; lcv < cnt; lcv++)
+	{
+
+		/* Same as x86_cmulsc, done once for all the taps */
+		ai = A[lcv].i;
+		aq = A[lcv].q;
+		bi = B[lcv].i;
+		bq = B[lcv].q;
+
+		ti = ai*bi-aq*bq;
+		tq = ai*bq+aq*bi;
+
+		ti += round;
+		tq += round;
+
+		ti >>= shift;
+		tq >>= shift;
+
+		ti = (int16)ti;
+		tq = (int16)tq;
+
+		for(tap = 0; tap < taps; tap++)
+		{
+			pt = late + (taps - 1 - tap)*spacing;
+			if(pt >= CODE_NCO_WRAP)
+				pt -= CODE_NCO_WRAP;
+
+			/* A set bit is a +1 chip, a clear bit flips the sign */
+			index = pt >> CODE_NCO_FRAC;
+			if((C[index >> 3] >> (index & 7)) & 1)	{ accum[tap].i += ti;	accum[tap].q += tq; }
+			else									{ accum[tap].i -= ti;	accum[tap].q -= tq; }
+		}
+
+		late += inc;
+		if(late >= CODE_NCO_WRAP)
+			late -= CODE_NCO_WRAP;
+	}
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
+/*----------------------------------------------------------------------------------------------*/
+/*!
+ * x86_dft: One bin of a short DFT for cnt series at once. Series d is A[d], A[stride+d], ...
+ * A[(taps-1)*stride+d], W holds the taps coefficients of the bin. Each output is the x86_cacc of
+ * its series against W, scaled down by 16 bits.
+ * */
+void x86_dft(CPX *A, int32 stride, MIX *W, int32 taps, CPX *C, int32 cnt)
+{
+
+	int32 lcv, tap;
+	int32 ai, aq;
+	int32 iaccum, qaccum;
+	CPX *a;
+
+	for(lcv = 0; lcv < cnt; lcv++)
+	{
+
+		iaccum = qaccum = 0;
+		a = &A[lcv];
+
+		for(tap = 0; tap < taps; tap++)
+		{
+			ai = a->i;
+			aq = a->q;
+
+			iaccum += ai*W[tap].i + aq*W[tap].nq;
+			qaccum += ai*W[tap].q + aq*W[tap].ni;
+
+			a += stride;
+		}
+
+		C[lcv].i = iaccum >> 16;
+		C[lcv].q = qaccum >> 16;
+
+	}
+
+}
+/*----------------------------------------------------------------------------------------------*/
+
+
 //int32 x86_acc(int16 *_A, int32 _cnt)
 //{
 //
@@ -22,6 +22,7 @@
 #include "fpga_regs_standard.h"
 #include "usrp_i2c_addr.h"
 #include "db_dbs_rx.h"
+#include "shm_ring.h"
 
 using namespace std;
 
@@ -69,7 +70,6 @@ void *record_thread(void *_opt);
 void *fifo_thread(void *_opt);
 void *key_thread(void *_arg);
 void resample(CPX *_in, CPX *_out, options *_opt);		//!< Resample to get in the 2.048 Msps format, also handles de-interleave
-void write_pipe(CPX *_buff, int _npipe, int _bytes);
 /*----------------------------------------------------------------------------------------------*/
 
 
@@ -586,32 +586,8 @@ void *record_thread(void *opt)
 }
 /*----------------------------------------------------------------------------------------------*/
 
-/* This is global so it can be handled by the signal handler */
-int fifo_pipe;
-
-/*----------------------------------------------------------------------------------------------*/
-void wait_for_client()
-{
-
-	printf("Waiting for client\n");
-	fifo_pipe = -1;
-	while((fifo_pipe == -1) && grun)
-	{
-		fifo_pipe = open("/tmp/GPSPIPE", O_WRONLY | O_NONBLOCK);
-		usleep(1000000);
-	}
-
-	if(fifo_pipe != -1)
-		printf("Client connected\n");
-	else
-	{
-		printf("Killed before client connected\n");
-		pthread_exit(0);
-	}
-
-}
-/*----------------------------------------------------------------------------------------------*/
-
+/* The shared ring the gps-sdr FIFO attaches to */
+Shm_Ring ring;
 
 /*----------------------------------------------------------------------------------------------*/
 void *fifo_thread(void *arg)
@@ -665,13 +641,10 @@ void *fifo_thread(void *arg)
 	if(_opt->verbose)
 		printf("FIFO thread start\n");
 
-	/* Everything set, now create a disk thread & pipe, and do some recording! */
-	fifo = mkfifo("/tmp/GPSPIPE", S_IRWXG | S_IRWXU | S_IRWXO);
-	if ((fifo == -1) && (errno != EEXIST))
-        printf("Error creating the named pipe");
-
-	/* Wait for the gps-sdr */
-	wait_for_client();
+	/* Everything set, now create the shared ring, and do some recording! The gps-sdr attaches
+	 * whenever it is ready, until then (or if it falls behind) packets are simply overwritten */
+	if(!ring.Create(bwrite, SHM_RING_SLOTS))
+		printf("Error creating the shared ring %s\n",SHM_RING_NAME);
 
 	/* Important set this to zero! */
 	leftover = 0;
@@ -705,7 +678,7 @@ void *fifo_thread(void *arg)
 		{
 			case 0:
 				resample(buff, buff_out, _opt);
-				write_pipe(buff_out, fifo_pipe, bwrite);
+				ring.Write(buff_out, bwrite, 0);
 
 				if(_opt->record)
 					fwrite(buff_out, 0x1, bwrite, fp_out);
@@ -717,7 +690,7 @@ void *fifo_thread(void *arg)
 				if(leftover == 0)
 				{
 					resample(buff, buff_out, _opt);
-					write_pipe(buff_out, fifo_pipe, bwrite);
+					ring.Write(buff_out, bwrite, 0);
 
 					if(_opt->record)
 						fwrite(buff_out, 0x1, bwrite, fp_out);
@@ -727,7 +700,7 @@ void *fifo_thread(void *arg)
 
 				leftover += 96;
 				resample(buff, buff_out, _opt);
-				write_pipe(buff_out, fifo_pipe, bwrite);
+				ring.Write(buff_out, bwrite, 0);
 
 				if(_opt->record)
 					fwrite(buff_out, 0x1, bwrite, fp_out);
@@ -739,7 +712,7 @@ void *fifo_thread(void *arg)
 				if(leftover > 4000)
 				{
 					resample(buff, buff_out, _opt);
-					write_pipe(buff_out, fifo_pipe, bwrite);
+					ring.Write(buff_out, bwrite, 0);
 
 					if(_opt->record)
 						fwrite(buff_out, 0x1, bwrite, fp_out);
@@ -754,7 +727,7 @@ void *fifo_thread(void *arg)
 
 				leftover += 192;
 				resample(buff, buff_out, _opt);
-				write_pipe(buff_out, fifo_pipe, bwrite);
+				ring.Write(buff_out, bwrite, 0);
 
 				if(_opt->record)
 					fwrite(buff_out, 0x1, bwrite, fp_out);
@@ -767,7 +740,7 @@ void *fifo_thread(void *arg)
 				{
 
 					resample(buff, buff_out, _opt);
-					write_pipe(buff_out, fifo_pipe, bwrite);
+					ring.Write(buff_out, bwrite, 0);
 
 					if(_opt->record)
 						fwrite(buff_out, 0x1, bwrite, fp_out);
@@ -795,7 +768,7 @@ void *fifo_thread(void *arg)
 
 	}
 
-	close(fifo_pipe);
+	ring.Close();
 
 	if(_opt->record)
 		fclose(fp_out);
@@ -840,39 +813,6 @@ void *key_thread(void *_arg)
 /*----------------------------------------------------------------------------------------------*/
 
 
-/*----------------------------------------------------------------------------------------------*/
-void kill_program(int _sig)
-{
-	//grun = false;
-	printf("Lost GPS-SDR!\n");
-	wait_for_client();
-}
-/*----------------------------------------------------------------------------------------------*/
-
-
-/*----------------------------------------------------------------------------------------------*/
-void write_pipe(CPX *_buff, int _npipe, int _bytes)
-{
-
-	int nbytes, bwrote;
-	char *pbuff;
-
-	/* Dump to the pipe */
-	nbytes = 0; pbuff = (char *)&_buff[0];
-	while((nbytes < _bytes) && grun)
-	{
-		signal(SIGPIPE, kill_program);
-		bwrote = write(_npipe, &pbuff[nbytes], PIPE_BUF);
-
-		if(bwrote > 0)
-			nbytes += bwrote;
-
-	}
-
-}
-/*----------------------------------------------------------------------------------------------*/
-
-
 /*----------------------------------------------------------------------------------------------*/
 void downsample(CPX *_dest, CPX *_source, double _fdest, double _fsource, int _samps)
 {